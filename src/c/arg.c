@@ -5,6 +5,11 @@
 
  */
 #include "../include/c_proto.h"
+#include "event/nfdwriter.h"
+#include "term/input.h"
+#include "window/window.h"
+#include "perf/nperf.h"
+#include "perf/ntrace.h"
 
 
 /* ---------------------------------------------------------- Variable's ---------------------------------------------------------- */
@@ -125,6 +130,7 @@ static void flagmap_create(void) {
   flagmap_entry_add(          "--zero", ZERO           );
   flagmap_entry_add(              "-!", USE_MAGIC      );
   flagmap_entry_add(         "--magic", USE_MAGIC      );
+  flagmap_entry_add(          "--perf", PERF_OVERLAY   );
 }
 
 /* Frees the flagmap once we are done using it. */
@@ -178,6 +184,7 @@ static void clioptmap_create(void) {
   clioptmap_entry_add(          "--safe", CLIOPT_SAFE          );
   clioptmap_entry_add(          "--test", CLIOPT_TEST          );
   clioptmap_entry_add(  "--debug-socket", CLIOPT_DEBUG_SOCKET  );
+  clioptmap_entry_add(         "--trace", CLIOPT_TRACE         );
 }
 
 /* Free the `command line option map`. */
@@ -379,6 +386,29 @@ void proccess_cli_arguments(int *const argc, char **argv) {
               break;
             }
             case CLIOPT_TEST: {
+              nwindow_test_scroll_bench();
+              nfdwriter_test_bench();
+              input_test_paste_bench();
+              softwrap_test();
+              softwrap_test_bench();
+              long_line_test();
+              long_line_test_bench();
+              display_string_test_bench();
+              nperf_test_bench();
+              ntrace_test_bench();
+              lsp_index_test_bench();
+              lsp_reindex_test();
+              lsp_reindex_test_bench();
+              symtab_test();
+              symtab_test_bench();
+              ctoken_test();
+              ctoken_test_bench();
+              include_resolver_test();
+              include_resolver_test_bench();
+              lsp_project_test();
+              lsp_project_index_test();
+              lsp_project_test_bench();
+              /* This one exits, so it has to run last. */
               norm_path_test();
               // SET(NO_NCURSES);
               // consume_argument(argc, argv, i--);
@@ -387,6 +417,14 @@ void proccess_cli_arguments(int *const argc, char **argv) {
             case CLIOPT_DEBUG_SOCKET: {
               exit(nanox_socketrun());
             }
+            case CLIOPT_TRACE: {
+              if (has_next_argument(i, *argc, argv[i]) && not_a_flag(argv[i + 1], argv[i])) {
+                ntrace_start(argv[i + 1]);
+                consume_argument(argc, argv, i);
+              }
+              consume_argument(argc, argv, i--);
+              break;
+            }
           }
         }
       }
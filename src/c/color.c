@@ -439,3 +439,99 @@ void precalc_multicolorinfo_for(openfilestruct *const file) {
 void precalc_multicolorinfo(void) {
   precalc_multicolorinfo_for(CTX_OF);
 }
+
+/* Recalculate the multi-line regex info of `file` after the lines `top` through `bot` changed.  Scanning starts at the start of
+ * any region still open when reaching `top`, and stops after the first line past `bot` that the scan left just like the last
+ * one did, as from there on the info cannot have changed.  So this costs the changed lines, not the whole file. */
+void precalc_multicolorinfo_range_for(openfilestruct *const file, linestruct *const top, linestruct *const bot) {
+  ASSERT(file);
+  ASSERT(top);
+  ASSERT(bot);
+  const colortype *ink;
+  regmatch_t startmatch, endmatch;
+  linestruct *line, *tailline, *scanned;
+  short was;
+  if (!IN_CURSES_CTX || ISSET(NO_SYNTAX) || !file->syntax || !file->syntax->multiscore) {
+    return;
+  }
+  /* The changed lines can be new, so allocate cache space for them. */
+  for (line=top; line && line != bot->next; line=line->next) {
+    if (!line->multidata) {
+      line->multidata = xmalloc(file->syntax->multiscore * sizeof(short));
+    }
+  }
+  for (ink=file->syntax->color; ink; ink=ink->next) {
+    /* If this is not a multi-line regex, skip it. */
+    if (!ink->end) {
+      continue;
+    }
+    /* Step back to a line that is reached outside of any region.  Note that this does not stop at the first start of a region,
+     * as that can be the end of an earlier region that opens a new one, which is only right when reached inside that region. */
+    line = top;
+    while (line->prev && line->prev->multidata && (line->prev->multidata[ink->id] == WHOLELINE || line->prev->multidata[ink->id] == STARTSHERE)) {
+      line = line->prev;
+    }
+    for (; line; line=line->next) {
+      int index = 0;
+      if (!line->multidata) {
+        line->multidata = xmalloc(file->syntax->multiscore * sizeof(short));
+        /* We know nothing about this line, and a scan reaching it here never makes it this, so it cannot end the scan. */
+        was = WHOLELINE;
+      }
+      else {
+        was = line->multidata[ink->id];
+      }
+      scanned = line;
+      /* Assume nothing applies until proven otherwise below. */
+      line->multidata[ink->id] = NOTHING;
+      /* When the line contains a start match, look for an end, and if found, mark all the lines that are affected. */
+      while (regexec(ink->start, (line->data + index), 1, &startmatch, ((index == 0) ? 0 : REG_NOTBOL)) == 0) {
+        /* Begin looking for an end match after the start match. */
+        index += startmatch.rm_eo;
+        /* If there is an end match on this same line, mark the line, but continue looking for other starts after it. */
+        if (regexec(ink->end, (line->data + index), 1, &endmatch, ((index == 0) ? 0 : REG_NOTBOL)) == 0) {
+          line->multidata[ink->id] = JUSTONTHIS;
+          index += endmatch.rm_eo;
+          /* If the total match has zero length, force an advance. */
+          if ((startmatch.rm_eo - startmatch.rm_so + endmatch.rm_eo) == 0) {
+            /* When at end-of-line, there is no other start. */
+            if (!line->data[index]) {
+              break;
+            }
+            index = step_right(line->data, index);
+          }
+          continue;
+        }
+        /* Look for an end match on later lines. */
+        tailline = line->next;
+        while (tailline && regexec(ink->end, tailline->data, 1, &endmatch, 0) != 0) {
+          tailline = tailline->next;
+        }
+        line->multidata[ink->id] = STARTSHERE;
+        /* Note that this also advances the line in the main loop. */
+        for (line = line->next; line != tailline; line = line->next) {
+          if (!line->multidata) {
+            line->multidata = xmalloc(file->syntax->multiscore * sizeof(short));
+          }
+          line->multidata[ink->id] = WHOLELINE;
+        }
+        if (!tailline) {
+          line = file->filebot;
+          break;
+        }
+        if (!tailline->multidata) {
+          tailline->multidata = xmalloc(file->syntax->multiscore * sizeof(short));
+        }
+        tailline->multidata[ink->id] = ENDSHERE;
+        /* Look for a possible new start after the end match. */
+        index = endmatch.rm_eo;
+      }
+      /* Past the changed lines, the line came out the same as the last scan left it, so the scan leaves it in the same state as well,
+       * and the rest is still valid.  Note that only comparing the old info is not enough, as the last scan may have reached this line
+       * inside a region, and only then found a start after its end, which makes a line that was reached inside a region look outside. */
+      if (scanned->lineno > bot->lineno && scanned->multidata[ink->id] == was) {
+        break;
+      }
+    }
+  }
+}
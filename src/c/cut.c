@@ -112,6 +112,8 @@ void expunge_for(openfilestruct *const file, int cols, undo_type action) {
     }
     /* Move the remainder of the line "in", over the current character. */
     memmove(&file->current->data[file->current_x], &file->current->data[file->current_x + charlen], (line_len - charlen + 1));
+    /* The line changed in place, so its cached chunks and checkpoints must not be trusted when it is measured or drawn below. */
+    ++line_data_version;
     /* When softwrapping, a changed number of chunks requires a refresh. */
     if (ISSET(SOFTWRAP) && extra_chunks_in(cols, file->current) != old_amount) {
       refresh_needed = TRUE;
@@ -786,6 +788,96 @@ void paste_text(void) {
   }
 }
 
+/* ----------------------------- Paste bulk ----------------------------- */
+
+/* Split `len` bytes of pasted `data` into a new list of lines in a single pass, dropping the control chars a paste cannot hold. */
+static linestruct *paste_bulk_lines(const char *const restrict data, Ulong len, linestruct **const bot) {
+  linestruct *top  = make_new_node(NULL);
+  linestruct *line = top;
+  Ulong start = 0;
+  Ulong n;
+  Uchar c;
+  for (Ulong i=0; i<=len; ++i) {
+    if (i < len && data[i] != '\r' && data[i] != '\n') {
+      continue;
+    }
+    line->data = xmalloc(i - start + 1);
+    n = 0;
+    for (Ulong j=start; j<i; ++j) {
+      c = data[j];
+      if (c == '\t' || (c >= 0x20 && c != DEL_CODE)) {
+        line->data[n++] = c;
+      }
+      /* Encode an embedded `NUL` byte as `0x0A`. */
+      else if (!c) {
+        line->data[n++] = '\n';
+      }
+    }
+    line->data[n] = '\0';
+    if (i == len) {
+      break;
+    }
+    /* Treat a windows line ending as a single break. */
+    if (data[i] == '\r' && (i + 1) < len && data[i + 1] == '\n') {
+      ++i;
+    }
+    line->next = make_new_node(line);
+    DLIST_ADV_NEXT(line);
+    start = (i + 1);
+  }
+  *bot = line;
+  return top;
+}
+
+/* Paste `len` bytes of `data` at the cursor in `file` as a single action.  The data is split into lines once, grafted in without
+ * copying it again, recorded as one paste undo item, and only the multi-line regex info of the changed lines is recalculated.
+ * This is what bracketed pastes use, as it skips the per-char input path with its auto-indent and bracket handling. */
+void paste_bulk_for(CTX_PARAMS, const char *const restrict data, Ulong len) {
+  ASSERT(file);
+  ASSERT(data);
+  linestruct *was_cutbuffer = cutbuffer;
+  linestruct *was_current   = file->current;
+  long        was_lineno    = file->current->lineno;
+  Ulong       was_leftedge  = 0;
+  linestruct *top;
+  linestruct *bot;
+  if (!len) {
+    return;
+  }
+  else if (ISSET(VIEW_MODE)) {
+    print_view_warning();
+    return;
+  }
+  top = paste_bulk_lines(data, len, &bot);
+  if (ISSET(SOFTWRAP)) {
+    was_leftedge = leftedge_for(cols, xplustabs_for(file), file->current);
+  }
+  /* Record this as a paste of the new lines, the same way a paste from the cutbuffer is, then graft the lines themselves in. */
+  cutbuffer = top;
+  add_undo_for(file, PASTE, NULL);
+  ingraft_buffer_into(file, top, bot);
+  update_undo_for(file, PASTE);
+  cutbuffer = was_cutbuffer;
+  /* When still on the same line and doing hard-wrapping, limit the width. */
+  if (file->current == was_current && ISSET(BREAK_LONG_LINES)) {
+    do_wrap_for(file, cols);
+  }
+  if (less_than_a_screenful_for(STACK_CTX, was_lineno, was_leftedge)) {
+    focusing = FALSE;
+  }
+  precalc_multicolorinfo_range_for(file, was_current, file->current);
+  /* Set the disired x position to where the pasted text ends. */
+  SET_PWW(file);
+  set_modified_for(file);
+  wipe_statusbar();
+  refresh_needed = TRUE;
+}
+
+/* Paste `len` bytes of `data` at the cursor as a single action.  Note that this is `context-safe`. */
+void paste_bulk(const char *const restrict data, Ulong len) {
+  CTX_CALL_WARGS(paste_bulk_for, data, len);
+}
+
 /* ----------------------------- Zap replace text ----------------------------- */
 
 /* Erase the currently marked region in `file`, then replace it with `replacewith`.  TODO: Make
@@ -5,6 +5,7 @@
 
  */
 #include "../../include/c_proto.h"
+#include "../perf/ntrace.h"
 
 #include <pthread.h>
 
@@ -80,6 +81,7 @@ void nevhandler_stop(nevhandler *handler, int status) {
 /* `Internal`  Task that the handler will perform. */
 static void *nevhandler_task(void *arg) {
   nevhandler *handler = arg;
+  ntrace_thread_name("nevhandler");
   while (1) {
     pthread_mutex_lock(&handler->mutex);
     while (!handler->count && handler->running) {
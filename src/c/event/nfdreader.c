@@ -9,44 +9,28 @@
 #include <pthread.h>
 #include <fcntl.h>
 
-/* `Internal`  Structure that holds the data that the event-handler will execute. */
-typedef struct {
-  nevhandler *handler;
-  Uchar *data;
-  long len;
-  nfdreader_cb callback;  
-} nfdreader_package;
+/* The size of the ring every reader reads into, this has to be a power of two. */
+#define RING_SIZE  (1UL << 16)
+#define RING_MASK  (RING_SIZE - 1)
 
 /* `Opaque`  Structure that reads from a fd and safely sends the data to the event-handler. */
 struct nfdreader {
   nevhandler *handler;
   int fd;
   nfdreader_cb callback;
+  Uchar *ring;
+  Ulong head;   /* The end of the read data, only the thread moves this. */
+  Ulong tail;   /* The end of the data given to the callback, only the event-handler moves this. */
+  bool queued;  /* When a drain is queued in the event-handler, or running, so a burst of reads only wakes it once. */
+  bool exited;  /* When the thread is gone, then a drain that was still queued frees the reader once it is done. */
   pthread_t thread;
   pthread_mutex_t mutex;
+  pthread_cond_t  cond; /* Signaled when the event-handler has freed space in the ring. */
   bool stop;
 };
 
 nfdreader *nfdreader_stdin = NULL;
 
-/* `Internal`  Callback that will run in the event-handler. */
-static void nfdreader_package_callback(void *arg) {
-  nfdreader_package *package = arg;
-  package->callback(package->handler, package->data, package->len);
-  free(package->data);
-  free(package);
-}
-
-/* `Internal`  Create a callback package to send to the event-handler. */
-static nfdreader_package *nfdreader_package_create(nfdreader *reader, const Uchar *data, long len) {
-  nfdreader_package *package = xmalloc(sizeof(*package));
-  package->handler = reader->handler;
-  package->data    = xmeml_copy(data, len);
-  package->len     = len;
-  package->callback      = reader->callback;
-  return package;
-}
-
 /* Close the fd and free the reader.  Note that this will only do that if `nfdreader_stop()` has been called. */
 static void nfdreader_free(nfdreader *reader) {
   if (!reader) {
@@ -57,39 +41,101 @@ static void nfdreader_free(nfdreader *reader) {
   pthread_mutex_unlock(&reader->mutex);
   if (should_free) {
     pthread_mutex_destroy(&reader->mutex);
+    pthread_cond_destroy(&reader->cond);
     close(reader->fd);
+    free(reader->ring);
     free(reader);
     reader = NULL;
   }
 }
 
+/* `Internal`  Callback that will run in the event-handler, giving all the data read since the last drain to the reader callback.
+ * The data is given as at most two contiguous spans, so the callback has to handle sequences split between calls.  The reader
+ * stays queued until a drain finds nothing more to give, so the thread never frees the reader while a drain can still use it. */
+static void nfdreader_drain(void *arg) {
+  nfdreader *reader = arg;
+  Ulong tail = reader->tail;
+  Ulong head;
+  Ulong start;
+  Ulong len;
+  bool more;
+  bool exited;
+  pthread_mutex_lock(&reader->mutex);
+  head = reader->head;
+  pthread_mutex_unlock(&reader->mutex);
+  while (tail < head) {
+    start = (tail & RING_MASK);
+    len   = (head - tail);
+    if (len > (RING_SIZE - start)) {
+      len = (RING_SIZE - start);
+    }
+    reader->callback(reader->handler, (reader->ring + start), len);
+    tail += len;
+  }
+  pthread_mutex_lock(&reader->mutex);
+  reader->tail = tail;
+  pthread_cond_signal(&reader->cond);
+  /* Data read while this drain ran gets a drain of its own, as the thread saw this one queued and did not queue another. */
+  more   = (reader->head != tail);
+  exited = reader->exited;
+  reader->queued = more;
+  pthread_mutex_unlock(&reader->mutex);
+  if (more) {
+    nevhandler_submit(reader->handler, nfdreader_drain, reader);
+  }
+  else if (exited) {
+    nfdreader_free(reader);
+  }
+}
+
 /* `Internal`  Task that the thread will run. */
 static void *nfdreader_thread_task(void *arg) {
   nfdreader *reader = arg;
-  Uchar buffer[4096];
+  Ulong start;
+  Ulong len;
   long bytes_read;
+  bool submit;
   while (1) {
-    mutex_action(&reader->mutex,
-      if (reader->stop) {
-        mutex_unlock(&reader->mutex);
-        break;
-      }
-    );
-    /* Lock then read the file descriptor. */
-    fdlock_action(reader->fd, F_RDLCK,
-      bytes_read = read(reader->fd, buffer, sizeof(buffer));
-    );
-    if (bytes_read > 0) {
-      nevhandler_submit(reader->handler, nfdreader_package_callback, nfdreader_package_create(reader, buffer, bytes_read));
+    pthread_mutex_lock(&reader->mutex);
+    /* When the event-handler falls behind, wait for it to make room. */
+    while (!reader->stop && (reader->head - reader->tail) == RING_SIZE) {
+      pthread_cond_wait(&reader->cond, &reader->mutex);
     }
-    else if (bytes_read == 0) {
+    if (reader->stop) {
+      pthread_mutex_unlock(&reader->mutex);
       break;
     }
-    else if (bytes_read < 0) {
+    start = (reader->head & RING_MASK);
+    len   = (RING_SIZE - (reader->head - reader->tail));
+    if (len > (RING_SIZE - start)) {
+      len = (RING_SIZE - start);
+    }
+    pthread_mutex_unlock(&reader->mutex);
+    /* Read straight into the free part of the ring. */
+    bytes_read = read(reader->fd, (reader->ring + start), len);
+    if (bytes_read < 0 && errno == EINTR) {
+      continue;
+    }
+    else if (bytes_read <= 0) {
       break;
     }
+    pthread_mutex_lock(&reader->mutex);
+    reader->head += bytes_read;
+    submit = !reader->queued;
+    reader->queued = TRUE;
+    pthread_mutex_unlock(&reader->mutex);
+    if (submit) {
+      nevhandler_submit(reader->handler, nfdreader_drain, reader);
+    }
+  }
+  pthread_mutex_lock(&reader->mutex);
+  reader->exited = TRUE;
+  /* A drain that is still queued uses the reader, so that drain frees it once it is done. */
+  submit = !reader->queued;
+  pthread_mutex_unlock(&reader->mutex);
+  if (submit) {
+    nfdreader_free(reader);
   }
-  nfdreader_free(reader);
   return NULL;
 }
 
@@ -101,10 +147,18 @@ nfdreader *nfdreader_create(nevhandler *handler, int fd, nfdreader_cb callback)
   reader->handler = handler;
   reader->fd = fd;
   reader->callback = callback;
-  reader->stop = FALSE;
+  reader->ring   = xmalloc(RING_SIZE);
+  reader->head   = 0;
+  reader->tail   = 0;
+  reader->queued = FALSE;
+  reader->exited = FALSE;
+  reader->stop   = FALSE;
   pthread_mutex_init(&reader->mutex, NULL);
+  pthread_cond_init(&reader->cond, NULL);
   if (pthread_create(&reader->thread, NULL, nfdreader_thread_task, reader) != 0) {
     pthread_mutex_destroy(&reader->mutex);
+    pthread_cond_destroy(&reader->cond);
+    free(reader->ring);
     free(reader);
     die("%s: Failed to create pthread.\n", __func__);
   }
@@ -118,6 +172,7 @@ void nfdreader_stop(nfdreader *reader) {
   }
   pthread_mutex_lock(&reader->mutex);
   reader->stop = TRUE;
+  pthread_cond_signal(&reader->cond);
   pthread_mutex_unlock(&reader->mutex);
 }
 
@@ -10,112 +10,166 @@
 
 #include <pthread.h>
 #include <fcntl.h>
+#include <poll.h>
+#include <sys/uio.h>
 
-typedef struct {
-  void *data;
-  Ulong len;
-} nfdwriter_task;
-
-#define TASKS_SIZE  1024
-#define BUFFER_SIZE 4096
+/* The size of the ring every writer has, this has to be a power of two. */
+#define RING_SIZE  (1UL << 20)
+#define RING_MASK  (RING_SIZE - 1)
 
+/* The ring positions only ever grow, and are masked when indexing, so `head - tail` is always the used size. */
 struct nfdwriter {
-  nfdwriter_task  tasks[TASKS_SIZE];
-  char  buffer[BUFFER_SIZE];
-  Ulong buffer_size;
-  int front;
-  int rear;
-  int count;
+  char *ring;
+  Ulong head;       /* The end of what the producer has written, only the producer touches this. */
+  Ulong published;  /* The end of what the thread may write out, moved to `head` by the producer on flush. */
+  Ulong tail;       /* The end of what the thread has written out, only the thread moves this. */
+  Ulong syscalls;   /* The number of `writev()` calls the thread has made. */
   int fd;
   pthread_t       thread;
   pthread_mutex_t mutex;
-  pthread_cond_t  cond;
+  pthread_cond_t  cond;       /* Signaled when there is published data, or when stopping. */
+  pthread_cond_t  space_cond; /* Signaled when the thread has written data out. */
   bool stop;
-  bool flush;
 };
 
 nfdwriter *nfdwriter_stdout = NULL;
 nfdwriter *nfdwriter_netlog = NULL;
 
-/* `Internal`  Add data to the internal buffer. */
-static inline void add_data_to_buffer(nfdwriter *writer, const void *data, Ulong len) {
-  memcpy((writer->buffer + writer->buffer_size), data, len);
-  writer->buffer_size += len;
+/* `Internal`  Write the ring data from position `from` to `to` to the fd, as at most two contiguous spans per call. */
+static void nfdwriter_write_span(nfdwriter *writer, Ulong from, Ulong to) {
+  struct iovec iov[2];
+  struct pollfd pfd;
+  Ulong start;
+  Ulong len;
+  int iovcnt;
+  long written;
+  while (from < to) {
+    start  = (from & RING_MASK);
+    len    = (to - from);
+    iovcnt = 1;
+    iov[0].iov_base = (writer->ring + start);
+    iov[0].iov_len  = ((len < (RING_SIZE - start)) ? len : (RING_SIZE - start));
+    if (iov[0].iov_len < len) {
+      iov[1].iov_base = writer->ring;
+      iov[1].iov_len  = (len - iov[0].iov_len);
+      iovcnt = 2;
+    }
+    written = writev(writer->fd, iov, iovcnt);
+    ++writer->syscalls;
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      /* The fd is non-blocking, so wait until it can take more. */
+      else if (errno == EAGAIN) {
+        pfd.fd     = writer->fd;
+        pfd.events = POLLOUT;
+        poll(&pfd, 1, -1);
+        continue;
+      }
+      /* The fd is gone, so there is no one left to write the data to. */
+      return;
+    }
+    from += written;
+  }
 }
 
 /* `Internal`  The task the fd-writer run's. */
 static void *nfdwriter_thread_task(void *arg) {
   nfdwriter *writer = arg;
-  nfdwriter_task task;
+  Ulong tail = writer->tail;
+  Ulong published;
+  bool stop;
   while (1) {
-    mutex_action(&writer->mutex,
-      while (!writer->count && !writer->stop) {
-        cond_wait(&writer->cond, &writer->mutex);
-      }
-      if (writer->stop) {
-        fdlock_action(writer->fd, F_WRLCK,
-          write(writer->fd, writer->buffer, writer->buffer_size);
-        );
-        mutex_unlock(&writer->mutex);
-        break;
-      }
-      task = writer->tasks[writer->front];
-      writer->front = ((writer->front + 1) % TASKS_SIZE);
-      --writer->count;
-    );
-    fdlock_action(writer->fd, F_WRLCK,
-      write(writer->fd, task.data, task.len);
-    );
-    free(task.data);
-    task.data = NULL;
+    pthread_mutex_lock(&writer->mutex);
+    while ((published = __atomic_load_n(&writer->published, __ATOMIC_ACQUIRE)) == tail && !writer->stop) {
+      pthread_cond_wait(&writer->cond, &writer->mutex);
+    }
+    stop = writer->stop;
+    pthread_mutex_unlock(&writer->mutex);
+    /* When stopping, write out everything that was published before exiting. */
+    if (published == tail && stop) {
+      break;
+    }
+    nfdwriter_write_span(writer, tail, published);
+    tail = published;
+    pthread_mutex_lock(&writer->mutex);
+    __atomic_store_n(&writer->tail, tail, __ATOMIC_RELEASE);
+    pthread_cond_broadcast(&writer->space_cond);
+    pthread_mutex_unlock(&writer->mutex);
   }
   return NULL;
 }
 
+/* `Internal`  Let the thread write out everything written so far. */
+static void nfdwriter_publish(nfdwriter *writer) {
+  if (__atomic_load_n(&writer->published, __ATOMIC_RELAXED) == writer->head) {
+    return;
+  }
+  pthread_mutex_lock(&writer->mutex);
+  __atomic_store_n(&writer->published, writer->head, __ATOMIC_RELEASE);
+  pthread_cond_signal(&writer->cond);
+  pthread_mutex_unlock(&writer->mutex);
+}
+
+/* `Internal`  Wait until the thread has written out everything up to `pos`. */
+static void nfdwriter_wait_for_tail(nfdwriter *writer, Ulong pos) {
+  pthread_mutex_lock(&writer->mutex);
+  while (__atomic_load_n(&writer->tail, __ATOMIC_ACQUIRE) < pos) {
+    pthread_cond_wait(&writer->space_cond, &writer->mutex);
+  }
+  pthread_mutex_unlock(&writer->mutex);
+}
+
 nfdwriter *nfdwriter_create(int fd) {
   nfdwriter *writer = xmalloc(sizeof(*writer));
-  writer->buffer_size = 0;
-  writer->fd    = fd;
-  writer->front = 0;
-  writer->rear  = 0;
-  writer->count = 0;
+  writer->ring      = xmalloc(RING_SIZE);
+  writer->head      = 0;
+  writer->published = 0;
+  writer->tail      = 0;
+  writer->syscalls  = 0;
+  writer->fd        = fd;
   pthread_mutex_init(&writer->mutex, NULL);
   pthread_cond_init(&writer->cond, NULL);
+  pthread_cond_init(&writer->space_cond, NULL);
   writer->stop = FALSE;
   if (pthread_create(&writer->thread, NULL, nfdwriter_thread_task, writer) != 0) {
     pthread_mutex_destroy(&writer->mutex);
     pthread_cond_destroy(&writer->cond);
+    pthread_cond_destroy(&writer->space_cond);
+    free(writer->ring);
     free(writer);
     return NULL;
   }
-  pthread_detach(writer->thread);
   return writer;
 }
 
 void nfdwriter_write(nfdwriter *writer, const void *data, Ulong len) {
-  if (!writer || !data || !len) {
+  const char *ptr = data;
+  Ulong space;
+  Ulong chunk;
+  Ulong start;
+  Ulong first;
+  if (!writer || !data || !len || writer->stop) {
     return;
   }
-  pthread_mutex_lock(&writer->mutex);
-  {
-    if ((writer->buffer_size + len) > BUFFER_SIZE) {
-      writer->tasks[writer->rear].data = xmeml_copy(writer->buffer, writer->buffer_size);
-      writer->tasks[writer->rear].len  = writer->buffer_size;
-      writer->rear = ((writer->rear + 1) % TASKS_SIZE);
-      ++writer->count;
-      writer->buffer_size = 0;
-      pthread_cond_signal(&writer->cond);
+  while (len) {
+    space = (RING_SIZE - (writer->head - __atomic_load_n(&writer->tail, __ATOMIC_ACQUIRE)));
+    /* The ring is full of unwritten data, so let the thread write out what we have, and wait for room. */
+    if (!space) {
+      nfdwriter_publish(writer);
+      nfdwriter_wait_for_tail(writer, (writer->head - (RING_SIZE / 2)));
+      continue;
     }
-    add_data_to_buffer(writer, data, len);
-    // if (writer->count < TASKS_SIZE) {
-    //   writer->tasks[writer->rear].data = xmeml_copy(data, len);
-    //   writer->tasks[writer->rear].len  = len;
-    //   writer->rear = ((writer->rear + 1) % TASKS_SIZE);
-    //   ++writer->count;
-    //   pthread_cond_signal(&writer->cond);
-    // }
+    chunk = ((len < space) ? len : space);
+    start = (writer->head & RING_MASK);
+    first = ((chunk < (RING_SIZE - start)) ? chunk : (RING_SIZE - start));
+    memcpy((writer->ring + start), ptr, first);
+    memcpy(writer->ring, (ptr + first), (chunk - first));
+    writer->head += chunk;
+    ptr          += chunk;
+    len          -= chunk;
   }
-  pthread_mutex_unlock(&writer->mutex);
 }
 
 int nfdwriter_printf(nfdwriter *writer, const char *format, ...) {
@@ -143,6 +197,7 @@ void nfdwriter_stop(nfdwriter *writer) {
   if (!writer) {
     return;
   }
+  nfdwriter_publish(writer);
   pthread_mutex_lock(&writer->mutex);
   if (!writer->stop) {
     writer->stop = TRUE;
@@ -159,22 +214,29 @@ void nfdwriter_free(nfdwriter *writer) {
   bool is_stopped = writer->stop;
   pthread_mutex_unlock(&writer->mutex);
   if (is_stopped) {
+    pthread_join(writer->thread, NULL);
     pthread_mutex_destroy(&writer->mutex);
     pthread_cond_destroy(&writer->cond);
+    pthread_cond_destroy(&writer->space_cond);
+    free(writer->ring);
     free(writer);
     writer = NULL;
   }
 }
 
 void nfdwriter_flush(nfdwriter *writer) {
-  pthread_mutex_lock(&writer->mutex);
-  writer->tasks[writer->rear].data = xmeml_copy(writer->buffer, writer->buffer_size);
-  writer->tasks[writer->rear].len  = writer->buffer_size;
-  writer->rear = ((writer->rear + 1) % TASKS_SIZE);
-  ++writer->count;
-  writer->buffer_size = 0;
-  pthread_cond_signal(&writer->cond);
-  pthread_mutex_unlock(&writer->mutex);
+  if (!writer) {
+    return;
+  }
+  nfdwriter_publish(writer);
+}
+
+void nfdwriter_drain(nfdwriter *writer) {
+  if (!writer) {
+    return;
+  }
+  nfdwriter_publish(writer);
+  nfdwriter_wait_for_tail(writer, writer->head);
 }
 
 static void nfdwriter_netlog_free(void) {
@@ -193,3 +255,81 @@ void nfdwriter_netlog_init(const char *addr, Ushort port) {
     atexit(nfdwriter_netlog_free);
   }
 }
+
+/* Tests. */
+
+#define NFDWRITER_TEST_FRAMES            (4000)
+#define NFDWRITER_TEST_WRITES_PER_FRAME  (400)
+
+/* `Internal`  Read and discard everything from the master side of a pty, until the slave side is closed. */
+static void *nfdwriter_test_pty_reader(void *arg) {
+  int fd = *(int *)arg;
+  char buffer[65536];
+  long len;
+  while ((len = read(fd, buffer, sizeof(buffer))) > 0 || (len < 0 && errno == EINTR));
+  return NULL;
+}
+
+/* `Internal`  Write frames of small writes, the way a tui frame looks, to `fd` and wait until all of it is written out. */
+static void nfdwriter_test_fd(const char *name, int fd) {
+  nfdwriter *writer = nfdwriter_create(fd);
+  char data[64];
+  Ulong bytes = 0;
+  Ulong syscalls;
+  int len;
+  if (!writer) {
+    return;
+  }
+  timer_action(ms,
+    for (int frame=0; frame<NFDWRITER_TEST_FRAMES; ++frame) {
+      for (int i=0; i<NFDWRITER_TEST_WRITES_PER_FRAME; ++i) {
+        len = snprintf(data, sizeof(data), "\x1b[%d;%dH\x1b[38;2;96;96;96m%7d ", ((i % 50) + 1), 1, (frame + i));
+        nfdwriter_write(writer, data, len);
+        bytes += len;
+      }
+      nfdwriter_flush(writer);
+    }
+    nfdwriter_drain(writer);
+  );
+  pthread_mutex_lock(&writer->mutex);
+  syscalls = writer->syscalls;
+  pthread_mutex_unlock(&writer->mutex);
+  nfdwriter_stop(writer);
+  nfdwriter_free(writer);
+  writef(
+    "%s: %s: Frames: %d: Writes: %d: Bytes: %lu in %.5f ms (%.1f MB/s): Syscalls: %lu\n",
+    __func__, name, NFDWRITER_TEST_FRAMES, (NFDWRITER_TEST_FRAMES * NFDWRITER_TEST_WRITES_PER_FRAME), bytes, (double)ms,
+    (((double)bytes / (1024.0 * 1024.0)) / ((double)ms / 1000.0)), syscalls
+  );
+}
+
+/* Measure the throughput of a writer into `/dev/null` and into a pty, where a thread reads the other end like a terminal would. */
+void nfdwriter_test_bench(void) {
+  pthread_t reader;
+  int master;
+  int slave;
+  int fd = open("/dev/null", O_WRONLY);
+  writef("\n");
+  if (fd >= 0) {
+    nfdwriter_test_fd("/dev/null", fd);
+    close(fd);
+  }
+  master = posix_openpt(O_RDWR | O_NOCTTY);
+  if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0 || (slave = open(ptsname(master), (O_WRONLY | O_NOCTTY))) < 0) {
+    if (master >= 0) {
+      close(master);
+    }
+    writef("%s: Failed to open a pty\n\n", __func__);
+    return;
+  }
+  if (pthread_create(&reader, NULL, nfdwriter_test_pty_reader, &master) != 0) {
+    close(slave);
+    close(master);
+    return;
+  }
+  nfdwriter_test_fd(ptsname(master), slave);
+  close(slave);
+  pthread_join(reader, NULL);
+  close(master);
+  writef("\n");
+}
@@ -19,7 +19,8 @@ extern nfdwriter *nfdwriter_netlog;
 /* Create a new `nfdwriter` instance. */
 nfdwriter *nfdwriter_create(int fd);
 
-/* Write to a fd in a process safe and thread safe manner, fully async. */
+/* Copy data into the ring of `writer`, fully async.  Nothing is written to the fd until `nfdwriter_flush()` publishes it,
+ * or the ring fills up.  Note that there can only be one thread writing to a given `writer`. */
 void nfdwriter_write(nfdwriter *writer, const void *data, Ulong len);
 
 int nfdwriter_printf(nfdwriter *writer, const char *fmt, ...) _PRINTFLIKE(2, 3);
@@ -27,8 +28,12 @@ int nfdwriter_printf(nfdwriter *writer, const char *fmt, ...) _PRINTFLIKE(2, 3);
 /* Stops the thread for `writer`.  This function is `NULL-SAFE`. */
 void nfdwriter_stop(nfdwriter *writer);
 
+/* Mark the end of a frame, letting the thread write out everything written so far.  This function is `NULL-SAFE`. */
 void nfdwriter_flush(nfdwriter *writer);
 
+/* Flush `writer`, and wait until the thread has written everything out.  This function is `NULL-SAFE`. */
+void nfdwriter_drain(nfdwriter *writer);
+
 /* Frees `writer`s memory, note that this will do nothing if `nfdwriter_stop()` has not been called before. */
 void nfdwriter_free(nfdwriter *writer);
 
@@ -37,4 +42,6 @@ void nfdwriter_free(nfdwriter *writer);
 
 void nfdwriter_netlog_init(const char *addr, Ushort port);
 
+void nfdwriter_test_bench(void);
+
 _END_C_LINKAGE
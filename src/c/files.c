@@ -5,6 +5,7 @@
 
  */
 #include "../include/c_proto.h"
+#include "perf/nperf.h"
 
 
 /* ---------------------------------------------------------- Define's ---------------------------------------------------------- */
@@ -1305,9 +1306,12 @@ int diralphasort(const void *va, const void *vb) {
 /* ----------------------------- Set modified ----------------------------- */
 
 /* Mark `file` as modified if it isn't already, and then update the title-bar to
- * display the buffer's new status.  As well as re-writing the lockfile it there is one. */
+ * display the buffer's new status.  As well as re-writing the lockfile it there is one.
+ * This runs on every edit, so it also tells the language server about the edit. */
 void set_modified_for(openfilestruct *const file) {
   ASSERT(file);
+  ++line_data_version;
+  lsp_note_edit(file);
   if (file->modified) {
     return;
   }
@@ -1750,6 +1754,8 @@ void read_file_into(CTX_ARGS, FILE *const f, int fd, const char *const restrict
   format_type format = NIX_FILE;
   /* The char we are currently processing. */
   char input;
+  /* When the read started, for the timings. */
+  Llong perf_start = nperf_now();
   /* When the caller knows we can write to this file. */
   if (undoable) {
     add_undo_for(file, INSERT, NULL);
@@ -1907,6 +1913,7 @@ void read_file_into(CTX_ARGS, FILE *const f, int fd, const char *const restrict
   else if (file->fmt == UNSPECIFIED) {
     file->fmt = format;
   }
+  nperf_record(NPERF_IO, perf_start);
 }
 
 /* Read the given open file f into the current buffer.  filename should be
@@ -2264,6 +2271,8 @@ bool write_file_for(openfilestruct *const file, const char *const restrict name,
   const char *newname;
   /* The flag we will use to open the file.  Use O_EXCL for an emergency file. */
   int open_flag = (O_WRONLY | O_CREAT | ((method == APPEND) ? O_APPEND : (normal ? O_TRUNC : O_EXCL)));
+  /* When the write started, for the timings.  Only writes that succeed are recorded. */
+  Llong perf_start = nperf_now();
   /* If we're writing a temporary file, we're probebly going outside
    * the operating directory, so skip the operating directory test. */
   if (normal && outside_of_confinement(realname, FALSE)) {
@@ -2515,6 +2524,7 @@ bool write_file_for(openfilestruct *const file, const char *const restrict name,
     free(tempname);
     free(realname);
   }
+  nperf_record(NPERF_IO, perf_start);
   return TRUE;
 }
 
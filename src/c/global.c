@@ -99,6 +99,8 @@ char *startup_problem = NULL;
 char *nanox_rc_path = NULL;
 /* The directory where we store backup files. */
 char *backup_dir = NULL;
+/* The extra directories to search for system includes, separated by colons. */
+char *include_path = NULL;
 /* The answer string used by the status-bar prompt. */
 char *answer = NULL;
 /* The opening and closing brackets that bracket searches can find. */
@@ -346,6 +348,8 @@ Ulong light_to_col = 0;
 Ulong typing_x = HIGHEST_POSITIVE;
 /* When the `(status/prompt)-bar` is marked, then this is the index in `answer` of that mark. */
 Ulong st_marked_x = 0;
+/* Bumped on every edit, so caches of how a line is laid out only check the line data itself again once this changed. */
+Ulong line_data_version = 1;
 
 /* ----------------------------- Ulong [] ----------------------------- */
 
@@ -461,12 +461,13 @@ Ulong editor_get_page_start(Editor *const editor, const Ulong column) {
 float editor_cursor_x_pos(Editor *const editor, linestruct *const line, Ulong index) {
   ASSERT(editor);
   ASSERT(line);
-  Ulong from_col  = editor_get_page_start(openeditor, wideness(line->data, index));
-  char *converted = display_string(line->data, from_col, editor->cols, TRUE, FALSE);
+  /* The conversion buffer, kept between calls, as this runs every frame. */
+  static char *converted = NULL;
+  static Ulong size      = 0;
+  Ulong from_col = editor_get_page_start(openeditor, line_wideness(line, index));
+  display_string_into(&converted, &size, line->data, line, from_col, editor->cols, TRUE, FALSE);
   // float ret = (string_pixel_offset(converted, NULL, (wideness(line->data, index) - from_col), gui_font_get_font(textfont)) + editor->text->pos.x);
-  float ret = (font_wideness(textfont, converted, (wideness(line->data, index) - from_col)) + editor->text->x);
-  free(converted);
-  return ret;
+  return (font_wideness(textfont, converted, (line_wideness(line, index) - from_col)) + editor->text->x);
 }
 
 /* ----------------------------- Editor get text line ----------------------------- */
@@ -609,14 +610,14 @@ void editor_text_line_marked_region(Editor *const editor,
     }
     /* Only paint if the marked part of the line is on this page. */
     if (xtop < till_x && xbot > from_x) {
-      startcol = (wideness(line->data, xtop) - from_col);
+      startcol = (line_wideness(line, xtop) - from_col);
       if (startcol < 0) {
         startcol = 0;
       }
       thetext = (data + actual_x(data, startcol));
       /* If the end mark is onscreen, compute the number of columns we will mark. */
       if (xbot < till_x) {
-        endcol   = (wideness(line->data, xbot) - from_col);
+        endcol   = (line_wideness(line, xbot) - from_col);
         paintlen = actual_x(thetext, (endcol - startcol));
       }
       if (paintlen == -1) {
@@ -646,6 +647,8 @@ void editor_text_line(Editor *const editor, linestruct *const line) {
   float x;
   float y;
   char *data;
+  const char *converted;
+  Ulong len;
   Ulong from_col;
   if (refresh_needed) {
     if (ISSET(LINE_NUMBERS)) {
@@ -658,15 +661,14 @@ void editor_text_line(Editor *const editor, linestruct *const line) {
     /* If the line has any text on it. */
     if (*line->data) {
       from_col = get_page_start(
-        wideness(line->data, ((line == editor->openfile->current) ? editor->openfile->current_x : 0)),
+        line_wideness(line, ((line == editor->openfile->current) ? editor->openfile->current_x : 0)),
         editor->cols
       );
-      data = display_string(line->data, from_col, editor->cols, TRUE, FALSE);
+      converted = display_string_row((line->lineno - editor->openfile->edittop->lineno), line->data, line, from_col, editor->cols, TRUE, FALSE, &len);
       x = editor->text->x;
       y = (font_row_baseline(textfont, (line->lineno - editor->openfile->edittop->lineno)) + editor->text->y);
-      font_vertbuf_add_mbstr(textfont, editor->buffer, data, STRLEN(data), NULL, PACKED_UINT_WHITE, &x, &y);
-      editor_text_line_marked_region(editor, line, data, from_col);
-      free(data);
+      font_vertbuf_add_mbstr(textfont, editor->buffer, converted, len, NULL, PACKED_UINT_WHITE, &x, &y);
+      editor_text_line_marked_region(editor, line, converted, from_col);
     }
   }
 }
@@ -705,7 +707,7 @@ void editor_draw(Editor *const editor) {
       );
     }
   }
-  vertex_buffer_render(editor->marked_region_buf, GL_TRIANGLES);
+  shader_rect_batch_push_vertbuf(editor->marked_region_buf, editor->text->layer);
   render_vertbuf(textfont, editor->buffer);
   /* Draw the top-bar of the editor. */
   etb_draw(editor->tb);
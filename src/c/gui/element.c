@@ -44,6 +44,7 @@ static Element *element_create_internal(void) {
   e->rect_buffer = vertex_buffer_new(RECT_VERTBUF);
   /* Layer. */
   e->layer = 0;
+  e->grid_node = -1;
   e->border_lsize = 0;
   e->border_tsize = 0;
   e->border_rsize = 0;
@@ -114,101 +115,16 @@ static void element_children_relative_pos(Element *const e) {
   );
 }
 
-/* ----------------------------- Bazier indices create ----------------------------- */
-
-static Uint *bazier_indices_create(Ulong n, Ulong *const len) {
-  ASSERT(len);
-  *len = ((n - 1) * 3);
-  Uint *ret = xmalloc(sizeof(Uint) * (*len));
-  for (Ulong i=0, no=1; i<(*len); i+=3, ++no) {
-    ret[i]   = 0;
-    ret[i+1] = no;
-    ret[i+2] = (no + 1);
-  }
-  return ret;
-}
-
-/* ----------------------------- Bazier corner arc ----------------------------- */
-
-static void bazier_corner_arc(float corner_x, float corner_y, float center_x,
-  float center_y, float t, float *const arcx, float *const arcy, Ulong n)
-{
-  ASSERT(arcx);
-  ASSERT(arcy);
-  float ax;
-  float ay;
-  flerp(t, corner_x, corner_y, center_x, center_y, &ax, &ay);
-  bazier_arc(corner_x, center_y, center_x, corner_y, ax, ay, arcx, arcy, n);
-}
-
-/* ----------------------------- Bazier vertex create ----------------------------- */
-
-static RectVertex *bazier_vertex_create(Ulong n) {
-  return xmalloc(sizeof(RectVertex) * (n + 1));
-}
-
-/* ----------------------------- Bazier vertex insert ----------------------------- */
-
-static void bazier_vertex_insert(RectVertex *vert, Ulong n, float cx, float cy, float *const arcx, float *const arcy, Uint color) {
-  UNPACK_FUINT_VARS(color, r,g,b,a);
-  vert[0] = (RectVertex){ cx,cy, r,g,b,a };
-  for (Ulong i=0; i<n; ++i) {
-    vert[i+1] = (RectVertex){ arcx[i],arcy[i], r,g,b,a };
-  }
-}
-
-/* ----------------------------- Element add rounded center rect ----------------------------- */
-
-static void element_add_rounded_center_rect(Element *const e, float offset) {
-  ASSERT(e);
-  RectVertex vert[4];
-  /* Create the center rect. */
-  if (e->width > e->height) {
-    shader_rect_vertex_load(vert, (e->x + offset), e->y, (e->width - (offset * 2)), e->height, e->color);
-  }
-  else {
-    shader_rect_vertex_load(vert, e->x, (e->y + offset), e->width, (e->height - (offset * 2)), e->color);
-  }
-  vertex_buffer_push_back(e->rect_buffer, ARRAY__LEN(vert), ARRAY__LEN(RECT_INDICES));
-}
-
-/* ----------------------------- Element instert bazier arc corner ----------------------------- */
-
-static void element_insert_bazier_arc_corner(Element *const e, RectVertex *vert, Uint *indi,
-  Ulong indi_len, Ulong n, float corner_x, float corner_y, float center_x, float center_y)
-{
-  ASSERT(e);
-  float arcx[n];
-  float arcy[n];
-  float t = UCHAR_TO_FLOAT(UNPACK_INT_DATA(e->xrectopts, 0, Uchar));
-  bazier_corner_arc(corner_x, corner_y, center_x, center_y, t, arcx, arcy, n);
-  bazier_vertex_insert(vert, n, center_x, center_y, arcx, arcy, e->color);
-  vertex_buffer_push_back(e->rect_buffer, vert, (n + 1), indi, indi_len);
-}
- 
 /* ----------------------------- Element rounded rect ----------------------------- */
 
+/* Add the rounded rect of `e`, the corners are made by the rect shader, so this is a single quad. */
 static void element_rounded_rect(Element *const e) {
   ASSERT(e);
-  Ulong n = 19;
-  RectVertex *vert = bazier_vertex_create(n);
-  Ulong indi_len;
-  Uint *indi = bazier_indices_create(n, &indi_len);
-  float offset = (FMINF(e->width, e->height) / 2);
-  element_add_rounded_center_rect(e, offset);
-  /* Top-Left */
-  element_insert_bazier_arc_corner(e, vert, indi, indi_len, n, e->x, e->y, (e->x + offset), (e->y + offset));
-  /* Top-Right */
-  element_insert_bazier_arc_corner(e, vert, indi, indi_len, n,
-    (e->x + e->width), e->y, ((e->x + e->width - offset)), (e->y + offset));
-  /* Bottom-Left */
-  element_insert_bazier_arc_corner(e, vert, indi, indi_len, n,
-    e->x, (e->y + e->height), (e->x + offset), ((e->y + e->height) - offset));
-  /* Bottom-Right */
-  element_insert_bazier_arc_corner(e, vert, indi, indi_len, n,
-    (e->x + e->width), (e->y + e->height), ((e->x + e->width) - offset), ((e->y + e->height) - offset));
-  free(indi);
-  free(vert);
+  RectVertex vert[4];
+  float t = UCHAR_TO_FLOAT(UNPACK_INT_DATA(e->xrectopts, 0, Uchar));
+  float radius = ((FMINF(e->width, e->height) / 2) * (1 - t));
+  shader_rect_vertex_load_rounded(vert, e->x, e->y, e->width, e->height, radius, e->color);
+  vertex_buffer_push_back(e->rect_buffer, vert, 4, RECT_INDICES, RECT_INDICES_LEN);
 }
 
 /* ----------------------------- Element draw rect ----------------------------- */
@@ -242,9 +158,8 @@ static inline void element_draw_rect(Element *const e) {
     }
     e->xflags &= ~ELEMENT_RECT_REFRESH;
   }
-  glUseProgram(rect_shader); {
-    vertex_buffer_render(e->rect_buffer, GL_TRIANGLES);
-  }
+  /* Add the rect to the batch, all rects are then drawn together ordered by layer. */
+  shader_rect_batch_push_vertbuf(e->rect_buffer, e->layer);
 }
 
 
@@ -307,35 +222,32 @@ void element_draw(Element *const e) {
 
 void element_move(Element *const e, float x, float y) {
   ASSERT(e);
-  element_grid_remove(e);
   if (!(e->x == x && e->y == y)) {
     e->xflags |= ELEMENT_RECT_REFRESH;
   }
   e->x = x;
   e->y = y;
   element_children_relative_pos(e);
-  element_grid_set(e);
+  element_grid_update(e);
 }
 
 /* ----------------------------- Element resize ----------------------------- */
 
 void element_resize(Element *const e, float width, float height) {
   ASSERT(e);
-  element_grid_remove(e);
   if (e->width != width || e->height != height) {
     e->xflags |= ELEMENT_RECT_REFRESH;
   }
   e->width  = width;
   e->height = height;
   element_children_relative_pos(e);
-  element_grid_set(e);
+  element_grid_update(e);
 }
 
 /* ----------------------------- Element move resize ----------------------------- */
  
 void element_move_resize(Element *const e, float x, float y, float width, float height) {
   ASSERT(e);
-  element_grid_remove(e);
   if (!(e->x == x && e->y == y && e->width == width && e->height == height)) {
     e->xflags |= ELEMENT_RECT_REFRESH;
   }
@@ -344,7 +256,7 @@ void element_move_resize(Element *const e, float x, float y, float width, float
   e->width  = width;
   e->height = height;
   element_children_relative_pos(e);
-  element_grid_set(e);
+  element_grid_update(e);
 }
 
 /* ----------------------------- Element move y clamp ----------------------------- */
@@ -354,13 +266,12 @@ void element_move_y_clamp(Element *const e, float y, float min, float max) {
   ASSERT(e);
   float newy = fclamp(y, min, max);
   /* Only perform any action when the passed y value is not the same as the current. */
-  element_grid_remove(e);
   if (e->y != newy) {
     e->xflags |= ELEMENT_RECT_REFRESH;
   }
   e->y = newy;
   element_children_relative_pos(e);
-  element_grid_set(e);
+  element_grid_update(e);
 }
 
 /* ----------------------------- Element delete borders ----------------------------- */
@@ -432,6 +343,7 @@ void element_set_borders(Element *const e, float lsize, float tsize, float rsize
 void element_set_layer(Element *const e, Ushort layer) {
   ASSERT(e);
   e->layer = layer;
+  element_grid_update(e);
   ELEMENT_CHILDREN_ITER(e, i, child,
     if (child->xflags & ELEMENT_SET_OWN_LAYER) {
       element_set_layer(child, child->layer);
@@ -547,6 +459,7 @@ Element *element_copy(Element *src, Element *parent) {
     element_set_parent(copy, parent);
   }
   copy->layer          = src->layer;
+  element_grid_update(copy);
   copy->rel_x          = src->rel_x;
   copy->rel_y          = src->rel_y;
   copy->rel_width      = src->rel_width;
@@ -3,10 +3,31 @@
   @author  Melwin Svensson.
   @date    15-5-2025.
 
+  The element grid is a dynamic bounding volume tree over all elements that take part in mouse events.  Every element
+  is a leaf that holds a slightly enlarged (fat) rect, so that small moves and resizes does not touch the tree at all,
+  and when they do the leaf is removed and reinserted in `O(log n)`.  Every node also holds the highest layer found
+  under it, so that a hit-test can skip entire subtrees that can never win over what has already been found.
+
  */
 #include "../../include/c_proto.h"
 
 
+/* ---------------------------------------------------------- Define's ---------------------------------------------------------- */
+
+
+#define ELEMENT_GRID_NULL  (-1)
+
+/* The maximum depth of the traversal stack.  The tree is balanced, so this is enough for more elements then we will ever have. */
+#define ELEMENT_GRID_STACK_SIZE  (256)
+
+#define ELEMENT_GRID_NODE_IS_LEAF(node)  ((node)->left == ELEMENT_GRID_NULL)
+
+/* Number of elements and mouse events used by `element_grid_test_bench()`. */
+#define ELEMENT_GRID_TEST_ELEMENTS  (500)
+#define ELEMENT_GRID_TEST_EVENTS    (1000000)
+#define ELEMENT_GRID_TEST_MOVES     (10000)
+
+
 /* ---------------------------------------------------------- Variable's ---------------------------------------------------------- */
 
 
@@ -16,76 +37,308 @@ ElementGrid *element_grid = NULL;
 /* ---------------------------------------------------------- Struct's ---------------------------------------------------------- */
 
 
+typedef struct {
+  /* The rect of this node.  For leafs this is the fat rect of the element, and for branches the union of both children. */
+  float x0;
+  float y0;
+  float x1;
+  float y1;
+
+  /* The parent of this node, or when this node is free, the next free node. */
+  int parent;
+  int left;
+  int right;
+
+  /* The height of this node in the tree, where leafs are `0`. */
+  int height;
+
+  /* The highest layer of any element under this node. */
+  Ushort layer;
+
+  /* The element of a leaf, `NULL` for branches. */
+  Element *e;
+} ElementGridNode;
+
 struct ElementGrid {
-  int cell_size;
-  HNMAP map;
-  // HashMapNum *map;
+  /* How much each leaf rect is enlarged in every direction. */
+  float margin;
+  int   root;
+  int   freelist;
+  int   count;
+  int   cap;
+  ElementGridNode *nodes;
 };
 
-typedef struct {
-  float x;
-  float y;
-  Element *ret;
-} GetPackage;
-
 
 /* ---------------------------------------------------------- Static function's ---------------------------------------------------------- */
 
 
-static __always_inline Ulong element_gridpos_xy_hash(int gx, int gy) {
-  Ulong x = (Ulong)gx;
-  Ulong y = (Ulong)gy;
-  return (x ^ (y * 0x9e3779b9UL + (x << 6) + (x >> 2)));
+/* ----------------------------- Element grid perimeter ----------------------------- */
+
+/* Return's the perimeter of the union of the rect of node `a` and the given rect, this is the cost we minimize when inserting. */
+static inline float element_grid_union_perimeter(ElementGridNode *const a, float x0, float y0, float x1, float y1) {
+  ASSERT(a);
+  return (((fmaxf(a->x1, x1) - fminf(a->x0, x0)) + (fmaxf(a->y1, y1) - fminf(a->y0, y0))) * 2);
 }
 
-// static inline Ulong element_gridpos_hash(ElementGridpos pos) {
-//   Ulong hx = (Ulong)pos.x;
-//   Ulong hy = (Ulong)pos.y;
-//   return (hx ^ (hy * 0x9e3779b9UL + (hx << 6) + (hx >> 2)));
-// }
+static inline float element_grid_perimeter(ElementGridNode *const a) {
+  ASSERT(a);
+  return (((a->x1 - a->x0) + (a->y1 - a->y0)) * 2);
+}
 
-// static inline Ulong element_grid_key(int x, int y) {
-//   return element_gridpos_hash((ElementGridpos){x, y});
-// }
+/* ----------------------------- Element grid node alloc ----------------------------- */
 
-static inline ElementGridpos element_gridpos_get(float x, float y) {
+static int element_grid_node_alloc(void) {
   ASSERT(element_grid);
-  return (ElementGridpos){(x / element_grid->cell_size), (y / element_grid->cell_size)};
+  int ret;
+  ElementGridNode *node;
+  if (element_grid->freelist == ELEMENT_GRID_NULL) {
+    element_grid->cap   = (element_grid->cap ? (element_grid->cap * 2) : 64);
+    element_grid->nodes = xrealloc(element_grid->nodes, (element_grid->cap * sizeof(ElementGridNode)));
+    for (int i=element_grid->count; i<element_grid->cap; ++i) {
+      element_grid->nodes[i].parent = ((i + 1) < element_grid->cap) ? (i + 1) : ELEMENT_GRID_NULL;
+      element_grid->nodes[i].height = -1;
+    }
+    element_grid->freelist = element_grid->count;
+  }
+  ret  = element_grid->freelist;
+  node = &element_grid->nodes[ret];
+  element_grid->freelist = node->parent;
+  node->parent = ELEMENT_GRID_NULL;
+  node->left   = ELEMENT_GRID_NULL;
+  node->right  = ELEMENT_GRID_NULL;
+  node->height = 0;
+  node->layer  = 0;
+  node->e      = NULL;
+  ++element_grid->count;
+  return ret;
 }
 
-static inline ElementGridpos element_grid_get_start(Element *const e) {
+/* ----------------------------- Element grid node release ----------------------------- */
+
+static void element_grid_node_release(int index) {
   ASSERT(element_grid);
-  ASSERT(e);
-  return element_gridpos_get(e->x, e->y);
+  ASSERT(index >= 0 && index < element_grid->cap);
+  element_grid->nodes[index].parent = element_grid->freelist;
+  element_grid->nodes[index].height = -1;
+  element_grid->freelist = index;
+  --element_grid->count;
 }
 
-static inline ElementGridpos element_grid_get_end(Element *const e) {
+/* ----------------------------- Element grid refit ----------------------------- */
+
+/* Recalculate the rect, height and layer of the branch at `index` from its children. */
+static void element_grid_refit(int index) {
   ASSERT(element_grid);
-  ASSERT(e);
-  return element_gridpos_get((e->x + e->width), (e->y + e->height));
+  ElementGridNode *node  = &element_grid->nodes[index];
+  ElementGridNode *left  = &element_grid->nodes[node->left];
+  ElementGridNode *right = &element_grid->nodes[node->right];
+  node->x0     = fminf(left->x0, right->x0);
+  node->y0     = fminf(left->y0, right->y0);
+  node->x1     = fmaxf(left->x1, right->x1);
+  node->y1     = fmaxf(left->y1, right->y1);
+  node->height = (1 + ((left->height > right->height) ? left->height : right->height));
+  node->layer  = ((left->layer > right->layer) ? left->layer : right->layer);
+}
+
+/* ----------------------------- Element grid replace child ----------------------------- */
+
+/* Make `new_child` take the place of `old_child` under `parent`, or the root when `parent` is `ELEMENT_GRID_NULL`. */
+static void element_grid_replace_child(int parent, int old_child, int new_child) {
+  ASSERT(element_grid);
+  if (parent == ELEMENT_GRID_NULL) {
+    element_grid->root = new_child;
+  }
+  else if (element_grid->nodes[parent].left == old_child) {
+    element_grid->nodes[parent].left = new_child;
+  }
+  else {
+    element_grid->nodes[parent].right = new_child;
+  }
 }
 
-static inline void element_grid_get_action(Ulong _UNUSED key, void *value, void *data) {
-  ASSERT(value);
-  Element *e = value;
-  GetPackage *p;
-  if (e->xflags & ELEMENT_HIDDEN) {
+/* ----------------------------- Element grid balance ----------------------------- */
+
+/* Perform a left or right rotation when the node at `a` is unbalanced.  Return's the new root of this subtree. */
+static int element_grid_balance(int a) {
+  ASSERT(element_grid);
+  ElementGridNode *nodes = element_grid->nodes;
+  int b;
+  int c;
+  int up;
+  int down;
+  int keep;
+  int balance;
+  if (ELEMENT_GRID_NODE_IS_LEAF(&nodes[a]) || nodes[a].height < 2) {
+    return a;
+  }
+  b = nodes[a].left;
+  c = nodes[a].right;
+  balance = (nodes[c].height - nodes[b].height);
+  if (balance > 1) {
+    up = c;
+  }
+  else if (balance < -1) {
+    up = b;
+  }
+  else {
+    return a;
+  }
+  /* Rotate `up` so that it takes the place of `a`, and `a` becomes a child of `up`. */
+  nodes[up].parent = nodes[a].parent;
+  element_grid_replace_child(nodes[a].parent, a, up);
+  nodes[a].parent = up;
+  /* Of the children of `up`, the taller one stays under `up` and the other one is moved down to `a`. */
+  if (nodes[nodes[up].left].height > nodes[nodes[up].right].height) {
+    keep = nodes[up].left;
+    down = nodes[up].right;
+  }
+  else {
+    keep = nodes[up].right;
+    down = nodes[up].left;
+  }
+  nodes[up].left  = a;
+  nodes[up].right = keep;
+  if (up == c) {
+    nodes[a].right = down;
+  }
+  else {
+    nodes[a].left = down;
+  }
+  nodes[down].parent = a;
+  element_grid_refit(a);
+  element_grid_refit(up);
+  return up;
+}
+
+/* ----------------------------- Element grid fix upwards ----------------------------- */
+
+/* Walk from `index` up to the root, balancing and refitting every node on the way. */
+static void element_grid_fix_upwards(int index) {
+  ASSERT(element_grid);
+  while (index != ELEMENT_GRID_NULL) {
+    index = element_grid_balance(index);
+    element_grid_refit(index);
+    index = element_grid->nodes[index].parent;
+  }
+}
+
+/* ----------------------------- Element grid insert leaf ----------------------------- */
+
+static void element_grid_insert_leaf(int leaf) {
+  ASSERT(element_grid);
+  ElementGridNode *nodes;
+  ElementGridNode *node;
+  ElementGridNode *child;
+  float x0;
+  float y0;
+  float x1;
+  float y1;
+  float cost;
+  float inherit;
+  float cost_left;
+  float cost_right;
+  int index;
+  int sibling;
+  int old_parent;
+  int new_parent;
+  if (element_grid->root == ELEMENT_GRID_NULL) {
+    element_grid->root = leaf;
+    element_grid->nodes[leaf].parent = ELEMENT_GRID_NULL;
     return;
   }
-  p = data;
-  /* Ensure the given position actually falls inside the element. */
-  if ((p->x >= e->x && p->x <= (e->x + e->width) && p->y >= e->y && p->y <= (e->y + e->height))
-  /* Also, ensure the layers are respected. */
-  && (!p->ret || (p->ret->layer < e->layer || (p->ret->layer == e->layer
-  && !(p->ret->xflags & ELEMENT_ABOVE) && (e->xflags & ELEMENT_ABOVE)))))
-  {
-    p->ret = e;
+  nodes = element_grid->nodes;
+  x0 = nodes[leaf].x0;
+  y0 = nodes[leaf].y0;
+  x1 = nodes[leaf].x1;
+  y1 = nodes[leaf].y1;
+  /* Find the best sibling, by walking down the side that grows the least. */
+  index = element_grid->root;
+  while (!ELEMENT_GRID_NODE_IS_LEAF(&nodes[index])) {
+    node    = &nodes[index];
+    cost    = (element_grid_union_perimeter(node, x0, y0, x1, y1) * 2);
+    inherit = ((element_grid_union_perimeter(node, x0, y0, x1, y1) - element_grid_perimeter(node)) * 2);
+    child      = &nodes[node->left];
+    cost_left  = (element_grid_union_perimeter(child, x0, y0, x1, y1) + inherit);
+    cost_left -= (ELEMENT_GRID_NODE_IS_LEAF(child) ? 0 : element_grid_perimeter(child));
+    child      = &nodes[node->right];
+    cost_right  = (element_grid_union_perimeter(child, x0, y0, x1, y1) + inherit);
+    cost_right -= (ELEMENT_GRID_NODE_IS_LEAF(child) ? 0 : element_grid_perimeter(child));
+    if (cost < cost_left && cost < cost_right) {
+      break;
+    }
+    index = ((cost_left < cost_right) ? node->left : node->right);
+  }
+  sibling = index;
+  /* Create a new parent for the sibling and the new leaf.  Note that this can move the node array. */
+  new_parent = element_grid_node_alloc();
+  nodes      = element_grid->nodes;
+  old_parent = nodes[sibling].parent;
+  nodes[new_parent].parent = old_parent;
+  nodes[new_parent].left   = sibling;
+  nodes[new_parent].right  = leaf;
+  element_grid_replace_child(old_parent, sibling, new_parent);
+  nodes[sibling].parent = new_parent;
+  nodes[leaf].parent    = new_parent;
+  element_grid_fix_upwards(new_parent);
+}
+
+/* ----------------------------- Element grid remove leaf ----------------------------- */
+
+static void element_grid_remove_leaf(int leaf) {
+  ASSERT(element_grid);
+  ElementGridNode *nodes = element_grid->nodes;
+  int parent;
+  int grandparent;
+  int sibling;
+  if (leaf == element_grid->root) {
+    element_grid->root = ELEMENT_GRID_NULL;
+    return;
   }
-  // if (p->x >= e->x && p->x <= (e->x + e->width) && p->y >= e->y && p->y <= (e->y + e->height)) {
-  //   if (!p->ret || (p->ret && (p->ret->layer < e->layer || (p->ret->layer == e->layer && !p->ret->is_above && e->is_above)))) {
-  //     p->ret = e;
-  //   }
-  // }
+  parent      = nodes[leaf].parent;
+  grandparent = nodes[parent].parent;
+  sibling     = ((nodes[parent].left == leaf) ? nodes[parent].right : nodes[parent].left);
+  /* The sibling takes the place of the parent, that we no longer need. */
+  element_grid_replace_child(grandparent, parent, sibling);
+  nodes[sibling].parent = grandparent;
+  element_grid_node_release(parent);
+  element_grid_fix_upwards(grandparent);
+}
+
+/* ----------------------------- Element grid leaf set rect ----------------------------- */
+
+/* Set the fat rect and layer of `leaf` from the element it holds. */
+static inline void element_grid_leaf_set_rect(int leaf) {
+  ASSERT(element_grid);
+  ElementGridNode *node = &element_grid->nodes[leaf];
+  node->x0    = (node->e->x - element_grid->margin);
+  node->y0    = (node->e->y - element_grid->margin);
+  node->x1    = (node->e->x + node->e->width  + element_grid->margin);
+  node->y1    = (node->e->y + node->e->height + element_grid->margin);
+  node->layer = node->e->layer;
+}
+
+/* ----------------------------- Element grid element contains ----------------------------- */
+
+static inline bool element_grid_element_contains(Element *const e, float x, float y) {
+  ASSERT(e);
+  return (x >= e->x && x <= (e->x + e->width) && y >= e->y && y <= (e->y + e->height));
+}
+
+/* ----------------------------- Element grid node contains ----------------------------- */
+
+static inline bool element_grid_node_contains(ElementGridNode *const node, float x, float y) {
+  ASSERT(node);
+  return (x >= node->x0 && x <= node->x1 && y >= node->y0 && y <= node->y1);
+}
+
+/* ----------------------------- Element grid is above ----------------------------- */
+
+/* Return's `TRUE` when `e` should receive mouse events before `current`, respecting the layers. */
+static inline bool element_grid_is_above(Element *const e, Element *const current) {
+  ASSERT(e);
+  return (!current || current->layer < e->layer || (current->layer == e->layer
+  && !(current->xflags & ELEMENT_ABOVE) && (e->xflags & ELEMENT_ABOVE)));
 }
 
 
@@ -94,11 +347,15 @@ static inline void element_grid_get_action(Ulong _UNUSED key, void *value, void
 
 /* ----------------------------- Element grid create ----------------------------- */
 
-void element_grid_create(int cell_size) {
+/* Create the element grid, where `margin` is how much the rect of every element is enlarged, so that small moves are free. */
+void element_grid_create(float margin) {
   MALLOC_STRUCT(element_grid);
-  element_grid->cell_size = cell_size;
-  element_grid->map = hnmap_create();
-  hnmap_set_free_func(element_grid->map, (void (*)(void *))hnmap_free);
+  element_grid->margin   = margin;
+  element_grid->root     = ELEMENT_GRID_NULL;
+  element_grid->freelist = ELEMENT_GRID_NULL;
+  element_grid->count    = 0;
+  element_grid->cap      = 0;
+  element_grid->nodes    = NULL;
 }
 
 /* ----------------------------- Element grid free ----------------------------- */
@@ -107,7 +364,7 @@ void element_grid_free(void) {
   if (!element_grid) {
     return;
   }
-  hnmap_free(element_grid->map);
+  free(element_grid->nodes);
   free(element_grid);
   element_grid = NULL;
 }
@@ -117,26 +374,20 @@ void element_grid_free(void) {
 void element_grid_set(Element *const e) {
   ASSERT(element_grid);
   ASSERT(e);
-  ElementGridpos start;
-  ElementGridpos end;
-  Ulong key;
-  HNMAP cellmap;
+  int leaf;
   if (e->xflags & ELEMENT_NOT_IN_MAP) {
     return;
   }
-  start = element_grid_get_start(e);
-  end   = element_grid_get_end(e);
-  for (int x=start.x; x<=end.x; ++x) {
-    for (int y=start.y; y<=end.y; ++y) {
-      key     = element_gridpos_xy_hash(x, y);
-      cellmap = hnmap_get(element_grid->map, key);
-      if (!cellmap) {
-        cellmap = hnmap_create();
-        hnmap_insert(element_grid->map, key, cellmap);
-      }
-      hnmap_insert(cellmap, (Ulong)e, e);
-    }
+  /* The element is already part of the grid. */
+  else if (e->grid_node != ELEMENT_GRID_NULL) {
+    element_grid_update(e);
+    return;
   }
+  leaf = element_grid_node_alloc();
+  element_grid->nodes[leaf].e = e;
+  element_grid_leaf_set_rect(leaf);
+  element_grid_insert_leaf(leaf);
+  e->grid_node = leaf;
 }
 
 /* ----------------------------- Element grid remove ----------------------------- */
@@ -144,154 +395,142 @@ void element_grid_set(Element *const e) {
 void element_grid_remove(Element *const e) {
   ASSERT(element_grid);
   ASSERT(e);
-  ElementGridpos start;
-  ElementGridpos end;
-  Ulong key;
-  HNMAP cellmap;
-  /* If the element do not wish to be part of the grid, and therefor not be part of mouse events, respect that. */
-  if (e->xflags & ELEMENT_NOT_IN_MAP) {
+  if (e->grid_node == ELEMENT_GRID_NULL) {
     return;
   }
-  start = element_grid_get_start(e);
-  end   = element_grid_get_end(e);
-  /* Columns */
-  for (int x=start.x; x<=end.x; ++x) {
-    /* Rows */
-    for (int y=start.y; y<=end.y; ++y) {
-      key     = element_gridpos_xy_hash(x, y);
-      cellmap = hnmap_get(element_grid->map, key);
-      if (!cellmap) {
-        continue;
-      }
-      hnmap_remove(cellmap, (Ulong)e);
-      /* Currently we only grow, in the sense that we never free empty grid tile maps. If we wanted to
-       * we could do it like this.  But first we should improve the grid map as a whole and the hashmap.
+  element_grid_remove_leaf(e->grid_node);
+  element_grid_node_release(e->grid_node);
+  e->grid_node = ELEMENT_GRID_NULL;
+}
 
-        if (!hashmapnum_size(cellmap)) {
-          hashmapnum_remove(grid->map, key);
-        } 
+/* ----------------------------- Element grid update ----------------------------- */
 
-       */
-    }
+/* Update the grid after `e` has moved, been resized or changed layer.  When the element still fits inside its
+ * fat rect and the layer is the same this does nothing, otherwise the element is reinserted in `O(log n)`. */
+void element_grid_update(Element *const e) {
+  ASSERT(element_grid);
+  ASSERT(e);
+  ElementGridNode *node;
+  if (e->grid_node == ELEMENT_GRID_NULL) {
+    return;
   }
+  node = &element_grid->nodes[e->grid_node];
+  if (node->layer == e->layer && e->x >= node->x0 && e->y >= node->y0
+  && (e->x + e->width) <= node->x1 && (e->y + e->height) <= node->y1)
+  {
+    return;
+  }
+  element_grid_remove_leaf(e->grid_node);
+  element_grid_leaf_set_rect(e->grid_node);
+  element_grid_insert_leaf(e->grid_node);
 }
 
 /* ----------------------------- Element grid get ----------------------------- */
 
+/* Return's the element at `x` and `y` that should receive mouse events, or `NULL` when there is none. */
 Element *element_grid_get(float x, float y) {
   ASSERT(element_grid);
-  ElementGridpos gridpos = element_gridpos_get(x, y);
-  Ulong key = element_gridpos_xy_hash(gridpos.x, gridpos.y);
-  HNMAP cellmap = hnmap_get(element_grid->map, key);
-  GetPackage *p;
-  Element *ret;
-  if (!cellmap) {
+  int stack[ELEMENT_GRID_STACK_SIZE];
+  int top = 0;
+  ElementGridNode *node;
+  Element *ret = NULL;
+  if (element_grid->root == ELEMENT_GRID_NULL) {
     return NULL;
   }
-  p = xmalloc(sizeof *p);
-  p->x   = x;
-  p->y   = y;
-  p->ret = NULL;
-  hnmap_forall_wdata(cellmap, element_grid_get_action, p);
-  ret = p->ret;
-  free(p);
+  stack[top++] = element_grid->root;
+  while (top) {
+    node = &element_grid->nodes[stack[--top]];
+    /* Skip this entire subtree when the position is not inside it, or nothing under it has a high enough layer. */
+    if (!element_grid_node_contains(node, x, y) || (ret && node->layer < ret->layer)) {
+      continue;
+    }
+    else if (ELEMENT_GRID_NODE_IS_LEAF(node)) {
+      if (!(node->e->xflags & ELEMENT_HIDDEN) && element_grid_element_contains(node->e, x, y) && element_grid_is_above(node->e, ret)) {
+        ret = node->e;
+      }
+    }
+    else {
+      ALWAYS_ASSERT((top + 2) <= ELEMENT_GRID_STACK_SIZE);
+      stack[top++] = node->left;
+      stack[top++] = node->right;
+    }
+  }
   return ret;
 }
 
 /* ----------------------------- Element grid contains ----------------------------- */
 
-/* Returns true if the grid tile of `x` and `y` contains any elements at all, this is
- * more efficent then running `element_grid_get()` as that does more to verify what
- * exact element in the grid should be returned based on layer and exact position. */
+/* Returns true if `x` and `y` is inside any element in the grid at all, this is more efficent then
+ * running `element_grid_get()` as this stops at the first element found, regardless of its layer. */
 bool element_grid_contains(float x, float y) {
   ASSERT(element_grid);
-  ElementGridpos gridpos = element_gridpos_get(x, y);
-  return hnmap_get(element_grid->map, element_gridpos_xy_hash(gridpos.x, gridpos.y));
+  int stack[ELEMENT_GRID_STACK_SIZE];
+  int top = 0;
+  ElementGridNode *node;
+  if (element_grid->root == ELEMENT_GRID_NULL) {
+    return FALSE;
+  }
+  stack[top++] = element_grid->root;
+  while (top) {
+    node = &element_grid->nodes[stack[--top]];
+    if (!element_grid_node_contains(node, x, y)) {
+      continue;
+    }
+    else if (ELEMENT_GRID_NODE_IS_LEAF(node)) {
+      if (element_grid_element_contains(node->e, x, y)) {
+        return TRUE;
+      }
+    }
+    else {
+      ALWAYS_ASSERT((top + 2) <= ELEMENT_GRID_STACK_SIZE);
+      stack[top++] = node->left;
+      stack[top++] = node->right;
+    }
+  }
+  return FALSE;
 }
 
-// ElementGrid *element_grid_create(int cell_size) {
-//   ElementGrid *grid;
-//   MALLOC_STRUCT(grid);
-//   grid->cell_size = cell_size;
-//   grid->map = hashmapnum_create_wfreefunc(cvec_free_void_ptr);
-//   return grid;
-// }
-// void element_grid_set(ElementGrid *const grid, Element *const e) {
-//   ASSERT(grid);
-//   ASSERT(e);
-//   ElementGridpos start;
-//   ElementGridpos end;
-//   Ulong key;
-//   CVec *vec;
-//   if (e->not_in_gridmap) {
-//     return;
-//   }
-//   start = element_grid_get_start(grid, e);
-//   end   = element_grid_get_end(grid, e);
-//   for (int x=start.x; x<=end.x; ++x) {
-//     for (int y=start.y; y<=end.y; ++y) {
-//       key = element_grid_key(x, y);
-//       vec = hashmapnum_get(grid->map, key);
-//       if (!vec) {
-//         vec = cvec_create();
-//         hashmapnum_insert(grid->map, key, vec);
-//       }
-//       cvec_push(vec, e);
-//     }
-//   }
-// }
-// void element_grid_remove(ElementGrid *const grid, Element *const e) {
-//   ASSERT(grid);
-//   ASSERT(e);
-//   TIMER_START(timer);
-//   ElementGridpos start;
-//   ElementGridpos end;
-//   Ulong key;
-//   CVec *vec;
-//   if (e->not_in_gridmap) {
-//     return;
-//   }
-//   start = element_grid_get_start(grid, e);
-//   end   = element_grid_get_end(grid, e);
-//   for (int x=start.x; x<=end.x; ++x) {
-//     for (int y=start.y; y<=end.y; ++y) {
-//       key = element_grid_key(x, y);
-//       vec = hashmapnum_get(grid->map, key);
-//       if (!vec) {
-//         continue;
-//       }
-//       cvec_remove_by_value(vec, e);
-//       if (!cvec_len(vec)) {
-//         hashmapnum_remove(grid->map, key);
-//       }
-//     }
-//   }
-//   TIMER_END(timer, ms);
-//   TIMER_PRINT(ms);
-// }
-// Element *element_grid_get(ElementGrid *const grid, float x, float y) {
-//   ASSERT(grid);
-//   TIMER_START(timer);
-//   ElementGridpos gridpos = element_gridpos_get(grid, x, y);
-//   Ulong key = element_grid_key(gridpos.x, gridpos.y);
-//   CVec *vec = hashmapnum_get(grid->map, key);
-//   Element *ret = NULL;
-//   Element *e;
-//   if (!vec) {
-//     return NULL;
-//   }
-//   for (int i=0; i<cvec_len(vec); ++i) {
-//     e = cvec_get(vec, i);
-//     if (e->hidden) {
-//       continue;
-//     }
-//     else if (x >= e->x && x <= (e->x + e->width) && y >= e->y && y <= (e->y + e->height)) {
-//       if ((ret && e->is_above) || !ret) {
-//         ret = e;
-//       }
-//     }
-//   }
-//   TIMER_END(timer, ms);
-//   TIMER_PRINT(ms);
-//   return ret;
-// }
+
+/* -------------------------------------------------------- Tests -------------------------------------------------------- */
+
+
+/* ----------------------------- Element grid test bench ----------------------------- */
+
+/* Measure hit-testing with a lot of elements in a temporary grid, the same way mouse motion does it, interleaved with moves. */
+void element_grid_test_bench(float width, float height) {
+  ElementGrid *saved = element_grid;
+  Element **elements = xmalloc(ELEMENT_GRID_TEST_ELEMENTS * sizeof(Element *));
+  Ulong hits = 0;
+  Element *e;
+  element_grid = NULL;
+  element_grid_create(saved ? saved->margin : 20);
+  srand(1);
+  timer_action(build_ms,
+    for (int i=0; i<ELEMENT_GRID_TEST_ELEMENTS; ++i) {
+      elements[i] = element_create((rand() % (int)width), (rand() % (int)height), (10 + (rand() % 300)), (10 + (rand() % 40)), TRUE);
+      element_set_layer(elements[i], (rand() % 4));
+    }
+  );
+  timer_action(move_ms,
+    for (int i=0; i<ELEMENT_GRID_TEST_MOVES; ++i) {
+      e = elements[rand() % ELEMENT_GRID_TEST_ELEMENTS];
+      element_move(e, (e->x + ((rand() % 41) - 20)), (e->y + ((rand() % 41) - 20)));
+    }
+  );
+  timer_action(get_ms,
+    for (int i=0; i<ELEMENT_GRID_TEST_EVENTS; ++i) {
+      hits += !!element_grid_get((rand() % (int)width), (rand() % (int)height));
+    }
+  );
+  for (int i=0; i<ELEMENT_GRID_TEST_ELEMENTS; ++i) {
+    element_free(elements[i]);
+  }
+  free(elements);
+  element_grid_free();
+  element_grid = saved;
+  writef(
+    "\n%s: Elements: %d: Build: %.5f ms: Moves: %d in %.5f ms: Hit-tests: %d in %.5f ms (%.1f ns each): Hits: %lu\n\n",
+    __func__, ELEMENT_GRID_TEST_ELEMENTS, (double)build_ms, ELEMENT_GRID_TEST_MOVES, (double)move_ms,
+    ELEMENT_GRID_TEST_EVENTS, (double)get_ms, (((double)get_ms * 1000000.0) / ELEMENT_GRID_TEST_EVENTS), hits
+  );
+}
@@ -5,16 +5,19 @@
 
  */
 #include "../../include/c_proto.h"
+#include "../event/nfuture.h"
 
 
 /* ---------------------------------------------------------- Define's ---------------------------------------------------------- */
 
 
-#define ASSERT_FONT  \
-  ASSERT(f);             \
-  ASSERT(f->path);       \
-  ASSERT(f->atlas);      \
-  ASSERT(f->font)
+#define ASSERT_FONT         \
+  ASSERT(f);                \
+  ASSERT(f->path);          \
+  ASSERT(f->cur);           \
+  ASSERT(f->cur->npages);   \
+  ASSERT(f->cur->glyphmap); \
+  ASSERT(f->cur->pages[0].font)
 
 /* TODO: Here we probebly should always round the resulting values so that we can align to pixels. */
 
@@ -26,17 +29,89 @@
 /* Use this to fully avoid devision by zero in a easy way. */
 #define GF_HALF_LH  (!f->line_height ? 0 : ((float)f->line_height / 2))
 
-#define GF_HEIGHT   (FONT_HEIGHT(f->font) + f->line_height)
+/* The primary page's font, this is what all font metrics are taken from. */
+#define GF_FONT  (f->cur->pages[0].font)
 
-#define GF_ROW_BASELINE(row)  (((row) * GF_HEIGHT) + f->font->ascender + GF_HALF_LH)
+#define GF_HEIGHT   (FONT_HEIGHT(GF_FONT) + f->line_height)
 
-#define GF_ROW_TOP(r)  (GF_ROW_BASELINE(r) - f->font->ascender  - GF_HALF_LH)
-#define GF_ROW_BOT(r)  (GF_ROW_BASELINE(r) - f->font->descender + GF_HALF_LH)
+#define GF_ROW_BASELINE(row)  (((row) * GF_HEIGHT) + GF_FONT->ascender + GF_HALF_LH)
+
+#define GF_ROW_TOP(r)  (GF_ROW_BASELINE(r) - GF_FONT->ascender  - GF_HALF_LH)
+#define GF_ROW_BOT(r)  (GF_ROW_BASELINE(r) - GF_FONT->descender + GF_HALF_LH)
+
+/* The maximum number of atlas pages a single font can have at the same time. */
+#define FONT_MAX_PAGES  (4)
+
+/* The glyphs that get rasterized into the primary page on a worker thread as soon as a font is loaded. */
+#define FONT_PRERASTER_CHARS  \
+  " !\"#$%&'()*+,-./0123456789:;<=>?@ABCDEFGHIJKLMNOPQRSTUVWXYZ[\\]^_`abcdefghijklmnopqrstuvwxyz{|}~"
+
+/* Padding in rows added around a dirty glyph region, as the atlas places glyphs with a one pixel border. */
+#define FONT_DIRTY_PADDING  (1)
+
+/* The maximum number of sizes of a single font that are kept loaded, including the current size. */
+#define FONT_SIZE_CACHE_MAX  (4)
+
+/* How many sizes above and below the current size that gets loaded in the background. */
+#define FONT_PREFETCH_RADIUS  (1)
+
+/* The smallest size we will ever load. */
+#define FONT_MIN_SIZE  (4)
+
+/* The atlas size, glyphs per frame and number of frames used by `font_test_evict()`, chosen so every page fills up several times. */
+#define FONT_TEST_ATLAS_SIZE        (128)
+#define FONT_TEST_GLYPHS_PER_FRAME  (16)
+#define FONT_TEST_FRAMES            (64)
 
 
 /* ---------------------------------------------------------- Struct's ---------------------------------------------------------- */
 
 
+/* One texture page of a font.  Every page has its own atlas and its own freetype font that loads glyphs into
+ * that atlas, so when a page is full we simply open another one instead of rebuilding everything. */
+typedef struct {
+  /* The texture atlas ptr. */
+  texture_atlas_t *atlas;
+
+  /* The freetype font type, that rasterizes into `atlas`. */
+  texture_font_t  *font;
+
+  /* The frame this page was last used in, this is how we find the least recently used page to evict. */
+  Ulong last_used;
+
+  /* The value of `atlas->used` when this page was last uploaded, used to detect glyphs we did not see being loaded. */
+  Ulong uploaded_used;
+
+  /* The range of rows in the atlas that has changed since the last upload.  When `dirty_top >= dirty_bot` the page is clean. */
+  Uint dirty_top;
+  Uint dirty_bot;
+
+  /* Set once the texture storage for this page has been allocated on the gpu. */
+  bool allocated : 1;
+
+  /* When the page is being pre-rasterized on a worker thread this holds that task, otherwise `NULL`. */
+  nfuture *raster;
+} FontPage;
+
+/* Everything that is loaded for one size of a font.  These are cached so that changing the size back and forth is instant. */
+typedef struct {
+  /* The size this is loaded at. */
+  Uint size;
+
+  /* All currently open pages.  The first page is the primary page, all metrics are taken from it and it's never evicted. */
+  FontPage pages[FONT_MAX_PAGES];
+  Uint     npages;
+
+  /* The page new glyphs gets loaded into. */
+  Uint load_page;
+
+  /* Maps a codepoint to the page it was loaded into, stored as `page + 1` so that a missing entry is `NULL`. */
+  HNMAP glyphmap;
+
+  /* The frame this size was last the current size, used to find what size to drop from the cache. */
+  Ulong last_used;
+} FontSize;
+
 struct Font {
   /* The size of the font. */
   Uint size;
@@ -47,17 +122,30 @@ struct Font {
   /* The path of the loaded font, this is useful when changing size. */
   char *path;
 
-  /* The texture atlas ptr. */
-  texture_atlas_t *atlas;
+  /* The currently used size, this is always one of the sizes in `cache`. */
+  FontSize *cur;
 
-  /* The freetype font type. */
-  texture_font_t  *font;
+  /* All loaded sizes, including the current one and the ones loaded ahead of time in the background. */
+  FontSize *cache[FONT_SIZE_CACHE_MAX];
+  Uint      ncache;
 
   /* This represents a deviation from the base separation
    * between rows.  Note that this can be negative or positive. */
   long line_height;
 };
 
+typedef struct {
+  Uint  page;
+  CVec *keys;
+} FontEvictPackage;
+
+/* What a worker needs to load the primary page of a size ahead of time. */
+typedef struct {
+  FontPage *page;
+  char *path;
+  Uint size;
+} FontPrefetchPackage;
+
 
 /* ---------------------------------------------------------- Static function's ---------------------------------------------------------- */
 
@@ -94,25 +182,441 @@ static inline void font_internal_set_path(Font *const f, const char *const restr
   f->path = free_and_assign(f->path, copy_of(path));
 }
 
-/* ----------------------------- Font internal load atlas ----------------------------- */
+/* ----------------------------- Font internal codepoint key ----------------------------- */
+
+/* Return's the key used in the glyph map for the first codepoint in `codepoint`. */
+static inline Ulong font_internal_codepoint_key(const char *const restrict codepoint) {
+  ASSERT(codepoint);
+  wchar wc;
+  if (mbtowide(&wc, codepoint) < 0) {
+    return (Uchar)*codepoint;
+  }
+  return (Uint)wc;
+}
+
+/* ----------------------------- Font internal page mark dirty ----------------------------- */
+
+/* Extend the dirty row range of `page` so it includes the rows `top` to `bot`. */
+static inline void font_internal_page_mark_dirty(FontPage *const page, long top, long bot) {
+  ASSERT(page);
+  ASSERT(page->atlas);
+  top -= FONT_DIRTY_PADDING;
+  bot += FONT_DIRTY_PADDING;
+  if (top < 0) {
+    top = 0;
+  }
+  if (bot > (long)page->atlas->height) {
+    bot = page->atlas->height;
+  }
+  if (page->dirty_top >= page->dirty_bot) {
+    page->dirty_top = top;
+    page->dirty_bot = bot;
+  }
+  else {
+    if (top < (long)page->dirty_top) {
+      page->dirty_top = top;
+    }
+    if (bot > (long)page->dirty_bot) {
+      page->dirty_bot = bot;
+    }
+  }
+}
+
+/* ----------------------------- Font internal page raster task ----------------------------- */
+
+/* Runs on a worker thread, and rasterizes all printable ascii glyphs into the page passed as `arg`. */
+static void *font_internal_page_raster_task(void *arg) {
+  ASSERT(arg);
+  FontPage *page = arg;
+  /* The null glyph is what the cursor is drawn with, so make sure it exists as well. */
+  texture_font_get_glyph(page->font, NULL);
+  texture_font_load_glyphs(page->font, FONT_PRERASTER_CHARS);
+  return page;
+}
+
+/* ----------------------------- Font internal page sync ----------------------------- */
+
+/* When the page at `index` is still being pre-rasterized, wait for that to finish and then
+ * register the rasterized glyphs.  Note that this must be called before the page is touched. */
+static inline void font_internal_page_sync(Font *const f, Uint index) {
+  ASSERT(f);
+  ASSERT(index < f->cur->npages);
+  FontPage *page = &f->cur->pages[index];
+  if (!page->raster) {
+    return;
+  }
+  nfuture_get(page->raster);
+  page->raster = NULL;
+  /* The font could not be loaded in the background, let the caller deal with it. */
+  if (!page->font) {
+    return;
+  }
+  for (const char *ch=FONT_PRERASTER_CHARS; *ch; ++ch) {
+    hnmap_insert(f->cur->glyphmap, (Uchar)*ch, (void *)(Ulong)(index + 1));
+  }
+  font_internal_page_mark_dirty(page, 0, page->atlas->height);
+}
+
+/* ----------------------------- Font internal page open ----------------------------- */
+
+/* Open a new page at index `f->cur->npages` using the internal `path`, `atlas_size` and the current size.  Return's `FALSE` on failure. */
+static bool font_internal_page_open(Font *const f) {
+  ASSERT(f);
+  ASSERT(f->path);
+  ALWAYS_ASSERT(f->cur->npages < FONT_MAX_PAGES);
+  FontPage *page = &f->cur->pages[f->cur->npages];
+  page->atlas = texture_atlas_new(f->atlas_size, f->atlas_size, 1);
+  page->font  = texture_font_new_from_file(page->atlas, f->cur->size, f->path);
+  if (!page->font) {
+    texture_atlas_free(page->atlas);
+    page->atlas = NULL;
+    return FALSE;
+  }
+  page->last_used     = frame_elapsed();
+  page->uploaded_used = 0;
+  page->dirty_top     = 0;
+  page->dirty_bot     = 0;
+  page->allocated     = FALSE;
+  page->raster        = NULL;
+  ++f->cur->npages;
+  return TRUE;
+}
+
+/* ----------------------------- Font internal size create ----------------------------- */
+
+/* Create a blank `FontSize` for `size`, without any pages. */
+static FontSize *font_internal_size_create(Uint size) {
+  FontSize *fs = xmalloc(sizeof(*fs));
+  fs->size      = size;
+  fs->npages    = 0;
+  fs->load_page = 0;
+  fs->glyphmap  = hnmap_create();
+  fs->last_used = frame_elapsed();
+  return fs;
+}
+
+/* ----------------------------- Font internal size free ----------------------------- */
+
+/* Close all pages of `fs` and free it.  This function is `NULL-SAFE`. */
+static void font_internal_size_free(FontSize *const fs) {
+  FontPage *page;
+  if (!fs) {
+    return;
+  }
+  for (Uint i=0; i<fs->npages; ++i) {
+    page = &fs->pages[i];
+    if (page->raster) {
+      nfuture_get(page->raster);
+      page->raster = NULL;
+    }
+    texture_font_free(page->font);
+    texture_atlas_free(page->atlas);
+  }
+  hnmap_free(fs->glyphmap);
+  free(fs);
+}
+
+/* ----------------------------- Font internal size find ----------------------------- */
+
+/* Return's the cache index of `size`, or `-1` when that size is not loaded. */
+static int font_internal_size_find(Font *const f, Uint size) {
+  ASSERT(f);
+  for (Uint i=0; i<f->ncache; ++i) {
+    if (f->cache[i]->size == size) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+/* ----------------------------- Font internal size drop ----------------------------- */
+
+/* Remove the size at cache index `index` and free it. */
+static void font_internal_size_drop(Font *const f, Uint index) {
+  ASSERT(f);
+  ASSERT(index < f->ncache);
+  ASSERT(f->cache[index] != f->cur);
+  font_internal_size_free(f->cache[index]);
+  f->cache[index] = f->cache[--f->ncache];
+}
+
+/* ----------------------------- Font internal size add ----------------------------- */
+
+/* Add `fs` to the cache of `f`, when the cache is full the least recently used size that is not the current one is dropped. */
+static void font_internal_size_add(Font *const f, FontSize *const fs) {
+  ASSERT(f);
+  ASSERT(fs);
+  int lru = -1;
+  if (f->ncache == FONT_SIZE_CACHE_MAX) {
+    for (Uint i=0; i<f->ncache; ++i) {
+      if (f->cache[i] != f->cur && (lru == -1 || f->cache[i]->last_used < f->cache[lru]->last_used)) {
+        lru = i;
+      }
+    }
+    ALWAYS_ASSERT(lru != -1);
+    font_internal_size_drop(f, lru);
+  }
+  f->cache[f->ncache++] = fs;
+}
+
+/* ----------------------------- Font internal clear cache ----------------------------- */
+
+/* Free every loaded size of `f`. */
+static void font_internal_clear_cache(Font *const f) {
+  ASSERT(f);
+  for (Uint i=0; i<f->ncache; ++i) {
+    font_internal_size_free(f->cache[i]);
+  }
+  f->ncache = 0;
+  f->cur    = NULL;
+}
+
+/* ----------------------------- Font internal evict collect ----------------------------- */
+
+static void font_internal_evict_collect(Ulong key, void *value, void *data) {
+  ASSERT(data);
+  FontEvictPackage *p = data;
+  if ((Ulong)value == (p->page + 1)) {
+    cvec_push(p->keys, (void *)key);
+  }
+}
+
+/* ----------------------------- Font internal page evict ----------------------------- */
+
+/* Throw away every glyph in the page at `index` so that it can be reused.  This is the least recently used
+ * page, and as it has not been drawn from this frame or the last no vertex buffer on screen references it. */
+static void font_internal_page_evict(Font *const f, Uint index) {
+  ASSERT(f);
+  /* The primary page holds the pre-rasterized ascii glyphs, and should never be evicted. */
+  ASSERT(index > 0 && index < f->cur->npages);
+  FontPage *page = &f->cur->pages[index];
+  FontEvictPackage p = { index, cvec_create() };
+  hnmap_forall_wdata(f->cur->glyphmap, font_internal_evict_collect, &p);
+  for (int i=0; i<cvec_len(p.keys); ++i) {
+    hnmap_remove(f->cur->glyphmap, (Ulong)cvec_get(p.keys, i));
+  }
+  cvec_free(p.keys);
+  texture_font_free(page->font);
+  texture_atlas_clear(page->atlas);
+  page->font = texture_font_new_from_file(page->atlas, f->cur->size, f->path);
+  ALWAYS_ASSERT(page->font);
+  font_internal_page_mark_dirty(page, 0, page->atlas->height);
+  page->last_used = frame_elapsed();
+  log_INFO_0("Font: Evicted atlas page %u of font size %u", index, f->cur->size);
+  /* Make sure anything still holding glyphs from this page gets rebuilt. */
+  refresh_needed = TRUE;
+}
+
+/* ----------------------------- Font internal page get glyph ----------------------------- */
+
+/* Return's the glyph of `codepoint` from the page at `index`, loading it into that page when needed.  Return's `NULL` when the page is full. */
+static texture_glyph_t *font_internal_page_get_glyph(Font *const f, Uint index, const char *const restrict codepoint) {
+  ASSERT(f);
+  ASSERT(index < f->cur->npages);
+  FontPage *page;
+  texture_glyph_t *glyph;
+  Ulong used;
+  font_internal_page_sync(f, index);
+  page  = &f->cur->pages[index];
+  used  = page->atlas->used;
+  glyph = texture_font_get_glyph(page->font, codepoint);
+  page->last_used = frame_elapsed();
+  /* When the atlas grew, this glyph was just rasterized so only the rows it covers needs to be uploaded. */
+  if (glyph && page->atlas->used != used) {
+    font_internal_page_mark_dirty(page, (glyph->t0 * page->atlas->height), (glyph->t1 * page->atlas->height));
+  }
+  return glyph;
+}
+
+/* ----------------------------- Font internal lru page ----------------------------- */
+
+/* Return's the least recently used page that can be evicted, or `0` when every page is still in use. */
+static Uint font_internal_lru_page(Font *const f) {
+  ASSERT(f);
+  Ulong frame = frame_elapsed();
+  Uint ret = 0;
+  for (Uint i=1; i<f->cur->npages; ++i) {
+    /* Pages used during this or the previous frame may still be referenced by a vertex buffer on screen. */
+    if ((f->cur->pages[i].last_used + 1) >= frame) {
+      continue;
+    }
+    else if (!ret || f->cur->pages[i].last_used < f->cur->pages[ret].last_used) {
+      ret = i;
+    }
+  }
+  return ret;
+}
+
+/* ----------------------------- Font internal get glyph ----------------------------- */
 
-/* Free the internal `texture_atlas_t` of `f` if it exists
- * and create a new one using the internal `atlas_size`. */
-static inline void font_internal_load_atlas(Font *const f) {
+/* Return's the glyph of `codepoint` and assigns the page it lives in to `*outpage`.  When the glyph is not loaded yet it is
+ * loaded into the current load page, and when that is full we open a new page or evict the least recently used one. */
+static texture_glyph_t *font_internal_get_glyph(Font *const f, const char *const restrict codepoint, Uint *const outpage) {
   ASSERT(f);
-  texture_atlas_free(f->atlas);
-  f->atlas = texture_atlas_new(f->atlas_size, f->atlas_size, 1);
+  ASSERT(outpage);
+  texture_glyph_t *glyph;
+  Ulong key;
+  Uint page;
+  /* The null glyph always lives in the primary page. */
+  if (!codepoint) {
+    *outpage = 0;
+    return font_internal_page_get_glyph(f, 0, NULL);
+  }
+  font_internal_page_sync(f, 0);
+  key = font_internal_codepoint_key(codepoint);
+  /* Fast path, we already know what page this glyph is in. */
+  if ((page = (Ulong)hnmap_get(f->cur->glyphmap, key))) {
+    *outpage = (page - 1);
+    return font_internal_page_get_glyph(f, *outpage, codepoint);
+  }
+  page = f->cur->load_page;
+  while (!(glyph = font_internal_page_get_glyph(f, page, codepoint))) {
+    /* There is still room to grow, so open another page. */
+    if (f->cur->npages < FONT_MAX_PAGES && font_internal_page_open(f)) {
+      page = (f->cur->npages - 1);
+    }
+    /* Otherwise, reuse the least recently used page. */
+    else if ((page = font_internal_lru_page(f))) {
+      font_internal_page_evict(f, page);
+    }
+    /* Every page is in use, so draw a blank glyph rather then failing. */
+    else {
+      log_ERR_NF("Font: All atlas pages are full, cannot load glyph: %u", (Uint)key);
+      *outpage = 0;
+      return font_internal_page_get_glyph(f, 0, " ");
+    }
+    f->cur->load_page = page;
+  }
+  hnmap_insert(f->cur->glyphmap, key, (void *)(Ulong)(page + 1));
+  *outpage = page;
+  return glyph;
 }
 
-/* ----------------------------- Font internal load font ----------------------------- */
+/* ----------------------------- Font internal glyphlen ----------------------------- */
 
-/* Free the internal `texture_font_t` of `f` if it exists and create a new one using the internal `path`, `size` and `atlas`. */
-static inline void font_internal_load_font(Font *const f) {
+/* Return's the width in pixels of the codepoint that `current` points to, including the kerning from `previous` when not `NULL`. */
+static inline float font_internal_glyphlen(Font *const f, const char *const restrict current, const char *const restrict previous) {
+  ASSERT(f);
+  ASSERT(current);
+  Uint page;
+  texture_glyph_t *glyph = font_internal_get_glyph(f, current, &page);
+  return (glyph->advance_x + (previous ? texture_glyph_get_kerning(glyph, previous) : 0));
+}
+
+/* ----------------------------- Font internal page upload ----------------------------- */
+
+/* Bind the texture of the page at `index`, and upload only the rows that have changed since the last upload. */
+static void font_internal_page_upload(Font *const f, Uint index) {
+  ASSERT(f);
+  ASSERT(index < f->cur->npages);
+  FontPage *page;
+  texture_atlas_t *atlas;
+  font_internal_page_sync(f, index);
+  page  = &f->cur->pages[index];
+  atlas = page->atlas;
+  if (!atlas->id) {
+    glGenTextures(1, &atlas->id);
+  }
+  glBindTexture(GL_TEXTURE_2D, atlas->id);
+  /* The first time we upload the full atlas, this is also where the texture storage gets allocated. */
+  if (!page->allocated) {
+    /* We repeat on the `s` axis, as the page index of a glyph is stored as the integer part of its `s` cordinate. */
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, atlas->width, atlas->height, 0, GL_RED, GL_UNSIGNED_BYTE, atlas->data);
+    page->allocated = TRUE;
+    page->dirty_top = 0;
+    page->dirty_bot = 0;
+  }
+  else {
+    /* Glyphs where loaded directly through the freetype font, so we do not know where they are. */
+    if (atlas->used != page->uploaded_used && page->dirty_top >= page->dirty_bot) {
+      font_internal_page_mark_dirty(page, 0, atlas->height);
+    }
+    if (page->dirty_top < page->dirty_bot) {
+      glTexSubImage2D(
+        GL_TEXTURE_2D, 0, 0, page->dirty_top, atlas->width, (page->dirty_bot - page->dirty_top),
+        GL_RED, GL_UNSIGNED_BYTE, (atlas->data + (page->dirty_top * atlas->width * atlas->depth))
+      );
+      page->dirty_top = 0;
+      page->dirty_bot = 0;
+    }
+  }
+  page->uploaded_used = atlas->used;
+}
+
+/* ----------------------------- Font internal prefetch task ----------------------------- */
+
+/* Runs on a worker thread, and loads the freetype font of a primary page and then rasterizes all printable ascii glyphs into it. */
+static void *font_internal_prefetch_task(void *arg) {
+  ASSERT(arg);
+  FontPrefetchPackage *p = arg;
+  FontPage *page = p->page;
+  page->font = texture_font_new_from_file(page->atlas, p->size, p->path);
+  if (page->font) {
+    font_internal_page_raster_task(page);
+  }
+  free(p->path);
+  free(p);
+  return page;
+}
+
+/* ----------------------------- Font internal prefetch ----------------------------- */
+
+/* Start loading `size` in the background, when it is not already loaded. */
+static void font_internal_prefetch(Font *const f, Uint size) {
   ASSERT(f);
   ASSERT(f->path);
-  ASSERT(f->atlas);
-  texture_font_free(f->font);
-  f->font = texture_font_new_from_file(f->atlas, f->size, f->path);
+  FontSize *fs;
+  FontPage *page;
+  FontPrefetchPackage *p;
+  if (size < FONT_MIN_SIZE || font_internal_size_find(f, size) != -1) {
+    return;
+  }
+  fs   = font_internal_size_create(size);
+  page = &fs->pages[0];
+  page->atlas         = texture_atlas_new(f->atlas_size, f->atlas_size, 1);
+  page->font          = NULL;
+  page->last_used     = 0;
+  page->uploaded_used = 0;
+  page->dirty_top     = 0;
+  page->dirty_bot     = 0;
+  page->allocated     = FALSE;
+  fs->npages    = 1;
+  /* Prefetched sizes have never been used, so they are the first to go. */
+  fs->last_used = 0;
+  p = xmalloc(sizeof(*p));
+  p->page = page;
+  p->path = copy_of(f->path);
+  p->size = size;
+  page->raster = nfuture_submit(font_internal_prefetch_task, p);
+  font_internal_size_add(f, fs);
+}
+
+/* ----------------------------- Font internal prefetch neighbors ----------------------------- */
+
+/* Start loading the sizes around the current size in the background, so that zooming in or out does not have to wait for them. */
+static void font_internal_prefetch_neighbors(Font *const f) {
+  ASSERT(f);
+  ASSERT(f->cur);
+  for (Uint i=1; i<=FONT_PREFETCH_RADIUS; ++i) {
+    font_internal_prefetch(f, (f->cur->size + i));
+    if (f->cur->size > i) {
+      font_internal_prefetch(f, (f->cur->size - i));
+    }
+  }
+}
+
+/* ----------------------------- Font internal prerasterize ----------------------------- */
+
+/* Start rasterizing the printable ascii glyphs into the primary page on a worker thread. */
+static inline void font_internal_prerasterize(Font *const f) {
+  ASSERT(f);
+  ASSERT(f->cur->npages);
+  ASSERT(!f->cur->pages[0].raster);
+  f->cur->pages[0].raster = nfuture_submit(font_internal_page_raster_task, &f->cur->pages[0]);
 }
 
 /* ----------------------------- Font internal load fallback ----------------------------- */
@@ -126,22 +630,64 @@ static inline void font_internal_load_fallback(Font *const f) {
     "  \"[NanoX-Source-Directory]/fonts/unifont.ttf\" to \"/etc/nanox/fonts/unifont.ttf\"."
   );
   font_internal_set_path(f, FALLBACK_FONT_PATH);
-  font_internal_load_atlas(f);
-  font_internal_load_font(f);
-  ALWAYS_ASSERT_MSG(f->font, "Failed to load the fallback font");
+  font_internal_clear_cache(f);
+  f->cur = font_internal_size_create(f->size);
+  font_internal_size_add(f, f->cur);
+  ALWAYS_ASSERT_MSG(font_internal_page_open(f), "Failed to load the fallback font");
 }
 
 /* ----------------------------- Font internal reload ----------------------------- */
 
-/* Free's both the internal atlas and font and recreates them based on the internal `path`, `size`, `atlas_size`. */
+/* Free's all loaded sizes and recreates the primary page based on the internal `path`, `size`, `atlas_size`. */
 static inline void font_internal_reload(Font *const f) {
   ASSERT(f);
   ASSERT(f->path);
-  font_internal_load_atlas(f);
-  font_internal_load_font(f);
-  if (!f->font) {
+  font_internal_clear_cache(f);
+  f->cur = font_internal_size_create(f->size);
+  font_internal_size_add(f, f->cur);
+  if (!font_internal_page_open(f)) {
     font_internal_load_fallback(f);
   }
+  font_internal_prerasterize(f);
+  font_internal_prefetch_neighbors(f);
+}
+
+/* ----------------------------- Font internal set size ----------------------------- */
+
+/* Make `f->size` the current size.  When it is already loaded, either because it was used before or because it was loaded ahead
+ * of time, this is just a swap.  Otherwise we load it here.  In both cases the sizes around the new size are then loaded in the background. */
+static void font_internal_set_size(Font *const f) {
+  ASSERT(f);
+  ASSERT(f->path);
+  FontSize *prev = f->cur;
+  FontSize *fs;
+  int index = font_internal_size_find(f, f->size);
+  prev->last_used = frame_elapsed();
+  if (index != -1) {
+    f->cur = f->cache[index];
+    font_internal_page_sync(f, 0);
+    /* The worker failed to load the font at this size, so throw it away and load it here instead. */
+    if (!f->cur->pages[0].font) {
+      f->cur = prev;
+      font_internal_size_drop(f, index);
+      index = -1;
+    }
+  }
+  if (index == -1) {
+    fs = font_internal_size_create(f->size);
+    font_internal_size_add(f, fs);
+    f->cur = fs;
+    if (!font_internal_page_open(f)) {
+      /* Keep the size we had, as the font cannot be loaded at this size. */
+      f->cur  = prev;
+      f->size = prev->size;
+      font_internal_size_drop(f, font_internal_size_find(f, fs->size));
+      return;
+    }
+    font_internal_prerasterize(f);
+  }
+  f->cur->last_used = frame_elapsed();
+  font_internal_prefetch_neighbors(f);
 }
 
 
@@ -156,9 +702,10 @@ Font *font_create(void) {
   /* Zero init the base attributes needed to load a font. */
   f->size = 0;
   f->path = NULL;
-  /* Zero init the atlas and font ptr's that make up the font. */
-  f->atlas = NULL;
-  f->font  = NULL;
+  f->atlas_size = 0;
+  /* Zero init the size cache that holds the pages that make up the font. */
+  f->cur    = NULL;
+  f->ncache = 0;
   /* Zero init the extra config options of the font. */
   f->line_height = 0;
   return f;
@@ -172,9 +719,8 @@ void font_free(Font *const f) {
   if (!f) {
     return;
   }
+  font_internal_clear_cache(f);
   free(f->path);
-  texture_atlas_free(f->atlas);
-  texture_font_free(f->font);
   free(f);
 }
 
@@ -188,6 +734,8 @@ void font_load(Font *const f, const char *const restrict path, Uint size, Uint a
   /* If the given path does not exist, set the fallback font path as the path. */
   if (!file_exists(path)) {
     font_internal_load_fallback(f);
+    font_internal_prerasterize(f);
+    font_internal_prefetch_neighbors(f);
   }
   /* Otherwise, just use the given path. */
   else {
@@ -198,18 +746,20 @@ void font_load(Font *const f, const char *const restrict path, Uint size, Uint a
 
 /* ----------------------------- Font get font ----------------------------- */
 
-/* Return's the internal `texture_font_t *` of `f`. */
+/* Return's the internal `texture_font_t *` of the primary page of `f`. */
 texture_font_t *font_get_font(Font *const f) {
   ASSERT_FONT;
-  return f->font;
+  font_internal_page_sync(f, 0);
+  return GF_FONT;
 }
 
 /* ----------------------------- Font get atlas ----------------------------- */
 
-/* Return's the internal `texture_atlas_t *` of `f`. */
+/* Return's the internal `texture_atlas_t *` of the primary page of `f`. */
 texture_atlas_t *font_get_atlas(Font *const f) {
   ASSERT_FONT;
-  return f->atlas;
+  font_internal_page_sync(f, 0);
+  return f->cur->pages[0].atlas;
 }
 
 /* ----------------------------- Font get glyph ----------------------------- */
@@ -217,7 +767,20 @@ texture_atlas_t *font_get_atlas(Font *const f) {
 /* Return's the glyph assisiated with `codepoint`. */
 texture_glyph_t *font_get_glyph(Font *const f, const char *const restrict codepoint) {
   ASSERT_FONT;
-  texture_glyph_t *glyph = texture_font_get_glyph(f->font, codepoint);
+  Uint page;
+  texture_glyph_t *glyph = font_internal_get_glyph(f, codepoint, &page);
+  ALWAYS_ASSERT(glyph);
+  return glyph;
+}
+
+/* ----------------------------- Font get glyph page ----------------------------- */
+
+/* Return's the glyph assisiated with `codepoint`, and assigns the atlas page it lives in to `*outpage`.  The page has to be
+ * added to the `s` coordinates of the glyph when drawing it, like `font_add_glyph()` does, as the glyph is only valid in that page. */
+texture_glyph_t *font_get_glyph_page(Font *const f, const char *const restrict codepoint, Uint *const outpage) {
+  ASSERT_FONT;
+  ASSERT(outpage);
+  texture_glyph_t *glyph = font_internal_get_glyph(f, codepoint, outpage);
   ALWAYS_ASSERT(glyph);
   return glyph;
 }
@@ -251,7 +814,9 @@ long font_get_line_height(Font *const f) {
 /* Return's `TRUE` if the currently loaded font in `f` is a `mono` font. */
 bool font_is_mono(Font *const f) {
   ASSERT_FONT;
-  return texture_font_is_mono(f->font);
+  /* The primary page can still be written to by the pre-rasterizing, so wait for that before reading from it. */
+  font_internal_page_sync(f, 0);
+  return texture_font_is_mono(GF_FONT);
 }
 
 /* ----------------------------- Font height ----------------------------- */
@@ -305,7 +870,7 @@ void font_change_size(Font *const f, Uint new_size) {
     return;
   }
   f->size = new_size;
-  font_internal_reload(f);
+  font_internal_set_size(f);
 }
 
 /* ----------------------------- Font increase size ----------------------------- */
@@ -313,15 +878,18 @@ void font_change_size(Font *const f, Uint new_size) {
 void font_increase_size(Font *const f) {
   ASSERT_FONT;
   ++f->size;
-  font_internal_reload(f);
+  font_internal_set_size(f);
 }
 
 /* ----------------------------- Font decrease size ----------------------------- */
 
 void font_decrease_size(Font *const f) {
   ASSERT_FONT;
+  if (f->size <= FONT_MIN_SIZE) {
+    return;
+  }
   --f->size;
-  font_internal_reload(f);
+  font_internal_set_size(f);
 }
 
 /* ----------------------------- Font decrease line height ----------------------------- */
@@ -348,12 +916,13 @@ void font_rows_cols(Font *const f, float width, float height, int *const outrows
   int cols;
   texture_glyph_t *glyph;
   if (outcols) {
-    if (texture_font_is_mono(f->font)) {
+    font_internal_page_sync(f, 0);
+    if (texture_font_is_mono(GF_FONT)) {
       glyph = font_get_glyph(f, " ");
       cols = (width / glyph->advance_x);
     }
     else {
-      cols = ((width / FONT_WIDTH(f->font)) * 0.9f);
+      cols = ((width / FONT_WIDTH(GF_FONT)) * 0.9f);
     }
     *outcols = cols;
   }
@@ -415,9 +984,33 @@ bool font_row_from_pos(Font *const f, float y_top, float y_bot, float y_pos, lon
 
 /* ----------------------------- Font index from pos ----------------------------- */
 
+/* Return's the index in `string` closest to `rawx`, where `normx` is the start position of the string. */
 Ulong font_index_from_pos(Font *const f, const char *const restrict string, Ulong len, float rawx, float normx) {
   ASSERT_FONT;
-  return strpx_str_index(f->font, string, len, rawx, normx);
+  ASSERT(string);
+  Ulong ret = 0;
+  float end = normx;
+  float closest = absf(normx - rawx);
+  const char *current;
+  const char *prev = NULL;
+  for (Ulong i=0; i<len && string[i]; i+=char_length(&string[i]), prev=current) {
+    /* Tabulators are drawn as `tabsize` spaces. */
+    if (*(current = &string[i]) == '\t') {
+      current = " ";
+      end += font_internal_glyphlen(f, current, prev);
+      if (tabsize > 1) {
+        end += (font_internal_glyphlen(f, current, " ") * (tabsize - 1));
+      }
+    }
+    else {
+      end += font_internal_glyphlen(f, current, prev);
+    }
+    if (absf(end - rawx) < closest) {
+      ret     = (i + char_length(&string[i]));
+      closest = absf(end - rawx);
+    }
+  }
+  return ret;
 }
 
 /* ----------------------------- Font breadth ----------------------------- */
@@ -427,7 +1020,7 @@ float font_breadth(Font *const f, const char *const restrict string) {
   ASSERT(string);
   float ret = 0;
   for (const char *ch=string, *prev=NULL; *ch; ch += char_length(ch)) {
-    ret += strpx_glyphlen(ch, prev, f->font);
+    ret += font_internal_glyphlen(f, ch, prev);
     prev = ch;
   }
   return ret;
@@ -440,7 +1033,7 @@ float font_wideness(Font *const f, const char *const restrict string, Ulong to_i
   ASSERT(string);
   float ret = 0;
   for (const char *ch=string, *prev=NULL; *ch && ch<(string + to_index); ch += char_length(ch)) {
-    ret += strpx_glyphlen(ch, prev, f->font);
+    ret += font_internal_glyphlen(f, ch, prev);
     prev = ch;
   }
   return ret;
@@ -459,8 +1052,12 @@ void font_add_glyph(Font *const f, vertex_buffer_t *const buf, const char *const
   float x1;
   float y0;
   float y1;
+  float s0;
+  float s1;
+  Uint page;
   FontVertex vertices[4];
-  texture_glyph_t *glyph = font_get_glyph(f, current);
+  texture_glyph_t *glyph = font_internal_get_glyph(f, current, &page);
+  ALWAYS_ASSERT(glyph);
   if (prev) {
     (*pen_x) += texture_glyph_get_kerning(glyph, prev);
   }
@@ -468,11 +1065,14 @@ void font_add_glyph(Font *const f, vertex_buffer_t *const buf, const char *const
   y0 = (int)((*pen_y) - glyph->offset_y);
   x1 = (int)(x0 + glyph->width);
   y1 = (int)(y0 + glyph->height);
+  /* The page the glyph lives in is stored as the integer part of `s`, the texture repeats so this samples the same texel. */
+  s0 = (glyph->s0 + page);
+  s1 = (glyph->s1 + page);
   UNPACK_FUINT_VARS(color, r,g,b,a);
-  vertices[0] = (FontVertex){ x0,y0, glyph->s0,glyph->t0, r,g,b,a };
-  vertices[1] = (FontVertex){ x0,y1, glyph->s0,glyph->t1, r,g,b,a };
-  vertices[2] = (FontVertex){ x1,y1, glyph->s1,glyph->t1, r,g,b,a };
-  vertices[3] = (FontVertex){ x1,y0, glyph->s1,glyph->t0, r,g,b,a };
+  vertices[0] = (FontVertex){ x0,y0, s0,glyph->t0, r,g,b,a };
+  vertices[1] = (FontVertex){ x0,y1, s0,glyph->t1, r,g,b,a };
+  vertices[2] = (FontVertex){ x1,y1, s1,glyph->t1, r,g,b,a };
+  vertices[3] = (FontVertex){ x1,y0, s1,glyph->t0, r,g,b,a };
   vertex_buffer_push_back(buf, vertices, 4, FONT_INDICES, FONT_INDICES_LEN);
   (*pen_x) += glyph->advance_x;
 }
@@ -501,15 +1101,56 @@ void font_vertbuf_add_mbstr(Font *const f, vertex_buffer_t *buf, const char *str
 
 /* ----------------------------- Font upload texture atlas ----------------------------- */
 
-/* Upload a atlas texture. */
+/* Upload the rows of every page that changed since the last upload, and leave the primary page bound. */
 void font_upload_texture_atlas(Font *const f) {
   ASSERT_FONT;
-  glBindTexture(GL_TEXTURE_2D, f->atlas->id);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-  glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, f->atlas->width, f->atlas->height, 0, GL_RED, GL_UNSIGNED_BYTE, f->atlas->data);
+  for (Uint i=f->cur->npages; i-- > 0;) {
+    font_internal_page_upload(f, i);
+  }
+}
+
+/* ----------------------------- Font render vertbuf ----------------------------- */
+
+/* Render `buf` using the pages of `f`.  Note that the font shader must be in use.  As every glyph is its own item in the
+ * buffer, we draw each run of glyphs from the same page with one draw call, and when there is only one page we draw it all at once. */
+void font_render_vertbuf(Font *const f, vertex_buffer_t *const buf) {
+  ASSERT_FONT;
+  ASSERT(buf);
+  Ulong nitems;
+  Uint page;
+  Uint run_page = 0;
+  const ivec4 *item;
+  const ivec4 *run_start = NULL;
+  const ivec4 *run_end   = NULL;
+  font_upload_texture_atlas(f);
+  if (f->cur->npages == 1) {
+    vertex_buffer_render(buf, GL_TRIANGLES);
+    frame_count_draw_calls(1);
+    return;
+  }
+  nitems = vector_size(buf->items);
+  vertex_buffer_render_setup(buf, GL_TRIANGLES);
+  for (Ulong i=0; i<=nitems; ++i) {
+    item = ((i < nitems) ? vector_get(buf->items, i) : NULL);
+    page = (item ? (Uint)((const FontVertex *)vector_get(buf->vertices, item->x))->s : 0);
+    /* Flush the current run when we reach the end, or the page changes. */
+    if (run_start && (!item || page != run_page)) {
+      glBindTexture(GL_TEXTURE_2D, f->cur->pages[run_page].atlas->id);
+      glDrawElements(
+        GL_TRIANGLES, ((run_end->z + run_end->w) - run_start->z), GL_UNSIGNED_INT, (void *)(run_start->z * sizeof(Uint))
+      );
+      frame_count_draw_calls(1);
+      run_start = NULL;
+    }
+    if (item) {
+      if (!run_start) {
+        run_start = item;
+        run_page  = ((page < f->cur->npages) ? page : 0);
+      }
+      run_end = item;
+    }
+  }
+  vertex_buffer_render_finish(buf);
 }
 
 /* ----------------------------- Font add cursor ----------------------------- */
@@ -520,8 +1161,8 @@ void font_add_cursor(Font *const f, vertex_buffer_t *const buf, long row, Uint c
   float y0 = ROUNDF(GF_ROW_TOP(row) + rowzero_y);
   float x1 = (x0 + 1);
   float y1 = ROUNDF(GF_ROW_BOT(row) + rowzero_y);
-  /* We use the NULL texture of font to make the cursor. */
-  texture_glyph_t *glyph = texture_font_get_glyph(f->font, NULL);
+  /* We use the NULL texture of the primary page to make the cursor. */
+  texture_glyph_t *glyph = font_get_glyph(f, NULL);
   UNPACK_FUINT_VARS(color, r,g,b,a);
   FontVertex vert[] = {
     { x0,y0, glyph->s0,glyph->t0, r,g,b,a },
@@ -531,3 +1172,40 @@ void font_add_cursor(Font *const f, vertex_buffer_t *const buf, long row, Uint c
   };
   vertex_buffer_push_back(buf, ARRAY__LEN(vert), ARRAY__LEN(FONT_INDICES));
 }
+
+
+/* -------------------------------------------------------- Tests -------------------------------------------------------- */
+
+
+/* ----------------------------- Font test evict ----------------------------- */
+
+/* Load new glyphs into a small atlas for a number of frames, uploading the atlas every frame the same way the renderer
+ * does, and assert that the pages filled up and the least recently used one was evicted.  This needs a gl context. */
+void font_test_evict(void) {
+  Font *f = font_create();
+  char mb[MAXCHARLEN + 1];
+  Uint wc = 0x4E00;
+  Ulong first_key = 0;
+  Ulong key;
+  font_load(f, FALLBACK_FONT_PATH, 16, FONT_TEST_ATLAS_SIZE);
+  for (int frame=0; frame<FONT_TEST_FRAMES; ++frame) {
+    frame_start();
+    for (int i=0; i<FONT_TEST_GLYPHS_PER_FRAME; ++i, ++wc) {
+      mb[widetomb(wc, mb)] = '\0';
+      ALWAYS_ASSERT(font_get_glyph(f, mb));
+      key = font_internal_codepoint_key(mb);
+      /* Remember the first glyph that did not fit in the primary page, as that page is never evicted. */
+      if (!first_key && (Ulong)hnmap_get(f->cur->glyphmap, key) > 1) {
+        first_key = key;
+      }
+    }
+    font_upload_texture_atlas(f);
+    frame_end();
+  }
+  ALWAYS_ASSERT_MSG((f->cur->npages == FONT_MAX_PAGES), "The atlas pages never filled up");
+  ALWAYS_ASSERT(first_key);
+  /* That glyph lives in a page that has not been used since, so it must have been evicted. */
+  ALWAYS_ASSERT_MSG(!hnmap_get(f->cur->glyphmap, first_key), "No atlas page was evicted");
+  font_free(f);
+  writef("\n%s: Loaded %u glyphs into %u pages, and the least recently used page was evicted\n\n", __func__, (wc - 0x4E00), (Uint)FONT_MAX_PAGES);
+}
@@ -5,6 +5,7 @@
 
  */
 #include "../../include/c_proto.h"
+#include "../perf/nperf.h"
 
 
 /* ---------------------------------------------------------- Define's ---------------------------------------------------------- */
@@ -29,6 +30,12 @@ static int framerate = 60;
 static Llong expected_frametime = FRAME_SWAP_RATE_TIME_NS_INT(60);
 /* The total time that passed during the previous frame in `nano-seconds`. */
 static Llong frametime = 0;
+/* The time the previous frame spent doing actual work, so without the sleep at the end, in `nano-seconds`. */
+static Llong worktime = 0;
+/* The number of draw calls made during the current frame. */
+static Ulong draw_calls = 0;
+/* The number of draw calls made during the previous frame. */
+static Ulong prev_draw_calls = 0;
 /* Total number of elapsed frames. */
 static Ulong elapsed_frames = 0;
 /* Frame start time. */
@@ -77,7 +84,10 @@ static inline bool frame_samples_within_tolerance(void) {
 
 /* Print the time the last elapsed frame took from start to finish. */
 static inline void frame_log_time(void) {
-  log_INFO_0("Frame: %lu: %.4f ms", elapsed_frames, NANO_TO_MILLI(frametime));
+  log_INFO_0(
+    "Frame: %lu: %.4f ms: Work: %.4f ms: Draw calls: %lu",
+    elapsed_frames, NANO_TO_MILLI(frametime), NANO_TO_MILLI(worktime), prev_draw_calls
+  );
 }
 
 /* ----------------------------- Frame log poll ----------------------------- */
@@ -120,6 +130,13 @@ void frame_start(void) {
 void frame_end(void) {
   clock_gettime(CLOCK_MONOTONIC, &t1);
   frametime = TIMESPEC_ELAPSED_NS(&t0, &t1);
+  worktime  = frametime;
+  /* Only the work counts, as the sleep below just waits for the next swap. */
+  if (nperf_collecting()) {
+    nperf_record_ns(NPERF_FRAME, worktime);
+  }
+  prev_draw_calls = draw_calls;
+  draw_calls      = 0;
   /* If less time has passed then a full frame, we sleep the remaining time away. */
   if (frametime < expected_frametime) {
     hiactime_sleep_total_duration(&t0, &t1, expected_frametime);
@@ -161,6 +178,27 @@ Llong frame_get_time_ns(void) {
   return frametime;
 }
 
+/* ----------------------------- Frame get work time ms ----------------------------- */
+
+/* Return the time the previous frame spent before sleeping in `milli-seconds`. */
+double frame_get_work_time_ms(void) {
+  return NANO_TO_MILLI(worktime);
+}
+
+/* ----------------------------- Frame count draw calls ----------------------------- */
+
+/* Add `n` draw calls to the count for the current frame. */
+void frame_count_draw_calls(Ulong n) {
+  draw_calls += n;
+}
+
+/* ----------------------------- Frame get draw calls ----------------------------- */
+
+/* Returns the number of draw calls made during the previous frame. */
+Ulong frame_get_draw_calls(void) {
+  return prev_draw_calls;
+}
+
 /* ----------------------------- Frame should poll ----------------------------- */
 
 /* Only performs the frame polling logic when `should_poll` is
@@ -5,12 +5,13 @@
 
  */
 #include "../../include/c_proto.h"
+#include "../perf/nperf.h"
 
 
 /* ---------------------------------------------------------- Define's ---------------------------------------------------------- */
 
 
-#define ELEMENT_GRID_CELL_SIZE  (20)
+#define ELEMENT_GRID_MARGIN  (20)
 
 
 /* ---------------------------------------------------------- Static function's ---------------------------------------------------------- */
@@ -37,7 +38,7 @@ static void gl_loop_init_glew(void) {
 /* ----------------------------- Gl loop init ----------------------------- */
 
 static void gl_loop_init(void) {
-  element_grid_create(ELEMENT_GRID_CELL_SIZE);
+  element_grid_create(ELEMENT_GRID_MARGIN);
   gl_window_init();
   gl_loop_init_glew();
   gl_mouse_init();
@@ -77,11 +78,17 @@ static void gl_loop_clean(void) {
 /* ----------------------------- Gl loop ----------------------------- */
 
 void gl_loop(void) {
+  Llong perf_start;
   gl_loop_init();
   while (gl_window_running()) {
     frame_start();
     statusbar_count_frame();
+    process_pending_callbacks();
+    if (ISSET(PERF_OVERLAY)) {
+      nperf_report();
+    }
     if (frame_should_poll() || refresh_needed) {
+      perf_start = nperf_now();
       place_the_cursor();
       glClear(GL_COLOR_BUFFER_BIT);
       editor_check_should_close();
@@ -92,10 +99,14 @@ void gl_loop(void) {
       suggestmenu_draw();
       promptmenu_draw();
       statusbar_draw();
+      shader_rect_batch_flush();
       gl_window_swap();
       refresh_needed = FALSE; 
+      nperf_record(NPERF_REFRESH, perf_start);
     }
+    perf_start = nperf_now();
     gl_window_poll_events();
+    nperf_record(NPERF_INPUT, perf_start);
     frame_end();
   }
   gl_loop_clean();
@@ -50,6 +50,8 @@ typedef enum {
   MENU_WIDTH_IS_STATIC = (1 << 4),
   /* Whether right and left arrows allows for closing and opening submenu's. */
   MENU_ARROW_DEPTH_NAVIGATION = (1 << 5),
+  /* When filtering, entries that are identical to the filter are not shown. */
+  MENU_FILTER_EXCLUDE_EXACT = (1 << 6),
   /* Defines. */
 # define MENU_REFRESH_TEXT            MENU_REFRESH_TEXT
 # define MENU_REFRESH_POS             MENU_REFRESH_POS
@@ -57,6 +59,7 @@ typedef enum {
 # define MENU_ACCEPT_ON_TAB           MENU_ACCEPT_ON_TAB
 # define MENU_WIDTH_IS_STATIC         MENU_WIDTH_IS_STATIC
 # define MENU_ARROW_DEPTH_NAVIGATION  MENU_ARROW_DEPTH_NAVIGATION
+# define MENU_FILTER_EXCLUDE_EXACT    MENU_FILTER_EXCLUDE_EXACT
 # define MENU_HAS_LABLE_OFFSET        MENU_HAS_LABLE_OFFSET
   /* The Default flags used for initilizing. */
 # define MENU_XFLAGS_DEFAULT (MENU_REFRESH_TEXT | MENU_REFRESH_POS | MENU_REFRESH_WIDTH | MENU_ARROW_DEPTH_NAVIGATION)
@@ -69,6 +72,7 @@ typedef enum {
 typedef struct {
   /* When this menu-entry is a singular clickable thing, this is its name. */
   char *lable;
+  Ulong len;
   /* When this menu-entry is a submenu. */
   Menu *menu;
 } MenuEntry;
@@ -88,8 +92,22 @@ struct Menu {
   /* The element representing the selected rect to be drawn.  TODO: Maybe add a way to add additional rects to an element...? */
   Element *selelem;
   
+  /* All entries of this menu. */
   CVec *entries;
 
+  /* The entries that match the current filter, in the same order as `entries`.  This is what the menu shows, so all
+   * rows, the selected entry and the viewtop refer to this.  Note that this only holds ptrs, so filtering never allocates. */
+  MenuEntry **index;
+  int indexlen;
+  int indexcap;
+
+  /* All shown entries start with this, or `NULL` when the menu is not filtered. */
+  char *filter;
+  Ulong filterlen;
+
+  /* The number of entries that has a submenu, so that we only look for them when there are any. */
+  int submenus;
+
   /* What the viewtop was before the last update to it. */
   int was_viewtop;
 
@@ -127,7 +145,8 @@ struct Menu {
 /* Create a allocated `MenuEntry` structure with a `lable` and no menu ptr. */
 static MenuEntry *menu_entry_create(const char *const restrict lable) {
   MenuEntry *me = xmalloc(sizeof(*me));
-  me->lable = copy_of(lable);
+  me->len   = strlen(lable);
+  me->lable = measured_copy(lable, me->len);
   me->menu  = NULL;
   return me;
 }
@@ -153,6 +172,48 @@ static MenuEntry *menu_entry_create_with_menu(const char *const restrict lable,
   return me;
 }
 
+/* ----------------------------- Menu entry matches filter ----------------------------- */
+
+/* Return's `TRUE` when `me` should be shown with the current filter of `menu`. */
+static inline bool menu_entry_matches_filter(Menu *const menu, MenuEntry *const me) {
+  ASSERT(menu);
+  ASSERT(me);
+  if (!menu->filter) {
+    return TRUE;
+  }
+  else if (me->len < menu->filterlen || ((menu->xflags & MENU_FILTER_EXCLUDE_EXACT) && me->len == menu->filterlen)) {
+    return FALSE;
+  }
+  return (strncmp(me->lable, menu->filter, menu->filterlen) == 0);
+}
+
+/* ----------------------------- Menu index push ----------------------------- */
+
+static inline void menu_index_push(Menu *const menu, MenuEntry *const me) {
+  ASSERT(menu);
+  ASSERT(me);
+  if (menu->indexlen == menu->indexcap) {
+    menu->indexcap = (menu->indexcap ? (menu->indexcap * 2) : 32);
+    menu->index    = xrealloc(menu->index, (menu->indexcap * sizeof(*menu->index)));
+  }
+  menu->index[menu->indexlen++] = me;
+}
+
+/* ----------------------------- Menu index rebuild ----------------------------- */
+
+/* Rebuild the shown entries of `menu` from all entries, using the current filter. */
+static void menu_index_rebuild(Menu *const menu) {
+  ASSERT(menu);
+  MenuEntry *me;
+  menu->indexlen = 0;
+  for (int i=0; i<cvec_len(menu->entries); ++i) {
+    me = cvec_get(menu->entries, i);
+    if (menu_entry_matches_filter(menu, me)) {
+      menu_index_push(menu, me);
+    }
+  }
+}
+
 /* ----------------------------- Menu selected is above screen ----------------------------- */
 
 static inline bool menu_selected_is_above_screen(Menu *const menu) {
@@ -184,7 +245,7 @@ static void menu_scrollbar_update_routine(void *arg, float *total_length, Uint *
   Menu *menu = arg;
   ASSIGN_IF_VALID(total_length, (menu->element->height - (menu->border_size * 2)));
   ASSIGN_IF_VALID(start,        0);
-  ASSIGN_IF_VALID(total,        (cvec_len(menu->entries) - menu->rows));
+  ASSIGN_IF_VALID(total,        (menu->indexlen - menu->rows));
   ASSIGN_IF_VALID(visible,      menu->rows);
   ASSIGN_IF_VALID(current,      menu->viewtop);
   ASSIGN_IF_VALID(top_offset,   menu->border_size);
@@ -197,7 +258,7 @@ static void menu_scrollbar_update_routine(void *arg, float *total_length, Uint *
 static void menu_scrollbar_moving_routine(void *arg, long index) {
   ASSERT(arg);
   Menu *menu = arg;
-  menu->viewtop = lclamp(index, 0, (cvec_len(menu->entries) - menu->rows));
+  menu->viewtop = lclamp(index, 0, (menu->indexlen - menu->rows));
 }
 
 /* ----------------------------- Menu scrollbar create ----------------------------- */
@@ -214,7 +275,7 @@ static void menu_scrollbar_create(Menu *const menu) {
 /* Return's the `lable` of the entry at `index`. */
 static char *menu_get_entry_lable(Menu *const menu, int index) {
   ASSERT_MENU;
-  return ((MenuEntry *)cvec_get(menu->entries, index))->lable;
+  return menu->index[index]->lable;
 }
 
 /* ----------------------------- Menu get entry menu ----------------------------- */
@@ -222,7 +283,7 @@ static char *menu_get_entry_lable(Menu *const menu, int index) {
 /* Return's the `menu` of the entry at `index`. */
 static Menu *menu_get_entry_menu(Menu *const menu, int index) {
   ASSERT_MENU;
-  return ((MenuEntry *)cvec_get(menu->entries, index))->menu;
+  return menu->index[index]->menu;
 }
 
 /* ----------------------------- Menu event bounds ----------------------------- */
@@ -230,7 +291,7 @@ static Menu *menu_get_entry_menu(Menu *const menu, int index) {
 /* Assigns the global absolute y top and bottom position as well as the most right allowed x position. */
 static void menu_event_bounds(Menu *const menu, float *const top, float *const bot, float *const right) {
   ASSERT_MENU;
-  int len = cvec_len(menu->entries);
+  int len = menu->indexlen;
   if (len) {
     /* Top of the menu. */
     ASSIGN_IF_VALID(top, (menu->element->y + menu->border_size));
@@ -327,15 +388,15 @@ static void menu_check_submenu(Menu *const menu) {
 
 static float menu_calculate_width(Menu *const menu) {
   ASSERT_MENU;
-  int len = cvec_len(menu->entries);
+  int len = menu->indexlen;
   int longest_index;
   Ulong longest_string;
   Ulong value;
   if (len && !(menu->xflags & MENU_WIDTH_IS_STATIC) && (menu->xflags & MENU_REFRESH_WIDTH)) {
     longest_index = 0;
-    longest_string = strlen(menu_get_entry_lable(menu, 0));
+    longest_string = menu->index[0]->len;
     for (int i=1; i<len; ++i) {
-      if ((value = strlen(menu_get_entry_lable(menu, i))) > longest_string) {
+      if ((value = menu->index[i]->len) > longest_string) {
         longest_index = i;
         longest_string = value;
       }
@@ -358,7 +419,7 @@ static void menu_resize(Menu *const menu) {
   float y;
   float width;
   float height;
-  int len = cvec_len(menu->entries);
+  int len = menu->indexlen;
   /* If there are entries in the menu or we need to recalculate the position. */
   if (len && (menu->xflags & MENU_REFRESH_POS)) {
     /* Set the number of visable rows. */
@@ -424,7 +485,7 @@ static void menu_draw_text(Menu *const menu) {
       pen_x = ((menu->element->x + menu->border_size + 1) + menu->lable_offset);
       pen_y = (font_row_baseline(menu->font, row) + menu->element->y + menu->border_size + 1);
       str   = menu_get_entry_lable(menu, (menu->viewtop + row));
-      font_vertbuf_add_mbstr(menu->font, menu->buffer, str, strlen(str), NULL, PACKED_UINT(255, 255, 255, 255), &pen_x, &pen_y);
+      font_vertbuf_add_mbstr(menu->font, menu->buffer, str, menu->index[menu->viewtop + row]->len, NULL, PACKED_UINT(255, 255, 255, 255), &pen_x, &pen_y);
       ++row;
     }
     menu->was_viewtop = menu->viewtop;
@@ -445,7 +506,7 @@ static void menu_submenu_pos_routine(void *arg, float width, float height, float
   Menu *menu = arg;
   int index = 0;
   /* Get the true index of this submenu entry. */
-  while (((MenuEntry *)cvec_get(menu->parent->entries, index))->menu != menu) {
+  while (index < menu->parent->indexlen && menu->parent->index[index]->menu != menu) {
     ++index;
   }
   /* Then offset the index to the visible entries. */
@@ -466,7 +527,12 @@ static void menu_push_back_submenu(Menu *const menu, const char *const restrict
   ASSERT_MENU;
   ASSERT(lable);
   ASSERT(submenu);
-  cvec_push(menu->entries, menu_entry_create_with_menu(lable, submenu));
+  MenuEntry *me = menu_entry_create_with_menu(lable, submenu);
+  cvec_push(menu->entries, me);
+  if (menu_entry_matches_filter(menu, me)) {
+    menu_index_push(menu, me);
+  }
+  ++menu->submenus;
   menu->xflags |= MENU_REFRESH_WIDTH;
 }
 
@@ -474,7 +540,7 @@ static void menu_push_back_submenu(Menu *const menu, const char *const restrict
 
 static void menu_selected_up_internal(Menu *const menu) {
   ASSERT_MENU;
-  int len = cvec_len(menu->entries);
+  int len = menu->indexlen;
   if (len) {
     /* If we are at the first entry. */
     if (menu->selected == 0) {
@@ -510,7 +576,7 @@ static void menu_selected_up_internal(Menu *const menu) {
 
 static void menu_selected_down_internal(Menu *const menu) {
   ASSERT_MENU;
-  int len = cvec_len(menu->entries);
+  int len = menu->indexlen;
   if (len) {
     /* If we are at the last entry. */
     if (menu->selected == (len - 1)) {
@@ -528,7 +594,7 @@ static void menu_selected_down_internal(Menu *const menu) {
       }
       /* Otherwise, if the currently selected entry if fully off screen, adjust the viewtop so that the selected is the last visible entry. */
       else if (menu_selected_is_off_screen(menu)) {
-        menu->viewtop = fclamp(((menu->selected + 1) - menu->rows + 1), 0, (cvec_len(menu->entries) - menu->rows));
+        menu->viewtop = fclamp(((menu->selected + 1) - menu->rows + 1), 0, (menu->indexlen - menu->rows));
         /* Only update the scrollbar when the viewtop has changed. */
         scrollbar_refresh(menu->sb);
       }
@@ -575,6 +641,12 @@ Menu *menu_create(Element *const parent, Font *const font, void *data,
   menu->buffer = vertex_buffer_new(FONT_VERTBUF);
   /* Entries vector. */
   menu->entries = cvec_create_setfree(menu_entry_free);
+  menu->index     = NULL;
+  menu->indexlen  = 0;
+  menu->indexcap  = 0;
+  menu->filter    = NULL;
+  menu->filterlen = 0;
+  menu->submenus  = 0;
   /* Create the element of the menu. */
   menu->element = element_create(100, 100, 100, 100, TRUE);
   /* The default background color for menu's is black. */
@@ -628,6 +700,8 @@ void menu_free(Menu *const menu) {
   menu->selelem = NULL;
   vertex_buffer_delete(menu->buffer);
   cvec_free(menu->entries);
+  free(menu->index);
+  free(menu->filter);
   free(menu->sb);
   free(menu);
 }
@@ -646,7 +720,7 @@ void menu_draw(Menu *const menu) {
   ASSERT_MENU;
   Menu *submenu;
   /* Only draw the suggestmenu if there are any available suggestions. */
-  if (!(menu->element->xflags & ELEMENT_HIDDEN) && cvec_len(menu->entries)) {
+  if (!(menu->element->xflags & ELEMENT_HIDDEN) && menu->indexlen) {
     menu_resize(menu);
     /* Draw the main element of the suggestmenu. */
     element_draw(menu->element);
@@ -657,7 +731,7 @@ void menu_draw(Menu *const menu) {
     /* Draw the text of the suggestmenu entries. */
     menu_draw_text(menu);
     /* Recursivly draw all submenus of this menu, this way we can have any number of nested menus. */
-    for (int i=0; i<cvec_len(menu->entries); ++i) {
+    for (int i=0; menu->submenus && i<menu->indexlen; ++i) {
       if ((submenu = menu_get_entry_menu(menu, i))) {
         menu_draw(submenu);
       }
@@ -670,7 +744,11 @@ void menu_draw(Menu *const menu) {
 void menu_push_back(Menu *const menu, const char *const restrict string) {
   ASSERT_MENU;
   ASSERT(string);
-  cvec_push(menu->entries, menu_entry_create(string));
+  MenuEntry *me = menu_entry_create(string);
+  cvec_push(menu->entries, me);
+  if (menu_entry_matches_filter(menu, me)) {
+    menu_index_push(menu, me);
+  }
   menu->xflags |= MENU_REFRESH_WIDTH;
 }
 
@@ -781,7 +859,7 @@ void menu_submenu_enter(Menu *const menu) {
 void menu_routine_accept(Menu *const menu) {
   ASSERT_MENU;
   /* As a sanity check only perform any action when the menu is not empty. */
-  if (cvec_len(menu->entries)) {
+  if (menu->indexlen) {
     /* If the currently selected entry of `menu` does not have a submenu, call the accept routine for `menu`. */
     if (!menu_get_entry_menu(menu, menu->selected)) {
       /* Run the user's accept routine. */
@@ -809,7 +887,7 @@ void menu_routine_hover(Menu *const menu, float x_pos, float y_pos) {
   float bot;
   float right;
   /* Only perform any action when there are entries in the menu. */
-  if (cvec_len(menu->entries)) {
+  if (menu->indexlen) {
     /* Get the absolute values where events are allowed. */
     menu_event_bounds(menu, &top, &bot, &right);
     /* If `y_pos` relates to a valid row in the suggestmenu completion menu, then adjust the selected to that row. */
@@ -827,7 +905,7 @@ void menu_routine_scroll(Menu *const menu, bool direction, float x_pos, float y_
   float top;
   float bot;
   float right;
-  int len = cvec_len(menu->entries);
+  int len = menu->indexlen;
   /* Only do anything if there are more entries then rows in the menu then maximum number of rows allowed. */
   if (len > menu->maxrows) {
     /* Get the absolute values where events are allowed. */
@@ -852,7 +930,7 @@ void menu_routine_click(Menu *const menu, float x_pos, float y_pos) {
   float bot;
   float right;
   /* Only perform any action when there are entries in the menu. */
-  if (cvec_len(menu->entries)) {
+  if (menu->indexlen) {
     /* Get the absolute values where events are allowed. */
     menu_event_bounds(menu, &top, &bot, &right);
     if (y_pos >= top && y_pos <= bot && x_pos < right) {
@@ -870,6 +948,10 @@ void menu_routine_click(Menu *const menu, float x_pos, float y_pos) {
 void menu_clear_entries(Menu *const menu) {
   ASSERT_MENU;
   cvec_clear(menu->entries);
+  menu->indexlen  = 0;
+  menu->submenus  = 0;
+  menu->filter    = free_and_assign(menu->filter, NULL);
+  menu->filterlen = 0;
   menu->viewtop  = 0;
   menu->selected = 0;
   menu->xflags |= (MENU_REFRESH_TEXT | MENU_REFRESH_POS | MENU_REFRESH_WIDTH);
@@ -918,6 +1000,19 @@ void menu_behavior_arrow_depth_navigation(Menu *const menu, bool enable_arrow_de
   // menu->arrow_depth_navigation = enable_arrow_depth_navigation;
 }
 
+/* ----------------------------- Menu behavior filter exclude exact ----------------------------- */
+
+/* Configure's if `menu` should hide entries that are identical to the current filter. */
+void menu_behavior_filter_exclude_exact(Menu *const menu, bool exclude_exact) {
+  ASSERT_MENU;
+  if (exclude_exact) {
+    menu->xflags |= MENU_FILTER_EXCLUDE_EXACT;
+  }
+  else {
+    menu->xflags &= ~MENU_FILTER_EXCLUDE_EXACT;
+  }
+}
+
 /* ----------------------------- Menu set lable offset ----------------------------- */
 
 void menu_set_lable_offset(Menu *const menu, Ushort pixels) {
@@ -980,7 +1075,7 @@ bool menu_is_ancestor(Menu *const menu, Menu *const ancestor) {
 /* Return's `TRUE` when `menu` is currently being shown and has more then zero entries. */
 bool menu_is_shown(Menu *const menu) {
   ASSERT_MENU;
-  return (!(menu->element->xflags & ELEMENT_HIDDEN) && cvec_len(menu->entries));
+  return (!(menu->element->xflags & ELEMENT_HIDDEN) && menu->indexlen);
 }
 
 /* ----------------------------- Menu get font ----------------------------- */
@@ -994,7 +1089,7 @@ Font *menu_get_font(Menu *const menu) {
 
 int menu_len(Menu *const menu) {
   ASSERT_MENU;
-  return cvec_len(menu->entries);
+  return menu->indexlen;
 }
 
 /* ----------------------------- Menu qsort cb strlen ----------------------------- */
@@ -1003,8 +1098,8 @@ int menu_len(Menu *const menu) {
 int menu_qsort_cb_strlen(const void *a, const void *b) {
   const MenuEntry *lhs = *(const MenuEntry **)a;
   const MenuEntry *rhs = *(const MenuEntry **)b;
-  long lhs_len = strlen(lhs->lable);
-  long rhs_len = strlen(rhs->lable);
+  long lhs_len = lhs->len;
+  long rhs_len = rhs->len;
   if (lhs_len == rhs_len) {
     return strcmp(lhs->lable, rhs->lable);
   }
@@ -1013,8 +1108,46 @@ int menu_qsort_cb_strlen(const void *a, const void *b) {
 
 /* ----------------------------- Menu qsort ----------------------------- */
 
+/* Sort all entries of `menu`.  The shown entries keep this order, so filtering never needs to sort again. */
 void menu_qsort(Menu *const menu, CmpFuncPtr cmp_func) {
   ASSERT_MENU;
   cvec_qsort(menu->entries, cmp_func);
+  menu_index_rebuild(menu);
+  menu->xflags |= MENU_REFRESH_TEXT;
+}
+
+/* ----------------------------- Menu filter ----------------------------- */
+
+/* Only show the entries of `menu` that start with `prefix`, or all entries when `prefix` is `NULL`.  When `prefix`
+ * only extends the current filter, like when the user types, only the currently shown entries are checked. */
+void menu_filter(Menu *const menu, const char *const restrict prefix) {
+  ASSERT_MENU;
+  int newlen = 0;
+  Ulong len = (prefix ? strlen(prefix) : 0);
+  /* Nothing has changed. */
+  if ((!prefix && !menu->filter) || (prefix && menu->filter && len == menu->filterlen && strcmp(prefix, menu->filter) == 0)) {
+    return;
+  }
+  /* The new filter extends the current one, so the shown entries can only become fewer. */
+  else if (prefix && menu->filter && len > menu->filterlen && strncmp(prefix, menu->filter, menu->filterlen) == 0) {
+    menu->filter    = xstrcpy(menu->filter, prefix);
+    menu->filterlen = len;
+    for (int i=0; i<menu->indexlen; ++i) {
+      if (menu_entry_matches_filter(menu, menu->index[i])) {
+        menu->index[newlen++] = menu->index[i];
+      }
+    }
+    menu->indexlen = newlen;
+  }
+  else {
+    menu->filter    = free_and_assign(menu->filter, (prefix ? measured_copy(prefix, len) : NULL));
+    menu->filterlen = len;
+    menu_index_rebuild(menu);
+  }
+  menu->viewtop  = 0;
+  menu->selected = 0;
+  menu->xflags |= (MENU_REFRESH_TEXT | MENU_REFRESH_POS | MENU_REFRESH_WIDTH);
+  scrollbar_refresh(menu->sb);
+  refresh_needed = TRUE;
 }
 
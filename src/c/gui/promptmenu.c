@@ -55,6 +55,8 @@ typedef struct {
 
   Menu *menu;
   CVec *completions;
+  /* The directory the current completions were read from, so we only read it again when it changes. */
+  char *searched_dir;
 
   /* The current mode we are in. */
   PromptMenuType mode;
@@ -125,36 +127,37 @@ static inline void promptmenu_add_cursor(void) {
 
 /* ----------------------------- Promptmenu find completions ----------------------------- */
 
-static void promptmenu_find_completions(void) {
+/* Show the completions that match the current answer.  The menu entries are only rebuilt and sorted when the completions
+ * themselves has changed, otherwise the menu is just filtered, which when the user types only checks the shown entries. */
+static void promptmenu_find_completions(bool reload) {
   ASSERT_PM;
   HashMap *map;
   char *entry;
-  Ulong j;
-  Ulong len;
-  menu_clear_entries(pm->menu);
-  if (cvec_len(pm->completions)) {
-    map = hashmap_create();
-    len = strlen(answer);
-    for (int i=0; i<cvec_len(pm->completions); ++i) {
-      entry = cvec_get(pm->completions, i);
-      /* When the first byte does not match, just continue. */
-      if (*entry != *answer) {
-        continue;
-      }
-      /* Otherwise, check the rest. */
-      for (j=1; j<len && (entry[j] == answer[j]); ++j);
-      /* All bytes did not match.  Or, the entry is already in the map. */
-      if (j < len || hashmap_get(map, entry)) {
-        continue;
+  if (reload) {
+    menu_clear_entries(pm->menu);
+    if (cvec_len(pm->completions)) {
+      map = hashmap_create();
+      for (int i=0; i<cvec_len(pm->completions); ++i) {
+        entry = cvec_get(pm->completions, i);
+        /* The entry is already in the map. */
+        if (hashmap_get(map, entry)) {
+          continue;
+        }
+        hashmap_insert(map, entry, entry);
+        menu_push_back(pm->menu, entry);
       }
-      hashmap_insert(map, entry, entry);
-      menu_push_back(pm->menu, entry);
+      hashmap_free(map);
+      menu_qsort(pm->menu, menu_qsort_cb_strlen);
     }
-    hashmap_free(map);
-    menu_qsort(pm->menu, menu_qsort_cb_strlen);
-    menu_refresh_text(pm->menu);
   }
-  /* If we did add some entries to the menu, we should show it. */
+  /* An empty answer matches nothing. */
+  if (*answer) {
+    menu_filter(pm->menu, answer);
+  }
+  else {
+    menu_clear_entries(pm->menu);
+  }
+  /* If there are any matching entries in the menu, we should show it. */
   if (menu_len(pm->menu)) {
     menu_show(pm->menu, TRUE);
     menu_refresh_pos(pm->menu);
@@ -166,31 +169,37 @@ static void promptmenu_find_completions(void) {
 
 /* ----------------------------- Promptmenu open file search ----------------------------- */
 
-static void promptmenu_dir_search(void) {
+/* Read the directory the answer points into as the completions.  Return's `TRUE` when the completions has changed. */
+static bool promptmenu_dir_search(void) {
   ASSERT_PM;
   directory_t dir;
   char *last_slash;
-  char *dirpath;
-  cvec_clear(pm->completions);
+  char *dirpath = NULL;
   if (*answer) {
-    directory_data_init(&dir);
     /* If the current answer is a dir itself. */
     if (dir_exists(answer)) {
-      directory_get(answer, &dir);
+      dirpath = copy_of(answer);
     }
     /* Otherwise, try the parent directory when there is a preceding slash. */
     else if ((last_slash = strrchr(answer, '/'))) {
       dirpath = measured_copy(answer, ((last_slash - answer) + 1));
-      directory_get(dirpath, &dir);
-      free(dirpath);
     }
     /* Otherwise, when non absolute path is used, try pwd. */
     /* else {
       dirpath = getpwd();
-      directory_get(dirpath, &dir);
-      FREE(dirpath);
     }
      * TODO: This needs some attention, as we need to add the non absolute paths to the completions. */
+  }
+  /* The completions are still from the same directory, so they only need to be filtered. */
+  if ((!dirpath && !pm->searched_dir) || (dirpath && pm->searched_dir && strcmp(dirpath, pm->searched_dir) == 0)) {
+    free(dirpath);
+    return FALSE;
+  }
+  cvec_clear(pm->completions);
+  pm->searched_dir = free_and_assign(pm->searched_dir, dirpath);
+  if (dirpath) {
+    directory_data_init(&dir);
+    directory_get(dirpath, &dir);
     if (dir.len) {
       DIRECTORY_ITER(dir, i, entry,
         cvec_push(pm->completions, copy_of(entry->path));
@@ -198,6 +207,7 @@ static void promptmenu_dir_search(void) {
     }
     directory_data_free(&dir);
   }
+  return TRUE;
 }
 
 /* ----------------------------- Promptmenu get x width ----------------------------- */
@@ -289,7 +299,7 @@ void promptmenu_create(void) {
   /* Ensure that when the root element is resized, the element keeps in the center. */
   pm->element->xflags |= (ELEMENT_HIDDEN | ELEMENT_CENTER_X | ELEMENT_CONSTRAIN_WIDTH | ELEMENT_SET_OWN_LAYER);
   /* For now just set the prompt-menu element's layer very high, to ensure it's always on top. */
-  pm->element->layer = 1000;
+  element_set_layer(pm->element, 1000);
   /* And also ensure that the menu and text of the prompt-menu is fully updated. */
   element_set_data_callback(pm->element, pm);
   element_set_extra_routine_rect(pm->element, promptmenu_extra_routine_rect);
@@ -301,6 +311,7 @@ void promptmenu_create(void) {
   pm->marked->color = PACKED_UINT_MARKED;
   element_set_parent(pm->marked, pm->element);
   pm->completions = cvec_create_setfree(free);
+  pm->searched_dir = NULL;
   pm->menu = menu_create(pm->element, uifont, pm, promptmenu_pos, promptmenu_accept);
   menu_set_lable_offset(pm->menu, font_breadth(uifont, " "));
   pm->mode = PROMPTMENU_TYPE_NONE;
@@ -319,6 +330,7 @@ void promptmenu_free(void) {
   ASSERT_PM;
   vertex_buffer_delete(pm->buf);
   cvec_free(pm->completions);
+  free(pm->searched_dir);
   menu_free(pm->menu);
   free(pm);
 }
@@ -368,6 +380,7 @@ void promptmenu_close(void) {
     menu_show(pm->menu, FALSE);
   }
   cvec_clear(pm->completions);
+  pm->searched_dir = free_and_assign(pm->searched_dir, NULL);
   pm->data.raw = NULL;
   refresh_needed = TRUE;
 }
@@ -417,17 +430,18 @@ void promptmenu_refresh_text(void) {
 
 void promptmenu_routine_completions_search(void) {
   ASSERT_PM;
+  bool reload = FALSE;
   switch (pm->mode) {
     case PROMPTMENU_TYPE_FILE_SAVE_BEFORE_CLOSE:
     case PROMPTMENU_TYPE_FILE_OPEN: {
-      promptmenu_dir_search();
+      reload = promptmenu_dir_search();
       break;
     }
     default: {
       break;
     }
   }
-  promptmenu_find_completions();
+  promptmenu_find_completions(reload);
 }
 
 /* ----------------------------- Promptmenu routine mouse click left ----------------------------- */
@@ -572,6 +586,12 @@ void promptmenu_routine_enter(void) {
       else if (strcasecmp(answer, "syntaxfile_test_read") == 0) {
         syntaxfile_test_read();
       }
+      else if (strcasecmp(answer, "element_grid_test_bench") == 0) {
+        element_grid_test_bench(gl_window_width(), gl_window_height());
+      }
+      else if (strcasecmp(answer, "font_test_evict") == 0) {
+        font_test_evict();
+      }
       else {
         promptmenu_close();
       }
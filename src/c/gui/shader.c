@@ -78,19 +78,36 @@
   "  frag_color = vec4(f_color.rgb, (f_color.a * a));"  "\n"  \
   "}"                                                   "\n"
 
-/* Rect shader openGL 2.0. */
-#define SHADER_RECT_VERT_DATA_120                                     \
-  "uniform mat4 projection;"                                    "\n"  \
-  "attribute vec2 vertex;"                                      "\n"  \
-  "attribute vec4 color;"                                       "\n"  \
-  "void main() {"                                               "\n"  \
-  "  gl_FrontColor = color;"                                    "\n"  \
-  "  gl_Position   = (projection * vec4(vertex, 0.0f, 1.0f));"  "\n"  \
-  "}"                                                           "\n"
-#define SHADER_RECT_FRAG_DATA_120         \
-  "void main() {"                   "\n"  \
-  "  gl_FragColor = gl_Color;"      "\n"  \
-  "}"                               "\n"
+/* Rect shader openGL 2.0.  Every rect is drawn as a quad, and the fragment shader uses the signed distance to a
+ * rounded box to get the coverage.  So a radius of zero is a regular rect, and anything else has rounded corners. */
+#define SHADER_RECT_VERT_DATA_120                                   \
+  "uniform mat4 projection;"                                  "\n"  \
+  "attribute vec2 vertex;"                                    "\n"  \
+  "attribute vec4 color;"                                     "\n"  \
+  "attribute vec4 rect;"                                      "\n"  \
+  "attribute float radius;"                                   "\n"  \
+  "varying vec4 f_color;"                                     "\n"  \
+  "varying vec2 f_pos;"                                       "\n"  \
+  "varying vec4 f_rect;"                                      "\n"  \
+  "varying float f_radius;"                                   "\n"  \
+  "void main() {"                                             "\n"  \
+  "  f_color  = color;"                                       "\n"  \
+  "  f_pos    = vertex;"                                      "\n"  \
+  "  f_rect   = rect;"                                        "\n"  \
+  "  f_radius = radius;"                                      "\n"  \
+  "  gl_Position = (projection * vec4(vertex, 0.0, 1.0));"    "\n"  \
+  "}"                                                         "\n"
+#define SHADER_RECT_FRAG_DATA_120                                                           \
+  "varying vec4 f_color;"                                                             "\n"  \
+  "varying vec2 f_pos;"                                                               "\n"  \
+  "varying vec4 f_rect;"                                                              "\n"  \
+  "varying float f_radius;"                                                           "\n"  \
+  "void main() {"                                                                     "\n"  \
+  "  vec2 half_size = (f_rect.zw * 0.5);"                                             "\n"  \
+  "  vec2 q = (abs(f_pos - (f_rect.xy + half_size)) - half_size + f_radius);"         "\n"  \
+  "  float d = (length(max(q, 0.0)) + min(max(q.x, q.y), 0.0) - f_radius);"           "\n"  \
+  "  gl_FragColor = vec4(f_color.rgb, (f_color.a * clamp((0.5 - d), 0.0, 1.0)));"     "\n"  \
+  "}"                                                                                 "\n"
 
 /* Rect shader openGL 3.0. */
 #define SHADER_RECT_VERT_DATA_130                                   \
@@ -98,18 +115,32 @@
   "uniform mat4 projection;"                                  "\n"  \
   "in vec2 vertex;"                                           "\n"  \
   "in vec4 color;"                                            "\n"  \
+  "in vec4 rect;"                                             "\n"  \
+  "in float radius;"                                          "\n"  \
   "out vec4 f_color;"                                         "\n"  \
+  "out vec2 f_pos;"                                           "\n"  \
+  "out vec4 f_rect;"                                          "\n"  \
+  "out float f_radius;"                                       "\n"  \
   "void main() {"                                             "\n"  \
-  "  f_color = color;"                                        "\n"  \
+  "  f_color  = color;"                                       "\n"  \
+  "  f_pos    = vertex;"                                      "\n"  \
+  "  f_rect   = rect;"                                        "\n"  \
+  "  f_radius = radius;"                                      "\n"  \
   "  gl_Position = (projection * vec4(vertex, 0.0f, 1.0f));"  "\n"  \
   "}"                                                         "\n"
-#define SHADER_RECT_FRAG_DATA_130         \
-  "#version 130"                    "\n"  \
-  "in vec4 f_color;"                "\n"  \
-  "out vec4 frag_color;"            "\n"  \
-  "void main() {"                   "\n"  \
-  "  frag_color = f_color;"         "\n"  \
-  "}"                               "\n"
+#define SHADER_RECT_FRAG_DATA_130                                                           \
+  "#version 130"                                                                      "\n"  \
+  "in vec4 f_color;"                                                                  "\n"  \
+  "in vec2 f_pos;"                                                                    "\n"  \
+  "in vec4 f_rect;"                                                                   "\n"  \
+  "in float f_radius;"                                                                "\n"  \
+  "out vec4 frag_color;"                                                              "\n"  \
+  "void main() {"                                                                     "\n"  \
+  "  vec2 half_size = (f_rect.zw * 0.5f);"                                            "\n"  \
+  "  vec2 q = (abs(f_pos - (f_rect.xy + half_size)) - half_size + f_radius);"         "\n"  \
+  "  float d = (length(max(q, 0.0f)) + min(max(q.x, q.y), 0.0f) - f_radius);"         "\n"  \
+  "  frag_color = vec4(f_color.rgb, (f_color.a * clamp((0.5f - d), 0.0f, 1.0f)));"    "\n"  \
+  "}"                                                                                 "\n"
 
 /* Rect shader openGL 3.3. */
 #define SHADER_RECT_VERT_DATA_330                                   \
@@ -117,18 +148,32 @@
   "uniform mat4 projection;"                                  "\n"  \
   "layout (location = 0) in vec2 vertex;"                     "\n"  \
   "layout (location = 1) in vec4 color;"                      "\n"  \
+  "layout (location = 2) in vec4 rect;"                       "\n"  \
+  "layout (location = 3) in float radius;"                    "\n"  \
   "out vec4 f_color;"                                         "\n"  \
+  "out vec2 f_pos;"                                           "\n"  \
+  "out vec4 f_rect;"                                          "\n"  \
+  "out float f_radius;"                                       "\n"  \
   "void main() {"                                             "\n"  \
-  "  f_color = color;"                                        "\n"  \
+  "  f_color  = color;"                                       "\n"  \
+  "  f_pos    = vertex;"                                      "\n"  \
+  "  f_rect   = rect;"                                        "\n"  \
+  "  f_radius = radius;"                                      "\n"  \
   "  gl_Position = (projection * vec4(vertex, 0.0f, 1.0f));"  "\n"  \
   "}"                                                         "\n"
-#define SHADER_RECT_FRAG_DATA_330  \
-  "#version 330 core"        "\n"  \
-  "in vec4 f_color;"         "\n"  \
-  "out vec4 frag_color;"     "\n"  \
-  "void main() {"            "\n"  \
-  "  frag_color = f_color;"  "\n"  \
-  "}"                        "\n"
+#define SHADER_RECT_FRAG_DATA_330                                                           \
+  "#version 330 core"                                                                 "\n"  \
+  "in vec4 f_color;"                                                                  "\n"  \
+  "in vec2 f_pos;"                                                                    "\n"  \
+  "in vec4 f_rect;"                                                                   "\n"  \
+  "in float f_radius;"                                                                "\n"  \
+  "out vec4 frag_color;"                                                              "\n"  \
+  "void main() {"                                                                     "\n"  \
+  "  vec2 half_size = (f_rect.zw * 0.5f);"                                            "\n"  \
+  "  vec2 q = (abs(f_pos - (f_rect.xy + half_size)) - half_size + f_radius);"         "\n"  \
+  "  float d = (length(max(q, 0.0f)) + min(max(q.x, q.y), 0.0f) - f_radius);"         "\n"  \
+  "  frag_color = vec4(f_color.rgb, (f_color.a * clamp((0.5f - d), 0.0f, 1.0f)));"    "\n"  \
+  "}"                                                                                 "\n"
 
 #define HACK_FONT_PATH     "/usr/share/fonts/TTF/Hack-Regular.ttf"
 #define DEFAULT_FONT_PATH  HACK_FONT_PATH
@@ -147,6 +192,16 @@ static int shader_location_rect_projection = -1;
 
 static mat4x4 projection;
 
+/* The rect batch, every rect drawn by elements is added here, and then drawn in one go when the batch is flushed. */
+static ShaderRectQuad *rect_batch = NULL;
+static Ulong rect_batch_len = 0;
+static Ulong rect_batch_cap = 0;
+/* Scratch space where the sorted quads are placed before they are pushed to `rect_batch_buf`. */
+static RectVertex *rect_batch_vert = NULL;
+static Uint *rect_batch_indi = NULL;
+static Ulong rect_batch_indi_cap = 0;
+static vertex_buffer_t *rect_batch_buf = NULL;
+
 
 /* ---------------------------------------------------------- Static function's ---------------------------------------------------------- */
 
@@ -325,6 +380,35 @@ static inline void mat4x4_orthographic(mat4x4 m, float left, float right, float
   }
 }
 
+/* ----------------------------- Shader rect quad cmp ----------------------------- */
+
+/* Sort quads by layer, and keep the order they were added in within the same layer. */
+static int shader_rect_quad_cmp(const void *a, const void *b) {
+  const ShaderRectQuad *qa = a;
+  const ShaderRectQuad *qb = b;
+  if (qa->layer != qb->layer) {
+    return ((qa->layer < qb->layer) ? -1 : 1);
+  }
+  return ((qa->seq < qb->seq) ? -1 : (qa->seq > qb->seq));
+}
+
+/* ----------------------------- Shader rect batch ensure indices ----------------------------- */
+
+/* Ensure the shared index array can hold `nquads`.  As all quads are made the same way, this is only ever extended. */
+static void shader_rect_batch_ensure_indices(Ulong nquads) {
+  if (nquads <= rect_batch_indi_cap) {
+    return;
+  }
+  rect_batch_indi = xrealloc(rect_batch_indi, (nquads * RECT_INDICES_LEN * sizeof(Uint)));
+  rect_batch_vert = xrealloc(rect_batch_vert, (nquads * 4 * sizeof(RectVertex)));
+  for (Ulong i=rect_batch_indi_cap; i<nquads; ++i) {
+    for (Ulong j=0; j<RECT_INDICES_LEN; ++j) {
+      rect_batch_indi[(i * RECT_INDICES_LEN) + j] = ((i * 4) + RECT_INDICES[j]);
+    }
+  }
+  rect_batch_indi_cap = nquads;
+}
+
 
 /* ---------------------------------------------------------- Global function's ---------------------------------------------------------- */
 
@@ -397,6 +481,7 @@ void shader_compile(void) {
       shader_location_rect_projection = glGetUniformLocation(rect_shader, "projection");
     }
   }
+  rect_batch_buf = vertex_buffer_new(RECT_VERTBUF);
 }
 
 /* ----------------------------- Shader free ----------------------------- */
@@ -409,6 +494,17 @@ void shader_free(void) {
   if (rect_shader) {
     glDeleteProgram(rect_shader);
   }
+  vertex_buffer_delete(rect_batch_buf);
+  free(rect_batch);
+  free(rect_batch_vert);
+  free(rect_batch_indi);
+  rect_batch_buf      = NULL;
+  rect_batch          = NULL;
+  rect_batch_vert     = NULL;
+  rect_batch_indi     = NULL;
+  rect_batch_len      = 0;
+  rect_batch_cap      = 0;
+  rect_batch_indi_cap = 0;
   font_free(textfont);
   font_free(uifont);
 }
@@ -417,11 +513,18 @@ void shader_free(void) {
 
 /* Takes a `RectVertex[4]` as `buf`. */
 void shader_rect_vertex_load(RectVertex *buf, float x, float y, float w, float h, Uint color) {
+  shader_rect_vertex_load_rounded(buf, x, y, w, h, 0, color);
+}
+
+/* ----------------------------- Shader rect vertex load rounded ----------------------------- */
+
+/* Takes a `RectVertex[4]` as `buf`.  The corners are rounded with `radius`, by the rect shader. */
+void shader_rect_vertex_load_rounded(RectVertex *buf, float x, float y, float w, float h, float radius, Uint color) {
   UNPACK_FUINT_VARS(color, r, g, b, a);
-  buf[0] = (RectVertex){x, y,             r,g,b,a};
-  buf[1] = (RectVertex){(x + w), y,       r,g,b,a};
-  buf[2] = (RectVertex){(x + w), (y + h), r,g,b,a};
-  buf[3] = (RectVertex){x, (y + h),       r,g,b,a};
+  buf[0] = (RectVertex){x, y,             r,g,b,a, x,y,w,h, radius};
+  buf[1] = (RectVertex){(x + w), y,       r,g,b,a, x,y,w,h, radius};
+  buf[2] = (RectVertex){(x + w), (y + h), r,g,b,a, x,y,w,h, radius};
+  buf[3] = (RectVertex){x, (y + h),       r,g,b,a, x,y,w,h, radius};
 }
 
 /* ----------------------------- Shader rect vertex load array ----------------------------- */
@@ -464,3 +567,72 @@ int shader_get_location_font_projection(void) {
 int shader_get_location_rect_projection(void) {
   return shader_location_rect_projection;
 }
+
+/* ----------------------------- Shader rect batch push ----------------------------- */
+
+/* Add a quad, as made by `shader_rect_vertex_load()` to the rect batch at `layer`. */
+void shader_rect_batch_push(const RectVertex *const vert, Ushort layer) {
+  ASSERT(vert);
+  ShaderRectQuad *quad;
+  if (rect_batch_len == rect_batch_cap) {
+    rect_batch_cap = (rect_batch_cap ? (rect_batch_cap * 2) : 64);
+    rect_batch     = xrealloc(rect_batch, (rect_batch_cap * sizeof(*rect_batch)));
+  }
+  quad = &rect_batch[rect_batch_len];
+  quad->layer = layer;
+  quad->seq   = rect_batch_len;
+  memcpy(quad->vert, vert, sizeof(quad->vert));
+  ++rect_batch_len;
+}
+
+/* ----------------------------- Shader rect batch push vertbuf ----------------------------- */
+
+/* Add all quads in `buf`, that must be a `RECT_VERTBUF` made only of quads, to the rect batch at `layer`. */
+void shader_rect_batch_push_vertbuf(vertex_buffer_t *const buf, Ushort layer) {
+  ASSERT(buf);
+  Ulong len = vector_size(buf->vertices);
+  const RectVertex *vert;
+  ASSERT(!(len % 4));
+  if (!len) {
+    return;
+  }
+  vert = vector_get(buf->vertices, 0);
+  for (Ulong i=0; i<len; i+=4) {
+    shader_rect_batch_push((vert + i), layer);
+  }
+}
+
+/* ----------------------------- Shader rect batch flush ----------------------------- */
+
+/* Draw all rects currently in the batch, ordered by layer, using one draw call for each layer.  This
+ * must be called before drawing anything else, so that the rects end up under what comes after them. */
+void shader_rect_batch_flush(void) {
+  Ulong start;
+  Ulong end;
+  if (!rect_batch_len) {
+    return;
+  }
+  else if (!rect_shader) {
+    rect_batch_len = 0;
+    return;
+  }
+  qsort(rect_batch, rect_batch_len, sizeof(*rect_batch), shader_rect_quad_cmp);
+  shader_rect_batch_ensure_indices(rect_batch_len);
+  for (Ulong i=0; i<rect_batch_len; ++i) {
+    memcpy((rect_batch_vert + (i * 4)), rect_batch[i].vert, sizeof(rect_batch[i].vert));
+  }
+  vertex_buffer_clear(rect_batch_buf);
+  vertex_buffer_push_back(rect_batch_buf, rect_batch_vert, (rect_batch_len * 4), rect_batch_indi, (rect_batch_len * RECT_INDICES_LEN));
+  glUseProgram(rect_shader); {
+    vertex_buffer_render_setup(rect_batch_buf, GL_TRIANGLES);
+    for (start=0; start<rect_batch_len; start=end) {
+      for (end=(start + 1); end<rect_batch_len && rect_batch[end].layer == rect_batch[start].layer; ++end);
+      glDrawElements(
+        GL_TRIANGLES, ((end - start) * RECT_INDICES_LEN), GL_UNSIGNED_INT, (void *)(start * RECT_INDICES_LEN * sizeof(Uint))
+      );
+      frame_count_draw_calls(1);
+    }
+    vertex_buffer_render_finish(rect_batch_buf);
+  }
+  rect_batch_len = 0;
+}
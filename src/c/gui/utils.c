@@ -38,11 +38,12 @@
 void render_vertbuf(Font *const f, vertex_buffer_t *buf) {
   ASSERT(f);
   ASSERT(buf);
-  font_upload_texture_atlas(f);
+  /* Any rects added before this text must be drawn first, so they end up under it. */
+  shader_rect_batch_flush();
   glEnable(GL_TEXTURE_2D);
   glUseProgram(font_shader); {
     glUniform1i(shader_get_location_font_tex() /* glGetUniformLocation(font_shader, "tex") */, 0);
-    vertex_buffer_render(buf, GL_TRIANGLES);
+    font_render_vertbuf(f, buf);
   }
 }
 
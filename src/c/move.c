@@ -14,15 +14,15 @@
 static Ulong proper_x(linestruct *const line, int cols, Ulong *const leftedge, bool forward, Ulong column, bool *const shifted) {
   ASSERT(line);
   ASSERT(leftedge);
-  Ulong index = actual_x(line->data, column);
+  Ulong index = line_actual_x(line, column);
   if (ISSET(SOFTWRAP) && line->data[index] == '\t' &&
-      ((forward && wideness(line->data, index) < (*leftedge)) ||
+      ((forward && line_wideness(line, index) < (*leftedge)) ||
        (!forward && (column / tabsize) == (((*leftedge) - 1) / tabsize) && (column / tabsize) < (((*leftedge) + cols - 1) / tabsize)))) {
     ++index;
     ASSIGN_IF_VALID(shifted, TRUE);
   }
   if (ISSET(SOFTWRAP)) {
-    (*leftedge) = leftedge_for(cols, wideness(line->data, index), line);
+    (*leftedge) = leftedge_for(cols, line_wideness(line, index), line);
   }
   return index;
 }
@@ -791,7 +791,6 @@ void do_end_for(CTX_ARGS) {
   ASSERT(file);
   linestruct *was_current = file->current;
   bool moved_off_chunk = TRUE;
-  bool kickoff         = TRUE;
   bool last_chunk      = FALSE;
   Ulong was_column = xplustabs_for(file);
   Ulong line_len   = strlen(file->current->data);
@@ -800,14 +799,14 @@ void do_end_for(CTX_ARGS) {
   Ulong right_x;
   if (ISSET(SOFTWRAP)) {
     leftedge   = leftedge_for(cols, was_column, file->current);
-    rightedge  = get_softwrap_breakpoint(cols, file->current->data, leftedge, &kickoff, &last_chunk);
+    rightedge  = softwrap_chunk_end(cols, file->current, leftedge, &last_chunk);
     /* If we're on the last chunk, we're already at the end of the line.  Otherwise, we're one culumn past the end of the line.
      * Shifting backwards one column might put us in the middle of a milti-column character, but `actual_x()` will fix that.
      * Why even do this?  This can be solved easily by `step_left()`? */
     if (!last_chunk) {
       --rightedge;
     }
-    right_x = actual_x(file->current->data, rightedge);
+    right_x = line_actual_x(file->current, rightedge);
     /* If already at the right edge of the screen, move fully to the end of the line.  Otherwise, move to the right edge. */
     if (file->current_x == right_x) {
       file->current_x = line_len;
@@ -68,6 +68,8 @@
 #define MINIBAR_OPT_STR         "-_",              "--minibar",                 N_("Show a feedback bar at the bottom")
 #define ZERO_OPT_STR            "-0",              "--zero",                    N_("Hide all bars, use whole terminal")
 #define MODERNBINDINGS_OPT_STR  "-/",              "--modernbindings",          N_("Use better-known key bindings")
+#define PERF_OPT_STR            "",                "--perf",                    N_("Show p50/p99 timings on the status bar")
+#define TRACE_OPT_STR           "",                _("--trace <file>"),         N_("Record a chrome trace into this file")
 
 
 /* ---------------------------------------------------------- Variable's ---------------------------------------------------------- */
@@ -322,43 +324,30 @@ static void die_curses(void) {
 
 /* Read in all waiting input bytes and paste them into the buffer in one go. */
 /* static */ void suck_up_input_and_paste_it(void) {
-  linestruct *was_cutbuffer;
-  linestruct *line;
-  Ulong index;
+  char *burst;
+  Ulong len;
+  Ulong cap;
   int input;
   /* Only perform any action when in `curses-mode`. */
   if (IN_CURSES_CTX) {
-    was_cutbuffer = cutbuffer;
-    line          = make_new_node(NULL);
-    line->data    = COPY_OF("");
-    index         = 0;
-    cutbuffer     = line;
+    cap   = 4096;
+    len   = 0;
+    burst = xmalloc(cap);
     while (bracketed_paste) {
       input = get_kbinput(midwin, BLIND);
-      if (input == '\r' || input == '\n') {
-        line->next = make_new_node(line);
-        DLIST_ADV_NEXT(line);
-        line->data = COPY_OF("");
-        index = 0;
-      }
-      else if ((0x20 <= input && input <= 0xFF && input != DEL_CODE) || input == '\t') {
-        line->data = xnstrncat(line->data, index++, (char *)&input, 1);
-        // line->data = xrealloc(line->data, (index + 2));
-        // line->data[index++] = input;
-        // line->data[index]   = '\0';
+      if ((0x20 <= input && input <= 0xFF && input != DEL_CODE) || input == '\t' || input == '\r' || input == '\n') {
+        if (len == cap) {
+          cap  *= 2;
+          burst = xrealloc(burst, cap);
+        }
+        burst[len++] = input;
       }
       else if (input != BRACKETED_PASTE_MARKER) {
         beep();
       }
     }
-    if (ISSET(VIEW_MODE)) {
-      print_view_warning();
-    }
-    else {
-      paste_text();
-    }
-    free_lines(cutbuffer);
-    cutbuffer = was_cutbuffer;
+    paste_bulk(burst, len);
+    free(burst);
   }
 }
 
@@ -377,6 +366,7 @@ linestruct *make_new_node(linestruct *prevnode)  {
   newnode->multidata  = NULL;
   newnode->lineno     = ((prevnode) ? (prevnode->lineno + 1) : 1);
   newnode->has_anchor = FALSE;
+  newnode->softwrap   = NULL;
   // newnode->flags.clear();
   newnode->is_block_comment_start   = FALSE;
   newnode->is_block_comment_end     = FALSE;
@@ -439,6 +429,8 @@ void delete_node_for(openfilestruct *const file, linestruct *const node) {
   /* Free the node's internal data. */
   free(node->data);
   free(node->multidata);
+  softwrap_cache_free(node);
+  long_line_forget(node);
   /* Free the node itself. */
   free(node);
 }
@@ -496,6 +488,7 @@ linestruct *copy_node(const linestruct *const src) {
   dst->multidata  = NULL;
   dst->lineno     = src->lineno;
   dst->has_anchor = src->has_anchor;
+  dst->softwrap   = NULL;
   return dst;
 }
 
@@ -973,6 +966,8 @@ void inject_into_buffer(CTX_ARGS, char *burst, Ulong count) {
   }
   /* Inject the burst into the cursor line of `file`. */
   file->current->data = xnstrninj(file->current->data, datalen, burst, count, file->current_x);
+  /* The cursor line changed, and is measured again before `set_modified_for()` is reached. */
+  ++line_data_version;
   /* When the cursor is on the top row and not on the first chunk of a line, adding text
    * there might change the preceding chunk and thus require an adjustment of firstcolumn. */
   if (line == file->edittop && file->firstcolumn > 0) {
@@ -1246,6 +1241,8 @@ void usage(void) {
   print_opt(MINIBAR_OPT_STR);
   print_opt(ZERO_OPT_STR);
   print_opt(MODERNBINDINGS_OPT_STR);
+  print_opt(PERF_OPT_STR);
+  print_opt(TRACE_OPT_STR);
   exit(0);
 }
 
@@ -0,0 +1,344 @@
+/** @file nperf.c
+
+  @author  Melwin Svensson.
+  @date    19-10-2026.
+
+ */
+#include "nperf.h"
+#include "ntrace.h"
+
+#include "../../include/c_proto.h"
+#include "../term/tui.h"
+#include "../window/window.h"
+
+#include <time.h>
+
+
+/* ---------------------------------------------------------- Define's ---------------------------------------------------------- */
+
+
+/* Every power of two is split into this many buckets, so a percentile is off by at most `1 / NPERF_SUB_BUCKETS`. */
+#define NPERF_SUB_BITS     (3)
+#define NPERF_SUB_BUCKETS  (1 << NPERF_SUB_BITS)
+/* Values below this get a bucket each. */
+#define NPERF_LINEAR       (NPERF_SUB_BUCKETS * 4)
+#define NPERF_LINEAR_BITS  (NPERF_SUB_BITS + 2)
+/* Enough buckets for any positive `Llong`. */
+#define NPERF_BUCKETS      (NPERF_LINEAR + ((64 - NPERF_LINEAR_BITS) * NPERF_SUB_BUCKETS))
+
+/* The least time between two overlay updates in the gui, as every update makes the gui draw a frame. */
+#define NPERF_GUI_REPORT_INTERVAL  (MILLI_TO_NANO(250))
+
+#define NPERF_NS_TO_MS(ns)  ((double)(ns) / 1000000.0)
+
+
+/* ---------------------------------------------------------- Struct's ---------------------------------------------------------- */
+
+
+/* A log-linear histogram.  All fields are only touched atomically, as indexing runs on other threads. */
+typedef struct {
+  Ulong buckets[NPERF_BUCKETS];
+  Ulong count;
+  Ulong sum;
+  Ulong max;
+} nperf_histogram;
+
+
+/* ---------------------------------------------------------- Variable's ---------------------------------------------------------- */
+
+
+static const char *const zone_names[NPERF_ZONE_COUNT] = {
+  "frame",
+  "input",
+  "refresh",
+  "highlight",
+  "index",
+  "io"
+};
+
+static nperf_histogram histograms[NPERF_ZONE_COUNT];
+
+/* Where to write the collected timings on exit, or `NULL` when no dump was asked for. */
+static char *dump_path = NULL;
+/* The start of the current frame, `0` when there is none.  Only the main thread touches this. */
+static Llong frame_start = 0;
+/* The last time the overlay was shown in the gui. */
+static Llong last_gui_report = 0;
+/* The bottom row the overlay is drawn into in the tui, so it goes through the same diff as everything else. */
+static nwindow *tui_overlay = NULL;
+static int tui_overlay_lines = 0;
+static int tui_overlay_cols = 0;
+
+
+/* ---------------------------------------------------------- Static function's ---------------------------------------------------------- */
+
+
+/* ----------------------------- Nperf clock ----------------------------- */
+
+static inline Llong nperf_clock(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (((Llong)ts.tv_sec * 1000000000LL) + ts.tv_nsec);
+}
+
+/* ----------------------------- Nperf bucket ----------------------------- */
+
+/* Return's the bucket `ns` falls in. */
+static inline Ulong nperf_bucket(Ulong ns) {
+  int msb;
+  if (ns < NPERF_LINEAR) {
+    return ns;
+  }
+  msb = (63 - __builtin_clzl(ns));
+  return (NPERF_LINEAR + ((msb - NPERF_LINEAR_BITS) * NPERF_SUB_BUCKETS) + ((ns >> (msb - NPERF_SUB_BITS)) & (NPERF_SUB_BUCKETS - 1)));
+}
+
+/* ----------------------------- Nperf bucket value ----------------------------- */
+
+/* Return's the middle of the range of values that land in `bucket`. */
+static inline Llong nperf_bucket_value(Ulong bucket) {
+  int msb;
+  Ulong sub;
+  Ulong width;
+  if (bucket < NPERF_LINEAR) {
+    return bucket;
+  }
+  msb   = (((bucket - NPERF_LINEAR) / NPERF_SUB_BUCKETS) + NPERF_LINEAR_BITS);
+  sub   = ((bucket - NPERF_LINEAR) % NPERF_SUB_BUCKETS);
+  width = (1UL << (msb - NPERF_SUB_BITS));
+  return (((NPERF_SUB_BUCKETS + sub) * width) + (width / 2));
+}
+
+/* ----------------------------- Nperf dump at exit ----------------------------- */
+
+static void nperf_dump_at_exit(void) {
+  nperf_dump(dump_path);
+  free(dump_path);
+  dump_path = NULL;
+}
+
+
+/* ---------------------------------------------------------- Global function's ---------------------------------------------------------- */
+
+
+/* ----------------------------- Nperf init ----------------------------- */
+
+void nperf_init(void) {
+  const char *path = getenv("NANOX_PERF_DUMP");
+  if (path && *path && !dump_path) {
+    dump_path = copy_of(path);
+    atexit(nperf_dump_at_exit);
+  }
+}
+
+/* ----------------------------- Nperf collecting ----------------------------- */
+
+bool nperf_collecting(void) {
+  return (ISSET(PERF_OVERLAY) || dump_path || ntrace_enabled());
+}
+
+/* ----------------------------- Nperf now ----------------------------- */
+
+Llong nperf_now(void) {
+  return (nperf_collecting() ? nperf_clock() : 0);
+}
+
+/* ----------------------------- Nperf record ----------------------------- */
+
+void nperf_record(nperf_zone zone, Llong start) {
+  Llong end;
+  if (start) {
+    end = nperf_clock();
+    nperf_record_ns(zone, (end - start));
+    ntrace_complete(zone_names[zone], start, end);
+  }
+}
+
+/* ----------------------------- Nperf record ns ----------------------------- */
+
+void nperf_record_ns(nperf_zone zone, Llong ns) {
+  ASSERT(zone < NPERF_ZONE_COUNT);
+  nperf_histogram *histogram = &histograms[zone];
+  Ulong value = ((ns > 0) ? ns : 0);
+  Ulong max   = __atomic_load_n(&histogram->max, __ATOMIC_RELAXED);
+  __atomic_fetch_add(&histogram->buckets[nperf_bucket(value)], 1, __ATOMIC_RELAXED);
+  __atomic_fetch_add(&histogram->count, 1, __ATOMIC_RELAXED);
+  __atomic_fetch_add(&histogram->sum, value, __ATOMIC_RELAXED);
+  while (value > max && !__atomic_compare_exchange_n(&histogram->max, &max, value, TRUE, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+}
+
+/* ----------------------------- Nperf frame begin ----------------------------- */
+
+void nperf_frame_begin(void) {
+  frame_start = nperf_now();
+}
+
+/* ----------------------------- Nperf frame started ----------------------------- */
+
+Llong nperf_frame_started(void) {
+  return frame_start;
+}
+
+/* ----------------------------- Nperf frame end ----------------------------- */
+
+void nperf_frame_end(void) {
+  nperf_record(NPERF_FRAME, frame_start);
+  frame_start = 0;
+}
+
+/* ----------------------------- Nperf percentile ----------------------------- */
+
+Llong nperf_percentile(nperf_zone zone, double percentile) {
+  ASSERT(zone < NPERF_ZONE_COUNT);
+  nperf_histogram *histogram = &histograms[zone];
+  Ulong count = __atomic_load_n(&histogram->count, __ATOMIC_RELAXED);
+  Ulong rank;
+  Ulong seen = 0;
+  if (!count) {
+    return 0;
+  }
+  /* The rank of the sample we want, one based, so the 100th percentile is the last sample. */
+  rank = (Ulong)ceil((percentile / 100.0) * count);
+  if (!rank) {
+    rank = 1;
+  }
+  for (Ulong i=0; i<NPERF_BUCKETS; ++i) {
+    seen += __atomic_load_n(&histogram->buckets[i], __ATOMIC_RELAXED);
+    if (seen >= rank) {
+      return nperf_bucket_value(i);
+    }
+  }
+  /* Samples added while walking can make the count run ahead of the buckets. */
+  return __atomic_load_n(&histogram->max, __ATOMIC_RELAXED);
+}
+
+/* ----------------------------- Nperf reset ----------------------------- */
+
+void nperf_reset(void) {
+  for (int i=0; i<NPERF_ZONE_COUNT; ++i) {
+    for (Ulong b=0; b<NPERF_BUCKETS; ++b) {
+      __atomic_store_n(&histograms[i].buckets[b], 0, __ATOMIC_RELAXED);
+    }
+    __atomic_store_n(&histograms[i].count, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&histograms[i].sum, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&histograms[i].max, 0, __ATOMIC_RELAXED);
+  }
+}
+
+/* ----------------------------- Nperf overlay line ----------------------------- */
+
+Ulong nperf_overlay_line(char *const restrict buffer, Ulong size) {
+  ASSERT(buffer);
+  ASSERT(size);
+  Ulong len = 0;
+  int   ret;
+  ret = snprintf(buffer, size, "p50/p99 ms:");
+  len = ((ret < 0) ? 0 : ((Ulong)ret < size) ? (Ulong)ret : (size - 1));
+  for (int i=0; i<NPERF_ZONE_COUNT && len < (size - 1); ++i) {
+    /* Only show the zones we have seen so far, to keep the line short. */
+    if (!__atomic_load_n(&histograms[i].count, __ATOMIC_RELAXED)) {
+      continue;
+    }
+    ret = snprintf((buffer + len), (size - len), "  %s %.2f/%.2f", zone_names[i],
+      NPERF_NS_TO_MS(nperf_percentile(i, 50.0)), NPERF_NS_TO_MS(nperf_percentile(i, 99.0)));
+    if (ret < 0) {
+      break;
+    }
+    len += (((Ulong)ret < (size - len)) ? (Ulong)ret : (size - len - 1));
+  }
+  return len;
+}
+
+/* ----------------------------- Nperf report ----------------------------- */
+
+void nperf_report(void) {
+  char  line[256];
+  Ulong len = nperf_overlay_line(line, sizeof(line));
+  Llong now;
+  if (IN_GUI_CTX) {
+    now = nperf_clock();
+    if ((now - last_gui_report) < NPERF_GUI_REPORT_INTERVAL) {
+      return;
+    }
+    last_gui_report = now;
+    statusline_gui(INFO, "%s", line);
+  }
+  else if (IN_CURSES_CTX) {
+    statusline_curses(INFO, "%s", line);
+  }
+  /* The tui has no status bar yet, so the line gets a window of its own on the bottom row. */
+  else if (ISSET(NO_NCURSES) && NLINES > 0 && NCOLS > 0) {
+    /* After a resize the old window no longer covers the bottom row, and the new one is written whole. */
+    if (!tui_overlay || tui_overlay_lines != NLINES || tui_overlay_cols != NCOLS) {
+      nwindow_free(tui_overlay);
+      tui_overlay       = nwindow_create(1, NCOLS, (NLINES - 1), 0);
+      tui_overlay_lines = NLINES;
+      tui_overlay_cols  = NCOLS;
+    }
+    /* Leave the cursor where the editor put it. */
+    nwindow_put_row(tui_overlay, 0, line, len);
+  }
+}
+
+/* ----------------------------- Nperf report hide ----------------------------- */
+
+void nperf_report_hide(void) {
+  nwindow_put_row(tui_overlay, 0, "", 0);
+}
+
+/* ----------------------------- Nperf dump ----------------------------- */
+
+bool nperf_dump(const char *const restrict path) {
+  ASSERT(path);
+  FILE *file = fopen(path, "w");
+  Ulong count;
+  if (!file) {
+    return FALSE;
+  }
+  fprintf(file, "%-10s %10s %10s %10s %10s %10s %10s\n", "zone", "count", "mean ms", "p50 ms", "p90 ms", "p99 ms", "max ms");
+  for (int i=0; i<NPERF_ZONE_COUNT; ++i) {
+    count = __atomic_load_n(&histograms[i].count, __ATOMIC_RELAXED);
+    fprintf(file, "%-10s %10lu %10.4f %10.4f %10.4f %10.4f %10.4f\n", zone_names[i], count,
+      (count ? (NPERF_NS_TO_MS(__atomic_load_n(&histograms[i].sum, __ATOMIC_RELAXED)) / count) : 0.0),
+      NPERF_NS_TO_MS(nperf_percentile(i, 50.0)),
+      NPERF_NS_TO_MS(nperf_percentile(i, 90.0)),
+      NPERF_NS_TO_MS(nperf_percentile(i, 99.0)),
+      NPERF_NS_TO_MS(__atomic_load_n(&histograms[i].max, __ATOMIC_RELAXED))
+    );
+  }
+  fclose(file);
+  return TRUE;
+}
+
+
+/* ---------------------------------------------------------- Tests ---------------------------------------------------------- */
+
+
+#define NPERF_TEST_SAMPLES  (4000000)
+
+/* Measure what a sample costs, clock read included, and check the percentiles of a known spread against what they should be. */
+void nperf_test_bench(void) {
+  Llong p50;
+  Llong p99;
+  double error_50;
+  double error_99;
+  nperf_reset();
+  writef("\n");
+  timer_action(ms,
+    for (Llong i=0; i<NPERF_TEST_SAMPLES; ++i) {
+      nperf_record_ns(NPERF_INPUT, ((((i % 1000) + 1) * 1000) + (nperf_clock() & 1)));
+    }
+  );
+  p50 = nperf_percentile(NPERF_INPUT, 50.0);
+  p99 = nperf_percentile(NPERF_INPUT, 99.0);
+  /* The samples spread evenly over 1 to 1000 micro-seconds, so the 50th percentile is 500 and the 99th is 990. */
+  error_50 = (fabs((double)p50 - 500000.0) / 500000.0);
+  error_99 = (fabs((double)p99 - 990000.0) / 990000.0);
+  writef(
+    "%s: Samples: %d in %.5f ms (%.1f ns per sample): p50: %.4f ms (%.1f%% off): p99: %.4f ms (%.1f%% off)\n",
+    __func__, NPERF_TEST_SAMPLES, (double)ms, (((double)ms * 1000000.0) / NPERF_TEST_SAMPLES),
+    NPERF_NS_TO_MS(p50), (error_50 * 100.0), NPERF_NS_TO_MS(p99), (error_99 * 100.0)
+  );
+  nperf_reset();
+  writef("\n");
+}
@@ -0,0 +1,76 @@
+/** @file nperf.h
+
+  @author Melwin Svensson.  19-10-2026.
+
+ */
+#pragma once
+
+#include "../../../config.h"
+#include "../../include/c_defs.h"
+
+_BEGIN_C_LINKAGE
+
+/* The parts of the editor we time.  Every zone gets its own histogram. */
+typedef enum {
+  NPERF_FRAME,      /* From a key being read (or a gui frame starting), until the screen is up to date again. */
+  NPERF_INPUT,      /* Handling the input itself, so binding lookup and the function it runs. */
+  NPERF_REFRESH,    /* Redrawing the edit window. */
+  NPERF_HIGHLIGHT,  /* Coloring a row, or recalculating the multiline color info. */
+  NPERF_INDEX,      /* Indexing a file for the language server. */
+  NPERF_IO,         /* Reading a file into a buffer, or writing one out. */
+#define NPERF_ZONE_COUNT  (NPERF_IO + 1)
+} nperf_zone;
+
+/* Start collecting when `NANOX_PERF_DUMP` is set in the environment, and write the collected timings to the file it names on exit. */
+void nperf_init(void);
+
+/* Returns `TRUE` when timings are being collected, that is when the overlay is on, when a dump was asked for or when tracing. */
+bool nperf_collecting(void);
+
+/* Return's the current monotonic time in `nano-seconds`, or `0` when not collecting, so that `nperf_record()` ignores it. */
+Llong nperf_now(void);
+
+/* Add the time elapsed since `start`, gotten from `nperf_now()`, to `zone`, and to the trace when tracing.  Does nothing when `start` is `0`.  This is thread-safe. */
+void nperf_record(nperf_zone zone, Llong start);
+
+/* Add a sample of `ns` nano-seconds to `zone`.  This is thread-safe. */
+void nperf_record_ns(nperf_zone zone, Llong ns);
+
+/* Mark the start of a frame, from the main thread. */
+void nperf_frame_begin(void);
+
+/* Return's the start of the current frame, or `0` when there is none. */
+Llong nperf_frame_started(void);
+
+/* Record the current frame into `NPERF_FRAME`, if one was started. */
+void nperf_frame_end(void);
+
+/* Return's the time below which `percentile` percent of the samples in `zone` fall, in `nano-seconds`. */
+Llong nperf_percentile(nperf_zone zone, double percentile);
+
+/* Forget all collected samples. */
+void nperf_reset(void);
+
+/* Write the one line summary the overlay shows into `buffer`, returning the length. */
+Ulong nperf_overlay_line(char *const restrict buffer, Ulong size);
+
+/* Show the overlay line in whatever context we are running in. */
+void nperf_report(void);
+
+/* Blank the row the overlay was drawn on in the tui, for when the overlay is turned off.  Once the row is blank, the diff makes this free. */
+void nperf_report_hide(void);
+
+/* Write a table of every zone to `path`.  Returns `FALSE` when the file could not be opened. */
+bool nperf_dump(const char *const restrict path);
+
+/* Time `action`, adding it to `zone`.  Note that `action` should not return, as the sample would then be lost. */
+#define nperf_time(zone, ...)             \
+  DO_WHILE(                               \
+    Llong __nperf_start = nperf_now();    \
+    DO_WHILE(__VA_ARGS__);                \
+    nperf_record((zone), __nperf_start);  \
+  )
+
+void nperf_test_bench(void);
+
+_END_C_LINKAGE
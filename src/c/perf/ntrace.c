@@ -0,0 +1,424 @@
+/** @file ntrace.c
+
+  @author  Melwin Svensson.
+  @date    19-10-2026.
+
+ */
+#include "ntrace.h"
+
+#include "../../include/c_proto.h"
+
+#include <pthread.h>
+#include <time.h>
+
+
+/* ---------------------------------------------------------- Define's ---------------------------------------------------------- */
+
+
+/* The number of events in one chunk of a thread buffer. */
+#define NTRACE_CHUNK_EVENTS  (1 << 14)
+/* The most chunks one thread may fill, after this events are dropped and counted. */
+#define NTRACE_MAX_CHUNKS    (256)
+
+#define NTRACE_NAME_SIZE  (32)
+
+
+/* ---------------------------------------------------------- Struct's ---------------------------------------------------------- */
+
+
+typedef struct {
+  Llong ts;           /* When the event happend, in monotonic `nano-seconds`. */
+  Llong dur;          /* How long it lasted, only for complete events. */
+  const char *name;
+  char phase;         /* The chrome phase, `B`, `E` or `X`. */
+} ntrace_event;
+
+/* Only the thread that owns a chunk writes to it, and it publishes `count` after the event is written,
+ * so a writer on another thread can read every event below `count` without taking any lock. */
+typedef struct ntrace_chunk {
+  struct ntrace_chunk *next;
+  Ulong count;
+  ntrace_event events[NTRACE_CHUNK_EVENTS];
+} ntrace_chunk;
+
+typedef struct ntrace_buffer {
+  struct ntrace_buffer *next;
+  ntrace_chunk *head;
+  ntrace_chunk *tail;
+  Ulong chunks;
+  Ulong dropped;
+  int   tid;
+  bool  named;
+  char  name[NTRACE_NAME_SIZE];
+} ntrace_buffer;
+
+
+/* ---------------------------------------------------------- Variable's ---------------------------------------------------------- */
+
+
+static bool tracing = FALSE;
+/* Where `ntrace_save()` and the exit handler write the trace, when set. */
+static char *trace_path = NULL;
+/* The time recording started, every timestamp is written relative to this. */
+static Llong trace_start = 0;
+/* Every thread that has recorded something, newest first.  Threads push themselves with a compare and swap. */
+static ntrace_buffer *buffers = NULL;
+static int next_tid = 1;
+
+static _Thread_local ntrace_buffer *thread_buffer = NULL;
+/* The name the calling thread gave itself, threads can start before recording does, so this is kept until the buffer exists. */
+static _Thread_local char thread_name[NTRACE_NAME_SIZE];
+
+
+/* ---------------------------------------------------------- Static function's ---------------------------------------------------------- */
+
+
+/* ----------------------------- Ntrace clock ----------------------------- */
+
+static inline Llong ntrace_clock(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (((Llong)ts.tv_sec * 1000000000LL) + ts.tv_nsec);
+}
+
+/* ----------------------------- Ntrace chunk create ----------------------------- */
+
+static ntrace_chunk *ntrace_chunk_create(void) {
+  ntrace_chunk *chunk = xmalloc(sizeof(*chunk));
+  chunk->next  = NULL;
+  chunk->count = 0;
+  return chunk;
+}
+
+/* ----------------------------- Ntrace thread buffer ----------------------------- */
+
+/* Return's the buffer of the calling thread, creating and publishing it the first time. */
+static ntrace_buffer *ntrace_thread_buffer(void) {
+  ntrace_buffer *buffer = thread_buffer;
+  if (!buffer) {
+    buffer = xmalloc(sizeof(*buffer));
+    buffer->head    = ntrace_chunk_create();
+    buffer->tail    = buffer->head;
+    buffer->chunks  = 1;
+    buffer->dropped = 0;
+    buffer->tid     = __atomic_fetch_add(&next_tid, 1, __ATOMIC_RELAXED);
+    buffer->named   = (*thread_name != '\0');
+    memcpy(buffer->name, thread_name, sizeof(buffer->name));
+    buffer->next    = __atomic_load_n(&buffers, __ATOMIC_RELAXED);
+    while (!__atomic_compare_exchange_n(&buffers, &buffer->next, buffer, TRUE, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+    thread_buffer = buffer;
+  }
+  return buffer;
+}
+
+/* ----------------------------- Ntrace thread buffer free ----------------------------- */
+
+/* Unlink the buffer of a thread that has exited from `buffers`, and free it with all its chunks.  Threads only ever push at
+ * the head, so any other link is only changed here.  Note that this must not run while a trace is being written. */
+static void ntrace_thread_buffer_free(ntrace_buffer *const buffer) {
+  ASSERT(buffer);
+  ntrace_buffer **link;
+  ntrace_buffer  *head;
+  ntrace_chunk   *chunk;
+  ntrace_chunk   *next;
+  do {
+    head = __atomic_load_n(&buffers, __ATOMIC_ACQUIRE);
+    if (head != buffer) {
+      break;
+    }
+  } while (!__atomic_compare_exchange_n(&buffers, &head, buffer->next, FALSE, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+  if (head != buffer) {
+    for (link=&head->next; *link; link=&(*link)->next) {
+      if (*link == buffer) {
+        *link = buffer->next;
+        break;
+      }
+    }
+  }
+  for (chunk=buffer->head; chunk; chunk=next) {
+    next = chunk->next;
+    free(chunk);
+  }
+  free(buffer);
+}
+
+/* ----------------------------- Ntrace push ----------------------------- */
+
+static void ntrace_push(const char *const restrict name, char phase, Llong ts, Llong dur) {
+  ntrace_buffer *buffer = ntrace_thread_buffer();
+  ntrace_chunk  *chunk  = buffer->tail;
+  ntrace_chunk  *next;
+  ntrace_event  *event;
+  if (chunk->count == NTRACE_CHUNK_EVENTS) {
+    if (buffer->chunks == NTRACE_MAX_CHUNKS) {
+      __atomic_store_n(&buffer->dropped, (buffer->dropped + 1), __ATOMIC_RELAXED);
+      return;
+    }
+    next = ntrace_chunk_create();
+    __atomic_store_n(&chunk->next, next, __ATOMIC_RELEASE);
+    buffer->tail = next;
+    ++buffer->chunks;
+    chunk = next;
+  }
+  event = &chunk->events[chunk->count];
+  event->ts    = ts;
+  event->dur   = dur;
+  event->name  = name;
+  event->phase = phase;
+  __atomic_store_n(&chunk->count, (chunk->count + 1), __ATOMIC_RELEASE);
+}
+
+/* ----------------------------- Ntrace write string ----------------------------- */
+
+/* Write `string` as a json string, quotes included. */
+static void ntrace_write_string(FILE *file, const char *string) {
+  putc_unlocked('"', file);
+  for (const char *ch=string; *ch; ++ch) {
+    if (*ch == '"' || *ch == '\\') {
+      putc_unlocked('\\', file);
+      putc_unlocked(*ch, file);
+    }
+    else if ((Uchar)*ch < 0x20) {
+      fprintf(file, "\\u%04x", (Uchar)*ch);
+    }
+    else {
+      putc_unlocked(*ch, file);
+    }
+  }
+  putc_unlocked('"', file);
+}
+
+/* ----------------------------- Ntrace write us ----------------------------- */
+
+/* Write `ns` as micro-seconds with three decimals.  This runs for every event, so it avoids `fprintf()`. */
+static void ntrace_write_us(FILE *file, Llong ns) {
+  char  buffer[32];
+  char *end = (buffer + sizeof(buffer));
+  char *ptr = end;
+  Ulong value = ((ns < 0) ? 0 : ns);
+  for (int i=0; i<3; ++i) {
+    *--ptr = ('0' + (value % 10));
+    value /= 10;
+  }
+  *--ptr = '.';
+  do {
+    *--ptr = ('0' + (value % 10));
+    value /= 10;
+  } while (value);
+  fwrite_unlocked(ptr, 1, (end - ptr), file);
+}
+
+/* ----------------------------- Ntrace save at exit ----------------------------- */
+
+static void ntrace_save_at_exit(void) {
+  ntrace_write(trace_path);
+}
+
+
+/* ---------------------------------------------------------- Global function's ---------------------------------------------------------- */
+
+
+/* ----------------------------- Ntrace start ----------------------------- */
+
+void ntrace_start(const char *const restrict path) {
+  if (tracing) {
+    return;
+  }
+  trace_start = ntrace_clock();
+  if (path && *path) {
+    trace_path = copy_of(path);
+    atexit(ntrace_save_at_exit);
+  }
+  __atomic_store_n(&tracing, TRUE, __ATOMIC_RELEASE);
+  ntrace_thread_name("main");
+}
+
+/* ----------------------------- Ntrace enabled ----------------------------- */
+
+bool ntrace_enabled(void) {
+  return __atomic_load_n(&tracing, __ATOMIC_RELAXED);
+}
+
+/* ----------------------------- Ntrace thread name ----------------------------- */
+
+void ntrace_thread_name(const char *const restrict format, ...) {
+  ASSERT(format);
+  va_list ap;
+  va_start(ap, format);
+  vsnprintf(thread_name, sizeof(thread_name), format, ap);
+  va_end(ap);
+  /* When this thread already records, the name goes straight to its buffer.  A writer can see a half written name
+   * when a thread is renamed while writing, but threads name themselves once when they start. */
+  if (thread_buffer) {
+    memcpy(thread_buffer->name, thread_name, sizeof(thread_buffer->name));
+    __atomic_store_n(&thread_buffer->named, TRUE, __ATOMIC_RELEASE);
+  }
+}
+
+/* ----------------------------- Ntrace begin ----------------------------- */
+
+void ntrace_begin(const char *const restrict name) {
+  if (ntrace_enabled()) {
+    ntrace_push(name, 'B', ntrace_clock(), 0);
+  }
+}
+
+/* ----------------------------- Ntrace end ----------------------------- */
+
+void ntrace_end(const char *const restrict name) {
+  if (ntrace_enabled()) {
+    ntrace_push(name, 'E', ntrace_clock(), 0);
+  }
+}
+
+/* ----------------------------- Ntrace complete ----------------------------- */
+
+void ntrace_complete(const char *const restrict name, Llong start, Llong end) {
+  if (ntrace_enabled()) {
+    ntrace_push(name, 'X', start, (end - start));
+  }
+}
+
+/* ----------------------------- Ntrace write ----------------------------- */
+
+long ntrace_write(const char *const restrict path) {
+  ASSERT(path);
+  FILE *file = fopen(path, "w");
+  int   pid  = getpid();
+  long  written = 0;
+  Ulong count;
+  Ulong dropped;
+  Llong last = 0;
+  ntrace_event *event;
+  /* The part of every event that only depends on the thread. */
+  char ids[64];
+  int  idslen;
+  if (!file) {
+    return -1;
+  }
+  /* The trace can get large, so write it out in big pieces, and lock the stream once instead of for every call. */
+  setvbuf(file, NULL, _IOFBF, (1 << 20));
+  flockfile(file);
+  fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", file);
+  fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":0,\"args\":{\"name\":\"nanox\"}}", pid);
+  for (ntrace_buffer *buffer=__atomic_load_n(&buffers, __ATOMIC_ACQUIRE); buffer; buffer=buffer->next) {
+    if (__atomic_load_n(&buffer->named, __ATOMIC_ACQUIRE)) {
+      fprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":", pid, buffer->tid);
+      ntrace_write_string(file, buffer->name);
+      fputs("}}", file);
+    }
+    idslen = snprintf(ids, sizeof(ids), ",\"pid\":%d,\"tid\":%d,\"ts\":", pid, buffer->tid);
+    for (ntrace_chunk *chunk=buffer->head; chunk; chunk=__atomic_load_n(&chunk->next, __ATOMIC_ACQUIRE)) {
+      count = __atomic_load_n(&chunk->count, __ATOMIC_ACQUIRE);
+      for (Ulong i=0; i<count; ++i) {
+        event = &chunk->events[i];
+        fputs_unlocked(",\n{\"name\":", file);
+        ntrace_write_string(file, event->name);
+        fputs_unlocked(",\"ph\":\"", file);
+        putc_unlocked(event->phase, file);
+        putc_unlocked('"', file);
+        fwrite_unlocked(ids, 1, idslen, file);
+        ntrace_write_us(file, (event->ts - trace_start));
+        if (event->phase == 'X') {
+          fputs_unlocked(",\"dur\":", file);
+          ntrace_write_us(file, event->dur);
+        }
+        putc_unlocked('}', file);
+        last = event->ts;
+        ++written;
+      }
+    }
+    /* Mark where a thread ran out of room, so a gap in the trace is not mistaken for idle time. */
+    if ((dropped = __atomic_load_n(&buffer->dropped, __ATOMIC_RELAXED))) {
+      fprintf(file, ",\n{\"name\":\"Dropped %lu events\",\"ph\":\"i\",\"s\":\"t\"", dropped);
+      fwrite_unlocked(ids, 1, idslen, file);
+      ntrace_write_us(file, (last - trace_start));
+      putc_unlocked('}', file);
+    }
+  }
+  fputs_unlocked("\n]}\n", file);
+  funlockfile(file);
+  if (fclose(file) != 0) {
+    return -1;
+  }
+  return written;
+}
+
+/* ----------------------------- Ntrace save ----------------------------- */
+
+void ntrace_save(void) {
+  long written;
+  if (!ntrace_enabled() || !trace_path) {
+    statusline(AHEM, _("Not tracing, start with --trace <file>"));
+    return;
+  }
+  written = ntrace_write(trace_path);
+  if (written < 0) {
+    statusline(ALERT, _("Could not write trace to %s: %s"), trace_path, strerror(errno));
+  }
+  else {
+    statusline(REMARK, _("Wrote %ld trace events to %s"), written, trace_path);
+  }
+}
+
+
+/* ---------------------------------------------------------- Tests ---------------------------------------------------------- */
+
+
+#define NTRACE_TEST_THREADS  (4)
+#define NTRACE_TEST_SCOPES   (250000)
+
+/* `Internal`  Record scopes the way a traced function does, from a thread of its own.  Return's the buffer of the thread. */
+static void *ntrace_test_thread(void *arg) {
+  ntrace_thread_name("bench %d", (int)(long)arg);
+  for (int i=0; i<NTRACE_TEST_SCOPES; ++i) {
+    ntrace_begin(__func__);
+    ntrace_end(__func__);
+  }
+  return thread_buffer;
+}
+
+/* Measure what an event costs with several threads recording at once, and what writing them out costs. */
+void ntrace_test_bench(void) {
+  pthread_t threads[NTRACE_TEST_THREADS];
+  void *thread_buffers[NTRACE_TEST_THREADS] = {NULL};
+  char path[] = "/tmp/ntrace_test_XXXXXX";
+  bool was_tracing = tracing;
+  long written = 0;
+  int  fd;
+  writef("\n");
+  if (!was_tracing) {
+    trace_start = ntrace_clock();
+    __atomic_store_n(&tracing, TRUE, __ATOMIC_RELEASE);
+  }
+  timer_action(record_ms,
+    for (long i=0; i<NTRACE_TEST_THREADS; ++i) {
+      pthread_create(&threads[i], NULL, ntrace_test_thread, (void *)i);
+    }
+    for (int i=0; i<NTRACE_TEST_THREADS; ++i) {
+      pthread_join(threads[i], &thread_buffers[i]);
+    }
+  );
+  if ((fd = mkstemp(path)) >= 0) {
+    close(fd);
+    timer_action(write_ms,
+      written = ntrace_write(path);
+    );
+    unlink(path);
+    writef(
+      "%s: Threads: %d: Events: %d in %.5f ms (%.1f ns per event): Wrote: %ld events in %.5f ms\n",
+      __func__, NTRACE_TEST_THREADS, (NTRACE_TEST_THREADS * NTRACE_TEST_SCOPES * 2), (double)record_ms,
+      (((double)record_ms * 1000000.0) / (NTRACE_TEST_THREADS * NTRACE_TEST_SCOPES * 2)), written, (double)write_ms
+    );
+  }
+  /* The bench threads are gone, so drop their buffers, or every run would leave their events in the trace. */
+  for (int i=0; i<NTRACE_TEST_THREADS; ++i) {
+    if (thread_buffers[i]) {
+      ntrace_thread_buffer_free(thread_buffers[i]);
+    }
+  }
+  if (!was_tracing) {
+    __atomic_store_n(&tracing, FALSE, __ATOMIC_RELEASE);
+  }
+  writef("\n");
+}
@@ -0,0 +1,58 @@
+/** @file ntrace.h
+
+  @author Melwin Svensson.  19-10-2026.
+
+ */
+#pragma once
+
+#include "../../../config.h"
+#include "../../include/c_defs.h"
+
+_BEGIN_C_LINKAGE
+
+/* Start recording events, naming the calling thread `main`.  When `path` is not `NULL`, the trace is written there on exit, and every time `ntrace_save()` runs. */
+void ntrace_start(const char *const restrict path);
+
+/* Returns `TRUE` when events are being recorded. */
+bool ntrace_enabled(void);
+
+/* Give the calling thread a name in the trace.  This can be done before recording starts, the name is kept until the thread records something. */
+void ntrace_thread_name(const char *const restrict format, ...) _PRINTFLIKE(1, 2);
+
+/* Record that `name` began on the calling thread now.  `name` must outlive the trace, so a literal or `__func__`. */
+void ntrace_begin(const char *const restrict name);
+
+/* Record that `name` ended on the calling thread now. */
+void ntrace_end(const char *const restrict name);
+
+/* Record `name` as one event from `start` to `end`, both monotonic times in `nano-seconds`. */
+void ntrace_complete(const char *const restrict name, Llong start, Llong end);
+
+/* Write every event recorded so far as chrome trace json to `path`, this can be done while recording.
+ * Returns the number of events written, or `-1` when the file could not be opened. */
+long ntrace_write(const char *const restrict path);
+
+/* Write the trace to the path given to `ntrace_start()`, and say so on the status bar. */
+void ntrace_save(void);
+
+void ntrace_test_bench(void);
+
+_END_C_LINKAGE
+
+#ifdef __cplusplus
+/* Records the scope it lives in as a begin and an end event, see `TRACE_FUNCTION`. */
+struct ntrace_scope {
+  const char *const name;
+
+  explicit ntrace_scope(const char *scope_name) noexcept : name(scope_name) {
+    ntrace_begin(name);
+  }
+
+  ~ntrace_scope(void) noexcept {
+    ntrace_end(name);
+  }
+};
+
+/* Trace the enclosing function, from here until it returns. */
+# define TRACE_FUNCTION  ntrace_scope __ntrace_scope(__func__)
+#endif
@@ -79,12 +79,15 @@ static const struct{ const char *const restrict name; int flag;} rcopts[] = {
   {        "cutfromcursor",  CUT_FROM_CURSOR},
   {            "emptyline",       EMPTY_LINE},
   {          "guidestripe",                0},
+  {          "includepath",                0},
   {            "indicator",        INDICATOR},
   {       "jumpyscrolling",  JUMPY_SCROLLING},
   {              "locking",          LOCKING},
   {        "matchbrackets",                0},
   {              "minibar",          MINIBAR},
   {            "noconvert",       NO_CONVERT},
+  {          "perfoverlay",     PERF_OVERLAY},
+  {          "projectwalk",     PROJECT_WALK},
   {           "showcursor",      SHOW_CURSOR},
   {            "smarthome",       SMART_HOME},
   {             "softwrap",         SOFTWRAP},
@@ -442,7 +445,8 @@ static Uint config_opt_from_string(const char *const restrict key) {
     { "backupdir",     BACKUPDIR        },
     { "wordchars",     WORDCHARS        },
     { "guidestripe",   GUIDESTRIPE      },
-    { "tabsize",       CONF_OPT_TABSIZE }
+    { "tabsize",       CONF_OPT_TABSIZE },
+    { "includepath",   INCLUDEPATH      }
   };
   /* Get the value based on the passed `key`. */
   for (Ulong i=0; i<ARRAY_SIZE(map); ++i) {
@@ -1564,6 +1568,11 @@ void parse_rcfile(FILE *rcstream, bool just_syntax, bool intros_only) {
     else if (configOption & WORDCHARS) {
       word_chars = realloc_strcpy(word_chars, argument);
     }
+    else if (configOption & INCLUDEPATH) {
+      include_path = realloc_strcpy(include_path, argument);
+      /* Resolve every include again, against the new search order. */
+      include_resolver_reset();
+    }
     else if (configOption & GUIDESTRIPE) {
       if (!parse_num(argument, &stripe_column) || stripe_column <= 0) {
         jot_error(N_("Guide column \"%s\" is invalid"), argument);
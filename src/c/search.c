@@ -492,7 +492,7 @@ int findnextstr_for(openfilestruct *const file, const char *const restrict needl
   if (modus == JUSTFIND && (!file->mark || file->softmark)) {
     spotlighted    = TRUE;
     light_from_col = xplustabs_for(file);
-    light_to_col   = wideness(line->data, (found_x + found_len));
+    light_to_col   = line_wideness(line, (found_x + found_len));
     refresh_needed = TRUE;
   }
   if (feedback > 0) {
@@ -646,7 +646,7 @@ long do_replace_loop_for(CTX_ARGS, const char *const restrict needle,
     if (!replaceall) {
       spotlighted = TRUE;
       light_from_col = xplustabs_for(file);
-      light_to_col   = wideness(file->current->data, (file->current_x + match_len));
+      light_to_col   = line_wideness(file->current, (file->current_x + match_len));
       /* Refresh the edit window, scrolling it if nessesary. */
       edit_refresh_for(STACK_CTX);
       /* TRANSLATORS: This is a prompt. */
@@ -832,16 +832,16 @@ void goto_line_and_column_for(CTX_ARGS, long line, long column, bool retain_answ
   file->current = line_from_number_for(file, line);
   /* Take a negative column number to mean, from the end of the line. */
   if (column < 0) {
-    column = (breadth(file->current->data) + column + 2);
+    column = (line_breadth(file->current) + column + 2);
   }
   if (column < 1) {
     column = 1;
   }
   /* Set the x position that corresponds to the requested column. */
-  file->current_x   = actual_x(file->current->data, (column - 1));
+  file->current_x   = line_actual_x(file->current, (column - 1));
   file->placewewant = (column - 1);
-  if (ISSET(SOFTWRAP) && (file->placewewant / cols) > (breadth(file->current->data) / cols)) {
-    file->placewewant = breadth(file->current->data);
+  if (ISSET(SOFTWRAP) && (file->placewewant / cols) > (line_breadth(file->current) / cols)) {
+    file->placewewant = line_breadth(file->current);
   }
   /* When a line number was manually given, center the target line. */
   if (interactive) {
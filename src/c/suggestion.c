@@ -25,6 +25,11 @@ typedef struct {
   char *buffer;
   /* Length of the current string used to search for suggestions. */
   Ulong length;
+  /* The string, line and start of the word where the last full search was done.  As long as the user keeps typing
+   * the same word, the suggestions can only become fewer, so we filter the menu instead of searching again. */
+  char *searched;
+  linestruct *searched_line;
+  Ulong searched_x;
 } Suggest/* Menu */;
 
 
@@ -307,8 +312,13 @@ void suggestmenu_create(void) {
   /* Insure <Left>/<Right> arrow input is ignored fully, as this menu will always only have a depth of one. */
   menu_behavior_arrow_depth_navigation(suggest->menu, FALSE);
   menu_show(suggest->menu, FALSE);
-  suggest->length = 0;
-  suggest->buffer = NULL;
+  /* Only show completions that are longer then the word itself. */
+  menu_behavior_filter_exclude_exact(suggest->menu, TRUE);
+  suggest->length        = 0;
+  suggest->buffer        = NULL;
+  suggest->searched      = NULL;
+  suggest->searched_line = NULL;
+  suggest->searched_x    = 0;
 }
 
 /* ----------------------------- Suggestmenu free ----------------------------- */
@@ -317,6 +327,7 @@ void suggestmenu_free(void) {
   ASSERT_SM;
   menu_free(suggest->menu);
   free(suggest->buffer);
+  free(suggest->searched);
   free(suggest);
   suggest = NULL;
 }
@@ -329,7 +340,8 @@ void suggestmenu_clear(void) {
   if (suggest->buffer) {
     *suggest->buffer = NUL;
   }
-  suggest->length = 0;
+  suggest->length   = 0;
+  suggest->searched = free_and_assign(suggest->searched, NULL);
   menu_clear_entries(suggest->menu);
   menu_show(suggest->menu, FALSE);
 }
@@ -363,10 +375,22 @@ void suggestmenu_find(void) {
   char *completion;
   Ulong i;
   Ulong j;
-  menu_clear_entries(suggest->menu);
   if (!suggest->length) {
+    suggest->searched = free_and_assign(suggest->searched, NULL);
+    menu_clear_entries(suggest->menu);
     return;
   }
+  /* The user is still typing the same word, so just filter the suggestions we already have. */
+  else if (suggest->searched && suggest->searched_line == GUI_OF->current && suggest->searched_x == (GUI_OF->current_x - suggest->length)
+  && strncmp(suggest->buffer, suggest->searched, strlen(suggest->searched)) == 0)
+  {
+    menu_filter(suggest->menu, suggest->buffer);
+    return;
+  }
+  menu_clear_entries(suggest->menu);
+  suggest->searched      = free_and_assign(suggest->searched, copy_of(suggest->buffer));
+  suggest->searched_line = GUI_OF->current;
+  suggest->searched_x    = (GUI_OF->current_x - suggest->length);
   map = hashmap_create_wfreefunc(free);
   /* For now we only search in the current editors files. */
   file = GUI_OF;
@@ -412,6 +436,7 @@ void suggestmenu_find(void) {
   }
   hashmap_free(map);
   menu_qsort(suggest->menu, menu_qsort_cb_strlen);
+  menu_filter(suggest->menu, suggest->buffer);
 }
 
 /* ----------------------------- Suggestmenu run ----------------------------- */
@@ -10,26 +10,36 @@
 
 /* --------------------- CSyntaxMacro --------------------- */
 
-/* Create a blank allocated `CSyntaxMacro` structure. */
-CSyntaxMacro *csyntaxmacro_create(void) {
-  CSyntaxMacro *macro = xmalloc(sizeof(*macro));
-  macro->args         = cvec_create_setfree(free);
-  macro->expanded     = NULL;
-  macro->expandstart  = syntaxfilepos_create(0, 0);
-  macro->expandend    = syntaxfilepos_create(0, 0);
-  macro->empty        = FALSE;
+/* Create a blank `CSyntaxMacro` structure in `arena`, it is freed together with the arena. */
+CSyntaxMacro *csyntaxmacro_create(SyntaxArena *const arena) {
+  ASSERT(arena);
+  CSyntaxMacro *macro = syntaxarena_alloc(arena, sizeof(*macro));
+  macro->args     = NULL;
+  macro->nargs    = 0;
+  macro->argcap   = 0;
+  macro->expanded = NULL;
+  macro->empty    = FALSE;
+  syntaxfilepos_set(&macro->expandstart, 0, 0);
+  syntaxfilepos_set(&macro->expandend, 0, 0);
   return macro;
 }
 
-/* Free's a `CSyntaxMacro` structure. */
-void csyntaxmacro_free(void *ptr) {
-  CSyntaxMacro *macro = ptr;
+/* Append a copy of `len` bytes of `arg` to the arguments of `macro`, both the copy and the array live in `arena`. */
+void csyntaxmacro_addarg(SyntaxArena *const arena, CSyntaxMacro *const macro, const char *const restrict arg, Ulong len) {
+  ASSERT(arena);
   ASSERT(macro);
-  cvec_free(macro->args);
-  free(macro->expanded);
-  syntaxfilepos_free(macro->expandstart);
-  syntaxfilepos_free(macro->expandend);
-  free(macro);
+  ASSERT(arg);
+  char **args;
+  /* Memory in a arena cannot be resized, so when full the array is copied into one twice the size. */
+  if (macro->nargs == macro->argcap) {
+    macro->argcap = (macro->argcap ? (macro->argcap * 2) : 4);
+    args = syntaxarena_alloc(arena, (sizeof(*args) * macro->argcap));
+    if (macro->nargs) {
+      memcpy(args, macro->args, (sizeof(*args) * macro->nargs));
+    }
+    macro->args = args;
+  }
+  macro->args[macro->nargs++] = syntaxarena_copy(arena, arg, len);
 }
 
 /* Parse the exantion of a macro. */
@@ -48,7 +58,7 @@ static void csyntaxmacro_expantion(SyntaxFile *const sf, CSyntaxMacro *const mac
   /* The length of blank chars. */
   Ulong white_len;
   /* Set the start position of this macro exantion inside the `SyntaxFile` structure. */
-  syntaxfilepos_set(macro->expandstart, line->lineno, (start - line->data));
+  syntaxfilepos_set(&macro->expandstart, line->lineno, (start - line->data));
   /* Iter until we reach eol. */
   while (*end) {
     /* Advance until we find backslash or eol. */
@@ -68,10 +78,11 @@ static void csyntaxmacro_expantion(SyntaxFile *const sf, CSyntaxMacro *const mac
       end = start;
     }
   }
-  /* Assign the expanded macro to the macro strucutre. */
-  macro->expanded = expanded;
+  /* Assign the expanded macro to the macro strucutre, the result is moved into the arena so it is freed together with the macro. */
+  macro->expanded = syntaxarena_copy(&sf->arena, expanded, strlen(expanded));
+  free(expanded);
   /* Set the end position of this macro expantion inside the `SyntaxFile` structure. */
-  syntaxfilepos_set(macro->expandend, line->lineno, (end - line->data));
+  syntaxfilepos_set(&macro->expandend, line->lineno, (end - line->data));
   /* Assign the line to *outline. */
   *outline = line;
   /* Also assign the data ptr to *outptr. */
@@ -118,7 +129,7 @@ static void csyntaxmacro_params(SyntaxFile *const sf, CSyntaxMacro *const macro,
       }
       else if (*data == ')') {
         /* When the last thing was a comma, report an error. */
-        if (wascomma && cvec_len(macro->args) != 0) {
+        if (wascomma && macro->nargs != 0) {
           syntaxfile_adderror(sf, line->lineno, (data - line->data), "Expected argument name");
         }
         break;
@@ -154,7 +165,7 @@ static void csyntaxmacro_params(SyntaxFile *const sf, CSyntaxMacro *const macro,
       if (*data == '.') {
         /* This is a valid variatic parameter argument. */
         if (strncmp(data, S__LEN("...")) == 0 && (isblankornulc(data + SLTLEN("...")) || isconeof(*(data + SLTLEN("...")), "\\),"))) {
-          cvec_push(macro->args, COPY_OF("..."));
+          csyntaxmacro_addarg(&sf->arena, macro, S__LEN("..."));
           idx = 3;
         }
         /* Add error. */
@@ -169,7 +180,7 @@ static void csyntaxmacro_params(SyntaxFile *const sf, CSyntaxMacro *const macro,
       }
       else {
         ASSERT((idx = wordendindex(data, 0, TRUE)) != 0);
-        cvec_push(macro->args, measured_copy(data, idx));
+        csyntaxmacro_addarg(&sf->arena, macro, data, idx);
       }
       data += idx;
       /* If this text was after anoter argument without a comma between them. */
@@ -217,7 +228,7 @@ static void csyntaxmacro_parse(SyntaxFile *const sf, SyntaxFileLine **const outl
     }
     else {
       /* Create the syntaxfile object. */
-      obj = syntaxobject_create();
+      obj = syntaxobject_create(&sf->arena);
       syntaxobject_setfile(obj, sf->path);
       syntaxobject_setcolor(obj, SYNTAX_COLOR_BLUE);
       syntaxobject_settype(obj, SYNTAX_OBJECT_TYPE_C_MACRO);
@@ -229,7 +240,7 @@ static void csyntaxmacro_parse(SyntaxFile *const sf, SyntaxFileLine **const outl
       free(ptr);
       /* Adv data ptr. */
       data += endidx;
-      macro = csyntaxmacro_create();
+      macro = csyntaxmacro_create(&sf->arena);
       /* If there is a '(' char directly after the macro name, this macro could have arguments. */
       if (*data == '(') {
         /* Parse the arguments. */
@@ -244,7 +255,7 @@ static void csyntaxmacro_parse(SyntaxFile *const sf, SyntaxFileLine **const outl
       }
       data += indentlen(data);
       csyntaxmacro_expantion(sf, macro, &line, &data);
-      syntaxobject_setdata(obj, macro, csyntaxmacro_free);
+      syntaxobject_setdata(obj, macro);
     }
   }
   *outline = line;
@@ -273,37 +284,29 @@ static void csyntaxpp_parse(SyntaxFile *const sf, SyntaxFileLine **const outline
 
 /* ----------------------------- CSyntaxStruct ----------------------------- */
 
-/* Create a new blank allocated `CSyntaxStruct` structure. */
-static CSyntaxStruct *csyntaxstruct_create(void) {
-  CSyntaxStruct *st = xmalloc(sizeof(*st));
-  st->bodystpos     = syntaxfilepos_create(0, 0);
-  st->bodyendpos    = syntaxfilepos_create(0, 0);
+/* Create a new blank `CSyntaxStruct` structure in `arena`, it is freed together with the arena. */
+static CSyntaxStruct *csyntaxstruct_create(SyntaxArena *const arena) {
+  ASSERT(arena);
+  CSyntaxStruct *st = syntaxarena_alloc(arena, sizeof(*st));
   st->forward_decl  = FALSE;
+  syntaxfilepos_set(&st->bodystpos, 0, 0);
+  syntaxfilepos_set(&st->bodyendpos, 0, 0);
   return st;
 }
 
-/* Free a allocated `CSyntaxStruct` structure. */
-static void csyntaxstruct_free(void *ptr) {
-  CSyntaxStruct *st = ptr;
-  ASSERT(st);
-  syntaxfilepos_free(st->bodystpos);
-  syntaxfilepos_free(st->bodyendpos);
-  free(st);
-}
-
 /* Add a c struct forward declaration object to the syntaxfile hashmap. */
 static void csyntaxstruct_add_forward_decl(SyntaxFile *const sf, int lineno, int colno,  const char *const restrict name) {
   ASSERT(sf);
   ASSERT(name);
   ASSERT(lineno > 0);
-  CSyntaxStruct *st = csyntaxstruct_create();
-  SyntaxObject *obj = syntaxobject_create();
+  CSyntaxStruct *st = csyntaxstruct_create(&sf->arena);
+  SyntaxObject *obj = syntaxobject_create(&sf->arena);
   syntaxobject_setfile(obj, sf->path);
   syntaxobject_setcolor(obj, SYNTAX_COLOR_GREEN);
   syntaxobject_settype(obj, SYNTAX_OBJECT_TYPE_C_STRUCT);
   syntaxobject_setpos(obj, lineno, colno);
   st->forward_decl = TRUE;
-  syntaxobject_setdata(obj, st, csyntaxstruct_free);
+  syntaxobject_setdata(obj, st);
   syntaxfile_addobject(sf, name, obj);
 }
 
@@ -313,8 +316,8 @@ static void csyntaxstruct_add_decl(SyntaxFile *const sf, SyntaxFileLine **const
   ASSERT(outline);
   ASSERT(outdata);
   ASSERT(name);
-  CSyntaxStruct *st = csyntaxstruct_create();
-  SyntaxObject *obj = syntaxobject_create();
+  CSyntaxStruct *st = csyntaxstruct_create(&sf->arena);
+  SyntaxObject *obj = syntaxobject_create(&sf->arena);
   SyntaxFileLine *line = *outline;
   const char *data = *outdata;
   ALWAYS_ASSERT(*data == '{');
@@ -323,10 +326,10 @@ static void csyntaxstruct_add_decl(SyntaxFile *const sf, SyntaxFileLine **const
   syntaxobject_settype(obj, SYNTAX_OBJECT_TYPE_C_STRUCT);
   syntaxobject_setpos(obj, row, col);
   st->forward_decl = FALSE;
-  syntaxfilepos_set(st->bodystpos, line->lineno, (data - line->data));
+  syntaxfilepos_set(&st->bodystpos, line->lineno, (data - line->data));
   findbracketmatch(&line, &data);
-  syntaxfilepos_set(st->bodyendpos, line->lineno, (data - line->data));
-  syntaxobject_setdata(obj, st, csyntaxstruct_free);
+  syntaxfilepos_set(&st->bodyendpos, line->lineno, (data - line->data));
+  syntaxobject_setdata(obj, st);
   syntaxfile_addobject(sf, name, obj);
   /* Set the current line and data ptr before we return. */
   *outline = line;
@@ -0,0 +1,372 @@
+/** @file ctoken.c
+
+  @author  Melwin Svensson.
+  @date    19-10-2026.
+
+ */
+#include "../../include/c_proto.h"
+
+#ifdef __SSE2__
+# include <emmintrin.h>
+#endif
+
+
+/* -------------------------------------------------------- CTokenClass -------------------------------------------------------- */
+
+/* What a byte can be the start of.  Every byte that is not in the table is a punctuation char of its own. */
+#define CTOKEN_CLASS_BLANK    (1 << 0)
+#define CTOKEN_CLASS_IDENT    (1 << 1)
+#define CTOKEN_CLASS_DIGIT    (1 << 2)
+#define CTOKEN_CLASS_QUOTE    (1 << 3)
+#define CTOKEN_CLASS_BRACKET  (1 << 4)
+
+/* The class of every byte.  Bytes above `0x7f` are part of a utf-8 sequence, and are treated as identifier chars. */
+static const Uchar ctoken_class[256] = {
+  [' ']  = CTOKEN_CLASS_BLANK,
+  ['\t'] = CTOKEN_CLASS_BLANK,
+  ['\r'] = CTOKEN_CLASS_BLANK,
+  ['\v'] = CTOKEN_CLASS_BLANK,
+  ['\f'] = CTOKEN_CLASS_BLANK,
+  ['a' ... 'z']   = CTOKEN_CLASS_IDENT,
+  ['A' ... 'Z']   = CTOKEN_CLASS_IDENT,
+  ['_']           = CTOKEN_CLASS_IDENT,
+  ['$']           = CTOKEN_CLASS_IDENT,
+  [0x80 ... 0xff] = CTOKEN_CLASS_IDENT,
+  ['0' ... '9']   = CTOKEN_CLASS_DIGIT,
+  ['"']  = CTOKEN_CLASS_QUOTE,
+  ['\''] = CTOKEN_CLASS_QUOTE,
+  ['(']  = CTOKEN_CLASS_BRACKET,
+  [')']  = CTOKEN_CLASS_BRACKET,
+  ['[']  = CTOKEN_CLASS_BRACKET,
+  [']']  = CTOKEN_CLASS_BRACKET,
+  ['{']  = CTOKEN_CLASS_BRACKET,
+  ['}']  = CTOKEN_CLASS_BRACKET,
+};
+
+#define CTOKEN_CLASS(c)  (ctoken_class[(Uchar)(c)])
+
+/* -------------------------------------------------------- CTokenScan -------------------------------------------------------- */
+
+/* Return`s the first char from `ptr` that is not blank, or `end`.  Indentation is the only long run of blanks in most
+ * code, so a run that is longer then one char is checked 16 bytes at a time when possible. */
+static inline const char *ctoken_skip_blank(const char *ptr, const char *const end) {
+#ifdef __SSE2__
+  __m128i space;
+  __m128i tab;
+  __m128i vec;
+  int mask;
+  /* Most runs are a single space, so only start comparing vectors when the run is longer. */
+  if ((end - ptr) >= 17 && ptr[0] == ptr[1]) {
+    space = _mm_set1_epi8(' ');
+    tab   = _mm_set1_epi8('\t');
+    while ((end - ptr) >= 16) {
+      vec  = _mm_loadu_si128((const __m128i *)ptr);
+      mask = (~_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(vec, space), _mm_cmpeq_epi8(vec, tab))) & 0xffff);
+      if (mask) {
+        return (ptr + __builtin_ctz(mask));
+      }
+      ptr += 16;
+    }
+  }
+#endif
+  while (ptr < end && (CTOKEN_CLASS(*ptr) & CTOKEN_CLASS_BLANK)) {
+    ++ptr;
+  }
+  return ptr;
+}
+
+/* Return`s the first `a` or `b` char from `ptr`, or `end` when there is none. */
+static inline const char *ctoken_find(const char *ptr, const char *const end, char a, char b) {
+#ifdef __SSE2__
+  __m128i va = _mm_set1_epi8(a);
+  __m128i vb = _mm_set1_epi8(b);
+  __m128i vec;
+  int mask;
+  while ((end - ptr) >= 16) {
+    vec  = _mm_loadu_si128((const __m128i *)ptr);
+    mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(vec, va), _mm_cmpeq_epi8(vec, vb)));
+    if (mask) {
+      return (ptr + __builtin_ctz(mask));
+    }
+    ptr += 16;
+  }
+#endif
+  while (ptr < end && *ptr != a && *ptr != b) {
+    ++ptr;
+  }
+  return ptr;
+}
+
+/* Return`s the char after the end of the block comment `ptr` is inside of, or `NULL` when it does not end on this line. */
+static inline const char *ctoken_block_comment_end(const char *ptr, const char *const end) {
+  while ((ptr = ctoken_find(ptr, end, '*', '*')) < end) {
+    if ((ptr + 1) < end && ptr[1] == '/') {
+      return (ptr + 2);
+    }
+    ++ptr;
+  }
+  return NULL;
+}
+
+/* Return`s the char after the `quote` that ends the literal `ptr` is inside of, or `end` when the literal is not closed. */
+static inline const char *ctoken_quote_end(const char *ptr, const char *const end, char quote) {
+  while ((ptr = ctoken_find(ptr, end, quote, '\\')) < end) {
+    if (*ptr == quote) {
+      return (ptr + 1);
+    }
+    /* Skip the escaped char. */
+    ptr += 2;
+  }
+  return end;
+}
+
+/* Return`s the char after the number that starts at `ptr`.  This is a preprocessing number, so suffixes, hex digits and exponents are included. */
+static inline const char *ctoken_number_end(const char *ptr, const char *const end) {
+  ++ptr;
+  while (ptr < end) {
+    if ((CTOKEN_CLASS(*ptr) & (CTOKEN_CLASS_IDENT | CTOKEN_CLASS_DIGIT)) || *ptr == '.') {
+      ++ptr;
+    }
+    else if ((*ptr == '+' || *ptr == '-') && (ptr[-1] == 'e' || ptr[-1] == 'E' || ptr[-1] == 'p' || ptr[-1] == 'P')) {
+      ++ptr;
+    }
+    else {
+      break;
+    }
+  }
+  return ptr;
+}
+
+/* -------------------------------------------------------- CTokenBuf -------------------------------------------------------- */
+
+/* Initialize `buf` as a empty buffer. */
+void ctokenbuf_init(CTokenBuf *const buf) {
+  ASSERT(buf);
+  buf->tokens = NULL;
+  buf->len    = 0;
+  buf->cap    = 0;
+}
+
+/* Free the tokens of `buf`, and leave it empty. */
+void ctokenbuf_free(CTokenBuf *const buf) {
+  ASSERT(buf);
+  free(buf->tokens);
+  ctokenbuf_init(buf);
+}
+
+/* Append a token to `buf`. */
+static inline void ctokenbuf_push(CTokenBuf *const buf, CTokenKind kind, Ulong offset, Ulong len) {
+  if (buf->len == buf->cap) {
+    buf->cap    = (buf->cap ? (buf->cap * 2) : 64);
+    buf->tokens = xrealloc(buf->tokens, (sizeof(*buf->tokens) * buf->cap));
+  }
+  buf->tokens[buf->len].offset = offset;
+  buf->tokens[buf->len].len    = len;
+  buf->tokens[buf->len].kind   = kind;
+  ++buf->len;
+}
+
+/* -------------------------------------------------------- CToken -------------------------------------------------------- */
+
+/* Tokenize the first `len` bytes of `data`, that is a single line of c or c++, into `buf`, replacing what was in it.  `state` is the
+ * state the previous line ended in, or `CTOKEN_STATE_NONE` for the first line, and the state this line ends in is returned.  Blanks
+ * are not tokens, and a block comment that spans lines gives a comment token on every line it is on.  Nothing is allocated unless
+ * `buf` has to grow, so the same buffer should be used for every line. */
+CTokenState ctoken_line(CTokenBuf *const buf, const char *const restrict data, Ulong len, CTokenState state) {
+  ASSERT(buf);
+  ASSERT(data || !len);
+  const char *end = (data + len);
+  const char *ptr = data;
+  const char *start;
+  CTokenKind kind;
+  buf->len = 0;
+  /* Finish the block comment the previous line ended in. */
+  if (state == CTOKEN_STATE_COMMENT) {
+    if (!(ptr = ctoken_block_comment_end(data, end))) {
+      ctokenbuf_push(buf, CTOKEN_COMMENT, 0, len);
+      return CTOKEN_STATE_COMMENT;
+    }
+    ctokenbuf_push(buf, CTOKEN_COMMENT, 0, (ptr - data));
+    state = CTOKEN_STATE_NONE;
+  }
+  /* A preprocessor line, the directive is a single token. */
+  else if ((ptr = ctoken_skip_blank(ptr, end)) < end && *ptr == '#') {
+    start = ptr;
+    ptr   = ctoken_skip_blank((ptr + 1), end);
+    while (ptr < end && (CTOKEN_CLASS(*ptr) & CTOKEN_CLASS_IDENT)) {
+      ++ptr;
+    }
+    ctokenbuf_push(buf, CTOKEN_PREPROCESSOR, (start - data), (ptr - start));
+  }
+  while ((ptr = ctoken_skip_blank(ptr, end)) < end) {
+    start = ptr;
+    if (CTOKEN_CLASS(*ptr) & CTOKEN_CLASS_IDENT) {
+      do {
+        ++ptr;
+      } while (ptr < end && (CTOKEN_CLASS(*ptr) & (CTOKEN_CLASS_IDENT | CTOKEN_CLASS_DIGIT)));
+      kind = CTOKEN_WORD;
+    }
+    else if ((CTOKEN_CLASS(*ptr) & CTOKEN_CLASS_DIGIT) || (*ptr == '.' && (ptr + 1) < end && (CTOKEN_CLASS(ptr[1]) & CTOKEN_CLASS_DIGIT))) {
+      ptr  = ctoken_number_end(ptr, end);
+      kind = CTOKEN_NUMBER;
+    }
+    else if (CTOKEN_CLASS(*ptr) & CTOKEN_CLASS_QUOTE) {
+      kind = ((*ptr == '"') ? CTOKEN_STRING : CTOKEN_CHAR);
+      ptr  = ctoken_quote_end((ptr + 1), end, *ptr);
+    }
+    else if (*ptr == '/' && (ptr + 1) < end && ptr[1] == '/') {
+      ptr  = end;
+      kind = CTOKEN_COMMENT;
+    }
+    else if (*ptr == '/' && (ptr + 1) < end && ptr[1] == '*') {
+      if (!(ptr = ctoken_block_comment_end((ptr + 2), end))) {
+        ptr   = end;
+        state = CTOKEN_STATE_COMMENT;
+      }
+      kind = CTOKEN_COMMENT;
+    }
+    else if (CTOKEN_CLASS(*ptr) & CTOKEN_CLASS_BRACKET) {
+      ++ptr;
+      kind = CTOKEN_BRACKET;
+    }
+    else {
+      ++ptr;
+      kind = CTOKEN_PUNCT;
+    }
+    ctokenbuf_push(buf, kind, (start - data), (ptr - start));
+  }
+  return state;
+}
+
+/* -------------------------------------------------------- Tests -------------------------------------------------------- */
+
+/* The most tokens a line in `ctoken_tests` gives. */
+#define CTOKEN_TEST_MAX_TOKENS  (10)
+
+/* A token a test line should give, the list ends at the first one without `text`. */
+typedef struct {
+  CTokenKind  kind;
+  const char *text;
+} CTokenTestToken;
+
+/* A line to tokenize, the state the previous line ended in, and the tokens and state it should give. */
+typedef struct {
+  const char     *line;
+  CTokenState     state;
+  CTokenState     result;
+  CTokenTestToken tokens[CTOKEN_TEST_MAX_TOKENS];
+} CTokenTest;
+
+static const CTokenTest ctoken_tests[] = {
+  /* Words, numbers and punctuation. */
+  { "int x = 0x1fUL;", CTOKEN_STATE_NONE, CTOKEN_STATE_NONE, {
+    {CTOKEN_WORD, "int"}, {CTOKEN_WORD, "x"}, {CTOKEN_PUNCT, "="}, {CTOKEN_NUMBER, "0x1fUL"}, {CTOKEN_PUNCT, ";"} } },
+  /* Preprocessing numbers take a sign only after a exponent, and can start with a dot. */
+  { "1e+5 + .5f - 0x1p-3", CTOKEN_STATE_NONE, CTOKEN_STATE_NONE, {
+    {CTOKEN_NUMBER, "1e+5"}, {CTOKEN_PUNCT, "+"}, {CTOKEN_NUMBER, ".5f"}, {CTOKEN_PUNCT, "-"}, {CTOKEN_NUMBER, "0x1p-3"} } },
+  { "1+2 0xe+1 a.b", CTOKEN_STATE_NONE, CTOKEN_STATE_NONE, {
+    {CTOKEN_NUMBER, "1"}, {CTOKEN_PUNCT, "+"}, {CTOKEN_NUMBER, "2"}, {CTOKEN_NUMBER, "0xe+1"},
+    {CTOKEN_WORD, "a"}, {CTOKEN_PUNCT, "."}, {CTOKEN_WORD, "b"} } },
+  /* Escaped quotes and backslashes do not end a literal. */
+  { "\"a\\\"b\" 'x' '\\''", CTOKEN_STATE_NONE, CTOKEN_STATE_NONE, {
+    {CTOKEN_STRING, "\"a\\\"b\""}, {CTOKEN_CHAR, "'x'"}, {CTOKEN_CHAR, "'\\''"} } },
+  { "\"\\\\\" x", CTOKEN_STATE_NONE, CTOKEN_STATE_NONE, {
+    {CTOKEN_STRING, "\"\\\\\""}, {CTOKEN_WORD, "x"} } },
+  { "\"open \\", CTOKEN_STATE_NONE, CTOKEN_STATE_NONE, {
+    {CTOKEN_STRING, "\"open \\"} } },
+  /* A block comment carries over to the next lines until it ends. */
+  { "int a; /* start", CTOKEN_STATE_NONE, CTOKEN_STATE_COMMENT, {
+    {CTOKEN_WORD, "int"}, {CTOKEN_WORD, "a"}, {CTOKEN_PUNCT, ";"}, {CTOKEN_COMMENT, "/* start"} } },
+  { "  # not a directive", CTOKEN_STATE_COMMENT, CTOKEN_STATE_COMMENT, {
+    {CTOKEN_COMMENT, "  # not a directive"} } },
+  { "still */ b", CTOKEN_STATE_COMMENT, CTOKEN_STATE_NONE, {
+    {CTOKEN_COMMENT, "still */"}, {CTOKEN_WORD, "b"} } },
+  { "/* one */ c /* two", CTOKEN_STATE_NONE, CTOKEN_STATE_COMMENT, {
+    {CTOKEN_COMMENT, "/* one */"}, {CTOKEN_WORD, "c"}, {CTOKEN_COMMENT, "/* two"} } },
+  { "/*/ x */", CTOKEN_STATE_NONE, CTOKEN_STATE_NONE, {
+    {CTOKEN_COMMENT, "/*/ x */"} } },
+  { "x // y /*", CTOKEN_STATE_NONE, CTOKEN_STATE_NONE, {
+    {CTOKEN_WORD, "x"}, {CTOKEN_COMMENT, "// y /*"} } },
+  /* The directive of a preprocessor line is a single token. */
+  { "  #  include <a.h>", CTOKEN_STATE_NONE, CTOKEN_STATE_NONE, {
+    {CTOKEN_PREPROCESSOR, "#  include"}, {CTOKEN_PUNCT, "<"}, {CTOKEN_WORD, "a"}, {CTOKEN_PUNCT, "."},
+    {CTOKEN_WORD, "h"}, {CTOKEN_PUNCT, ">"} } },
+  { "f(a[1]){}", CTOKEN_STATE_NONE, CTOKEN_STATE_NONE, {
+    {CTOKEN_WORD, "f"}, {CTOKEN_BRACKET, "("}, {CTOKEN_WORD, "a"}, {CTOKEN_BRACKET, "["}, {CTOKEN_NUMBER, "1"},
+    {CTOKEN_BRACKET, "]"}, {CTOKEN_BRACKET, ")"}, {CTOKEN_BRACKET, "{"}, {CTOKEN_BRACKET, "}"} } },
+  { "", CTOKEN_STATE_COMMENT, CTOKEN_STATE_COMMENT, {
+    {CTOKEN_COMMENT, ""} } },
+};
+
+/* Tokenize every line in `ctoken_tests`, and assert that each gives the tokens and state it should. */
+void ctoken_test(void) {
+  const CTokenTest *test;
+  CTokenBuf buf;
+  CTokenState state;
+  Ulong expected;
+  ctokenbuf_init(&buf);
+  for (Ulong i=0; i<ARRAY_SIZE(ctoken_tests); ++i) {
+    test  = &ctoken_tests[i];
+    state = ctoken_line(&buf, test->line, strlen(test->line), test->state);
+    for (expected=0; expected<CTOKEN_TEST_MAX_TOKENS && test->tokens[expected].text; ++expected);
+    if (state != test->result || buf.len != expected) {
+      writef("%s: '%s': Tokens: %lu, expected %lu: State: %d, expected %d\n", __func__, test->line, buf.len, expected, state, test->result);
+    }
+    ALWAYS_ASSERT(state == test->result);
+    ALWAYS_ASSERT(buf.len == expected);
+    for (Ulong t=0; t<buf.len; ++t) {
+      if (buf.tokens[t].kind != test->tokens[t].kind || buf.tokens[t].len != strlen(test->tokens[t].text)
+       || memcmp((test->line + buf.tokens[t].offset), test->tokens[t].text, buf.tokens[t].len) != 0) {
+        writef("%s: '%s': Token %lu is '%.*s', expected '%s'\n",
+          __func__, test->line, t, (int)buf.tokens[t].len, (test->line + buf.tokens[t].offset), test->tokens[t].text);
+        ALWAYS_ASSERT_MSG(FALSE, "ctoken_line() gave the wrong token");
+      }
+    }
+  }
+  ctokenbuf_free(&buf);
+  writef("%s: Passed\n", __func__);
+}
+
+/* Tokenize every c source and header in `/usr/include`, and print the throughput.  Only the tokenizing is timed, not the reading. */
+void ctoken_test_bench(void) {
+  SyntaxFile *sf;
+  CTokenBuf buf;
+  CTokenState state;
+  char **paths;
+  Ulong npaths;
+  Ulong files  = 0;
+  Ulong lines  = 0;
+  Ulong bytes  = 0;
+  Ulong tokens = 0;
+  Ulong words  = 0;
+  double total = 0;
+  ctokenbuf_init(&buf);
+  paths = syntaxfile_test_paths("/usr/include", &npaths);
+  for (Ulong i=0; i<npaths; ++i) {
+    sf = syntaxfile_create();
+    syntaxfile_read(sf, paths[i]);
+    if (sf->filetop) {
+      state = CTOKEN_STATE_NONE;
+      timer_action(ms,
+        for (SyntaxFileLine *line=sf->filetop; line; line=line->next) {
+          state   = ctoken_line(&buf, line->data, line->len, state);
+          tokens += buf.len;
+          for (Ulong t=0; t<buf.len; ++t) {
+            words += (buf.tokens[t].kind == CTOKEN_WORD);
+          }
+        }
+      );
+      total += ms;
+      ++files;
+      lines += sf->nlines;
+      bytes += sf->size;
+    }
+    syntaxfile_free(sf);
+    free(paths[i]);
+  }
+  free(paths);
+  ctokenbuf_free(&buf);
+  writef("\n%s: Files: %lu: Lines: %lu: Tokens: %lu: Words: %lu: Time: %.3f ms: %.0f tokens/sec: %.1f MB/sec\n\n",
+    __func__, files, lines, tokens, words, total, (total > 0 ? (tokens / (total / 1000.0)) : 0),
+    (total > 0 ? ((bytes / (1024.0 * 1024.0)) / (total / 1000.0)) : 0));
+}
@@ -5,24 +5,106 @@
 
  */
 #include "../../include/c_proto.h"
+#include "../perf/ntrace.h"
 
 
-/* -------------------------------------------------------- SyntaxFileError -------------------------------------------------------- */
+/* -------------------------------------------------------- SyntaxArena -------------------------------------------------------- */
 
-/* Create a new allocated `SyntaxFilePos` structure. */
-SyntaxFilePos *syntaxfilepos_create(int row, int column) {
-  SyntaxFilePos *pos = xmalloc(sizeof(*pos));
-  pos->row    = row;
-  pos->column = column;
-  return pos;
+/* The size of the first block of a arena, every new block is twice the size of the last, up to `SYNTAX_ARENA_MAX_BLOCK`.
+ * Most files only produce a few objects, so the first block is kept small. */
+#define SYNTAX_ARENA_MIN_BLOCK  (4096)
+#define SYNTAX_ARENA_MAX_BLOCK  (65536)
+#define SYNTAX_ARENA_ALIGN      (16)
+
+/* Initialize `arena` as a empty arena.  Zeroing the structure does the same. */
+void syntaxarena_init(SyntaxArena *const arena) {
+  ASSERT(arena);
+  arena->head    = NULL;
+  arena->tail    = NULL;
+  arena->nblocks = 0;
+  arena->size    = 0;
+}
+
+/* Free every block of `arena`, and with that everything that was allocated from it, then leave it empty. */
+void syntaxarena_free(SyntaxArena *const arena) {
+  ASSERT(arena);
+  SyntaxArenaBlock *block = arena->head;
+  SyntaxArenaBlock *next;
+  while (block) {
+    next = block->next;
+    free(block);
+    block = next;
+  }
+  syntaxarena_init(arena);
 }
 
-/* Free a `SyntaxFilePos` structure. */
-void syntaxfilepos_free(SyntaxFilePos *const pos) {
-  free(pos);
+/* Return`s `size` bytes from `arena`, aligned for any type.  A new block is only made when the current one is full. */
+void *syntaxarena_alloc(SyntaxArena *const arena, Ulong size) {
+  ASSERT(arena);
+  SyntaxArenaBlock *block = arena->head;
+  Ulong offset = 0;
+  Ulong cap;
+  if (block) {
+    offset = ((block->used + SYNTAX_ARENA_ALIGN - 1) & ~(Ulong)(SYNTAX_ARENA_ALIGN - 1));
+  }
+  if (!block || (offset + size) > block->cap) {
+    cap = (block ? (block->cap * 2) : SYNTAX_ARENA_MIN_BLOCK);
+    if (cap > SYNTAX_ARENA_MAX_BLOCK) {
+      cap = SYNTAX_ARENA_MAX_BLOCK;
+    }
+    if (cap < size) {
+      cap = size;
+    }
+    block = xmalloc(sizeof(*block) + cap);
+    block->next = arena->head;
+    block->used = 0;
+    block->cap  = cap;
+    /* The new block is the one allocations are made from, the old one is kept in the list until the arena is freed. */
+    if (!arena->tail) {
+      arena->tail = block;
+    }
+    arena->head = block;
+    ++arena->nblocks;
+    offset = 0;
+  }
+  block->used  = (offset + size);
+  arena->size += size;
+  return (block->data + offset);
+}
+
+/* Return`s a copy of `len` bytes of `string` allocated in `arena`, that is always `NULL-TERMINATED`. */
+char *syntaxarena_copy(SyntaxArena *const arena, const char *const restrict string, Ulong len) {
+  ASSERT(arena);
+  ASSERT(string);
+  char *ret = syntaxarena_alloc(arena, (len + 1));
+  memcpy(ret, string, len);
+  ret[len] = '\0';
+  return ret;
+}
+
+/* Move every block of `src` into `dst`, so everything that was allocated from `src` is now owned by `dst`, and `src` is left empty. */
+void syntaxarena_take(SyntaxArena *const dst, SyntaxArena *const src) {
+  ASSERT(dst);
+  ASSERT(src);
+  if (!src->head) {
+    return;
+  }
+  /* Append the blocks of `src` after the last block of `dst`, so `dst` keeps allocating from its own current block. */
+  if (!dst->head) {
+    dst->head = src->head;
+  }
+  else {
+    dst->tail->next = src->head;
+  }
+  dst->tail     = src->tail;
+  dst->nblocks += src->nblocks;
+  dst->size    += src->size;
+  syntaxarena_init(src);
 }
 
-/* Set the values for a allocated `SyntaxFilePos` structure. */
+/* -------------------------------------------------------- SyntaxFilePos -------------------------------------------------------- */
+
+/* Set the values of a `SyntaxFilePos` structure. */
 void syntaxfilepos_set(SyntaxFilePos *const pos, int row, int column) {
   ASSERT(pos);
   pos->row    = row;
@@ -119,137 +201,82 @@ void syntaxfileline_from_str(const char *const restrict string, SyntaxFileLine *
 
 /* -------------------------------------------------------- SyntaxObject -------------------------------------------------------- */
 
-/* Create a allocated blank SyntaxObject structure. */
-SyntaxObject *syntaxobject_create(void) {
-  SyntaxObject *node = xmalloc(sizeof(*node));
+/* Create a blank SyntaxObject structure in `arena`, it is freed together with the arena. */
+SyntaxObject *syntaxobject_create(SyntaxArena *const arena) {
+  ASSERT(arena);
+  SyntaxObject *node = syntaxarena_alloc(arena, sizeof(*node));
   node->file = NULL;
   /* Make this the only object in the double circular list. */
-  node->prev     = node;
-  node->next     = node;
-  node->color    = SYNTAX_COLOR_NONE;
-  node->type     = SYNTAX_OBJECT_TYPE_NONE;
-  node->pos      = syntaxfilepos_create(0, 0);
-  node->data     = NULL;
-  node->freedata = NULL;
+  node->prev  = node;
+  node->next  = node;
+  node->color = SYNTAX_COLOR_NONE;
+  node->type  = SYNTAX_OBJECT_TYPE_NONE;
+  node->data  = NULL;
+  syntaxfilepos_set(&node->pos, 0, 0);
   return node;
 }
 
-/* Free a SyntaxObject structure. */
-void syntaxobject_free(SyntaxObject *const obj) {
-  ASSERT(obj);
-  ASSERT(obj->pos);
-  free(obj->file);
-  CALL_IF_VALID(obj->freedata, obj->data);
-  syntaxfilepos_free(obj->pos);
-  free(obj);
-}
-
-/* Unlink and free a SyntaxObject structure from its double linked list. */
+/* Unlink a SyntaxObject structure from its double linked list.  The object itself stays in its arena until the arena is freed. */
 void syntaxobject_unlink(SyntaxObject *const obj) {
   ASSERT(obj);
-  ASSERT(obj->pos);
   CLIST_UNLINK(obj);
-  syntaxobject_free(obj);
-}
-
-/* Free a entire double linked list of SyntaxObject structure's. */
-void syntaxobject_free_objects(void *ptr) {
-  SyntaxObject *head = ptr;
-  ASSERT(head);
-  ASSERT(head->pos);
-  /* If there are any stacked objects, free all of them. */
-  while (head != head->next) {
-    syntaxobject_unlink(head->next);
-  }
-  syntaxobject_free(head);
 }
 
-/* Set the file in `obj` so we know where it was parsed from. */
+/* Set the file in `obj` so we know where it was parsed from.  This is not copied, so `file` must live as long as `obj`. */
 void syntaxobject_setfile(SyntaxObject *const obj, const char *const restrict file) {
   ASSERT(obj);
   ASSERT(file);
-  obj->file = copy_of(file);
+  obj->file = file;
 }
 
-/* Set a `SyntaxObject`'s data, and the function that will be used to free it, or `NULL` when not needed. */
-void syntaxobject_setdata(SyntaxObject *const obj, void *const data, FreeFuncPtr freedatafunc) {
+/* Set a `SyntaxObject`'s data, this should be allocated in the same arena as `obj`. */
+void syntaxobject_setdata(SyntaxObject *const obj, void *const data) {
   ASSERT(obj);
-  ASSERT(obj->pos);
   ASSERT(data);
-  ASSERT(freedatafunc);
-  obj->data     = data;
-  obj->freedata = freedatafunc;
+  obj->data = data;
 }
 
 /* Set the row and column of this `SyntaxObject`. */
 void syntaxobject_setpos(SyntaxObject *const obj, int row, int column) {
   ASSERT(obj);
-  ASSERT(obj->pos);
-  obj->pos->row    = row;
-  obj->pos->column = column;
+  syntaxfilepos_set(&obj->pos, row, column);
 }
 
 /* Set the color of a `SyntaxObject`.  NOTE: we will probebly change the internal strucure later to just have a 4 float or 4 char based color. */
 void syntaxobject_setcolor(SyntaxObject *const obj, SyntaxColor color) {
   ASSERT(obj);
-  ASSERT(obj->pos);
   obj->color = color;
 }
 
 /* Set the `type` of a `SyntaxObject`. */
 void syntaxobject_settype(SyntaxObject *const obj, SyntaxObjectType type) {
   ASSERT(obj);
-  ASSERT(obj->pos);
   obj->type = type;
 }
 
 /* -------------------------------------------------------- SyntaxFileError -------------------------------------------------------- */
 
-/* Create a new `SyntaxFileError *` and append it to the end of a double linked list of errors, or `NULL` for first error. */
-SyntaxFileError *syntaxfileerror_create(SyntaxFileError *const prev) {
-  SyntaxFileError *node = xmalloc(sizeof(*node));
+/* Create a new `SyntaxFileError *` in `arena` and append it to the end of a double linked list of errors, or `NULL` for first error. */
+SyntaxFileError *syntaxfileerror_create(SyntaxArena *const arena, SyntaxFileError *const prev) {
+  ASSERT(arena);
+  SyntaxFileError *node = syntaxarena_alloc(arena, sizeof(*node));
   node->prev = prev;
   node->next = NULL;
   node->file = NULL;
   node->msg  = NULL;
-  node->pos  = syntaxfilepos_create(0, 0);
+  syntaxfilepos_set(&node->pos, 0, 0);
   return node;
 }
 
-/* Free a allocated `SyntaxFileError` struct. */
-void syntaxfileerror_free(SyntaxFileError *const err) {
-  ASSERT(err);
-  ASSERT(err->pos);
-  free(err->file);
-  free(err->msg);
-  syntaxfilepos_free(err->pos);
-  free(err);
-}
-
-/* Unlink `error` from the double linked list. */
+/* Unlink `error` from the double linked list.  The error itself stays in its arena until the arena is freed. */
 void syntaxfileerror_unlink(SyntaxFileError *const err) {
   ASSERT(err);
-  ASSERT(err->pos);
   if (err->prev) {
     err->prev->next = err->next;
   }
   if (err->next) {
     err->next->prev = err->prev;
   }
-  syntaxfileerror_free(err);
-}
-
-/* Free a entire double linked list of `SyntaxFileError` structure's. */
-void syntaxfileerror_free_errors(SyntaxFileError *head) {
-  /* Make this function NULL-SAFE. */
-  if (!head) {
-    return;
-  }
-  while (head->next) {
-    head = head->next;
-    syntaxfileerror_free(head->prev);
-  }
-  syntaxfileerror_free(head);
 }
 
 /* -------------------------------------------------------- SyntaxFile -------------------------------------------------------- */
@@ -263,56 +290,97 @@ SyntaxFile *syntaxfile_create(void) {
   sfile->errtop  = NULL;
   sfile->errbot  = NULL;
   sfile->stat    = NULL;
+  sfile->data    = NULL;
+  sfile->size    = 0;
+  sfile->lines   = NULL;
+  sfile->nlines  = 0;
+  /* The objects are owned by the arena, so the map does not free them. */
   sfile->objects = hashmap_create();
-  hashmap_set_free_value_callback(sfile->objects, syntaxobject_free_objects);
+  syntaxarena_init(&sfile->arena);
   return sfile;
 }
 
-/* Free a `SyntaxFile` structure. */
+/* Free a `SyntaxFile` structure, and with its arena every object and error that was not taken from it. */
 void syntaxfile_free(SyntaxFile *const sf) {
   ASSERT(sf);
   ASSERT(sf->objects);
-  free(sf->path);
   hashmap_free(sf->objects);
-  syntaxfileline_free_lines(sf->filetop);
-  syntaxfileerror_free_errors(sf->errtop);
+  /* When the file was read, the lines are slices of `data`, otherwise they are a list of their own. */
+  if (sf->lines) {
+    free(sf->lines);
+    free(sf->data);
+  }
+  else {
+    syntaxfileline_free_lines(sf->filetop);
+  }
+  syntaxarena_free(&sf->arena);
   free(sf);
 }
 
-/* Read the file at `path` into the `SyntaxFile` struct `sfile`. */
+/* Split the data of `sf` into lines.  All lines live in a single array, and are slices of the data, the only change made to the
+ * data is that every newline becomes a `NULL-TERMINATOR`.  The lines are still linked, so they can be walked like any other. */
+static void syntaxfile_split_lines(SyntaxFile *const sf) {
+  ASSERT(sf);
+  ASSERT(sf->data);
+  SyntaxFileLine *line;
+  char *data = sf->data;
+  char *end  = (sf->data + sf->size);
+  char *nl;
+  Ulong nlines = 1;
+  /* Count the lines first, so they can be allocated at once. */
+  for (nl=memchr(data, '\n', sf->size); nl; nl=memchr((nl + 1), '\n', (end - (nl + 1)))) {
+    ++nlines;
+  }
+  sf->lines  = xmalloc(sizeof(*sf->lines) * nlines);
+  sf->nlines = nlines;
+  for (Ulong i=0; i<nlines; ++i) {
+    line = &sf->lines[i];
+    nl   = memchr(data, '\n', (end - data));
+    line->prev   = (i ? (line - 1) : NULL);
+    line->next   = (((i + 1) < nlines) ? (line + 1) : NULL);
+    line->data   = data;
+    line->len    = ((nl ? nl : end) - data);
+    line->lineno = (i + 1);
+    if (nl) {
+      *nl  = '\0';
+      data = (nl + 1);
+    }
+  }
+  sf->filetop = sf->lines;
+  sf->filebot = &sf->lines[nlines - 1];
+}
+
+/* Read the file at `path` into the `SyntaxFile` struct `sfile`.  The data is read into a single buffer the size of the file,
+ * and the lines are slices of it, so reading a file is two allocations no matter how many lines it has. */
 void syntaxfile_read(SyntaxFile *const sf, const char *const restrict path) {
   ASSERT(sf);
   ASSERT(path);
-  char *data;
-  char  buffer[4096];
-  Ulong bytes_read, total_bytes=0;
+  struct stat st;
+  Ulong total = 0;
+  long  bytes_read;
   int   fd;
   /* If the file does not exist, return early. */
   if (!file_exists(path)) {
     return;
   }
-  /* If the file exists, set the syntaxfile path to its path. */
-  sf->path = copy_of(path);
-  /* Init the data ptr. */
-  data = xmalloc(1);
+  /* If the file exists, set the syntaxfile path to its path.  It lives in the arena, as every object and error refers to it. */
+  sf->path = syntaxarena_copy(&sf->arena, path, strlen(path));
   /* Open the fd as a read only file-descriptor. */
   ALWAYS_ASSERT_MSG(((fd = open(path, O_RDONLY)) >= 0), strerror(errno));
   /* Perform the reading under lock. */
   fdlock_action(fd, F_RDLCK,
-    /* Read all data from fd. */
-    while ((bytes_read = read(fd, buffer, sizeof(buffer))) > 0) {
-      data = xrealloc(data, (bytes_read + total_bytes + 1));
-      memcpy((data + total_bytes), buffer, bytes_read);
-      total_bytes += bytes_read;
+    ALWAYS_ASSERT_MSG((fstat(fd, &st) == 0), strerror(errno));
+    /* Size the buffer once, and read straight into it. */
+    sf->data = xmalloc(st.st_size + 1);
+    while (total < (Ulong)st.st_size && (bytes_read = read(fd, (sf->data + total), (st.st_size - total))) > 0) {
+      total += bytes_read;
     }
   );
   /* Null terminate the data buffer and close the fd. */
-  data[total_bytes] = '\0';
+  sf->data[total] = '\0';
+  sf->size = total;
   close(fd);
-  /* Split the data into lines. */
-  syntaxfileline_from_str(data, &sf->filetop, &sf->filebot);
-  /* Free the data after we create the lines. */
-  free(data);
+  syntaxfile_split_lines(sf);
 }
 
 /* Add a error to the `SyntaxFile`. */
@@ -320,21 +388,20 @@ void syntaxfile_adderror(SyntaxFile *const sf, int row, int column, const char *
   ASSERT(sf);
   /* If this is the first error, both errtop and errbot will point to the same data. */
   if (!sf->errtop) {
-    sf->errtop = syntaxfileerror_create(NULL);
+    sf->errtop = syntaxfileerror_create(&sf->arena, NULL);
     sf->errbot = sf->errtop;
   }
   /* Otherwise, append a new error to errbot, and set errbot to the new error. */
   else {
-    sf->errbot->next = syntaxfileerror_create(sf->errbot);
+    sf->errbot->next = syntaxfileerror_create(&sf->arena, sf->errbot);
     sf->errbot = sf->errbot->next;
   }
   /* Set the position data for the error. */
-  sf->errbot->pos->row    = row;
-  sf->errbot->pos->column = column;
+  syntaxfilepos_set(&sf->errbot->pos, row, column);
   /* Set the file this error is from. */
-  sf->errbot->file = copy_of(sf->path);
+  sf->errbot->file = sf->path;
   /* Set the message of the error. */
-  sf->errbot->msg = copy_of(msg);
+  sf->errbot->msg = syntaxarena_copy(&sf->arena, msg, strlen(msg));
 }
 
 /* Add a SyntaxObject to the hashmap of a SyntaxFile structure, and if it exists, append it to the double linked list that is the object's. */
@@ -358,11 +425,34 @@ void syntaxfile_addobject(SyntaxFile *const sf, const char *const restrict key,
 }
 
 
-/* -------------------------------------------------------- Tests -------------------------------------------------------- */
-
-static HashMap *globmap = NULL;
-
-static void syntaxfile_test_append_node(void *dst, void *src) {
+/* -------------------------------------------------------- SyntaxParse -------------------------------------------------------- */
+
+/* The number of files a worker takes at once.  Headers differ a lot in size, so the files are handed out in small batches
+ * as workers become free, rather then split evenly up front. */
+#define SYNTAX_PARSE_BATCH        (8)
+#define SYNTAX_PARSE_MAX_THREADS  (32)
+
+typedef struct {
+  char *const *paths;
+  Ulong npaths;
+  Ulong next;   /* The next file to hand out, only accessed atomically. */
+} SyntaxParseQueue;
+
+typedef struct {
+  SyntaxParseQueue *queue;
+  int              id;
+  HashMap         *objects;  /* Every object this worker parsed, merged by name. */
+  SyntaxFileError *errtop;   /* Every error this worker found. */
+  SyntaxFileError *errbot;
+  SyntaxArena      arena;    /* Owns every object and error of this worker. */
+  Ulong files;
+  Ulong lines;
+  Ulong nobjects;
+  Ulong nerrors;
+} SyntaxParseWorker;
+
+/* Append the objects in the list `src` to the list `dst`, used when merging objects with the same name. */
+static void syntaxobject_append_list(void *dst, void *src) {
   ASSERT(dst);
   ASSERT(src);
   SyntaxObject *dst_head = dst;
@@ -375,46 +465,201 @@ static void syntaxfile_test_append_node(void *dst, void *src) {
   dst_head->prev = src_tail;
 }
 
-static void syntaxfile_test_read_one_file(const char *path, Ulong *nlines, Ulong *nobj) {
-  ASSERT(path);
-  SyntaxFileError *err;
-  SyntaxFile *sfile = syntaxfile_create();
-  syntaxfile_read(sfile, path);
-  // process_syntaxfile_c(sfile);
-  syntaxfile_parse_csyntax(sfile);
-  if (sfile->errtop) {
-    err = sfile->errtop;
-    while (err) {
-      writef("%s:[%d:%d]: %s\n", err->file, err->pos->row, err->pos->column, err->msg);
-      err = err->next;
+/* Parse the file at `path` with a `SyntaxFile` of its own, and move what it produced into `worker`. */
+static void syntaxfile_parse_one(SyntaxParseWorker *const worker, const char *const restrict path) {
+  SyntaxFile *sf = syntaxfile_create();
+  syntaxfile_read(sf, path);
+  if (sf->filetop) {
+    syntaxfile_parse_csyntax(sf);
+    ++worker->files;
+    worker->lines    += sf->filebot->lineno;
+    worker->nobjects += hashmap_size(sf->objects);
+    /* Take over the errors. */
+    if (sf->errtop) {
+      for (SyntaxFileError *err=sf->errtop; err; err=err->next) {
+        ++worker->nerrors;
+      }
+      if (!worker->errtop) {
+        worker->errtop = sf->errtop;
+      }
+      else {
+        worker->errbot->next = sf->errtop;
+        sf->errtop->prev     = worker->errbot;
+      }
+      worker->errbot = sf->errbot;
+      sf->errtop = NULL;
+      sf->errbot = NULL;
     }
+    hashmap_append_waction(worker->objects, sf->objects, syntaxobject_append_list);
+    /* And the memory all of it lives in. */
+    syntaxarena_take(&worker->arena, &sf->arena);
   }
-  ASSIGN_IF_VALID(nlines, sfile->filebot->lineno);
-  ASSIGN_IF_VALID(nobj, hashmap_size(sfile->objects));
-  hashmap_append_waction(globmap, sfile->objects, syntaxfile_test_append_node);
-  syntaxfile_free(sfile);
+  syntaxfile_free(sf);
 }
 
-void syntaxfile_test_read(void) {
-  globmap = hashmap_create();
-  hashmap_set_free_value_callback(globmap, syntaxobject_free_objects);
-  Ulong num_lines, total_lines=0, files_read=0, num_obj, tot_obj=0;
-  directory_t dir;
-  directory_data_init(&dir);
-  timer_action(ms,
-    if (directory_get_recurse("/usr/include", &dir) != -1) {
-      DIRECTORY_ITER(dir, i, entry,
-        if (directory_entry_is_non_exec_file(entry) && entry->ext && (strcmp(entry->ext, "h") == 0 || strcmp(entry->ext, "c") == 0)) {
-          syntaxfile_test_read_one_file(entry->path, &num_lines, &num_obj);
-          total_lines += num_lines;
-          ++files_read;
-          tot_obj += num_obj;
+/* The task every worker thread runs, taking batches of files until there are none left. */
+static void *syntaxfile_parse_task(void *arg) {
+  SyntaxParseWorker *worker = arg;
+  SyntaxParseQueue  *queue  = worker->queue;
+  Ulong start;
+  Ulong end;
+  ntrace_thread_name("synx %d", worker->id);
+  while ((start = __atomic_fetch_add(&queue->next, SYNTAX_PARSE_BATCH, __ATOMIC_RELAXED)) < queue->npaths) {
+    end = (start + SYNTAX_PARSE_BATCH);
+    if (end > queue->npaths) {
+      end = queue->npaths;
+    }
+    ntrace_begin(__func__);
+    for (Ulong i=start; i<end; ++i) {
+      syntaxfile_parse_one(worker, queue->paths[i]);
+    }
+    ntrace_end(__func__);
+  }
+  return NULL;
+}
+
+/* Parse every file in `paths` as c syntax, using `nthreads` threads, or one per cpu when `nthreads` is `0`.  Every file is parsed
+ * by a `SyntaxFile` of its own, the objects are merged per thread, and then all merged into `objects` at the end.  Everything in
+ * `objects` is owned by `arena`, so `objects` must not free its values, and `arena` must be freed after it.  When `errors` is not
+ * `NULL`, it is set to a list of every error found, that also lives in `arena`.  The totals are put in `stats`. */
+void syntaxfile_parse_files(char *const *const paths, Ulong npaths, int nthreads, HashMap *const objects, SyntaxArena *const arena, SyntaxFileError **const errors, SyntaxParseStats *const stats) {
+  ASSERT(paths || !npaths);
+  ASSERT(objects);
+  ASSERT(arena);
+  ASSERT(stats);
+  pthread_t         threads[SYNTAX_PARSE_MAX_THREADS];
+  SyntaxParseWorker workers[SYNTAX_PARSE_MAX_THREADS];
+  SyntaxParseQueue  queue = { paths, npaths, 0 };
+  SyntaxFileError  *errtop = NULL;
+  SyntaxFileError  *errbot = NULL;
+  Ulong             nbatches = ((npaths + SYNTAX_PARSE_BATCH - 1) / SYNTAX_PARSE_BATCH);
+  if (nthreads <= 0) {
+    nthreads = sysconf(_SC_NPROCESSORS_ONLN);
+  }
+  if (nthreads > SYNTAX_PARSE_MAX_THREADS) {
+    nthreads = SYNTAX_PARSE_MAX_THREADS;
+  }
+  /* There is no point in having threads without any files. */
+  if ((Ulong)nthreads > nbatches) {
+    nthreads = nbatches;
+  }
+  if (nthreads < 1) {
+    nthreads = 1;
+  }
+  memset(stats, 0, sizeof(*stats));
+  stats->threads = nthreads;
+  timer_action(parse_ms,
+    for (int i=0; i<nthreads; ++i) {
+      memset(&workers[i], 0, sizeof(workers[i]));
+      workers[i].queue   = &queue;
+      workers[i].id      = i;
+      workers[i].objects = hashmap_create();
+      /* The calling thread does the work of the first worker. */
+      if (i) {
+        ALWAYS_ASSERT(pthread_create(&threads[i], NULL, syntaxfile_parse_task, &workers[i]) == 0);
+      }
+    }
+    syntaxfile_parse_task(&workers[0]);
+    for (int i=1; i<nthreads; ++i) {
+      pthread_join(threads[i], NULL);
+    }
+  );
+  /* Reduce every worker into the result. */
+  timer_action(merge_ms,
+    for (int i=0; i<nthreads; ++i) {
+      hashmap_append_waction(objects, workers[i].objects, syntaxobject_append_list);
+      hashmap_free(workers[i].objects);
+      syntaxarena_take(arena, &workers[i].arena);
+      if (workers[i].errtop) {
+        if (!errtop) {
+          errtop = workers[i].errtop;
+        }
+        else {
+          errbot->next = workers[i].errtop;
+          workers[i].errtop->prev = errbot;
         }
-      );
+        errbot = workers[i].errbot;
+      }
+      stats->files    += workers[i].files;
+      stats->lines    += workers[i].lines;
+      stats->objects  += workers[i].nobjects;
+      stats->errors   += workers[i].nerrors;
     }
   );
+  if (errors) {
+    *errors = errtop;
+  }
+  stats->arena_blocks = arena->nblocks;
+  stats->arena_bytes  = arena->size;
+  stats->parse_ms = parse_ms;
+  stats->merge_ms = merge_ms;
+}
+
+/* Print the throughput in `stats`, prefixed by `name`. */
+void syntaxfile_print_stats(const char *const restrict name, const SyntaxParseStats *const stats) {
+  ASSERT(name);
+  ASSERT(stats);
+  double secs = ((stats->parse_ms + stats->merge_ms) / 1000.0);
+  writef(
+    "%s: Threads: %d: Files: %lu: Lines: %lu: Objects: %lu: Errors: %lu: Arena: %lu bytes in %lu blocks: Parse: %.3f ms: Merge: %.3f ms: %.0f files/sec: %.0f lines/sec\n",
+    name, stats->threads, stats->files, stats->lines, stats->objects, stats->errors, stats->arena_bytes, stats->arena_blocks, stats->parse_ms, stats->merge_ms,
+    (secs > 0 ? (stats->files / secs) : 0), (secs > 0 ? (stats->lines / secs) : 0)
+  );
+}
+
+/* -------------------------------------------------------- Tests -------------------------------------------------------- */
+
+/* Return`s every c source and header under `path`, the number of them is put in `npaths`.  The caller frees every path and the array. */
+char **syntaxfile_test_paths(const char *const restrict path, Ulong *const npaths) {
+  ASSERT(path);
+  ASSERT(npaths);
+  directory_t dir;
+  char **paths = NULL;
+  Ulong cap    = 0;
+  *npaths = 0;
+  directory_data_init(&dir);
+  if (directory_get_recurse(path, &dir) != -1) {
+    DIRECTORY_ITER(dir, i, entry,
+      if (directory_entry_is_non_exec_file(entry) && entry->ext && (strcmp(entry->ext, "h") == 0 || strcmp(entry->ext, "c") == 0)) {
+        if (*npaths == cap) {
+          cap   = (cap ? (cap * 2) : 256);
+          paths = xrealloc(paths, (sizeof(*paths) * cap));
+        }
+        paths[(*npaths)++] = copy_of(entry->path);
+      }
+    );
+  }
   directory_data_free(&dir);
-  writef("\n%s: Files read: %lu: Lines read: %lu: Total objects: %lu: Time: %.5f ms\n\n", __func__, files_read, total_lines, tot_obj, (double)ms);
-  writef("%d\n", hashmap_size(globmap));
-  hashmap_free(globmap);
+  return paths;
+}
+
+/* Parse every c source and header in `/usr/include`, first on a single thread and then on one per cpu, and print the throughput of both. */
+void syntaxfile_test_read(void) {
+  HashMap *objects;
+  SyntaxArena arena;
+  SyntaxFileError *errors;
+  SyntaxParseStats stats;
+  Ulong npaths;
+  char **paths = syntaxfile_test_paths("/usr/include", &npaths);
+  writef("\n");
+  for (int pass=0; pass<2; ++pass) {
+    objects = hashmap_create();
+    syntaxarena_init(&arena);
+    syntaxfile_parse_files(paths, npaths, (pass ? 0 : 1), objects, &arena, (pass ? NULL : &errors), &stats);
+    /* Only print the errors once. */
+    if (!pass) {
+      for (SyntaxFileError *err=errors; err; err=err->next) {
+        writef("%s:[%d:%d]: %s\n", err->file, err->pos.row, err->pos.column, err->msg);
+      }
+    }
+    syntaxfile_print_stats(__func__, &stats);
+    writef("%s: Unique names: %d\n", __func__, hashmap_size(objects));
+    hashmap_free(objects);
+    syntaxarena_free(&arena);
+  }
+  writef("\n");
+  for (Ulong i=0; i<npaths; ++i) {
+    free(paths[i]);
+  }
+  free(paths);
 }
@@ -5,6 +5,30 @@
 
 #include <sys/ioctl.h>
 #include <sys/ttydefaults.h>
+#include <pthread.h>
+
+#define PASTE_START      "\x1b[200~"
+#define PASTE_END        "\x1b[201~"
+#define PASTE_MARKERLEN  SLTLEN(PASTE_START)
+
+/* Bytes of a key sequence that was cut off at the end of the last feed, or the body of a paste that has not ended yet. */
+static Uchar *pending = NULL;
+static Ulong pending_len = 0;
+static Ulong pending_cap = 0;
+/* When we are inside a bracketed paste. */
+static bool in_paste = FALSE;
+/* How much of the pending paste body has already been searched for the end marker. */
+static Ulong paste_scanned = 0;
+
+/* `Internal`  Make room for `len` more bytes in the pending buffer. */
+static void pending_ensure(Ulong len) {
+  if ((pending_len + len) > pending_cap) {
+    while ((pending_len + len) > pending_cap) {
+      pending_cap = (pending_cap ? (pending_cap * 2) : 256);
+    }
+    pending = xrealloc(pending, pending_cap);
+  }
+}
 
 int parse_input_key(const Uchar *data, Ulong len, bool *shift) {
   Uchar modifiers = 6;
@@ -668,3 +692,243 @@ int parse_input_key(const Uchar *data, Ulong len, bool *shift) {
   }
   return TUI_KEY_ERR;
 }
+
+/* Return's the length of the first key sequence in `data`, or `0` when `data` ends before the sequence does.  Note that a lone escape is the escape key itself. */
+Ulong input_key_len(const Uchar *data, Ulong len) {
+  Ulong charlen;
+  if (!len) {
+    return 0;
+  }
+  else if (data[0] == ESC) {
+    if (len == 1) {
+      return 1;
+    }
+    /* Csi, parameter and intermediate bytes up to a final byte. */
+    else if (data[1] == TUI_KEY_CSI) {
+      for (Ulong i=2; i<len; ++i) {
+        if (data[i] >= 0x40 && data[i] <= 0x7E) {
+          return (i + 1);
+        }
+        /* Not part of a valid sequence, so end the unknown sequence here. */
+        else if (data[i] < 0x20 || data[i] > 0x7E) {
+          return i;
+        }
+      }
+      return 0;
+    }
+    /* Ss3, always a single char. */
+    else if (data[1] == TUI_KEY_O) {
+      return ((len < 3) ? 0 : 3);
+    }
+    /* Alt plus a key. */
+    charlen = input_key_len((data + 1), (len - 1));
+    return (charlen ? (charlen + 1) : 0);
+  }
+  else if (data[0] >= 0xC2 && data[0] <= 0xF4) {
+    charlen = ((data[0] < 0xE0) ? 2 : (data[0] < 0xF0) ? 3 : 4);
+    return ((charlen > len) ? 0 : charlen);
+  }
+  return 1;
+}
+
+/* `Internal`  Send `*key` to `callback` when there is one. */
+static inline void input_feed_flush_key(input_event *const key, input_event_cb callback, void *arg) {
+  if (key->count) {
+    callback(key, arg);
+    key->count = 0;
+  }
+}
+
+/* Split `data` read from the terminal into events, and send them to `callback`.  The body of a bracketed paste becomes a single
+ * event, and the same key repeated in a row becomes a single event with a count.  A sequence or paste cut off at the end of
+ * `data` is kept until the next call, so `data` can be given in any pieces. */
+void input_feed(const Uchar *data, Ulong len, input_event_cb callback, void *arg) {
+  input_event key = {0};
+  input_event paste = {0};
+  const Uchar *ptr = data;
+  const Uchar *end;
+  Ulong size = len;
+  Ulong i = 0;
+  Ulong from;
+  Ulong seqlen;
+  bool shift;
+  int keycode;
+  key.type   = INPUT_EVENT_KEY;
+  paste.type = INPUT_EVENT_PASTE;
+  /* Continue from what was left over last time. */
+  if (pending_len) {
+    pending_ensure(len);
+    memcpy((pending + pending_len), data, len);
+    pending_len += len;
+    ptr  = pending;
+    size = pending_len;
+  }
+  while (i < size) {
+    if (in_paste) {
+      /* Only search what we have not already searched, including the part of a marker that could have been cut off. */
+      from = ((paste_scanned > (PASTE_MARKERLEN - 1)) ? (paste_scanned - (PASTE_MARKERLEN - 1)) : 0);
+      end  = memmem((ptr + i + from), (size - i - from), S__LEN(PASTE_END));
+      if (!end) {
+        paste_scanned = (size - i);
+        break;
+      }
+      input_feed_flush_key(&key, callback, arg);
+      paste.data = (ptr + i);
+      paste.len  = (end - (ptr + i));
+      callback(&paste, arg);
+      i = ((end - ptr) + PASTE_MARKERLEN);
+      in_paste      = FALSE;
+      paste_scanned = 0;
+      continue;
+    }
+    else if ((size - i) >= PASTE_MARKERLEN && memcmp((ptr + i), S__LEN(PASTE_START)) == 0) {
+      i += PASTE_MARKERLEN;
+      in_paste      = TRUE;
+      paste_scanned = 0;
+      continue;
+    }
+    seqlen = input_key_len((ptr + i), (size - i));
+    /* A escape at the end of a longer read is most likely the start of a sequence that was cut off, while the escape key itself is read on its own. */
+    if (!seqlen || (ptr[i] == ESC && (i + 1) == size && size > 1)) {
+      break;
+    }
+    shift   = FALSE;
+    keycode = parse_input_key((ptr + i), seqlen, &shift);
+    if (key.count && keycode != TUI_KEY_ERR && keycode == key.keycode && shift == key.shift) {
+      ++key.count;
+    }
+    else {
+      input_feed_flush_key(&key, callback, arg);
+      key.keycode = keycode;
+      key.shift   = shift;
+      key.count   = 1;
+      key.data    = (ptr + i);
+      key.len     = seqlen;
+    }
+    i += seqlen;
+  }
+  input_feed_flush_key(&key, callback, arg);
+  /* Keep what is left for the next call. */
+  if (ptr == pending) {
+    memmove(pending, (pending + i), (size - i));
+    pending_len = (size - i);
+  }
+  else if (i < size) {
+    pending_len = 0;
+    pending_ensure(size - i);
+    memcpy(pending, (ptr + i), (size - i));
+    pending_len = (size - i);
+  }
+}
+
+/* Tests. */
+
+#define INPUT_TEST_PASTE_LINES  (200000)
+#define INPUT_TEST_KEYS         (100000)
+
+typedef struct {
+  Ulong expected;   /* The bytes the reader has to deliver before we are done. */
+  Ulong bytes;      /* The bytes the reader has delivered. */
+  Ulong drains;     /* The number of times the reader callback ran in the event-handler. */
+  Ulong keys;       /* The key events, and the keys they hold. */
+  Ulong key_count;
+  Ulong pastes;     /* The paste events, and the bytes they hold. */
+  Ulong paste_bytes;
+  nevhandler *handler;
+} input_test_stats;
+
+typedef struct {
+  int fd;
+  const char *data;
+  Ulong len;
+} input_test_writer;
+
+static input_test_stats *input_test = NULL;
+
+/* `Internal`  Count the events the way the tui would handle them. */
+static void input_test_event(const input_event *event, void *arg) {
+  input_test_stats *stats = arg;
+  if (event->type == INPUT_EVENT_PASTE) {
+    ++stats->pastes;
+    stats->paste_bytes += event->len;
+  }
+  else {
+    ++stats->keys;
+    stats->key_count += event->count;
+  }
+}
+
+/* `Internal`  The reader callback, runs in the event-handler. */
+static void input_test_read(nevhandler *handler, const Uchar *data, long len) {
+  ++input_test->drains;
+  input_test->bytes += len;
+  input_feed(data, len, input_test_event, input_test);
+  if (input_test->bytes == input_test->expected) {
+    nevhandler_stop(handler, 0);
+  }
+}
+
+/* `Internal`  Write all the data into the pipe in terminal sized writes, like a terminal forwarding a paste. */
+static void *input_test_write(void *arg) {
+  input_test_writer *writer = arg;
+  Ulong len;
+  long written;
+  for (Ulong i=0; i<writer->len; i+=written) {
+    len     = (((writer->len - i) < 4096) ? (writer->len - i) : 4096);
+    written = write(writer->fd, (writer->data + i), len);
+    if (written < 0) {
+      break;
+    }
+  }
+  close(writer->fd);
+  return NULL;
+}
+
+/* Measure pasting a large file followed by a lot of held down arrow keys, through a pipe, the reader and the event-handler
+ * the same way stdin goes in the tui.  Reports the handler wakeups and the events the input was decoded into. */
+void input_test_paste_bench(void) {
+  input_test_stats stats = {0};
+  input_test_writer writer;
+  pthread_t thread;
+  int fds[2];
+  char *data;
+  Ulong len = 0;
+  Ulong cap = ((INPUT_TEST_PASTE_LINES * 64) + (INPUT_TEST_KEYS * 3) + 64);
+  if (!terminfo) {
+    terminfo_init();
+  }
+  data = xmalloc(cap);
+  len += snprintf((data + len), (cap - len), PASTE_START);
+  for (int i=0; i<INPUT_TEST_PASTE_LINES; ++i) {
+    len += snprintf((data + len), (cap - len), "  static int value_%d = (%d * 4);\r", i, i);
+  }
+  len += snprintf((data + len), (cap - len), PASTE_END);
+  for (int i=0; i<INPUT_TEST_KEYS; ++i) {
+    len += snprintf((data + len), (cap - len), "\x1b[B");
+  }
+  if (pipe(fds) != 0) {
+    free(data);
+    return;
+  }
+  stats.expected = len;
+  stats.handler  = nevhandler_create();
+  input_test     = &stats;
+  writer.fd   = fds[1];
+  writer.data = data;
+  writer.len  = len;
+  timer_action(ms,
+    nfdreader_create(stats.handler, fds[0], input_test_read);
+    pthread_create(&thread, NULL, input_test_write, &writer);
+    nevhandler_start(stats.handler, FALSE);
+  );
+  pthread_join(thread, NULL);
+  input_test = NULL;
+  /* The handler is not freed, as the reader thread can still be leaving `nevhandler_submit()`. */
+  writef(
+    "\n%s: Bytes: %lu in %.5f ms (%.1f MB/s): Writes: %lu: Reader callbacks: %lu: "
+    "Pastes: %lu (%lu bytes): Key events: %lu (%lu keys)\n\n",
+    __func__, stats.bytes, (double)ms, (((double)stats.bytes / (1024.0 * 1024.0)) / ((double)ms / 1000.0)),
+    ((len + 4095) / 4096), stats.drains, stats.pastes, stats.paste_bytes, stats.keys, stats.key_count
+  );
+  free(data);
+}
@@ -133,8 +133,30 @@
 #define TUI_KEY_SUPER_SHIFT_ENTER     0x5201
 #define TUI_KEY_SUPER_SHIFT_ALT_ENTER 0x5301
 
+typedef enum {
+  INPUT_EVENT_KEY,    /* A key, repeated `count` times. */
+  INPUT_EVENT_PASTE,  /* The whole body of a bracketed paste. */
+} input_event_type;
+
+typedef struct {
+  input_event_type type;
+  int keycode;        /* The parsed key, or `TUI_KEY_ERR` when unknown.  Only for `INPUT_EVENT_KEY`. */
+  bool shift;         /* When shift was held.  Only for `INPUT_EVENT_KEY`. */
+  Ulong count;        /* How many times the key was repeated in a row.  Only for `INPUT_EVENT_KEY`. */
+  const Uchar *data;  /* The sequence of the first key, or the paste body.  Only valid during the callback. */
+  Ulong len;
+} input_event;
+
+typedef void (*input_event_cb)(const input_event *event, void *arg);
+
 _BEGIN_C_LINKAGE
 
 int parse_input_key(const Uchar *data, Ulong len, bool *shift);
 
+Ulong input_key_len(const Uchar *data, Ulong len);
+
+void input_feed(const Uchar *data, Ulong len, input_event_cb callback, void *arg);
+
+void input_test_paste_bench(void);
+
 _END_C_LINKAGE
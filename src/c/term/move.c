@@ -17,29 +17,46 @@ void tui_clear_screen(void) {
   nfdwriter_write_stdout(terminfo->clear_screen_str, strlen(terminfo->clear_screen_str));
 }
 
-void tui_move(int row, int column) {
-  char buffer[256];
+/* Write the cursor address sequence for `row` and `column` into `buffer`, returning the length.  Nothing is written to the terminal. */
+Ulong tui_move_str(char *const restrict buffer, Ulong size, int row, int column) {
   unibi_var_t vars[9] = {0};
   vars[0].i_ = row;
   vars[1].i_ = column;
-  Ulong len = unibi_run(terminfo->cursor_address_str, vars, buffer, sizeof(buffer));
+  return unibi_run(terminfo->cursor_address_str, vars, buffer, size);
+}
+
+void tui_move(int row, int column) {
+  char buffer[256];
+  Ulong len = tui_move_str(buffer, sizeof(buffer), row, column);
   if (!len) {
     return;
   }
   nfdwriter_write_stdout(buffer, len);
 }
 
-void tui_set_foreground_color(Uchar r, Uchar g, Uchar b) {
-  if (terminfo->ext.set_rgb_foreground == -1) {
-    return;
+/* `Internal`  Run the rgb extended string at `index` into `buffer`, returning the length, or `0` when the terminal lacks it. */
+static Ulong tui_rgb_color_str(int index, char *const restrict buffer, Ulong size, Uchar r, Uchar g, Uchar b) {
+  if (index == -1) {
+    return 0;
   }
-  char buffer[256];
   unibi_var_t vars[9] = {0};
   vars[0].i_ = r;
   vars[1].i_ = g;
   vars[2].i_ = b;
-  const char *str = unibi_get_ext_str(terminfo->term, terminfo->ext.set_rgb_foreground);
-  Ulong len = unibi_run(str, vars, buffer, sizeof(buffer));
+  return unibi_run(unibi_get_ext_str(terminfo->term, index), vars, buffer, size);
+}
+
+Ulong tui_set_foreground_color_str(char *const restrict buffer, Ulong size, Uchar r, Uchar g, Uchar b) {
+  return tui_rgb_color_str(terminfo->ext.set_rgb_foreground, buffer, size, r, g, b);
+}
+
+Ulong tui_set_background_color_str(char *const restrict buffer, Ulong size, Uchar r, Uchar g, Uchar b) {
+  return tui_rgb_color_str(terminfo->ext.set_rgb_background, buffer, size, r, g, b);
+}
+
+void tui_set_foreground_color(Uchar r, Uchar g, Uchar b) {
+  char buffer[256];
+  Ulong len = tui_set_foreground_color_str(buffer, sizeof(buffer), r, g, b);
   if (!len) {
     return;
   }
@@ -47,16 +64,8 @@ void tui_set_foreground_color(Uchar r, Uchar g, Uchar b) {
 }
 
 void tui_set_background_color(Uchar r, Uchar g, Uchar b) {
-  if (terminfo->ext.set_rgb_background == -1) {
-    return;
-  }
   char buffer[256];
-  unibi_var_t vars[9] = {0};
-  vars[0].i_ = r;
-  vars[1].i_ = g;
-  vars[2].i_ = b;
-  const char *str = unibi_get_ext_str(terminfo->term, terminfo->ext.set_rgb_background);
-  Ulong len = unibi_run(str, vars, buffer, sizeof(buffer));
+  Ulong len = tui_set_background_color_str(buffer, sizeof(buffer), r, g, b);
   if (!len) {
     return;
   }
@@ -6,7 +6,10 @@
 _BEGIN_C_LINKAGE
 
 void tui_clear_screen(void);
+Ulong tui_move_str(char *const restrict buffer, Ulong size, int row, int column);
 void tui_move(int row, int column);
+Ulong tui_set_foreground_color_str(char *const restrict buffer, Ulong size, Uchar r, Uchar g, Uchar b);
+Ulong tui_set_background_color_str(char *const restrict buffer, Ulong size, Uchar r, Uchar g, Uchar b);
 void tui_set_foreground_color(Uchar r, Uchar g, Uchar b);
 void tui_set_background_color(Uchar r, Uchar g, Uchar b);
 void tui_reset_color(void);
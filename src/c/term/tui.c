@@ -104,8 +104,36 @@ void tui_init(void) {
   terminfo_init();
 }
 
+/* Write the sequence that limits scrolling to the screen rows `top_row` through `bot_row` into `buffer`, returning the length.  The rows are zero based
+ * and inclusive, and a negative `top_row` writes the sequence that resets the region to the whole screen.  Note that setting the region homes the cursor. */
+Ulong tui_scroll_region_str(char *const restrict buffer, Ulong size, int top_row, int bot_row) {
+  int len;
+  if (top_row < 0) {
+    len = snprintf(buffer, size, "\x1b[r");
+  }
+  else {
+    len = snprintf(buffer, size, "\x1b[%d;%dr", (top_row + 1), (bot_row + 1));
+  }
+  return ((len < 0 || (Ulong)len >= size) ? 0 : len);
+}
+
+/* Write the sequence that scrolls the content of the scroll region up `howmush` rows into `buffer`, or down when `howmush` is negative, returning the length. */
+Ulong tui_scroll_str(char *const restrict buffer, Ulong size, int howmush) {
+  int len;
+  if (!howmush) {
+    return 0;
+  }
+  len = snprintf(buffer, size, "\x1b[%d%c", ABS(howmush), ((howmush > 0) ? 'S' : 'T'));
+  return ((len < 0 || (Ulong)len >= size) ? 0 : len);
+}
+
 void tui_scroll_region(int top_row, int bot_row) {
-  nfdwriter_printf(nfdwriter_stdout, "\233%d;%dr", top_row, bot_row);
+  char buffer[64];
+  Ulong len = tui_scroll_region_str(buffer, sizeof(buffer), top_row, bot_row);
+  if (!len) {
+    return;
+  }
+  nfdwriter_write_stdout(buffer, len);
 }
 
 void tui_set_curs_blink(bool enable) {
@@ -28,6 +28,11 @@ int open_tty(void);
 
 void tui_init(void);
 
+Ulong tui_scroll_region_str(char *const restrict buffer, Ulong size, int top_row, int bot_row);
+
+Ulong tui_scroll_str(char *const restrict buffer, Ulong size, int howmush);
+
+/* Limit scrolling to the zero based screen rows `top_row` through `bot_row`, inclusive.  A negative `top_row` resets it to the whole screen. */
 void tui_scroll_region(int top_row, int bot_row);
 
 void tui_set_curs_blink(bool enable);
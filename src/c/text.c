@@ -658,10 +658,10 @@ static void rewrap_paragraph_for(openfilestruct *const file, int rows,
   long break_pos;
   Ulong line_len;
   /* Do the loop... */
-  while (breadth((*line)->data) > wrap_at) {
+  while (line_breadth(*line) > wrap_at) {
     line_len = strlen((*line)->data);
     /* Find a point in the line where it can be broken. */
-    break_pos = break_line(((*line)->data + lead_len), (wrap_at - wideness((*line)->data, lead_len)), FALSE);
+    break_pos = break_line(((*line)->data + lead_len), (wrap_at - line_wideness(*line, lead_len)), FALSE);
     /* If we can't break the line, or don't need to, we're done. */
     if (break_pos < 0 || (lead_len + break_pos) == lead_len) {
       break;
@@ -1947,7 +1947,7 @@ void do_wrap_for(openfilestruct *const file, int cols) {
   Ulong rear_x;
   Ulong typed_x;
   /* First find the last blank character where we can break the line. */
-  wrap_loc = break_line((line->data + lead_len), (wrap_at - wideness(line->data, lead_len)), FALSE);
+  wrap_loc = break_line((line->data + lead_len), (wrap_at - line_wideness(line, lead_len)), FALSE);
   /* If no wrapping point was found before end-of-line, we don't wrap. */
   if (wrap_loc < 0 || (lead_len + wrap_loc) == line_len) {
     return;
@@ -1968,7 +1968,7 @@ void do_wrap_for(openfilestruct *const file, int cols) {
   rest_length = (line_len - wrap_loc);
   /* When prepending and the remainder of this line will not make the next line too long, then join the two
    * lines, so that, after the line wrap, the remainder will effectively have been prefixed to the next line. */
-  if (file->spillage_line && file->spillage_line == line->next && (rest_length + breadth(line->next->data)) <= wrap_at) {
+  if (file->spillage_line && file->spillage_line == line->next && (rest_length + line_breadth(line->next)) <= wrap_at) {
     /* Go to the end of this line. */
     file->current_x = line_len;
     /* If the remainder doesn't end in a blank, add a space. */
@@ -2142,7 +2142,7 @@ bool begpar(const linestruct *const line, int depth) {
     return TRUE;
   }
   /* If indentation of this and preceding line are equal, this is not a BOP. */
-  if (wideness(line->prev->data, (quot_len + prev_dent_len)) == wideness(line->data, (quot_len + indent_len))) {
+  if (line_wideness(line->prev, (quot_len + prev_dent_len)) == line_wideness(line, (quot_len + indent_len))) {
     return FALSE;
   }
   /* Otherwise, this is a BOP if the preceding line is not. */
@@ -3361,6 +3361,8 @@ void do_undo_for(CTX_ARGS) {
   else if (u->type == INSERT || u->type == COUPLE_BEGIN) {
     recook = TRUE;
   }
+  /* Going back to where the `file` was last saved, or redoing without marking it modified, still changes the lines. */
+  ++line_data_version;
   /* When at the point where the `file` was last saved, unset `file->modified`. */
   if (file->current_undo == file->last_saved) {
     file->modified = FALSE;
@@ -3594,6 +3596,8 @@ void do_redo_for(CTX_ARGS) {
   else if (u->type == INSERT || u->type == COUPLE_END) {
     recook = TRUE;
   }
+  /* Going back to where the `file` was last saved, or redoing without marking it modified, still changes the lines. */
+  ++line_data_version;
   /* When at the point where the `file` was last saved, unset `file->modified`. */
   if (file->current_undo == file->last_saved) {
     file->modified = FALSE;
@@ -4043,7 +4047,7 @@ void do_linter_for(CTX_ARGS_REF_OF, char *const linter) {
         /* Put the cursor at the repoted position, but don't go beyond EOL
          * when the second number is a column number instead of an index. */
         goto_line_posx_for(*file, rows, curlint->lineno, (curlint->colno - 1));
-        (*file)->current_x = actual_x((*file)->current->data, (*file)->placewewant);
+        (*file)->current_x = line_actual_x((*file)->current, (*file)->placewewant);
         titlebar(NULL);
         adjust_viewport_for(STACK_CTX_DF, CENTERING);
         confirm_margin_for(*file, &TUI_COLS);
@@ -221,7 +221,7 @@ Ulong get_page_start(Ulong column, int cols) {
 
 /* Return the placewewant associated with `file->current_x`, i.e. the zero-based column position of the cursor. */
 Ulong xplustabs_for(openfilestruct *const file) {
-  return wideness(file->current->data, file->current_x);
+  return line_wideness(file->current, file->current_x);
 }
 
 /* Return the placewewant associated with current_x, i.e. the zero-based column position of the cursor. */
@@ -229,23 +229,184 @@ Ulong xplustabs(void) {
   return xplustabs_for(CTX_OF);
 }
 
-/* A strnlen() with tabs and multicolumn characters factored in: how many columns wide are the first maxlen bytes of text? */
-Ulong wideness(const char *text, Ulong maxlen) {
-  Ulong width = 0;
-  if (!maxlen) {
-    return 0;
+/* ----------------------------- Bytes hash ----------------------------- */
+
+/* Return a hash of the first `len` bytes of `data`.  This is used to tell when the data a cache was built from has changed,
+ * so it hashes eight bytes at a time into eight independent lanes, to stay far cheaper than the work the caches save. */
+Ulong bytes_hash(const char *const restrict data, Ulong len) {
+  Ulong lane[8] = {
+    len, 0x9E3779B97F4A7C15UL, 0xC2B2AE3D27D4EB4FUL, 0x165667B19E3779F9UL,
+    0x85EBCA77C2B2AE63UL, 0x27D4EB2F165667C5UL, 0xFF51AFD7ED558CCDUL, 0xC4CEB9FE1A85EC53UL
+  };
+  Ulong word;
+  Ulong hash = 0;
+  Ulong i;
+  for (i=0; (i + 64) <= len; i += 64) {
+    for (int j=0; j<8; ++j) {
+      memcpy(&word, (data + i + (j * 8)), 8);
+      lane[j] = ((lane[j] ^ word) * 0x100000001B3UL);
+    }
+  }
+  for (; i<len; ++i) {
+    lane[0] = ((lane[0] ^ (Uchar)data[i]) * 0x100000001B3UL);
+  }
+  /* Fold the lanes, mixing the high bits of each down, as the multiplies only ever carry changes upward. */
+  for (int j=0; j<8; ++j) {
+    hash = ((hash ^ lane[j] ^ (lane[j] >> 31)) * 0x9E3779B97F4A7C15UL);
+  }
+  return hash;
+}
+
+/* ----------------------------- Long line index ----------------------------- */
+
+/* Lines at least this long get a checkpoint index, shorter ones are simply walked from the start. */
+#define LONG_LINE_THRESHOLD  (16384)
+/* The distance in bytes between two checkpoints. */
+#define LONG_LINE_STEP       (4096)
+/* The number of long lines that can have an index at the same time. */
+#define LONG_LINE_SLOTS      (4)
+
+/* A place in a long line where a walk can start, instead of at byte zero. */
+typedef struct {
+  Ulong byte;  /* The index of the first character at or after a multiple of `LONG_LINE_STEP`. */
+  Ulong col;   /* The column that character starts at. */
+  Ulong hash;  /* The hash of the bytes since the previous checkpoint, plus the few after it that decide the width of the last character. */
+} long_line_checkpoint;
+
+/* The checkpoints of one long line.  They are only ever made as far as a walk needed them.  After an edit, meaning once `line_data_version`
+ * changed, they are checked against the line again as walks reach them, and cut off at the first one the line no longer matches. */
+typedef struct {
+  const linestruct *line;        /* The line this index is for, or `NULL` when the slot is unused. */
+  const char *data;              /* The data of `line` when the index was made, as an edit that moved it starts the index over. */
+  long_line_checkpoint *points;  /* The checkpoints, `points[0]` is always the start of the line. */
+  Ulong count;
+  Ulong cap;
+  Ulong checked;                 /* The number of checkpoints known to still match the line at `version`. */
+  Ulong version;                 /* The `line_data_version` the first `checked` checkpoints were checked at. */
+  Ulong used;                    /* When this slot was last used, so the least recently used one gets reused. */
+  long  tabsize;                 /* The tabsize the columns were computed with. */
+  bool  complete;                /* Whether the last checkpoint is the end of the line. */
+} long_line_index;
+
+/* Whether walks use the checkpoints, only turned off to compare against in the benchmark. */
+static bool long_line_indexing = TRUE;
+
+static long_line_index long_lines[LONG_LINE_SLOTS];
+static Ulong           long_line_clock = 0;
+static pthread_mutex_t long_line_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/* `Internal`  Return the hash that checkpoint `to` has when the text since `from` is unchanged. */
+static Ulong long_line_segment_hash(const char *const restrict text, const long_line_checkpoint *const from, const long_line_checkpoint *const to) {
+  return bytes_hash((text + from->byte), strnlen((text + from->byte), ((to->byte - from->byte) + MAXCHARLEN)));
+}
+
+/* `Internal`  Return the index slot for `line`, reusing the least recently used slot when `line` has none. */
+static long_line_index *long_line_index_for(const linestruct *const line) {
+  long_line_index *index = &long_lines[0];
+  for (int i=0; i<LONG_LINE_SLOTS; ++i) {
+    if (long_lines[i].line == line) {
+      index = &long_lines[i];
+      break;
+    }
+    else if (long_lines[i].used < index->used) {
+      index = &long_lines[i];
+    }
+  }
+  if (!index->points) {
+    index->cap    = 64;
+    index->points = xmalloc(index->cap * sizeof(*index->points));
+  }
+  if (index->line != line || index->data != line->data || index->tabsize != tabsize) {
+    index->line      = line;
+    index->data      = line->data;
+    index->tabsize   = tabsize;
+    index->count     = 1;
+    index->checked   = 1;
+    index->version   = line_data_version;
+    index->complete  = FALSE;
+    index->points[0] = (long_line_checkpoint){ 0, 0, 0 };
+  }
+  else if (index->version != line_data_version) {
+    index->checked = 1;
+    index->version = line_data_version;
+  }
+  index->used = ++long_line_clock;
+  return index;
+}
+
+/* `Internal`  Walk `LONG_LINE_STEP` bytes further than the last checkpoint of `index`, and add a checkpoint there, or at the end of the line. */
+static void long_line_add_checkpoint(long_line_index *const index, const char *const restrict text) {
+  long_line_checkpoint *last = &index->points[index->count - 1];
+  long_line_checkpoint point = *last;
+  Ulong target = (((last->byte / LONG_LINE_STEP) + 1) * LONG_LINE_STEP);
+  while (text[point.byte] && point.byte < target) {
+    point.byte += advance_over((text + point.byte), &point.col);
+  }
+  point.hash = long_line_segment_hash(text, last, &point);
+  index->complete = !text[point.byte];
+  if (index->count == index->cap) {
+    index->cap   *= 2;
+    index->points = xrealloc(index->points, (index->cap * sizeof(*index->points)));
+  }
+  index->points[index->count++] = point;
+  index->checked = index->count;
+}
+
+/* `Internal`  Return whether a walk that stops before byte `byte_limit`, or at column `col_limit`, can start from `point`. */
+#define LONG_LINE_POINT_FITS(point, byte_limit, col_limit)  ((point).byte < (byte_limit) && (point).col <= (col_limit))
+
+/* `Internal`  Return the farthest checkpoint in `line` that lies before byte `byte_limit` and at or before column `col_limit`.  Checkpoints
+ * are only hashed again the first time a walk reaches them after an edit, so an edited line loses only the checkpoints after the edit. */
+static long_line_checkpoint long_line_checkpoint_for(const linestruct *const line, Ulong byte_limit, Ulong col_limit) {
+  long_line_index *index;
+  long_line_checkpoint point;
+  Ulong i;
+  pthread_mutex_lock(&long_line_mutex);
+  index = long_line_index_for(line);
+  for (; index->checked<index->count && LONG_LINE_POINT_FITS(index->points[index->checked], byte_limit, col_limit); ++index->checked) {
+    i = index->checked;
+    if (index->points[i].hash != long_line_segment_hash(line->data, &index->points[i - 1], &index->points[i])) {
+      index->count    = i;
+      index->complete = FALSE;
+      break;
+    }
+  }
+  while (!index->complete && LONG_LINE_POINT_FITS(index->points[index->count - 1], byte_limit, col_limit)) {
+    long_line_add_checkpoint(index, line->data);
+  }
+  for (i=(index->checked - 1); i>0 && !LONG_LINE_POINT_FITS(index->points[i], byte_limit, col_limit); --i);
+  point = index->points[i];
+  pthread_mutex_unlock(&long_line_mutex);
+  return point;
+}
+
+/* Drop the checkpoint index of `line`, if it has one.  This is called when `line` is freed, so a new line at the same address starts over. */
+void long_line_forget(const linestruct *const line) {
+  pthread_mutex_lock(&long_line_mutex);
+  for (int i=0; i<LONG_LINE_SLOTS; ++i) {
+    if (long_lines[i].line == line) {
+      long_lines[i].line = NULL;
+      long_lines[i].data = NULL;
+      long_lines[i].used = 0;
+    }
   }
+  pthread_mutex_unlock(&long_line_mutex);
+}
+
+/* Return whether `text` is long enough that walking it from a checkpoint pays off.  Such lines are also drawn without syntax coloring. */
+bool is_long_line(const char *const restrict text) {
+  return (strnlen(text, LONG_LINE_THRESHOLD) == LONG_LINE_THRESHOLD);
+}
+
+/* `Internal`  Return the number of columns the first `maxlen` bytes of `text` take, when the walk starts at `width` columns. */
+static Ulong wideness_from(const char *text, Ulong maxlen, Ulong width) {
   for (Ulong charlen; *text && (maxlen > (charlen = advance_over(text, &width))); maxlen -= charlen, text += charlen);
   return width;
 }
 
-/* Return the index in text of the character that (when displayed) will not overshoot the given column. */
-Ulong actual_x(const char *text, Ulong column) {
-  /* From where we start walking through the text. */
+/* `Internal`  Return the number of bytes of `text` that fit before column `column`, when the walk starts at `width` columns. */
+static Ulong actual_x_from(const char *text, Ulong column, Ulong width) {
   const char *start = text;
-  /* The current accumulated span, in columns. */
-  Ulong width = 0;
-  /* Calculated length of the current char. */
   int charlen;
   while (*text) {
     charlen = advance_over(text, &width);
@@ -257,6 +418,19 @@ Ulong actual_x(const char *text, Ulong column) {
   return (text - start);
 }
 
+/* A strnlen() with tabs and multicolumn characters factored in: how many columns wide are the first maxlen bytes of text? */
+Ulong wideness(const char *text, Ulong maxlen) {
+  if (!maxlen) {
+    return 0;
+  }
+  return wideness_from(text, maxlen, 0);
+}
+
+/* Return the index in text of the character that (when displayed) will not overshoot the given column. */
+Ulong actual_x(const char *text, Ulong column) {
+  return actual_x_from(text, column, 0);
+}
+
 /* Return the number of columns that the given text occupies. */
 Ulong breadth(const char *text) {
   Ulong span = 0;
@@ -264,6 +438,43 @@ Ulong breadth(const char *text) {
   return span;
 }
 
+/* The same as `wideness()` for the data of `line`, but a long line is walked from the last checkpoint before `maxlen`. */
+Ulong line_wideness(const linestruct *const line, Ulong maxlen) {
+  long_line_checkpoint point;
+  if (!maxlen) {
+    return 0;
+  }
+  if (maxlen > LONG_LINE_STEP && long_line_indexing && is_long_line(line->data)) {
+    point = long_line_checkpoint_for(line, maxlen, (Ulong)-1);
+    return wideness_from((line->data + point.byte), (maxlen - point.byte), point.col);
+  }
+  return wideness_from(line->data, maxlen, 0);
+}
+
+/* The same as `actual_x()` for the data of `line`, but a long line is walked from the last checkpoint at or before `column`. */
+Ulong line_actual_x(const linestruct *const line, Ulong column) {
+  long_line_checkpoint point;
+  if (column >= LONG_LINE_STEP && long_line_indexing && is_long_line(line->data)) {
+    point = long_line_checkpoint_for(line, (Ulong)-1, column);
+    return (point.byte + actual_x_from((line->data + point.byte), column, point.col));
+  }
+  return actual_x_from(line->data, column, 0);
+}
+
+/* The same as `breadth()` for the data of `line`, but a long line is walked from its last checkpoint, which is the end of the line. */
+Ulong line_breadth(const linestruct *const line) {
+  long_line_checkpoint point;
+  const char *text = line->data;
+  Ulong span = 0;
+  if (long_line_indexing && is_long_line(text)) {
+    point = long_line_checkpoint_for(line, (Ulong)-1, (Ulong)-1);
+    text += point.byte;
+    span  = point.col;
+  }
+  for (; *text; text += advance_over(text, &span));
+  return span;
+}
+
 /* ----------------------------- Number of characters in ----------------------------- */
 
 /* Count the number of characters from begin to end, and return it. */
@@ -630,3 +841,129 @@ const char *strstrwrapper(const char *const haystack, const char *const needle,
     }
   }
 }
+
+/* ----------------------------- Long line tests ----------------------------- */
+
+#define LONG_LINE_TEST_SIZE   (20 * 1024 * 1024)
+#define LONG_LINE_TEST_MOVES  (40)
+
+/* `Internal`  Move the cursor to evenly spread places in `line`, the way a cursor move and redrawing the line looks it up, and put
+ * the resulting columns and indexes in `results`.  Halfway through, a tab is put into the line, which like any edit bumps `line_data_version`. */
+static void long_line_test_moves(linestruct *const line, Ulong *const results) {
+  Ulong x;
+  Ulong col;
+  Ulong start_x;
+  for (int i=0; i<LONG_LINE_TEST_MOVES; ++i) {
+    if (i == (LONG_LINE_TEST_MOVES / 2)) {
+      line->data[LONG_LINE_TEST_SIZE / 3] = '\t';
+      ++line_data_version;
+    }
+    x       = (((LONG_LINE_TEST_SIZE / LONG_LINE_TEST_MOVES) * i) + (i * 7));
+    col     = line_wideness(line, x);
+    start_x = line_actual_x(line, get_page_start(col, 80));
+    results[(i * 3)]     = col;
+    results[(i * 3) + 1] = start_x;
+    results[(i * 3) + 2] = line_wideness(line, start_x);
+  }
+  line->data[LONG_LINE_TEST_SIZE / 3] = ' ';
+  ++line_data_version;
+}
+
+/* `Internal`  Return the number of places in `line` where the checkpoint index disagrees with walking the line from its start. */
+static Ulong long_line_test_compare(const linestruct *const line) {
+  Ulong len        = strlen(line->data);
+  Ulong span       = breadth(line->data);
+  Ulong mismatches = (line_breadth(line) != span);
+  for (Ulong x=0; x<=(len + LONG_LINE_STEP); x+=(LONG_LINE_STEP / 3)) {
+    mismatches += (line_wideness(line, x) != wideness(line->data, x));
+  }
+  for (Ulong col=0; col<=(span + LONG_LINE_STEP); col+=(LONG_LINE_STEP / 3)) {
+    mismatches += (line_actual_x(line, col) != actual_x(line->data, col));
+  }
+  return mismatches;
+}
+
+/* Delete characters from a long line through `expunge_for()` after its checkpoint index was made, both early in the line and close
+ * to its end, and assert that after every deletion the index agrees with walking the line from its start.  As the line has tabs in
+ * it, every deletion before a tab moves the columns of everything after it. */
+void long_line_test(void) {
+  static const char pattern[] = "{\"key\":\t\"value\"},";
+  openfilestruct file;
+  linestruct *line   = make_new_node(NULL);
+  bool  was_using_gui = ISSET(USING_GUI);
+  long  was_tabsize   = tabsize;
+  Ulong size          = (LONG_LINE_THRESHOLD * 4);
+  Ulong places[]      = { (LONG_LINE_STEP + 5), (size - (LONG_LINE_STEP / 2)) };
+  Ulong mismatches    = 0;
+  if (tabsize <= 0) {
+    tabsize = 8;
+  }
+  /* Keep `expunge_for()` from drawing the line, as there is no screen. */
+  SET(USING_GUI);
+  line->data = xmalloc(size + 1);
+  for (Ulong i=0; i<size; ++i) {
+    line->data[i] = pattern[i % (sizeof(pattern) - 1)];
+  }
+  line->data[size] = '\0';
+  memset(&file, 0, sizeof(file));
+  file.filetop     = line;
+  file.filebot     = line;
+  file.current     = line;
+  file.edittop     = line;
+  file.modified    = TRUE;
+  file.last_action = OTHER;
+  file.totsize     = size;
+  mismatches += long_line_test_compare(line);
+  for (Ulong i=0; i<ARRAY_SIZE(places); ++i) {
+    for (int j=0; j<3; ++j) {
+      file.current_x = (places[i] - (j * 7));
+      expunge_for(&file, 80, DEL);
+      mismatches += long_line_test_compare(line);
+    }
+  }
+  ALWAYS_ASSERT_MSG(!mismatches, "The checkpoint index disagrees with the line after a deletion");
+  discard_until_for(&file, NULL);
+  delete_node_for(NULL, line);
+  refresh_needed = FALSE;
+  tabsize = was_tabsize;
+  if (!was_using_gui) {
+    UNSET(USING_GUI);
+  }
+  writef("%s: Passed\n", __func__);
+}
+
+/* Measure moving the cursor around a single 20 MB line, with and without the checkpoint index, and assert that both agree. */
+void long_line_test_bench(void) {
+  static const char pattern[] = "{\"key\":\"value with\ta tab\",\"n\":12345},";
+  linestruct *line = make_new_node(NULL);
+  long  was_tabsize = tabsize;
+  Ulong results[2][LONG_LINE_TEST_MOVES * 3];
+  Ulong mismatches = 0;
+  if (tabsize <= 0) {
+    tabsize = 8;
+  }
+  line->data = xmalloc(LONG_LINE_TEST_SIZE + 1);
+  for (Ulong i=0; i<LONG_LINE_TEST_SIZE; ++i) {
+    line->data[i] = pattern[i % (sizeof(pattern) - 1)];
+  }
+  line->data[LONG_LINE_TEST_SIZE] = '\0';
+  writef("\n");
+  for (int pass=0; pass<2; ++pass) {
+    long_line_indexing = pass;
+    timer_action(ms,
+      long_line_test_moves(line, results[pass]);
+    );
+    writef(
+      "%s: Line: %d bytes: Moves: %d: Indexed: %s: %.5f ms\n",
+      __func__, LONG_LINE_TEST_SIZE, LONG_LINE_TEST_MOVES, (long_line_indexing ? "yes" : "no"), (double)ms
+    );
+  }
+  for (int i=0; i<(LONG_LINE_TEST_MOVES * 3); ++i) {
+    mismatches += (results[0][i] != results[1][i]);
+  }
+  writef("%s: Mismatches: %lu\n\n", __func__, mismatches);
+  ALWAYS_ASSERT_MSG(!mismatches, "The checkpoint index disagrees with walking the line from its start");
+  long_line_indexing = TRUE;
+  tabsize = was_tabsize;
+  delete_node_for(NULL, line);
+}
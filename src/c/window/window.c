@@ -3,10 +3,19 @@
 #include "../event/nfdwriter.h"
 #include "../term/move.h"
 #include "../term/tui.h"
+#include "../term/terminfo.h"
 
 #include <sys/ioctl.h>
 #include <errno.h>
 
+/* The codepoint we give every cell in the front grid when we dont know what is on screen, this forces the next update to write it. */
+#define NWINDOW_CELL_INVALID  (0xFFFFFFFFU)
+/* When the next changed cell on the same row is at most this many cells past the terminal cursor, we rewrite the
+ * unchanged cells in between instead of emitting a cursor move, as that is never longer then the move itself. */
+#define NWINDOW_MAX_REWRITE_GAP  (4)
+/* The number of rows a terminal scroll has to save before we use it, as it costs about as much as a short row. */
+#define NWINDOW_MIN_SCROLL_GAIN  (2)
+
 typedef struct {
   Uchar r;      /* Red */
   Uchar g;      /* Green */
@@ -15,37 +24,53 @@ typedef struct {
 } nwindow_rgb;
 
 typedef struct {
-  char *data;
-} nwindow_line;
+  Uint ch;        /* The codepoint in this cell, `0` for the right half of a double width char. */
+  nwindow_rgb fg; /* Foreground rgb color. */
+  nwindow_rgb bg; /* Background rgb color. */
+  Uchar attr;     /* `NWINDOW_ATTR_*` flags. */
+} nwindow_cell;
 
 struct nwindow {
   nwindow_rgb fg; /* Foreground rgb color. */
   nwindow_rgb bg; /* Background rgb color. */
+  Uchar attr;     /* The `NWINDOW_ATTR_*` flags added text gets. */
   short cur_x;    /* Cursor x pos. */
   short cur_y;    /* Cursor y pos. */
   short beg_x;    /* X cordinate of the top-left column in the screen. */
   short beg_y;    /* Y cordinate of the top-left row in screen. */
   short size_x;
   short size_y;
-  nwindow_line *line;
+  nwindow_cell *back;   /* What we want the screen to show, this is what all drawing writes into. */
+  nwindow_cell *front;  /* What we know the screen shows, as of the last update. */
+  nwindow *next;
 };
 
-/* `Internal`  Turn on the `window` rgb colors, if any. */
-static void nwindow_enable_rgb_color(nwindow *window, bool enable) {
-  if (enable) {
-    if (window->fg.enabled) {
-      tui_set_foreground_color(window->fg.r, window->fg.g, window->fg.b);
-    }
-    if (window->bg.enabled) {
-      tui_set_background_color(window->bg.r, window->bg.g, window->bg.b);
-    }
-  }
-  else {
-    if (window->fg.enabled || window->bg.enabled) {
-      tui_reset_color();
-    }
-  }
-}
+/* The terminal state as we build an update, so we only emit what actually changes. */
+typedef struct {
+  int row;        /* The terminal cursor row, or `-1` when unknown. */
+  int column;     /* The terminal cursor column, or `-1` when unknown. */
+  nwindow_rgb fg;
+  nwindow_rgb bg;
+  Uchar attr;
+} nwindow_termstate;
+
+/* All created windows, so `nwindow_update()` can flush them all. */
+static nwindow *windows = NULL;
+/* The window that last moved its cursor, the terminal cursor is left there after an update. */
+static nwindow *cursor_window = NULL;
+
+/* The output of a update, we build it all here so it can be written with a single call. */
+static char *update_data = NULL;
+static Ulong update_len = 0;
+static Ulong update_cap = 0;
+/* The number of bytes the last `nwindow_update()` wrote. */
+static Ulong last_update_bytes = 0;
+
+/* When `TRUE`, updates let the terminal scroll content that only moved vertically, instead of writing it again. */
+static bool scroll_acceleration = TRUE;
+/* Row hashes of the back and front grid, used to find vertical scrolls. */
+static Ulong *row_hash = NULL;
+static short row_hash_cap = 0;
 
 /* `Internal`  Set a `nwindow_rgb` struct's `enabled` flag to `FALSE` when `encoded` is set to -1, otherwise set the `r,g,b` code based on the encoded data. */
 static void nwindow_rgb_set_encoded(nwindow_rgb *rgb, int encoded) {
@@ -60,21 +85,308 @@ static void nwindow_rgb_set_encoded(nwindow_rgb *rgb, int encoded) {
   rgb->enabled = TRUE;
 }
 
+/* `Internal`  Return's `TRUE` when `a` and `b` would print the same, two disabled colors are equal regardless of their `r,g,b`. */
+static inline bool nwindow_rgb_eq(const nwindow_rgb *const a, const nwindow_rgb *const b) {
+  if (!a->enabled || !b->enabled) {
+    return (a->enabled == b->enabled);
+  }
+  return (a->r == b->r && a->g == b->g && a->b == b->b);
+}
+
+/* `Internal`  Return's `TRUE` when `a` and `b` would print the same. */
+static inline bool nwindow_cell_eq(const nwindow_cell *const a, const nwindow_cell *const b) {
+  return (a->ch == b->ch && a->attr == b->attr && nwindow_rgb_eq(&a->fg, &b->fg) && nwindow_rgb_eq(&a->bg, &b->bg));
+}
+
+/* `Internal`  Return's `TRUE` when `cell` can be written without changing the terminal colors or attributes in `ts`. */
+static inline bool nwindow_cell_same_sgr(const nwindow_cell *const cell, const nwindow_termstate *const ts) {
+  return (cell->attr == ts->attr && nwindow_rgb_eq(&cell->fg, &ts->fg) && nwindow_rgb_eq(&cell->bg, &ts->bg));
+}
+
+/* `Internal`  Set `len` cells starting at `cells` to a space with the default colors. */
+static void nwindow_cells_blank(nwindow_cell *cells, long len) {
+  for (long i=0; i<len; ++i) {
+    cells[i].ch         = ' ';
+    cells[i].fg.enabled = FALSE;
+    cells[i].bg.enabled = FALSE;
+    cells[i].attr       = 0;
+  }
+}
+
+/* `Internal`  Mark `len` cells starting at `cells` as unknown, so the next update writes them. */
+static void nwindow_cells_invalidate(nwindow_cell *cells, long len) {
+  for (long i=0; i<len; ++i) {
+    cells[i].ch = NWINDOW_CELL_INVALID;
+  }
+}
+
+/* `Internal`  Shift the rows of the `size_x` by `size_y` grid `cells` up `howmush` rows, or down when negative, and blank the rows that opens up. */
+static void nwindow_cells_shift(nwindow_cell *cells, short size_x, short size_y, int howmush) {
+  long rows = ABS(howmush);
+  long size = (size_x * size_y);
+  CLAMP_MAX(rows, size_y);
+  if (howmush > 0) {
+    memmove(cells, (cells + (rows * size_x)), ((size - (rows * size_x)) * sizeof(*cells)));
+    nwindow_cells_blank((cells + (size - (rows * size_x))), (rows * size_x));
+  }
+  else if (howmush < 0) {
+    memmove((cells + (rows * size_x)), cells, ((size - (rows * size_x)) * sizeof(*cells)));
+    nwindow_cells_blank(cells, (rows * size_x));
+  }
+}
+
+/* `Internal`  Return's a hash of the `len` cells at `cells`, or `0` when any of them is unknown, so that row never matches another. */
+static Ulong nwindow_cells_hash(const nwindow_cell *const cells, short len) {
+  Ulong hash = 14695981039346656037UL;
+  for (short i=0; i<len; ++i) {
+    if (cells[i].ch == NWINDOW_CELL_INVALID) {
+      return 0;
+    }
+    hash = ((hash ^ cells[i].ch) * 1099511628211UL);
+    hash = ((hash ^ cells[i].attr) * 1099511628211UL);
+    hash = ((hash ^ (cells[i].fg.enabled ? (cells[i].fg.r | (cells[i].fg.g << 8) | (cells[i].fg.b << 16) | (1 << 24)) : 0)) * 1099511628211UL);
+    hash = ((hash ^ (cells[i].bg.enabled ? (cells[i].bg.r | (cells[i].bg.g << 8) | (cells[i].bg.b << 16) | (1 << 24)) : 0)) * 1099511628211UL);
+  }
+  return (hash ? hash : 1);
+}
+
+/* `Internal`  Append `len` bytes of `data` to the update output. */
+static void nwindow_update_append(const char *const restrict data, Ulong len) {
+  if ((update_len + len) > update_cap) {
+    while ((update_len + len) > update_cap) {
+      update_cap = (update_cap ? (update_cap * 2) : 4096);
+    }
+    update_data = xrealloc(update_data, update_cap);
+  }
+  memcpy((update_data + update_len), data, len);
+  update_len += len;
+}
+
+/* `Internal`  Move the terminal cursor in `ts` to `row` and `column`, when its not already there. */
+static void nwindow_update_move(nwindow_termstate *const ts, int row, int column) {
+  char buffer[256];
+  Ulong len;
+  if (ts->row == row && ts->column == column) {
+    return;
+  }
+  len = tui_move_str(buffer, sizeof(buffer), row, column);
+  nwindow_update_append(buffer, len);
+  ts->row    = row;
+  ts->column = column;
+}
+
+/* `Internal`  Bring the terminal colors and attributes in `ts` to the ones of `cell`, with as few bytes as we can. */
+static void nwindow_update_sgr(nwindow_termstate *const ts, const nwindow_cell *const cell) {
+  char buffer[256];
+  Ulong len;
+  /* Colors and attributes can only be turned off all at once, so reset when something needs to go. */
+  if ((ts->fg.enabled && !cell->fg.enabled) || (ts->bg.enabled && !cell->bg.enabled) || (ts->attr & ~cell->attr)) {
+    nwindow_update_append(S__LEN("\x1b[0m"));
+    ts->fg.enabled = FALSE;
+    ts->bg.enabled = FALSE;
+    ts->attr       = 0;
+  }
+  if ((cell->attr & NWINDOW_ATTR_BOLD) && !(ts->attr & NWINDOW_ATTR_BOLD)) {
+    nwindow_update_append(S__LEN("\x1b[1m"));
+  }
+  if ((cell->attr & NWINDOW_ATTR_UNDERLINE) && !(ts->attr & NWINDOW_ATTR_UNDERLINE)) {
+    nwindow_update_append(S__LEN("\x1b[4m"));
+  }
+  if ((cell->attr & NWINDOW_ATTR_REVERSE) && !(ts->attr & NWINDOW_ATTR_REVERSE)) {
+    nwindow_update_append(S__LEN("\x1b[7m"));
+  }
+  ts->attr = cell->attr;
+  if (cell->fg.enabled && !nwindow_rgb_eq(&cell->fg, &ts->fg)) {
+    len = tui_set_foreground_color_str(buffer, sizeof(buffer), cell->fg.r, cell->fg.g, cell->fg.b);
+    nwindow_update_append(buffer, len);
+    ts->fg = cell->fg;
+  }
+  if (cell->bg.enabled && !nwindow_rgb_eq(&cell->bg, &ts->bg)) {
+    len = tui_set_background_color_str(buffer, sizeof(buffer), cell->bg.r, cell->bg.g, cell->bg.b);
+    nwindow_update_append(buffer, len);
+    ts->bg = cell->bg;
+  }
+}
+
+/* `Internal`  Write the codepoint of `cell` at the terminal cursor, and advance the cursor in `ts` by `width`. */
+static void nwindow_update_putc(nwindow_termstate *const ts, const nwindow_cell *const cell, int width) {
+  char mb[MAXCHARLEN];
+  int len = widetomb(cell->ch, mb);
+  if (len <= 0) {
+    nwindow_update_append(S__LEN("?"));
+  }
+  else {
+    nwindow_update_append(mb, len);
+  }
+  ts->column += width;
+  /* Once we reach the last column, terminals differ in where the cursor is, so we no longer know. */
+  if (NCOLS > 0 && ts->column >= NCOLS) {
+    ts->row    = -1;
+    ts->column = -1;
+  }
+}
+
+/* `Internal`  When the rows of `window` moved vertically since the last update, by comparing the row hashes of the back and
+ * front grid, append a terminal scroll of the window rows to the update and shift the front grid to match, so only the
+ * rows that opened up are left to write.  Return's `TRUE` when a scroll was appended. */
+static bool nwindow_update_scroll(nwindow *window, nwindow_termstate *const ts) {
+  char buffer[64];
+  Ulong *back;
+  Ulong *front;
+  int matches;
+  int unmoved = 0;
+  int best_matches;
+  int best = 0;
+  /* The terminal can only scroll whole screen rows, so the window has to span the width of the screen. */
+  if (!scroll_acceleration || window->size_y < 2 || window->beg_x || NCOLS <= 0 || window->size_x != NCOLS) {
+    return FALSE;
+  }
+  if (row_hash_cap < window->size_y) {
+    row_hash_cap = window->size_y;
+    row_hash     = xrealloc(row_hash, (row_hash_cap * 2 * sizeof(*row_hash)));
+  }
+  back  = row_hash;
+  front = (row_hash + window->size_y);
+  for (short y=0; y<window->size_y; ++y) {
+    back[y]  = nwindow_cells_hash((window->back  + (y * window->size_x)), window->size_x);
+    front[y] = nwindow_cells_hash((window->front + (y * window->size_x)), window->size_x);
+    unmoved += (front[y] && back[y] == front[y]);
+  }
+  if (unmoved == window->size_y) {
+    return FALSE;
+  }
+  best_matches = unmoved;
+  for (int k=1; k<window->size_y; ++k) {
+    /* Scrolled up `k` rows, so row `y` now shows what row `y + k` showed. */
+    matches = 0;
+    for (int y=0; (y + k) < window->size_y; ++y) {
+      matches += (front[y + k] && back[y] == front[y + k]);
+    }
+    if (matches > best_matches) {
+      best_matches = matches;
+      best         = k;
+    }
+    /* Scrolled down `k` rows, so row `y` now shows what row `y - k` showed. */
+    matches = 0;
+    for (int y=k; y<window->size_y; ++y) {
+      matches += (front[y - k] && back[y] == front[y - k]);
+    }
+    if (matches > best_matches) {
+      best_matches = matches;
+      best         = -k;
+    }
+  }
+  if (!best || (best_matches - unmoved) < NWINDOW_MIN_SCROLL_GAIN) {
+    return FALSE;
+  }
+  /* The rows that open up get the current background, so make that the default first. */
+  if (ts->fg.enabled || ts->bg.enabled || ts->attr) {
+    nwindow_update_append(S__LEN("\x1b[0m"));
+    ts->fg.enabled = FALSE;
+    ts->bg.enabled = FALSE;
+    ts->attr       = 0;
+  }
+  nwindow_update_append(buffer, tui_scroll_region_str(buffer, sizeof(buffer), window->beg_y, (window->beg_y + window->size_y - 1)));
+  nwindow_update_append(buffer, tui_scroll_str(buffer, sizeof(buffer), best));
+  nwindow_update_append(buffer, tui_scroll_region_str(buffer, sizeof(buffer), -1, -1));
+  /* Setting the scroll region homes the cursor. */
+  ts->row    = 0;
+  ts->column = 0;
+  nwindow_cells_shift(window->front, window->size_x, window->size_y, best);
+  return TRUE;
+}
+
+/* `Internal`  Append everything that differs between the back and front grid of `window` to the update, and make the front match. */
+static void nwindow_update_window(nwindow *window, nwindow_termstate *const ts) {
+  nwindow_cell *back;
+  nwindow_cell *front;
+  nwindow_cell *gap;
+  int row;
+  int column;
+  int width;
+  int from;
+  bool rewrite;
+  nwindow_update_scroll(window, ts);
+  for (short y=0; y<window->size_y; ++y) {
+    back  = (window->back  + (y * window->size_x));
+    front = (window->front + (y * window->size_x));
+    row   = (window->beg_y + y);
+    for (short x=0; x<window->size_x; ++x) {
+      if (nwindow_cell_eq(&back[x], &front[x])) {
+        continue;
+      }
+      /* The right half of a double width char is written by its left half. */
+      else if (!back[x].ch) {
+        front[x] = back[x];
+        continue;
+      }
+      column = (window->beg_x + x);
+      width  = ((x + 1) < window->size_x && !back[x + 1].ch) ? 2 : 1;
+      rewrite = FALSE;
+      /* When the cursor is just a few unchanged cells behind us, writing those cells again is cheaper then a move. */
+      if (ts->row == row && ts->column < column && ts->column >= window->beg_x && (column - ts->column) <= NWINDOW_MAX_REWRITE_GAP) {
+        from    = (ts->column - window->beg_x);
+        rewrite = TRUE;
+        for (int i=from; i<x && rewrite; ++i) {
+          gap     = &back[i];
+          rewrite = (gap->ch && gap->ch != NWINDOW_CELL_INVALID && nwindow_cell_same_sgr(gap, ts));
+        }
+        if (rewrite) {
+          for (int i=from; i<x; ++i) {
+            nwindow_update_putc(ts, &back[i], 1);
+          }
+        }
+      }
+      if (!rewrite) {
+        nwindow_update_move(ts, row, column);
+      }
+      nwindow_update_sgr(ts, &back[x]);
+      nwindow_update_putc(ts, &back[x], width);
+      front[x] = back[x];
+      if (width == 2) {
+        front[x + 1] = back[x + 1];
+        ++x;
+      }
+    }
+  }
+}
+
+/* `Internal`  Build the update for all windows into the update output, without writing it, and return the length. */
+static Ulong nwindow_update_build(void) {
+  nwindow_termstate ts = { -1, -1, { 0, 0, 0, FALSE }, { 0, 0, 0, FALSE }, 0 };
+  update_len = 0;
+  for (nwindow *window = windows; window; window = window->next) {
+    nwindow_update_window(window, &ts);
+  }
+  /* Always leave the terminal with the default colors, as other writers assume it. */
+  if (ts.fg.enabled || ts.bg.enabled || ts.attr) {
+    nwindow_update_append(S__LEN("\x1b[0m"));
+  }
+  if (cursor_window) {
+    nwindow_update_move(&ts, (cursor_window->beg_y + cursor_window->cur_y), (cursor_window->beg_x + cursor_window->cur_x));
+  }
+  return update_len;
+}
+
 nwindow *nwindow_create(short rows, short columns, short screen_row, short screen_column) {
   nwindow *window = xmalloc(sizeof(*window));
-  window->beg_y = screen_row; 
+  window->beg_y = screen_row;
   window->beg_x = screen_column;
   window->cur_x = 0;
   window->cur_y = 0;
   window->size_x = columns;
   window->size_y = rows;
-  window->line = xmalloc(sizeof(*window->line) * window->size_y);
-  for (short y = 0; y < window->size_y; ++y) {
-    window->line[y].data = xmalloc(window->size_x);
-    memset(window->line[y].data, ' ', window->size_x);
-  }
+  window->back  = xmalloc(sizeof(*window->back) * window->size_x * window->size_y);
+  window->front = xmalloc(sizeof(*window->front) * window->size_x * window->size_y);
+  nwindow_cells_blank(window->back, (window->size_x * window->size_y));
+  /* We dont know what the screen shows, so the first update writes the whole window. */
+  nwindow_cells_blank(window->front, (window->size_x * window->size_y));
+  nwindow_cells_invalidate(window->front, (window->size_x * window->size_y));
   window->fg.enabled = FALSE;
   window->bg.enabled = FALSE;
+  window->attr = 0;
+  window->next = windows;
+  windows = window;
   return window;
 }
 
@@ -82,11 +394,18 @@ void nwindow_free(nwindow *window) {
   if (!window) {
     return;
   }
-  for (short y = 0; y < window->size_y; ++y) {
-    free(window->line[y].data);
+  for (nwindow **link = &windows; *link; link = &(*link)->next) {
+    if (*link == window) {
+      *link = window->next;
+      break;
+    }
   }
+  if (cursor_window == window) {
+    cursor_window = NULL;
+  }
+  free(window->back);
+  free(window->front);
   free(window);
-  window = NULL;
 }
 
 bool nwindow_move(nwindow *window, short row, short column) {
@@ -97,11 +416,15 @@ bool nwindow_move(nwindow *window, short row, short column) {
   }
   window->cur_x = column;
   window->cur_y = row;
-  tui_move((window->beg_y + window->cur_y), (window->beg_x + window->cur_x));
+  cursor_window = window;
   return TRUE;
 }
 
 void nwindow_add_nstr(nwindow *window, const char *string, Ulong len) {
+  nwindow_cell *cell;
+  wchar wc;
+  int charlen;
+  int width;
   /* Return early upon bad parameters. */
   if (!window || !string || !len) {
     errno = EINVAL;
@@ -110,17 +433,36 @@ void nwindow_add_nstr(nwindow *window, const char *string, Ulong len) {
   if (len == (Ulong)-1) {
     len = strlen(string);
   }
-  /* If the string length overshots the window size, just print what fits. */
-  if ((short)(window->cur_x + len) >= window->size_x) {
-    len = (window->size_x - window->cur_x);
+  cell = (window->back + (window->cur_y * window->size_x));
+  for (Ulong i=0; i<len && window->cur_x < window->size_x; i+=charlen) {
+    charlen = mbtowide(&wc, (string + i));
+    /* Invalid or cut off sequences are shown byte by byte. */
+    if (charlen <= 0 || (i + charlen) > len) {
+      wc      = (Uchar)string[i];
+      charlen = 1;
+      width   = 1;
+    }
+    else {
+      width = (is_doublewidth(string + i) ? 2 : 1);
+    }
+    /* If the string overshots the window size, just keep what fits. */
+    if ((window->cur_x + width) > window->size_x) {
+      break;
+    }
+    cell[window->cur_x].ch   = wc;
+    cell[window->cur_x].fg   = window->fg;
+    cell[window->cur_x].bg   = window->bg;
+    cell[window->cur_x].attr = window->attr;
+    if (width == 2) {
+      cell[window->cur_x + 1]    = cell[window->cur_x];
+      cell[window->cur_x + 1].ch = 0;
+    }
+    window->cur_x += width;
+  }
+  /* Keep the cursor inside the window, like the cut off write left it. */
+  if (window->cur_x >= window->size_x) {
+    window->cur_x = (window->size_x - 1);
   }
-  /* Insert the data in the line. */
-  memcpy((window->line[window->cur_y].data + window->cur_x), string, len);
-  tui_move((window->beg_y + window->cur_y), (window->beg_x + window->cur_x));
-  nwindow_enable_rgb_color(window, TRUE);
-  nfdwriter_write_stdout(string, len);
-  nwindow_enable_rgb_color(window, FALSE);
-  window->cur_x += len;
 }
 
 void nwindow_add_str(nwindow *window, const char *string) {
@@ -162,45 +504,186 @@ void nwindow_set_rgb_code(nwindow *window, Uchar r_fg, Uchar g_fg, Uchar b_fg, U
   nwindow_set_rgb(window, (r_fg | (g_fg << 8) | (b_fg << 16)), (r_bg | (g_bg << 8) | (b_bg << 16)));
 }
 
+void nwindow_attr_on(nwindow *window, Uchar attr) {
+  if (!window) {
+    return;
+  }
+  window->attr |= attr;
+}
+
+void nwindow_attr_off(nwindow *window, Uchar attr) {
+  if (!window) {
+    return;
+  }
+  window->attr &= ~attr;
+}
+
 void nwindow_clrtoeol(nwindow *window) {
   if (!window) {
     return;
   }
-  short was_cur_x = window->cur_x;
-  window->fg.enabled = FALSE;
-  window->bg.enabled = FALSE;
-  nwindow_printf(window, "%*s", (window->size_x - window->cur_x), " ");
-  window->fg.enabled = TRUE;
-  window->bg.enabled = TRUE;
-  window->cur_x = was_cur_x;
+  nwindow_cells_blank((window->back + (window->cur_y * window->size_x) + window->cur_x), (window->size_x - window->cur_x));
+}
+
+void nwindow_put_row(nwindow *window, short row, const char *string, Ulong len) {
+  nwindow *saved_cursor;
+  short saved_x;
+  short saved_y;
+  if (!window || row >= window->size_y || row < 0) {
+    return;
+  }
+  saved_cursor = cursor_window;
+  saved_x = window->cur_x;
+  saved_y = window->cur_y;
+  window->cur_x = 0;
+  window->cur_y = row;
+  nwindow_clrtoeol(window);
+  if (len) {
+    nwindow_add_nstr(window, string, len);
+  }
+  window->cur_x = saved_x;
+  window->cur_y = saved_y;
+  cursor_window = saved_cursor;
 }
 
 void nwindow_redrawl(nwindow *window, short row) {
   if (!window || row >= window->size_y || row < 0) {
     return;
   }
-  nwindow_move_add_nstr(window, row, 0, window->line[row].data, window->size_x);
+  nwindow_cells_invalidate((window->front + (row * window->size_x)), window->size_x);
 }
 
 void nwindow_redrawln(nwindow *window, short from, short howmeny) {
   if (!window || from >= window->size_y || from < 0) {
     return;
   }
-  short was_cur_x = window->cur_x;
-  short was_cur_y = window->cur_y;
-  while (from < window->size_y) {
+  short end = (from + howmeny);
+  CLAMP_MAX(end, window->size_y);
+  while (from < end) {
     nwindow_redrawl(window, from++);
   }
-  window->cur_x = was_cur_x;
-  window->cur_y = was_cur_y;
 }
 
 void nwindow_scroll(nwindow *window, int howmush) {
-  tui_scroll_region(window->beg_x, (window->beg_y + window->size_y));
-  if (howmush > 0) {
-    nfdwriter_printf(nfdwriter_stdout, "\233%dS", howmush);
+  if (!window || !howmush) {
+    return;
   }
-  else if (howmush < 0) {
-    nfdwriter_printf(nfdwriter_stdout, "\233%dT", (howmush * (-1)));
+  /* Only the content moves here, the next update sees the rows moved and lets the terminal scroll them. */
+  nwindow_cells_shift(window->back, window->size_x, window->size_y, howmush);
+}
+
+/* Write the difference between what all windows want on screen and what the screen shows, in a single write.  Returns the number of bytes written. */
+Ulong nwindow_update(void) {
+  last_update_bytes = nwindow_update_build();
+  if (last_update_bytes) {
+    nfdwriter_write_stdout(update_data, last_update_bytes);
+  }
+  return last_update_bytes;
+}
+
+Ulong nwindow_last_update_bytes(void) {
+  return last_update_bytes;
+}
+
+/* Tests. */
+
+#define NWINDOW_TEST_LINES               (100000)
+#define NWINDOW_TEST_ROWS                (50)
+#define NWINDOW_TEST_COLUMNS             (160)
+#define NWINDOW_TEST_SCROLL_STEP         (3)
+#define NWINDOW_TEST_REDRAWS_PER_SCROLL  (2)
+
+/* `Internal`  The bytes the old immediate backend wrote for a `nwindow_add_nstr()` of `len` bytes at `row` and `column`, with or without a color. */
+static Ulong nwindow_test_immediate_bytes(int row, int column, Ulong len, bool colored) {
+  char buffer[256];
+  Ulong bytes = (tui_move_str(buffer, sizeof(buffer), row, column) + len);
+  if (colored) {
+    bytes += (tui_set_foreground_color_str(buffer, sizeof(buffer), 0x60, 0x60, 0x60) + SLTLEN("\x1b[0m"));
+  }
+  return bytes;
+}
+
+/* `Internal`  Scroll through all `lines` in a fresh window, redrawing every row of it each frame like `edit_refresh()` does.
+ * Returns the bytes the updates built, and adds the frames and the bytes the immediate backend would have written. */
+static Ulong nwindow_test_scroll_run(char **lines, Ulong *lens, Ulong *frames, Ulong *immediate_bytes) {
+  nwindow *window = nwindow_create(NWINDOW_TEST_ROWS, NWINDOW_TEST_COLUMNS, 0, 0);
+  Ulong bytes = 0;
+  Ulong len;
+  for (int top=0; (top + NWINDOW_TEST_ROWS) <= NWINDOW_TEST_LINES; top+=NWINDOW_TEST_SCROLL_STEP) {
+    for (int redraw=0; redraw<NWINDOW_TEST_REDRAWS_PER_SCROLL; ++redraw) {
+      for (short row=0; row<NWINDOW_TEST_ROWS; ++row) {
+        len = lens[top + row];
+        CLAMP_MAX(len, (Ulong)(NWINDOW_TEST_COLUMNS - 8));
+        nwindow_move(window, row, 0);
+        nwindow_set_rgb(window, 0x606060, -1);
+        nwindow_printf(window, "%7d ", (top + row + 1));
+        nwindow_set_rgb(window, -1, -1);
+        nwindow_add_nstr(window, lines[top + row], len);
+        nwindow_clrtoeol(window);
+        if (immediate_bytes) {
+          *immediate_bytes += nwindow_test_immediate_bytes(row, 0, 8, TRUE);
+          *immediate_bytes += nwindow_test_immediate_bytes(row, 8, len, FALSE);
+          *immediate_bytes += nwindow_test_immediate_bytes(row, (8 + len), (NWINDOW_TEST_COLUMNS - 8 - len), FALSE);
+        }
+      }
+      bytes += nwindow_update_build();
+      ++(*frames);
+    }
+  }
+  nwindow_free(window);
+  return bytes;
+}
+
+/* Replay scrolling through a large file a few lines at a time, with an unchanged redraw between each scroll like cursor movement
+ * gives, and compare the bytes the diff writes with and without terminal scrolling, and what the immediate backend wrote. */
+void nwindow_test_scroll_bench(void) {
+  nwindow *saved_windows = windows;
+  nwindow *saved_cursor  = cursor_window;
+  bool saved_scroll_acceleration = scroll_acceleration;
+  int saved_ncols = NCOLS;
+  char **lines;
+  Ulong *lens;
+  Ulong diff_bytes;
+  Ulong scroll_bytes;
+  Ulong immediate_bytes = 0;
+  Ulong frames = 0;
+  if (!terminfo) {
+    terminfo_init();
+  }
+  windows       = NULL;
+  cursor_window = NULL;
+  /* Make the test window span the screen, so it can be scrolled by the terminal. */
+  NCOLS = NWINDOW_TEST_COLUMNS;
+  lines = xmalloc(NWINDOW_TEST_LINES * sizeof(*lines));
+  lens  = xmalloc(NWINDOW_TEST_LINES * sizeof(*lens));
+  srand(1);
+  for (int i=0; i<NWINDOW_TEST_LINES; ++i) {
+    lines[i] = fmtstr("%*sstatic int value_%d = (%d * %d); /* %.*s */", ((rand() % 4) * 2), "", i, rand(), rand(), (rand() % 60), "comment comment comment comment comment comment comment comment");
+    lens[i]  = strlen(lines[i]);
+  }
+  scroll_acceleration = FALSE;
+  timer_action(diff_ms,
+    diff_bytes = nwindow_test_scroll_run(lines, lens, &frames, &immediate_bytes);
+  );
+  frames = 0;
+  scroll_acceleration = TRUE;
+  timer_action(scroll_ms,
+    scroll_bytes = nwindow_test_scroll_run(lines, lens, &frames, NULL);
+  );
+  for (int i=0; i<NWINDOW_TEST_LINES; ++i) {
+    free(lines[i]);
   }
+  free(lines);
+  free(lens);
+  windows             = saved_windows;
+  cursor_window       = saved_cursor;
+  scroll_acceleration = saved_scroll_acceleration;
+  NCOLS               = saved_ncols;
+  writef(
+    "\n%s: Lines: %d: Frames: %lu: Immediate: %lu bytes (%.1f per frame): Diff: %lu bytes (%.1f per frame) in %.5f ms: "
+    "Diff with scrolling: %lu bytes (%.1f per frame) in %.5f ms: Saved by scrolling: %.1f%%\n\n",
+    __func__, NWINDOW_TEST_LINES, frames, immediate_bytes, ((double)immediate_bytes / frames),
+    diff_bytes, ((double)diff_bytes / frames), (double)diff_ms, scroll_bytes, ((double)scroll_bytes / frames), (double)scroll_ms,
+    (diff_bytes ? (100.0 - (((double)scroll_bytes * 100.0) / diff_bytes)) : 0.0)
+  );
 }
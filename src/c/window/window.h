@@ -5,6 +5,11 @@
 
 _BEGIN_C_LINKAGE
 
+/* Attributes text added to a `nwindow` can have, see `nwindow_attr_on()`. */
+#define NWINDOW_ATTR_BOLD       (1 << 0)
+#define NWINDOW_ATTR_UNDERLINE  (1 << 1)
+#define NWINDOW_ATTR_REVERSE    (1 << 2)
+
 typedef struct nwindow nwindow;
 
 nwindow *nwindow_create(short rows, short columns, short screen_row, short screen_column);
@@ -29,14 +34,35 @@ void nwindow_set_rgb(nwindow *window, int encoded_fg, int encoded_bg);
 /* See `nwindow_set_rgb_int()`.  This just encodes the int inline, then calls `nwindow_set_rgb_int()`. */
 void nwindow_set_rgb_code(nwindow *window, Uchar r_fg, Uchar g_fg, Uchar b_fg, Uchar r_bg, Uchar g_bg, Uchar b_bg);
 
+/* Turn on the `NWINDOW_ATTR_*` flags in `attr` for text added to `window` from now on. */
+void nwindow_attr_on(nwindow *window, Uchar attr);
+
+/* Turn off the `NWINDOW_ATTR_*` flags in `attr` for text added to `window` from now on. */
+void nwindow_attr_off(nwindow *window, Uchar attr);
+
 void nwindow_clrtoeol(nwindow *window);
 
+/* Replace `row` of `window` with `len` bytes of `string`, blanking the rest of it.  Unlike moving there and adding the
+ * string, this leaves both the cursor of `window` and the window the next `nwindow_update()` puts the cursor in alone. */
+void nwindow_put_row(nwindow *window, short row, const char *string, Ulong len);
+
 void nwindow_redrawl(nwindow *window, short row);
 
 void nwindow_redrawln(nwindow *window, short from, short howmeny);
 
+/* Move the content of `window` up `howmush` rows, or down when negative.  The next `nwindow_update()` lets the terminal scroll it. */
 void nwindow_scroll(nwindow *window, int howmush);
 
+/* Nothing above writes to the terminal, this writes only the cells of all windows that changed since the last update,
+ * then leaves the cursor where the last moved window has it.  Rows that only moved vertically in a window that spans
+ * the screen width are scrolled by the terminal instead of written again.  Returns the number of bytes written. */
+Ulong nwindow_update(void);
+
+/* Return's the number of bytes the last `nwindow_update()` wrote. */
+Ulong nwindow_last_update_bytes(void);
+
+void nwindow_test_scroll_bench(void);
+
 /* Macro's to do some chained things. */
 
 #define nwindow_move_add_nstr(window, row, column, string, len) \
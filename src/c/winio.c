@@ -5,6 +5,7 @@
 
  */
 #include "../include/c_proto.h"
+#include "perf/nperf.h"
 
 
 /* ---------------------------------------------------------- Define's ---------------------------------------------------------- */
@@ -1976,16 +1977,138 @@ Ulong get_softwrap_breakpoint(int cols, const char *const restrict linedata, Ulo
   return ((cols > 1) ? breaking_col : (column - 1));
 }
 
+/* ----------------------------- Softwrap cache ----------------------------- */
+
+/* Whether the chunks of wrapped lines are cached, only turned off to compare against in the benchmark. */
+static bool softwrap_caching = TRUE;
+
+/* Free the cached softwrap chunks of `line`, if any. */
+void softwrap_cache_free(linestruct *const line) {
+  ASSERT(line);
+  if (line->softwrap) {
+    free(line->softwrap->edges);
+    free(line->softwrap);
+    line->softwrap = NULL;
+  }
+}
+
+/* `Internal`  Return the chunk edges of `line` when the window is `cols` wide, and put the number of chunks in `*count`.  The
+ * starting column of chunk `n` is `edges[n]` and the last chunk ends at `edges[*count]`.  Lines that wrap get their edges cached
+ * in the line itself, and lines that fit on a single row use `single`, as computing those is no more work than checking a cache.
+ * The line data is only hashed again after an edit, as until `line_data_version` changes no line can have changed. */
+static const Ulong *softwrap_edges(int cols, linestruct *const line, Ulong *const count, Ulong single[2]) {
+  softwrapcache *cache = line->softwrap;
+  Ulong len;
+  Ulong hash;
+  Ulong end_col;
+  bool  kickoff     = TRUE;
+  bool  end_of_line = FALSE;
+  bool  same_layout = (cache && cache->cols == cols && cache->tabsize == tabsize && cache->at_blanks == ISSET(AT_BLANKS));
+  if (same_layout && cache->version == line_data_version) {
+    *count = cache->count;
+    return cache->edges;
+  }
+  len  = strlen(line->data);
+  hash = bytes_hash(line->data, len);
+  if (same_layout && cache->len == len && cache->hash == hash) {
+    cache->version = line_data_version;
+    *count = cache->count;
+    return cache->edges;
+  }
+  single[0] = 0;
+  single[1] = get_softwrap_breakpoint(cols, line->data, 0, &kickoff, &end_of_line);
+  if (end_of_line) {
+    softwrap_cache_free(line);
+    *count = 1;
+    return single;
+  }
+  if (!cache) {
+    cache        = xmalloc(sizeof(*cache));
+    cache->cap   = 8;
+    cache->edges = xmalloc(cache->cap * sizeof(Ulong));
+    line->softwrap = cache;
+  }
+  cache->edges[0] = 0;
+  cache->edges[1] = single[1];
+  cache->count    = 1;
+  while (!end_of_line) {
+    end_col = get_softwrap_breakpoint(cols, line->data, cache->edges[cache->count], &kickoff, &end_of_line);
+    if (cache->count + 2 > cache->cap) {
+      cache->cap  *= 2;
+      cache->edges = xrealloc(cache->edges, (cache->cap * sizeof(Ulong)));
+    }
+    cache->edges[++cache->count] = end_col;
+  }
+  cache->len       = len;
+  cache->hash      = hash;
+  cache->cols      = cols;
+  cache->tabsize   = tabsize;
+  cache->at_blanks = ISSET(AT_BLANKS);
+  cache->version   = line_data_version;
+  *count = cache->count;
+  return cache->edges;
+}
+
+/* `Internal`  Return the chunk that `column` is on, given the edges of a line with `count` chunks.  A column past the end of the line is on the last chunk. */
+static Ulong softwrap_chunk_of(const Ulong *const edges, Ulong count, Ulong column) {
+  Ulong lo = 1;
+  Ulong hi = count;
+  Ulong mid;
+  /* Find the first chunk end that lies after `column`. */
+  while (lo < hi) {
+    mid = (lo + ((hi - lo) / 2));
+    if (edges[mid] > column) {
+      hi = mid;
+    }
+    else {
+      lo = mid + 1;
+    }
+  }
+  return ((edges[lo] > column) ? (lo - 1) : (count - 1));
+}
+
+/* Return the end column of the chunk of `line` that starts at `leftedge`, and set `*end_of_line` to whether this is the last chunk.  The
+ * chunks are the ones the line is drawn with, found by walking them from the start of the line, without scanning the line again. */
+Ulong softwrap_chunk_end(int cols, linestruct *const line, Ulong leftedge, bool *const end_of_line) {
+  ASSERT(line);
+  ASSERT(end_of_line);
+  Ulong single[2];
+  Ulong count;
+  Ulong chunk;
+  bool  kickoff = TRUE;
+  const Ulong *edges;
+  if (!softwrap_caching) {
+    *end_of_line = FALSE;
+    return get_softwrap_breakpoint(cols, line->data, leftedge, &kickoff, end_of_line);
+  }
+  edges = softwrap_edges(cols, line, &count, single);
+  chunk = softwrap_chunk_of(edges, count, leftedge);
+  *end_of_line = (chunk == (count - 1));
+  return edges[chunk + 1];
+}
+
 /* Return the row number of the softwrapped chunk in the given line that the given column is on, relative
  * to the first row (zero-based).  If leftedge isn't NULL, return in it the leftmost column of the chunk. */
 Ulong get_chunk_and_edge(int cols, Ulong column, linestruct *line, Ulong *leftedge) {
+  Ulong single[2];
+  Ulong count;
+  Ulong chunk;
   Ulong end_col;
   Ulong current_chunk = 0;
   Ulong start_col     = 0;
-  bool end_of_line    = FALSE;
-  bool kickoff        = TRUE;
+  bool  end_of_line   = FALSE;
+  bool  kickoff       = TRUE;
+  const Ulong *edges;
+  if (softwrap_caching) {
+    edges = softwrap_edges(cols, line, &count, single);
+    chunk = softwrap_chunk_of(edges, count, column);
+    if (leftedge) {
+      *leftedge = edges[chunk];
+    }
+    return chunk;
+  }
   while (TRUE) {
-    end_col = get_softwrap_breakpoint(line->data, start_col, &kickoff, &end_of_line, cols);
+    end_col = get_softwrap_breakpoint(cols, line->data, start_col, &kickoff, &end_of_line);
     /* When the column is in range or we reached end-of-line, we're done. */
     if (end_of_line || (start_col <= column && column < end_col)) {
       if (leftedge) {
@@ -2072,13 +2195,45 @@ int go_forward_chunks_for(openfilestruct *const file, int cols, int nrows, lines
   Ulong current_leftedge;
   bool kickoff;
   bool eol;
-  if (ISSET(SOFTWRAP)) {
+  Ulong single[2];
+  Ulong count;
+  Ulong chunk;
+  const Ulong *edges;
+  if (ISSET(SOFTWRAP) && softwrap_caching) {
+    current_leftedge = (*leftedge);
+    i = nrows;
+    /* Skip whole lines at a time, using the chunks of each line. */
+    while (i > 0) {
+      edges = softwrap_edges(cols, *line, &count, single);
+      chunk = softwrap_chunk_of(edges, count, current_leftedge);
+      if ((count - 1 - chunk) >= (Ulong)i) {
+        current_leftedge = edges[chunk + i];
+        i = 0;
+      }
+      /* At the end of the buffer, we end up at the end column of the last chunk. */
+      else if ((*line) == file->filebot) {
+        i -= (count - 1 - chunk);
+        current_leftedge = edges[count];
+        break;
+      }
+      else {
+        i -= (count - chunk);
+        CLIST_ADV_NEXT(*line);
+        current_leftedge = 0;
+      }
+    }
+    /* Only change leftedge when we actually could move. */
+    if (i < nrows) {
+      (*leftedge) = current_leftedge;
+    }
+  }
+  else if (ISSET(SOFTWRAP)) {
     current_leftedge = (*leftedge);
     kickoff = TRUE;
     /* Advance thrue the requested number of chunks. */
     for (i=nrows; i>0; --i) {
       eol = FALSE;
-      current_leftedge = get_softwrap_breakpoint((*line)->data, current_leftedge, &kickoff, &eol, cols);
+      current_leftedge = get_softwrap_breakpoint(cols, (*line)->data, current_leftedge, &kickoff, &eol);
       if (!eol) {
         continue;
       }
@@ -2138,35 +2293,65 @@ void ensure_firstcolumn_is_aligned(void) {
   }
 }
 
-/* Convert text into a string that can be displayed on screen.
- * The caller wants to display text starting with the given column, and
- * extending for at most span columns. The returned string is dynamically
- * allocated, and should be freed. If isdata is TRUE, the caller might put "<"
- * at the beginning or ">" at the end of the line if it's too long. If isprompt
- * is TRUE, the caller might put ">" at the end of the line if it's too long. */
-char *display_string(const char *text, Ulong column, Ulong span, bool isdata, bool isprompt) {
+/* ----------------------------- Display string ----------------------------- */
+
+/* The number of times a conversion buffer was allocated or grown, only read by the benchmark.  As rows are converted from any
+ * thread, this is only ever touched atomically. */
+static Ulong display_allocations = 0;
+
+/* The scratch buffer of every row this thread has converted through `display_string_row()`. */
+static _Thread_local char **display_rows = NULL;
+static _Thread_local Ulong *display_row_sizes = NULL;
+static _Thread_local int    display_row_count = 0;
+
+/* `Internal`  Make sure `*buffer` can hold `size` bytes, growing it when needed. */
+static void display_reserve(char **const buffer, Ulong *const bufsize, Ulong size) {
+  if (!*buffer || *bufsize < size) {
+    *buffer  = xrealloc(*buffer, size);
+    *bufsize = size;
+    __atomic_fetch_add(&display_allocations, 1, __ATOMIC_RELAXED);
+  }
+}
+
+/* Convert text into a string that can be displayed on screen, and write it into `*buffer`, that has room for `*bufsize`
+ * bytes and is grown when needed, or allocated when `NULL`.  Return the length of the converted string.  The caller wants
+ * to display text starting with the given column, and extending for at most span columns.  If isdata is TRUE, the caller
+ * might put "<" at the beginning or ">" at the end of the line if it's too long.  If isprompt is TRUE, the caller might
+ * put ">" at the end of the line if it's too long.  When text is the data of `line`, pass it, so a long line is walked from a
+ * checkpoint instead of from its start, and `NULL` otherwise. */
+Ulong display_string_into(char **const buffer, Ulong *const bufsize, const char *text, const linestruct *const line, Ulong column, Ulong span, bool isdata, bool isprompt) {
+  ASSERT(buffer);
+  ASSERT(bufsize);
+  ASSERT(!line || text == line->data);
   /* The beginning of the text, to later determine the covered part. */
   const char *origin = text;
   /* The index of the first character that the caller wishes to show. */
-  Ulong start_x = actual_x(text, column);
+  Ulong start_x;
   /* The actual column where that first character starts. */
-  Ulong start_col = wideness(text, start_x);
+  Ulong start_col;
   /* The number of zero-width characters for which to reserve space. */
   Ulong stowaways = 20;
   /* The amount of memory to reserve for the displayable string. */
-  Ulong allocsize = (((IN_GUI_CTX ? (span + 50) : COLS) + stowaways) * MAXCHARLEN + 1);
+  Ulong allocsize;
   /* The displayable string we will return. */
-  char *converted = xmalloc(allocsize);
+  char *converted;
   /* Current position in converted. */
   Ulong index = 0;
   /* The column number just beyond the last shown character. */
   Ulong beyond = (column + span);
-  text += start_x;
   if (span > HIGHEST_POSITIVE) {
     statusline(ALERT, "Span has underflowed -- please report a bug");
-    converted[0] = '\0';
-    return converted;
+    display_reserve(buffer, bufsize, 1);
+    (*buffer)[0] = '\0';
+    return 0;
   }
+  start_x   = (line ? line_actual_x(line, column) : actual_x(text, column));
+  start_col = (line ? line_wideness(line, start_x) : wideness(text, start_x));
+  /* Reserve room for a whole row, or for span when that is wider, like before the screen is set up. */
+  allocsize = ((((IN_GUI_CTX || span > (Ulong)COLS) ? (span + 50) : (Ulong)COLS) + stowaways) * MAXCHARLEN + 1);
+  display_reserve(buffer, bufsize, allocsize);
+  converted = *buffer;
+  text += start_x;
   /* If the first character starts before the left edge, or would be overwritten by a "<" token, then show placeholders instead. */
   if ((start_col < column || (start_col > 0 && isdata && !ISSET(SOFTWRAP))) && *text && *text != '\t') {
     if (is_cntrl_char(text)) {
@@ -2254,7 +2439,8 @@ char *display_string(const char *text, Ulong column, Ulong span, bool isdata, bo
     if (charwidth == 0 && --stowaways == 0) {
       stowaways  = 40;
       allocsize += (stowaways * MAXCHARLEN);
-      converted  = xrealloc(converted, allocsize);
+      display_reserve(buffer, bufsize, allocsize);
+      converted  = *buffer;
     }
     /* On a Linux console, skip zero-width characters, as it would show them WITH a width, thus messing up the display.  See bug #52954. */
     if (on_a_vt && charwidth == 0) {
@@ -2288,9 +2474,51 @@ char *display_string(const char *text, Ulong column, Ulong span, bool isdata, bo
   /* Remember what part of the original text is covered by converted. */
   from_x = start_x;
   till_x = (text - origin);
+  return index;
+}
+
+/* Convert text into a string that can be displayed on screen.  The returned string is dynamically allocated, and should be freed.
+ * For the rows of the edit window, `display_string_row()` reuses a buffer instead.  See `display_string_into()` for the rest. */
+char *display_string(const char *text, Ulong column, Ulong span, bool isdata, bool isprompt) {
+  char *converted = NULL;
+  Ulong size      = 0;
+  display_string_into(&converted, &size, text, NULL, column, span, isdata, isprompt);
   return converted;
 }
 
+/* Convert text into a string that can be displayed on `row`, into a scratch buffer this thread keeps for that row, and return it,
+ * with its length in `*len` when not `NULL`.  The string stays valid until the same row is converted again, and must not be freed. */
+const char *display_string_row(int row, const char *text, const linestruct *const line, Ulong column, Ulong span, bool isdata, bool isprompt, Ulong *const len) {
+  ASSERT(row >= 0);
+  Ulong length;
+  if (row >= display_row_count) {
+    display_rows      = xrealloc(display_rows, ((row + 1) * sizeof(*display_rows)));
+    display_row_sizes = xrealloc(display_row_sizes, ((row + 1) * sizeof(*display_row_sizes)));
+    for (int i=display_row_count; i<=row; ++i) {
+      display_rows[i]      = NULL;
+      display_row_sizes[i] = 0;
+    }
+    display_row_count = (row + 1);
+  }
+  length = display_string_into(&display_rows[row], &display_row_sizes[row], text, line, column, span, isdata, isprompt);
+  if (len) {
+    *len = length;
+  }
+  return display_rows[row];
+}
+
+/* Free the row scratch buffers of the calling thread. */
+void display_string_rows_free(void) {
+  for (int i=0; i<display_row_count; ++i) {
+    free(display_rows[i]);
+  }
+  free(display_rows);
+  free(display_row_sizes);
+  display_rows      = NULL;
+  display_row_sizes = NULL;
+  display_row_count = 0;
+}
+
 /* Check whether the mark is on, or whether old_column and new_column are on different "pages"
  * (in softwrap mode, only the former applies), which means that the relevant line needs to be redrawn. */
 bool line_needs_update_for(openfilestruct *const file, int cols, Ulong old_column, Ulong new_column) {
@@ -2347,12 +2575,10 @@ bool less_than_a_screenful(Ulong was_lineno, Ulong was_leftedge) {
  * to the given leftedge in current.  The returned column is relative to the start of the text. */
 Ulong actual_last_column_for(openfilestruct *const file, int cols, Ulong leftedge, Ulong column) {
   ASSERT(file);
-  bool  kickoff, last_chunk;
+  bool  last_chunk;
   Ulong end_col;
   if (ISSET(SOFTWRAP)) {
-    kickoff    = TRUE;
-    last_chunk = FALSE;
-    end_col    = (get_softwrap_breakpoint(file->current->data, leftedge, &kickoff, &last_chunk, cols) - leftedge);
+    end_col = (softwrap_chunk_end(cols, file->current, leftedge, &last_chunk) - leftedge);
     /* If we're not on the last chunk, we're one column past the end of the row.  Shifting back one column
      * might put us in the middle of a multi-column character, but 'actual_x()' will fix that later. */
     if (!last_chunk) {
@@ -2610,6 +2836,8 @@ void edit_refresh_for(CTX_ARGS) {
   ASSERT(file);
   linestruct *line;
   int row = 0;
+  Llong perf_start = nperf_now();
+  Llong precalc_start;
   /* If the current line in file is out of view, get it back on screen. */
   if (current_is_offscreen_for(STACK_CTX)) {
     adjust_viewport_for(STACK_CTX, ((focusing || ISSET(JUMPY_SCROLLING)) ? CENTERING : FLOWING));
@@ -2622,7 +2850,9 @@ void edit_refresh_for(CTX_ARGS) {
     /* When the line above the viewport does not have multidata, recalculate it. */
     recook |= (ISSET(SOFTWRAP) && file->edittop->prev && !file->edittop->prev->multidata);
     if (recook) {
+      precalc_start = nperf_now();
       precalc_multicolorinfo_for(file);
+      nperf_record(NPERF_HIGHLIGHT, precalc_start);
       perturbed = FALSE;
       recook    = FALSE;
     }
@@ -2654,6 +2884,7 @@ void edit_refresh_for(CTX_ARGS) {
     wnoutrefresh(midwin);
     refresh_needed = FALSE; 
   }
+  nperf_record(NPERF_REFRESH, perf_start);
 }
 
 /* Refresh the screen without changing the position of lines.  Use this if we've moved and changed text. */
@@ -3136,7 +3367,7 @@ void report_cursor_position_for(openfilestruct *const file) {
   int linepct;
   int colpct;
   int charpct;
-  Ulong fullwidth = (breadth(file->current->data) + 1);
+  Ulong fullwidth = (line_breadth(file->current) + 1);
   Ulong column = (xplustabs_for(file) + 1);
   Ulong sum;
   char saved_byte = file->current->data[file->current_x];
@@ -3399,12 +3630,12 @@ void draw_row_marked_region_for_curses(openfilestruct *const file, int row, cons
     /* Only paint if the marked part of the line is on this page. */
     if (top_x < till_x && bot_x > from_x) {
       /* Compute on witch screen column to start painting. */
-      start_col = (wideness(line->data, top_x) - from_col);
+      start_col = (line_wideness(line, top_x) - from_col);
       CLAMP_MIN(start_col, 0);
       thetext = (converted + actual_x(converted, start_col));
       /* If the end of the mark if onscreen, compute how menu characters to paint.  Otherwise, just paint all. */
       if (bot_x < till_x) {
-        endcol = (wideness(line->data, bot_x) - from_col);
+        endcol = (line_wideness(line, bot_x) - from_col);
         paintlen = actual_x(thetext, (endcol - start_col));
       }
       wattron(midwin, interface_color_pair[config->selectedtext_color]);
@@ -3424,12 +3655,16 @@ void draw_row_marked_region_curses(int row, const char *const restrict converted
  * of regular characters.  'from_col' is the column number of the first character of this "page". */
 void draw_row_curses_for(openfilestruct *const file, int row, const char *const restrict converted, linestruct *const line, Ulong from_col) {
   ASSERT(file);
+  /* A long line only gets the part on screen drawn, without coloring, as matching the syntax would still walk the whole line. */
+  bool long_line = is_long_line(line->data);
+  Llong perf_start;
   render_line_text(row, converted, line, from_col);
-  if (ISSET(EXPERIMENTAL_FAST_LIVE_SYNTAX)) {
+  perf_start = nperf_now();
+  if (!long_line && ISSET(EXPERIMENTAL_FAST_LIVE_SYNTAX)) {
     apply_syntax_to_line(row, converted, line, from_col);
   }
   /* If there are color rules (and coloring is turned on), apply them. */
-  else if (file->syntax && !ISSET(NO_SYNTAX)) {
+  else if (!long_line && file->syntax && !ISSET(NO_SYNTAX)) {
     const colortype *varnish = file->syntax->color;
     /* If there are multiline regexes, make sure this line has a cache. */
     if (file->syntax->multiscore > 0 && !line->multidata) {
@@ -3480,10 +3715,10 @@ void draw_row_curses_for(openfilestruct *const file, int row, const char *const
             continue;
           }
           if (match.rm_so > (int)from_x) {
-            start_col = wideness(line->data, match.rm_so) - from_col;
+            start_col = line_wideness(line, match.rm_so) - from_col;
           }
           thetext  = converted + actual_x(converted, start_col);
-          paintlen = actual_x(thetext, wideness(line->data, match.rm_eo) - from_col - start_col);
+          paintlen = actual_x(thetext, line_wideness(line, match.rm_eo) - from_col - start_col);
           midwin_mv_add_nstr_wattr(row, (margin + start_col), thetext, paintlen, varnish->attributes);
         }
         continue;
@@ -3504,7 +3739,7 @@ void draw_row_curses_for(openfilestruct *const file, int row, const char *const
           }
           /* Only if it is visible, paint the part to be coloured. */
           if (endmatch.rm_eo > (int)from_x) {
-            paintlen = actual_x(converted, wideness(line->data, endmatch.rm_eo) - from_col);
+            paintlen = actual_x(converted, line_wideness(line, endmatch.rm_eo) - from_col);
             midwin_mv_add_nstr_wattr(row, margin, converted, paintlen, varnish->attributes);
           }
           line->multidata[varnish->id] = ENDSHERE;
@@ -3517,7 +3752,7 @@ void draw_row_curses_for(openfilestruct *const file, int row, const char *const
         startmatch.rm_so += index;
         startmatch.rm_eo += index;
         if (startmatch.rm_so > (int)from_x) {
-          start_col = wideness(line->data, startmatch.rm_so) - from_col;
+          start_col = line_wideness(line, startmatch.rm_so) - from_col;
         }
         thetext = converted + actual_x(converted, start_col);
         if (regexec(varnish->end, line->data + startmatch.rm_eo, 1, &endmatch, (startmatch.rm_eo == 0) ? 0 : REG_NOTBOL) == 0) {
@@ -3526,7 +3761,7 @@ void draw_row_curses_for(openfilestruct *const file, int row, const char *const
           endmatch.rm_eo += startmatch.rm_eo;
           /* Only paint the match if it is visible on screen and it is more than zero characters long. */
           if (endmatch.rm_eo > (int)from_x && endmatch.rm_eo > startmatch.rm_so) {
-            paintlen = actual_x(thetext, wideness(line->data, endmatch.rm_eo) - from_col - start_col);
+            paintlen = actual_x(thetext, line_wideness(line, endmatch.rm_eo) - from_col - start_col);
             midwin_mv_add_nstr_wattr(row, margin + start_col, thetext, paintlen, varnish->attributes);
             line->multidata[varnish->id] = JUSTONTHIS;
           }
@@ -3547,6 +3782,7 @@ void draw_row_curses_for(openfilestruct *const file, int row, const char *const
       }
     }
   }
+  nperf_record(NPERF_HIGHLIGHT, perf_start);
   if (stripe_column > (long)from_col && !inhelp && (!sequel_column || stripe_column <= (long)sequel_column) && stripe_column <= (long)(from_col + editwincols)) {
     long  target_column = (stripe_column - from_col - 1);
     Ulong target_x      = actual_x(converted, target_column);
@@ -3598,7 +3834,7 @@ int update_line_curses_for(openfilestruct *const file, linestruct *const line, U
   /* The row in the edit window we will be updating. */
   int row;
   /* The data of the line with tabs and control characters expanded. */
-  char *converted;
+  const char *converted;
   /* From which column a horizontally scrolled line is displayed. */
   Ulong from_col;
   /* Just return early when running in gui mode. */
@@ -3610,11 +3846,10 @@ int update_line_curses_for(openfilestruct *const file, linestruct *const line, U
   }
   sequel_column = 0;
   row = (line->lineno - file->edittop->lineno);
-  from_col = get_page_start(wideness(line->data, index), editwincols);
+  from_col = get_page_start(line_wideness(line, index), editwincols);
   /* Expand the piece to be drawn to its representable form, and draw it. */
-  converted = display_string(line->data, from_col, editwincols, TRUE, FALSE);
+  converted = display_string_row(row, line->data, line, from_col, editwincols, TRUE, FALSE, NULL);
   draw_row_curses_for(file, row, converted, line, from_col);
-  free(converted);
   if (!ISSET(NO_NCURSES)) {
     if (from_col > 0) {
       mvwaddchwattr(midwin, row, margin, '<', hilite_attribute);
@@ -3651,9 +3886,7 @@ int update_softwrapped_line_curses_for(openfilestruct *const file, linestruct *c
   /* The end column of the current_chunk. */
   Ulong to_col = 0;
   /* The data of the chunk with tabs and controll chars expanded. */
-  char *converted;
-  /* This tells the softwrapping rutine to start at begining-of-line. */
-  bool kickoff = TRUE;
+  const char *converted;
   /* Becomes 'TRUE' when the last chunk of the line has been reached. */
   bool end_of_line = FALSE;
   if (line == file->edittop) {
@@ -3673,12 +3906,11 @@ int update_softwrapped_line_curses_for(openfilestruct *const file, linestruct *c
   }
   starting_row = row;
   while (!end_of_line && row < editwinrows) {
-    to_col = get_softwrap_breakpoint(line->data, from_col, &kickoff, &end_of_line, editwincols);
+    to_col = softwrap_chunk_end(editwincols, line, from_col, &end_of_line);
     sequel_column = (end_of_line ? 0 : to_col);
     /* Convert the chunk to its displayable form and draw it. */
-    converted = display_string(line->data, from_col, (to_col - from_col), TRUE, FALSE);
+    converted = display_string_row(row, line->data, line, from_col, (to_col - from_col), TRUE, FALSE, NULL);
     draw_row_curses_for(file, row++, converted, line, from_col);
-    free(converted);
     from_col = to_col;
   }
   if (spotlighted && line == file->current) {
@@ -3737,12 +3969,11 @@ void spotlight_softwrapped_curses_for(openfilestruct *const file, Ulong from_col
   Ulong leftedge = leftedge_for(editwincols, from_col, file->current);
   Ulong break_col;
   bool  end_of_line = FALSE;
-  bool  kickoff     = TRUE;
   char *word;
   place_the_cursor_curses_for(file);
   row = file->cursor_row;
   while (row < editwinrows) {
-    break_col = get_softwrap_breakpoint(file->current->data, leftedge, &kickoff, &end_of_line, editwincols);
+    break_col = softwrap_chunk_end(editwincols, file->current, leftedge, &end_of_line);
     /* If the highlighting ends on this chunk, we can stop after it. */
     if (break_col >= to_col) {
       end_of_line = TRUE;
@@ -3773,3 +4004,194 @@ void spotlight_softwrapped_curses_for(openfilestruct *const file, Ulong from_col
 void spotlight_softwrapped_curses(Ulong from_col, Ulong to_col) {
   spotlight_softwrapped_curses_for(openfile, from_col, to_col);
 }
+
+/* ----------------------------- Softwrap tests ----------------------------- */
+
+#define SOFTWRAP_TEST_LINES  (16)
+#define SOFTWRAP_TEST_WIDTH  (32768)
+#define SOFTWRAP_TEST_COLS   (80)
+
+/* `Internal`  Scroll one row at a time from the top of `file` to the bottom and back, placing the cursor on every row the way
+ * the tui does, and return the number of rows that were scrolled. */
+static Ulong softwrap_test_scroll(openfilestruct *const file) {
+  linestruct *line = file->filetop;
+  Ulong leftedge = 0;
+  Ulong rows = 0;
+  while (!go_forward_chunks_for(file, SOFTWRAP_TEST_COLS, 1, &line, &leftedge)) {
+    leftedge = leftedge_for(SOFTWRAP_TEST_COLS, leftedge, line);
+    chunk_for(SOFTWRAP_TEST_COLS, leftedge, line);
+    ++rows;
+  }
+  leftedge = leftedge_for(SOFTWRAP_TEST_COLS, leftedge, line);
+  while (!go_back_chunks_for(file, SOFTWRAP_TEST_COLS, 1, &line, &leftedge)) {
+    extra_chunks_in(SOFTWRAP_TEST_COLS, line);
+    ++rows;
+  }
+  return rows;
+}
+
+/* Delete a long softwrapped line one character at a time through `expunge_for()`, and assert that after every deletion the cached chunk
+ * count matches that of a freshly measured copy, and that every deletion that crossed a wrap boundary asked for a refresh. */
+void softwrap_test(void) {
+  openfilestruct file;
+  linestruct *line;
+  linestruct *fresh;
+  bool  was_softwrap  = ISSET(SOFTWRAP);
+  bool  was_using_gui = ISSET(USING_GUI);
+  long  was_tabsize   = tabsize;
+  Ulong width         = (SOFTWRAP_TEST_COLS * 3);
+  Ulong before;
+  Ulong after;
+  Ulong crossed = 0;
+  memset(&file, 0, sizeof(file));
+  if (tabsize <= 0) {
+    tabsize = 8;
+  }
+  SET(SOFTWRAP);
+  /* Keep `expunge_for()` from drawing the line, as there is no screen. */
+  SET(USING_GUI);
+  line = make_new_node(NULL);
+  line->data = xmalloc(width + 1);
+  memset(line->data, 'a', width);
+  line->data[width] = '\0';
+  file.filetop     = line;
+  file.filebot     = line;
+  file.current     = line;
+  file.edittop     = line;
+  file.modified    = TRUE;
+  file.last_action = OTHER;
+  file.totsize     = width;
+  while (line->data[0]) {
+    before = extra_chunks_in(SOFTWRAP_TEST_COLS, line);
+    refresh_needed = FALSE;
+    expunge_for(&file, SOFTWRAP_TEST_COLS, DEL);
+    after = extra_chunks_in(SOFTWRAP_TEST_COLS, line);
+    fresh = make_new_node(NULL);
+    fresh->data = copy_of(line->data);
+    ALWAYS_ASSERT_MSG((after == extra_chunks_in(SOFTWRAP_TEST_COLS, fresh)), "Stale chunk count after a deletion");
+    if (after != before) {
+      ALWAYS_ASSERT_MSG(refresh_needed, "A deletion across a wrap boundary did not ask for a refresh");
+      ++crossed;
+    }
+    delete_node_for(NULL, fresh);
+  }
+  ALWAYS_ASSERT_MSG((crossed >= 2), "The deletions never crossed a wrap boundary");
+  discard_until_for(&file, NULL);
+  delete_node_for(NULL, line);
+  refresh_needed = FALSE;
+  tabsize = was_tabsize;
+  if (!was_softwrap) {
+    UNSET(SOFTWRAP);
+  }
+  if (!was_using_gui) {
+    UNSET(USING_GUI);
+  }
+  writef("%s: Passed\n", __func__);
+}
+
+/* Measure scrolling through a buffer of very long softwrapped lines, with and without the chunks of each line cached. */
+void softwrap_test_bench(void) {
+  openfilestruct file;
+  linestruct *line = NULL;
+  bool  was_softwrap = ISSET(SOFTWRAP);
+  long  was_tabsize  = tabsize;
+  Ulong rows;
+  memset(&file, 0, sizeof(file));
+  if (tabsize <= 0) {
+    tabsize = 8;
+  }
+  SET(SOFTWRAP);
+  for (int i=0; i<SOFTWRAP_TEST_LINES; ++i) {
+    line = make_new_node(line);
+    line->data = xmalloc(SOFTWRAP_TEST_WIDTH + 1);
+    for (int j=0; j<SOFTWRAP_TEST_WIDTH; ++j) {
+      line->data[j] = (((j % 7) == 6) ? ' ' : ((j % 11) == 10) ? '\t' : ('a' + (j % 26)));
+    }
+    line->data[SOFTWRAP_TEST_WIDTH] = '\0';
+    if (line->prev) {
+      line->prev->next = line;
+    }
+    else {
+      file.filetop = line;
+    }
+  }
+  file.filebot = line;
+  writef("\n");
+  for (int pass=0; pass<2; ++pass) {
+    softwrap_caching = pass;
+    timer_action(ms,
+      rows = softwrap_test_scroll(&file);
+    );
+    writef(
+      "%s: Lines: %d: Width: %d: Cols: %d: Cached: %s: Scrolled rows: %lu in %.5f ms\n",
+      __func__, SOFTWRAP_TEST_LINES, SOFTWRAP_TEST_WIDTH, SOFTWRAP_TEST_COLS, (softwrap_caching ? "yes" : "no"), rows, (double)ms
+    );
+  }
+  writef("\n");
+  softwrap_caching = TRUE;
+  while (file.filebot) {
+    line = file.filebot->prev;
+    delete_node_for(NULL, file.filebot);
+    file.filebot = line;
+  }
+  tabsize = was_tabsize;
+  if (!was_softwrap) {
+    UNSET(SOFTWRAP);
+  }
+}
+
+/* ----------------------------- Display string test bench ----------------------------- */
+
+#define DISPLAY_STRING_TEST_ROWS    (60)
+#define DISPLAY_STRING_TEST_COLS    (200)
+#define DISPLAY_STRING_TEST_FRAMES  (5000)
+
+/* Measure converting every row of a full edit window once per refresh, allocating a string per row the way `display_string()` does,
+ * against converting into the per-row buffers of `display_string_row()`, and report the allocations each refresh makes. */
+void display_string_test_bench(void) {
+  char *lines[DISPLAY_STRING_TEST_ROWS];
+  char *converted;
+  long  was_tabsize = tabsize;
+  Ulong bytes[2] = {0, 0};
+  Ulong allocations[2];
+  Ulong len;
+  if (tabsize <= 0) {
+    tabsize = 8;
+  }
+  for (int row=0; row<DISPLAY_STRING_TEST_ROWS; ++row) {
+    lines[row] = fmtstr("\tstatic int value_%d = (%d * 4); /* A comment\tthat goes on and on for a while, row %d. */", row, row, row);
+  }
+  writef("\n");
+  __atomic_store_n(&display_allocations, 0, __ATOMIC_RELAXED);
+  timer_action(alloc_ms,
+    for (int frame=0; frame<DISPLAY_STRING_TEST_FRAMES; ++frame) {
+      for (int row=0; row<DISPLAY_STRING_TEST_ROWS; ++row) {
+        converted = display_string(lines[row], (frame % 8), DISPLAY_STRING_TEST_COLS, TRUE, FALSE);
+        bytes[0] += strlen(converted);
+        free(converted);
+      }
+    }
+  );
+  allocations[0] = __atomic_exchange_n(&display_allocations, 0, __ATOMIC_RELAXED);
+  timer_action(row_ms,
+    for (int frame=0; frame<DISPLAY_STRING_TEST_FRAMES; ++frame) {
+      for (int row=0; row<DISPLAY_STRING_TEST_ROWS; ++row) {
+        display_string_row(row, lines[row], NULL, (frame % 8), DISPLAY_STRING_TEST_COLS, TRUE, FALSE, &len);
+        bytes[1] += len;
+      }
+    }
+  );
+  allocations[1] = __atomic_load_n(&display_allocations, __ATOMIC_RELAXED);
+  writef(
+    "%s: Rows: %d: Refreshes: %d: display_string(): %.5f ms, %.2f allocations per refresh: "
+    "display_string_row(): %.5f ms, %.2f allocations per refresh: Bytes match: %s\n\n",
+    __func__, DISPLAY_STRING_TEST_ROWS, DISPLAY_STRING_TEST_FRAMES,
+    (double)alloc_ms, ((double)allocations[0] / DISPLAY_STRING_TEST_FRAMES),
+    (double)row_ms, ((double)allocations[1] / DISPLAY_STRING_TEST_FRAMES), ((bytes[0] == bytes[1]) ? "yes" : "no")
+  );
+  display_string_rows_free();
+  for (int row=0; row<DISPLAY_STRING_TEST_ROWS; ++row) {
+    free(lines[row]);
+  }
+  tabsize = was_tabsize;
+}
@@ -98,6 +98,7 @@ bool find_matching_bracket(linestruct *start_line, Ulong start_index, linestruct
 
 bool find_end_bracket(linestruct *from, Ulong index, linestruct **end, Ulong *end_index) {
   PROFILE_FUNCTION;
+  TRACE_FUNCTION;
   if (!from || index >= strlen(from->data)) {
     return FALSE;
   }
@@ -149,6 +150,7 @@ bool find_end_bracket(linestruct *from, Ulong index, linestruct **end, Ulong *en
 
 char *fetch_bracket_body(linestruct *from, Ulong index) {
   PROFILE_FUNCTION;
+  TRACE_FUNCTION;
   string      ret = "";
   linestruct *end_line;
   Ulong       end_index;
@@ -145,6 +145,16 @@ void do_parse(void) {
     NETLOG("Cursor word: '%s'.\n", cursorword);
     free(cursorword);
   }
+  /* Index the open file and everything it includes on the threadpool, so the editor does not block on large include graphs.
+   * The first time this is done for a file of a project, the whole project is indexed, and after that only the open file. */
+  if (openfile->is_c_file || openfile->is_cxx_file) {
+    if (!LSP->cache_dir) {
+      LSP->cache_dir = index_cache_dir();
+    }
+    if (!LSP->index_project(openfile->filename)) {
+      LSP->index_file_async(openfile->filename, TRUE);
+    }
+  }
   /* PROFILE_FUNCTION;
   if (openfile->type.is_set<C_CPP>()) {
     LSP->index_file(openfile->filename);
@@ -164,6 +174,53 @@ void do_parse(void) {
   } */
 }
 
+/* Go to where the word at the cursor is defined, in the buffer that file is open in, or in a new one. */
+void do_goto_definition(void) {
+  Ulong start = get_prev_cursor_word_start_index(TRUE);
+  Ulong end   = get_current_cursor_word_end_index(TRUE);
+  const char *path;
+  char *at_file;
+  long line;
+  bool found = FALSE;
+  bool known;
+  struct stat st;
+  openfilestruct *file = openfile;
+  if (start == end) {
+    statusline(AHEM, _("No word at the cursor"));
+    return;
+  }
+  /* The index knows files by their absolute path. */
+  at_file = abs_path(openfile->filename);
+  known   = LSP->find_definition((openfile->current->data + start), (end - start), at_file, openfile->current->lineno, &path, &line);
+  free(at_file);
+  if (!known) {
+    statusline(AHEM, _("No defenition of '%.*s' is known"), (int)(end - start), (openfile->current->data + start));
+    return;
+  }
+  /* Use the buffer the file is already open in, when there is one. */
+  if (stat(path, &st) != -1) {
+    do {
+      if (file->statinfo && file->statinfo->st_dev == st.st_dev && file->statinfo->st_ino == st.st_ino) {
+        found = TRUE;
+        break;
+      }
+      DLIST_ADV_NEXT(file);
+    } while (file != openfile);
+  }
+  if (!found) {
+    if (!open_buffer(path, TRUE)) {
+      return;
+    }
+    redecorate_after_switch();
+  }
+  else if (file != openfile) {
+    openfile = file;
+    redecorate_after_switch();
+  }
+  goto_line_and_column(line, 1, FALSE, FALSE);
+  refresh_needed = TRUE;
+}
+
 void do_test(void) {
   // const char *found = nstrchr_ccpp(openfile->current->data + openfile->current_x, ';');
   // if (found) {
@@ -685,6 +742,7 @@ void remove_local_vars_from(linestruct *line) {
     }
     if (it->second.from_line == line->lineno && it->second.color == FG_VS_CODE_BRIGHT_CYAN &&
         it->second.type == LOCAL_VAR_SYNTAX) {
+      symbol_changed(it->first.data(), it->first.size());
       it = test_map.erase(it);
     }
     else {
@@ -703,6 +761,7 @@ void remove_from_color_map(linestruct *line, int color, int type) {
         continue;
       }
       else if (c == color && fline == line->lineno && t == type) {
+        symbol_changed(it->first.data(), it->first.size());
         test_map.erase(it);
         break;
       }
@@ -982,6 +982,8 @@ void shortcut_init(void) {
   add_to_sclist(MMAIN, "M-#", 0, do_toggle, LINE_NUMBERS);
   add_to_sclist(MMAIN, "M-P", 0, do_toggle, WHITESPACE_DISPLAY);
   add_to_sclist(MMAIN, "M-Y", 0, do_toggle, NO_SYNTAX);
+  add_to_sclist(MMAIN, "M-%", 0, do_toggle, PERF_OVERLAY);
+  add_to_sclist(MMAIN, "M-*", 0, ntrace_save, 0);
   /* Group of 'Behavior' toggles. */
   add_to_sclist(MMAIN, "M-H", 0, do_toggle, SMART_HOME);
   add_to_sclist(MMAIN, "M-I", 0, do_toggle, AUTOINDENT);
@@ -1066,6 +1068,7 @@ void shortcut_init(void) {
   add_to_sclist(MMOST, "F10", KEY_F(10), paste_text, 0);
   /* add_to_sclist(MMAIN, "F11", KEY_F(11), report_cursor_position, 0); */
   /* add_to_sclist(MMAIN, "F11", KEY_F(11), do_test, 0); */
+  add_to_sclist(MMAIN, "F11", KEY_F(11), do_goto_definition, 0);
   add_to_sclist(MMAIN, "F12", KEY_F(12), do_spell, 0);
   add_to_sclist(MMAIN, "M-&", 0, show_curses_version, 0);
   add_to_sclist((MMOST & ~MMAIN) | MYESNO, "", KEY_CANCEL, do_cancel, 0);
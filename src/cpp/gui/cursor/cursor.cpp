@@ -68,7 +68,7 @@ linestruct *line_from_cursor_pos(Editor *const editor) {
  * in 20 min just to test and its already perfect as it just cannot preduce the problems we had with the old system. */
 
 
-float *pixpositions(const char *const restrict string, float normx, Ulong *outlen, texture_font_t *const font) {
+float *pixpositions(const char *const restrict string, float normx, Ulong *outlen, Font *const font) {
   ASSERT(string);
   Ulong len=strlen(string), i;
   float *array, start=normx, end=normx;
@@ -25,23 +25,25 @@
 
 void line_add_cursor(long lineno, Font *const font, vertex_buffer_t *const buf, vec4 color, float xpos, float yoffset) {
   ASSERT(font);
-  float top, bot, x0, x1, y0, y1;
+  float top, bot, x0, x1, y0, y1, s0, s1;
+  Uint page;
   /* Use the NULL texture as the cursor texture, so just a rectangle. */
-  texture_glyph_t *glyph = texture_font_get_glyph(font_get_font(font), NULL);
-  ALWAYS_ASSERT(glyph);
+  texture_glyph_t *glyph = font_get_glyph_page(font, NULL, &page);
   // row_top_bot_pixel(lineno, font, &top, &bot);
   font_row_top_bot(font, lineno, &top, &bot);
   x0 = (int)xpos;
   y0 = (int)(top + yoffset);
   x1 = (int)(x0 + 1);
   y1 = (int)(bot + yoffset);
+  s0 = (glyph->s0 + page);
+  s1 = (glyph->s1 + page);
   Uint indices[] = { 0, 1, 2, 0, 2, 3 };
   FontVertex vertices[] = {
     // Position   Texture               Color
-    {  x0,y0,   glyph->s0, glyph->t0, color.r,color.g,color.b,color.a },
-    {  x0,y1,   glyph->s0, glyph->t1, color.r,color.g,color.b,color.a },
-    {  x1,y1,   glyph->s1, glyph->t1, color.r,color.g,color.b,color.a },
-    {  x1,y0,   glyph->s1, glyph->t0, color.r,color.g,color.b,color.a }
+    {  x0,y0,   s0, glyph->t0, color.r,color.g,color.b,color.a },
+    {  x0,y1,   s0, glyph->t1, color.r,color.g,color.b,color.a },
+    {  x1,y1,   s1, glyph->t1, color.r,color.g,color.b,color.a },
+    {  x1,y0,   s1, glyph->t0, color.r,color.g,color.b,color.a }
   };
   vertex_buffer_push_back(buf, vertices, 4, indices, 6);
 }
@@ -14,12 +14,12 @@ void upload_texture_atlas(texture_atlas_t *atlas) {
 }
 
 /* Returns the width of a glyph character considering kerning from previous character. */
-float glyph_width(const char *current, const char *prev, texture_font_t *font) {
+float glyph_width(const char *current, const char *prev, Font *const font) {
   ASSERT(current);
   ASSERT(font);
   float ret = 0;
-  texture_glyph_t *glyph = texture_font_get_glyph(font, current);
-  ALWAYS_ASSERT(glyph);
+  /* Go through the font, so the glyph is registered in the page it ends up in. */
+  texture_glyph_t *glyph = font_get_glyph(font, current);
   if (prev) {
     ret += texture_glyph_get_kerning(glyph, prev);
   }
@@ -28,7 +28,7 @@ float glyph_width(const char *current, const char *prev, texture_font_t *font) {
 }
 
 /* Calculates the total length of all glyphs in a string to the index. */
-float string_pixel_offset(const char *string, const char *previous_char, Ulong index, texture_font_t *font) {
+float string_pixel_offset(const char *string, const char *previous_char, Ulong index, Font *const font) {
   ASSERT(string);
   ASSERT(font);
   const char *current = &string[0];
@@ -49,7 +49,7 @@ float string_pixel_offset(const char *string, const char *previous_char, Ulong i
   return ret;
 }
 
-float pixel_breadth(texture_font_t *font, const char *text) {
+float pixel_breadth(Font *const font, const char *text) {
   float ret = 0.0f;
   for (const char *cur = text, *prev = NULL; *cur; ++cur) {
     ret += glyph_width(cur, prev, font);
@@ -59,7 +59,7 @@ float pixel_breadth(texture_font_t *font, const char *text) {
 }
 
 /* Returns character index from x pixel position in string. */
-long index_from_mouse_x(const char *string, Uint len, texture_font_t *font, float offset) {
+long index_from_mouse_x(const char *string, Uint len, Font *const font, float offset) {
   ASSERT(string);
   ASSERT(font);
   const char *cur;
@@ -91,7 +91,7 @@ long index_from_mouse_x(const char *string, Uint len, texture_font_t *font, floa
 }
 
 /* Returns character index from x pixel position in string. */
-long index_from_mouse_x(const char *string, texture_font_t *font, float offset) {
+long index_from_mouse_x(const char *string, Font *const font, float offset) {
   return index_from_mouse_x(string, strlen(string), font, offset);
 }
 
@@ -136,7 +136,7 @@ linestruct *line_and_index_from_mousepos(texture_font_t *const font, Ulong *cons
 }
 
 /* Calculate the length the line number takes up in a given line. */
-float get_line_number_pixel_offset(linestruct *line, texture_font_t *font) {
+float get_line_number_pixel_offset(linestruct *line, Font *const font) {
   ASSERT(line);
   ASSERT(font);
   char linenobuf[margin + 1];
@@ -145,24 +145,24 @@ float get_line_number_pixel_offset(linestruct *line, texture_font_t *font) {
 }
 
 /* Calculates cursor x position for the gui. */
-float line_pixel_x_pos(linestruct *line, Ulong index, texture_font_t *font) {
+float line_pixel_x_pos(linestruct *line, Ulong index, Font *const font) {
   ASSERT(line);
   ASSERT(font);
   float ret = 0;
   /* Convert the line data into a display string. */
-  Ulong from_col  = get_page_start(wideness(line->data, index), openeditor->cols);
+  Ulong from_col  = get_page_start(line_wideness(line, index), openeditor->cols);
   char *converted = display_string(line->data, from_col, openeditor->cols, TRUE, FALSE);
   /* When line numbers are turned on we calculate the combined length of the lineno, seperator and current line data. */
   if (ISSET(LINE_NUMBERS)) {
     ret = get_line_number_pixel_offset(line, font);
   }
-  ret += string_pixel_offset(converted, NULL, (wideness(line->data, index) - from_col), font);
+  ret += string_pixel_offset(converted, NULL, (line_wideness(line, index) - from_col), font);
   free(converted);
   return ret;
 }
 
 /* Calculates cursor x position for the gui. */
-float cursor_pixel_x_pos(texture_font_t *font) {
+float cursor_pixel_x_pos(Font *const font) {
   ASSERT(font);
   return line_pixel_x_pos(openeditor->openfile->current, openeditor->openfile->current_x, font);
 }
@@ -192,16 +192,16 @@ float cursor_pixel_y_pos(texture_font_t *font) {
 }
 
 /* Add one glyph to 'buffer' to be rendered.  At position pen. */
-void add_glyph(const char *current, const char *prev, vertex_buffer_t *buf, texture_font_t *font, vec4 color, vec2 *penpos) {
+void add_glyph(const char *current, const char *prev, vertex_buffer_t *buf, Font *const font, vec4 color, vec2 *penpos) {
   ASSERT(current);
   ASSERT(buf);
   ASSERT(font);
   ASSERT(penpos);
-  float x0, x1, y0, y1;
+  float x0, x1, y0, y1, s0, s1;
+  Uint page;
   Uint indices[] = { 0, 1, 2, 0, 2, 3 };
   FontVertex vertices[4];
-  texture_glyph_t *glyph = texture_font_get_glyph(font, current);
-  ALWAYS_ASSERT(glyph);
+  texture_glyph_t *glyph = font_get_glyph_page(font, current, &page);
   if (prev) {
     penpos->x += texture_glyph_get_kerning(glyph, prev);
   }
@@ -209,15 +209,18 @@ void add_glyph(const char *current, const char *prev, vertex_buffer_t *buf, text
   y0 = (int)(penpos->y - glyph->offset_y);
   x1 = (int)(x0 + glyph->width);
   y1 = (int)(y0 + glyph->height);
-  vertices[0] = { x0,y0, glyph->s0,glyph->t0, color.r,color.g,color.b,color.a };
-  vertices[1] = { x0,y1, glyph->s0,glyph->t1, color.r,color.g,color.b,color.a };
-  vertices[2] = { x1,y1, glyph->s1,glyph->t1, color.r,color.g,color.b,color.a };
-  vertices[3] = { x1,y0, glyph->s1,glyph->t0, color.r,color.g,color.b,color.a };
+  /* The page is the integer part of 's', see 'font_add_glyph()'. */
+  s0 = (glyph->s0 + page);
+  s1 = (glyph->s1 + page);
+  vertices[0] = { x0,y0, s0,glyph->t0, color.r,color.g,color.b,color.a };
+  vertices[1] = { x0,y1, s0,glyph->t1, color.r,color.g,color.b,color.a };
+  vertices[2] = { x1,y1, s1,glyph->t1, color.r,color.g,color.b,color.a };
+  vertices[3] = { x1,y0, s1,glyph->t0, color.r,color.g,color.b,color.a };
   vertex_buffer_push_back(buf, vertices, 4, indices, 6);
   penpos->x += glyph->advance_x;
 }
 
-void vertex_buffer_add_string(vertex_buffer_t *buf, const char *string, Ulong slen, const char *previous, texture_font_t *font, vec4 color, vec2 *penpos) {
+void vertex_buffer_add_string(vertex_buffer_t *buf, const char *string, Ulong slen, const char *previous, Font *const font, vec4 color, vec2 *penpos) {
   ASSERT(buf);
   ASSERT(string);
   ASSERT(font);
@@ -239,7 +242,7 @@ void vertex_buffer_add_mbstr(vertex_buffer_t *buf, const char *string, Ulong len
   const char *cur = string;
   const char *prev = previous;
   while (*cur && cur < (string + len)) {
-    add_glyph(cur, prev, buf, font_get_font(font), color, penpos);
+    add_glyph(cur, prev, buf, font, color, penpos);
     prev = cur;
     cur += char_length(cur);
   }
@@ -247,30 +250,32 @@ void vertex_buffer_add_mbstr(vertex_buffer_t *buf, const char *string, Ulong len
 
 
 /* Add a cursor in `buf` using the NULL texture from `font` in the color of `color`, at `at`. */
-void add_cursor(texture_font_t *font, vertex_buffer_t *buf, vec4 color, vec2 at) {
+void add_cursor(Font *const font, vertex_buffer_t *buf, vec4 color, vec2 at) {
   ASSERT(font);
   ASSERT(buf);
+  Uint page;
   /* Use the NULL texture as the cursor texture, so just a rectangle. */
-  texture_glyph_t *glyph = texture_font_get_glyph(font, NULL);
-  ALWAYS_ASSERT(glyph);
+  texture_glyph_t *glyph = font_get_glyph_page(font, NULL, &page);
   float x0 = (int)at.x;
-  float y0 = (int)(at.y - FONT_HEIGHT(font));
+  float y0 = (int)(at.y - FONT_HEIGHT(font_get_font(font)));
   float x1 = (int)(x0 + 1);
-  float y1 = (int)(y0 + FONT_HEIGHT(font));
+  float y1 = (int)(y0 + FONT_HEIGHT(font_get_font(font)));
+  float s0 = (glyph->s0 + page);
+  float s1 = (glyph->s1 + page);
   Uint indices[] = { 0, 1, 2, 0, 2, 3 };
   FontVertex vertices[] = {
     // Position   Texture               Color
-    {  x0,y0,   glyph->s0, glyph->t0, color.r,color.g,color.b,color.a },
-    {  x0,y1,   glyph->s0, glyph->t1, color.r,color.g,color.b,color.a },
-    {  x1,y1,   glyph->s1, glyph->t1, color.r,color.g,color.b,color.a },
-    {  x1,y0,   glyph->s1, glyph->t0, color.r,color.g,color.b,color.a }
+    {  x0,y0,   s0, glyph->t0, color.r,color.g,color.b,color.a },
+    {  x0,y1,   s0, glyph->t1, color.r,color.g,color.b,color.a },
+    {  x1,y1,   s1, glyph->t1, color.r,color.g,color.b,color.a },
+    {  x1,y0,   s1, glyph->t0, color.r,color.g,color.b,color.a }
   };
   vertex_buffer_push_back(buf, vertices, 4, indices, 6);
 }
 
 /* Add cursor to buffer at `openfile->current_x` in `openfile->current->data`. */
-void add_openfile_cursor(texture_font_t *font, vertex_buffer_t *buf, vec4 color) {
-  add_cursor(font, buf, color, vec2(cursor_pixel_x_pos(font), cursor_pixel_y_pos(font)));
+void add_openfile_cursor(Font *const font, vertex_buffer_t *buf, vec4 color) {
+  add_cursor(font, buf, color, vec2(cursor_pixel_x_pos(font), cursor_pixel_y_pos(font_get_font(font))));
 }
 
 /* Update projection for a shader. */
@@ -15,7 +15,7 @@ float pixnbreadth_prev(const char *const restrict string, long len, const char *
   float ret;
   const char *ch, *prev;
   for (ret=0, ch=string, prev=prev_char; len>(ch - string); ++ch) {
-    ret += glyph_width(ch, prev, font_get_font(textfont));
+    ret += glyph_width(ch, prev, textfont);
     prev = ch;
   }
   return ret;
@@ -27,23 +27,12 @@ float pixnbreadth(const char *const restrict string, long len) {
   return pixnbreadth_prev(string, len, NULL);
 }
 
-float pixbreadth(texture_font_t *const font, const char *const restrict string) {
-  ASSERT(font);
-  ASSERT(string);
-  float ret = 0;
-  for (const char *ch=string, *prev=NULL; *ch; ++ch) {
-    ret += glyph_width(ch, prev, font);
-    prev = ch;
-  }
-  return ret;
-}
-
 float pixbreadth(Font *const font, const char *const restrict string) {
   ASSERT(font);
   ASSERT(string);
   float ret = 0;
   for (const char *ch=string, *prev=NULL; *ch; ++ch) {
-    ret += glyph_width(ch, prev, font_get_font(font));
+    ret += glyph_width(ch, prev, font);
     prev = ch;
   }
   return ret;
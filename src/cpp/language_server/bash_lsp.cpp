@@ -30,5 +30,6 @@ void get_env_path_binaries(void) {
       directory_data_free(&dir);
     }
     free_chararray(paths, npaths);
+    symbols_changed();
   }
 }
@@ -195,7 +195,7 @@ namespace Parse {
       }
       cd.name = measured_copy(start, (end - start));
       // unix_socket_debug("%s\n", cd.name);
-      LSP->index.classes.push_back(cd);
+      LSP->target().classes.push_back(cd);
     }
   }
 
@@ -278,6 +278,7 @@ namespace Parse {
     }
     linestruct *from = *from_line;
     PROFILE_FUNCTION;
+    TRACE_FUNCTION;
     const char *data = &from->data[indent_char_len(from)];
     if (invalid_variable_sig(data)) {
       return;
@@ -338,13 +339,13 @@ namespace Parse {
                     ++val_st;
                     char       *name  = measured_copy(st, (val_st - st));
                     char       *alias = measured_copy(val_st, (end - val_st));
-                    const auto &it    = LSP->index.tdstructs.find(alias);
+                    const auto &it    = LSP->target().tdstructs.find(alias);
                     /* If not inside map, we add it. */
-                    if (it == LSP->index.tdstructs.end()) {
+                    if (it == LSP->target().tdstructs.end()) {
                       TypedefStruct tds;
                       tds.name                        = name;
                       tds.alias                       = alias;
-                      LSP->index.tdstructs[tds.alias] = tds;
+                      LSP->target().tdstructs[tds.alias] = tds;
                     }
                     /* Otherwise free the alloced data. */
                     else {
@@ -409,7 +410,7 @@ namespace Parse {
                       alias_end = alias_st;
                       ADV_PTR(alias_end, *alias_end != '\t' && *alias_end != ' ' && *alias_end != ';');
                       tsc.alias                       = measured_copy(alias_st, (alias_end - alias_st));
-                      LSP->index.tdstructs[tsc.alias] = tsc;
+                      LSP->target().tdstructs[tsc.alias] = tsc;
                       *from_line                      = end_line;
                     }
                   }
@@ -491,7 +492,7 @@ namespace Parse {
               ste.name                     = measured_copy(st, (end - st));
               ste.decl_st                  = from->lineno;
               ste.decl_end                 = end_line->lineno;
-              LSP->index.structs[ste.name] = ste;
+              LSP->target().structs[ste.name] = ste;
               return;
             }
           }
@@ -591,16 +592,16 @@ namespace Parse {
       }
       switch (idx) {
         case 0 : {
-          LSP->index.rawtypedef.push_back(expr);
+          LSP->target().rawtypedef.push_back(expr);
           break;
         }
         case 1 : { /* enum */
           // unix_socket_debug("%s\n", expr.c_str());
-          LSP->index.rawenum.push_back(expr);
+          LSP->target().rawenum.push_back(expr);
           break;
         }
         case 2 : {
-          LSP->index.rawstruct.push_back(expr);
+          LSP->target().rawstruct.push_back(expr);
           break;
         }
         case 3 : { /* 'class' */
@@ -656,13 +657,14 @@ namespace Parse {
         free(body);
       }
       if (ee.name) {
-        LSP->index.enums[ee.name] = ee;
+        LSP->target().enums[ee.name] = ee;
       }
     }
   }
 
   void variable(linestruct *line, const char *current_file, vector<var_t> &v_vec) {
     PROFILE_FUNCTION;
+    TRACE_FUNCTION;
     const char *data = &line->data[indent_char_len(line)];
     if (invalid_variable_sig(data)) {
       return;
@@ -810,7 +812,7 @@ namespace Parse {
             return;
           }
           /* For now we only take current file func def`s. */
-          if (strcmp(tail(current_file), tail(openfile->filename)) == 0) {
+          if (strcmp(tail(current_file), tail(LSP->main_file())) == 0) {
             // unix_socket_debug("Name: %s\n", name);
             FunctionDef fd;
             fd.file     = copy_of(current_file);
@@ -848,7 +850,7 @@ namespace Parse {
                       vd.value    = copy_of("");
                       vd.decl_st  = fd.decl_st;
                       vd.decl_end = fd.decl_end;
-                      LSP->index.vars[vd.name].push_back(vd);
+                      LSP->target().vars[vd.name].push_back(vd);
                     }
                   }
                   free(var);
@@ -864,7 +866,7 @@ namespace Parse {
               // unix_socket_debug("  body: %s\n", body);
               free(body);
             }
-            LSP->index.functiondefs[fd.name] = fd;
+            LSP->target().functiondefs[fd.name] = fd;
             return;
           }
           if (param_str) {
@@ -926,7 +928,7 @@ void do_parse(linestruct **line, const char *current_file) {
               type.c_str(), name.c_str(), value.c_str(), decl_line, scope_end, file.c_str());
     }
     for (const auto &it : vars) {
-      LSP->index.variabels.push_back(it);
+      LSP->target().variabels.push_back(it);
     }
   } */
   Parse::function(line, current_file);
@@ -945,7 +947,7 @@ void do_bash_parse(linestruct *line, const char *current_file) {
     (*start == ' ' || *start == '\t') ? ++start : 0;
     /* Invalid variable decl.  There is a space behind the '=' char. */
     if (start == end) {
-      LSP->index.bash_data.error.push_back({
+      LSP->target().bash_data.error.push_back({
         copy_of("Decl has no name"),
         (int)line->lineno,
         (int)(ptr - line->data),
@@ -978,6 +980,6 @@ void do_bash_parse(linestruct *line, const char *current_file) {
     }
     char *var_value = measured_copy(start, (end - start));
     // NLOG("%s %s\n", var_name, var_value);
-    LSP->index.bash_data.variable[var_name] = {var_name, var_value, (int)line->lineno};
+    LSP->target().bash_data.variable[var_name] = {var_name, var_value, (int)line->lineno};
   }
 }
@@ -0,0 +1,361 @@
+#include "../../include/prototypes.h"
+
+/* Resolves '#include <...>' names to files.  The directories are searched in the order of 'include_path' from the rcfile, then the
+ * '-I' directories of the indexed project, and then the directories the compiler searches, as it reports them.  Every directory that
+ * is looked in is listed once, and every name is resolved once, misses included, so after the first few files most includes are a
+ * single hash lookup and no syscalls.  A miss is trusted for 'INCLUDE_MISS_RECHECK_NS', after that the directories it was looked
+ * for in are checked for a new modification time, as a header may have been installed since.  This is used by the indexer from
+ * many threads, so everything is done under 'include_mutex'. */
+
+/* How long a name that was not found is trusted, before the directories it was looked for in are checked again. */
+#define INCLUDE_MISS_RECHECK_NS  (1000000000LL)
+
+/* What was found in a directory, 'exists' is 'FALSE' when it could not be opened.  'mtime' is the modification time of the
+ * directory when it was listed, which changes when a file in it is created, removed or renamed. */
+struct IncludeDir {
+  bool exists = FALSE;
+  struct timespec mtime = {0, 0};
+  unordered_map<string, bool> files;
+};
+
+/* A name that was resolved, 'path' is a empty string when it was not found anywhere, and then 'checked' is when that was last made sure of. */
+struct IncludeResult {
+  string path;
+  Llong  checked = 0;
+};
+
+static pthread_mutex_t include_mutex = PTHREAD_MUTEX_INITIALIZER;
+static bool            include_ready = FALSE;
+static vector<string>  include_dirs;
+static vector<string>  include_project_dirs;
+static unordered_map<string, IncludeDir> include_listings;
+/* Every name that was resolved, and the file it was found at. */
+static unordered_map<string, IncludeResult> include_results;
+static Ulong include_nlistings = 0;
+static Ulong include_nmisses   = 0;
+
+/* Used when the compiler could not be asked for its directories. */
+static const char *const include_default_dirs[] = {
+  "/usr/local/include",
+  "/usr/include",
+  "/usr/lib/clang/19/include",
+  "/usr/include/c++/v1",
+};
+
+/* `Internal`  Return`s a monotonic time in nano-seconds. */
+static Llong include_clock(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ((ts.tv_sec * 1000000000LL) + ts.tv_nsec);
+}
+
+/* Add 'dir' to the end of the search order, unless it is already in it. */
+static void include_add_dir(const char *dir, Ulong len) {
+  string path(dir, len);
+  while (path.size() > 1 && path.back() == '/') {
+    path.pop_back();
+  }
+  if (path.empty()) {
+    return;
+  }
+  for (const auto &it : include_dirs) {
+    if (it == path) {
+      return;
+    }
+  }
+  include_dirs.push_back(path);
+}
+
+/* Add the directories that 'cmd' reports it searches for '#include <...>', from the output of running it with '-v'. */
+static void include_add_compiler_dirs(const char *cmd) {
+  Uint   nlines;
+  bool   in_list = FALSE;
+  char  *dir;
+  char **lines = retrieve_exec_output(cmd, &nlines);
+  if (!lines) {
+    return;
+  }
+  for (Uint i = 0; i < nlines; ++i) {
+    if (strcmp(lines[i], "#include <...> search starts here:") == 0) {
+      in_list = TRUE;
+    }
+    else if (strcmp(lines[i], "End of search list.") == 0) {
+      in_list = FALSE;
+    }
+    /* Every directory is on a line of its own, indented by a space.  Clang marks some as frameworks, those are skipped. */
+    else if (in_list && lines[i][0] == ' ' && !strstr(lines[i], "(framework directory)")) {
+      if ((dir = abs_path(lines[i] + 1))) {
+        include_add_dir(dir, strlen(dir));
+        free(dir);
+      }
+    }
+    free(lines[i]);
+  }
+  free(lines);
+}
+
+/* Build the search order.  The c directories come before the c++ ones, so a c header is never taken from a c++ wrapper. */
+static void include_setup(void) {
+  PROFILE_FUNCTION;
+  TRACE_FUNCTION;
+  const char *start;
+  const char *end;
+  if (include_path) {
+    for (start = include_path; *start; start = (*end ? (end + 1) : end)) {
+      for (end = start; *end && *end != ':'; ++end);
+      include_add_dir(start, (end - start));
+    }
+  }
+  for (const auto &dir : include_project_dirs) {
+    include_add_dir(dir.data(), dir.size());
+  }
+  Ulong configured = include_dirs.size();
+  include_add_compiler_dirs("cc -x c -E -v - < /dev/null 2>&1");
+  include_add_compiler_dirs("c++ -x c++ -E -v - < /dev/null 2>&1");
+  if (include_dirs.size() == configured) {
+    for (const char *dir : include_default_dirs) {
+      include_add_dir(dir, strlen(dir));
+    }
+  }
+  include_ready = TRUE;
+}
+
+/* Return`s the listing of 'dir', reading it the first time it is asked for. */
+static const IncludeDir &include_listing(const string &dir) {
+  DIR           *d;
+  struct dirent *entry;
+  auto it = include_listings.find(dir);
+  if (it != include_listings.end()) {
+    return it->second;
+  }
+  IncludeDir &listing = include_listings[dir];
+  struct stat st;
+  ++include_nlistings;
+  if ((d = opendir(dir.c_str()))) {
+    listing.exists = TRUE;
+    if (fstat(dirfd(d), &st) == 0) {
+      listing.mtime = st.st_mtim;
+    }
+    while ((entry = readdir(d))) {
+      if (entry->d_type != DT_DIR) {
+        listing.files[entry->d_name] = TRUE;
+      }
+    }
+    closedir(d);
+  }
+  return listing;
+}
+
+/* `Internal`  Return`s 'TRUE' when any directory a name in 'sub' was looked for in has changed since it was listed, and forgets those listings. */
+static bool include_miss_stale(const string &sub) {
+  struct stat st;
+  bool stale = FALSE;
+  bool exists;
+  for (const auto &dir : include_dirs) {
+    auto it = include_listings.find(dir + "/" + sub);
+    if (it == include_listings.end()) {
+      continue;
+    }
+    exists = (stat(it->first.c_str(), &st) == 0 && S_ISDIR(st.st_mode));
+    if (exists != it->second.exists || (exists && (st.st_mtim.tv_sec != it->second.mtime.tv_sec || st.st_mtim.tv_nsec != it->second.mtime.tv_nsec))) {
+      include_listings.erase(it);
+      stale = TRUE;
+    }
+  }
+  return stale;
+}
+
+/* Return`s the file that '#include <name>' refers to, or 'NULL' when it is not in any of the search directories.
+ * The returned path is allocated, and must be freed by the caller. */
+char *include_resolve(const char *name) {
+  ASSERT(name);
+  pthread_mutex_guard_t guard(&include_mutex);
+  const char *slash = strrchr(name, '/');
+  string sub  = (slash ? string(name, (slash - name + 1)) : string());
+  string base = (slash ? string(slash + 1) : string(name));
+  string found;
+  Llong  now;
+  if (!include_ready) {
+    include_setup();
+  }
+  auto it = include_results.find(name);
+  if (it != include_results.end()) {
+    if (!it->second.path.empty()) {
+      return measured_copy(it->second.path.data(), it->second.path.size());
+    }
+    /* A miss is only looked for again once one of the directories it was looked for in changed. */
+    if (((now = include_clock()) - it->second.checked) < INCLUDE_MISS_RECHECK_NS) {
+      return NULL;
+    }
+    else if (!include_miss_stale(sub)) {
+      it->second.checked = now;
+      return NULL;
+    }
+  }
+  /* Only the directory the file would be in is listed, so 'sys/types.h' lists 'sys/' under every search directory until found. */
+  for (const auto &dir : include_dirs) {
+    const IncludeDir &listing = include_listing(dir + "/" + sub);
+    if (listing.exists && listing.files.find(base) != listing.files.end()) {
+      found = (dir + "/" + name);
+      break;
+    }
+  }
+  if (found.empty()) {
+    ++include_nmisses;
+  }
+  include_results[name] = { found, include_clock() };
+  return (found.empty() ? NULL : measured_copy(found.data(), found.size()));
+}
+
+/* Forget every listing and result, and build the search order again on the next lookup.  This is done whenever the rcfile sets
+ * 'include_path', and is needed when headers that were found before are removed. */
+void include_resolver_reset(void) {
+  pthread_mutex_guard_t guard(&include_mutex);
+  include_dirs.clear();
+  include_listings.clear();
+  include_results.clear();
+  include_nlistings = 0;
+  include_nmisses   = 0;
+  include_ready     = FALSE;
+}
+
+/* Search 'dirs' before the directories of the compiler, these are the '-I' directories of a project.  The search order is built
+ * again on the next lookup, but the directories already listed are kept, as their content did not change. */
+void include_resolver_set_project_dirs(const vector<string> &dirs) {
+  pthread_mutex_guard_t guard(&include_mutex);
+  include_project_dirs = dirs;
+  include_dirs.clear();
+  include_results.clear();
+  include_ready = FALSE;
+}
+
+/* Add 'dirs' to the end of the '-I' directories of the projects, keeping the ones of the projects that were indexed before. */
+void include_resolver_add_project_dirs(const vector<string> &dirs) {
+  vector<string> merged;
+  {
+    pthread_mutex_guard_t guard(&include_mutex);
+    merged = include_project_dirs;
+  }
+  for (const auto &dir : dirs) {
+    bool known = FALSE;
+    for (const auto &it : merged) {
+      if (it == dir) {
+        known = TRUE;
+        break;
+      }
+    }
+    if (!known) {
+      merged.push_back(dir);
+    }
+  }
+  include_resolver_set_project_dirs(merged);
+}
+
+/* ----------------------------- Tests ----------------------------- */
+
+/* Check that a header that was not found is found once it is created, but only after its directory was checked again, and that
+ * a miss in a directory that did not change is not listed again. */
+void include_resolver_test(void) {
+  char dir[] = "/tmp/include_resolver_test_XXXXXX";
+  char path[PATH_MAX];
+  char *found;
+  Ulong listings;
+  FILE *file;
+  struct timespec times[2] = {{0, UTIME_OMIT}, {1, 0}};
+  ALWAYS_ASSERT(mkdtemp(dir));
+  /* Make sure creating the header changes the modification time, even on a file system with coarse timestamps. */
+  ALWAYS_ASSERT(utimensat(AT_FDCWD, dir, times, 0) == 0);
+  include_resolver_set_project_dirs({dir});
+  ALWAYS_ASSERT(!include_resolve("include_resolver_test.h"));
+  snprintf(path, sizeof(path), "%s/include_resolver_test.h", dir);
+  ALWAYS_ASSERT((file = fopen(path, "w")));
+  fclose(file);
+  /* The miss is trusted until it is old enough. */
+  ALWAYS_ASSERT(!include_resolve("include_resolver_test.h"));
+  include_results["include_resolver_test.h"].checked -= INCLUDE_MISS_RECHECK_NS;
+  ALWAYS_ASSERT((found = include_resolve("include_resolver_test.h")) && strcmp(found, path) == 0);
+  free(found);
+  /* A miss in directories that did not change only costs a stat of each. */
+  ALWAYS_ASSERT(!include_resolve("include_resolver_test_missing.h"));
+  listings = include_nlistings;
+  include_results["include_resolver_test_missing.h"].checked -= INCLUDE_MISS_RECHECK_NS;
+  ALWAYS_ASSERT(!include_resolve("include_resolver_test_missing.h"));
+  ALWAYS_ASSERT(include_nlistings == listings);
+  unlink(path);
+  rmdir(dir);
+  include_resolver_set_project_dirs(vector<string>());
+  include_resolver_reset();
+  writef("%s: Passed\n", __func__);
+}
+
+/* Resolve every '#include <...>' in the headers of '/usr/include', the way 'do_include()' used to, with a 'stat()' of every candidate
+ * in every search directory, and then with the resolver.  Prints how many syscalls and how much time each took. */
+void include_resolver_test_bench(void) {
+  char **paths;
+  Ulong  npaths;
+  Ulong  nstats     = 0;
+  Ulong  found[2]   = {0, 0};
+  vector<string> names;
+  vector<string> dirs;
+  writef("\n");
+  paths = syntaxfile_test_paths("/usr/include", &npaths);
+  for (Ulong i = 0; i < npaths; ++i) {
+    SyntaxFile *sf = syntaxfile_create();
+    syntaxfile_read(sf, paths[i]);
+    for (SyntaxFileLine *line = sf->filetop; line; line = line->next) {
+      const char *start = line->data;
+      const char *end;
+      ADV_TO_NEXT_WORD(start);
+      if (*start != '#') {
+        continue;
+      }
+      ++start;
+      ADV_TO_NEXT_WORD(start);
+      if (strncmp(start, "include", 7) != 0) {
+        continue;
+      }
+      start += 7;
+      ADV_TO_NEXT_WORD(start);
+      if (*start == '<' && (end = strchr(start, '>')) && end > (start + 1)) {
+        names.push_back(string((start + 1), (end - start - 1)));
+      }
+    }
+    syntaxfile_free(sf);
+    free(paths[i]);
+  }
+  free(paths);
+  /* Use the same search order for both, so only the lookups differ. */
+  include_resolver_reset();
+  {
+    pthread_mutex_guard_t guard(&include_mutex);
+    include_setup();
+    dirs = include_dirs;
+  }
+  include_resolver_reset();
+  timer_action(stat_ms,
+    for (const auto &name : names) {
+      for (const auto &dir : dirs) {
+        ++nstats;
+        if (file_exists((dir + "/" + name).c_str())) {
+          ++found[0];
+          break;
+        }
+      }
+    }
+  );
+  timer_action(resolve_ms,
+    for (const auto &name : names) {
+      char *path = include_resolve(name.c_str());
+      if (path) {
+        ++found[1];
+        free(path);
+      }
+    }
+  );
+  writef("%s: Includes: %lu: Search dirs: %lu\n", __func__, names.size(), dirs.size());
+  writef("%s: Stat: Found: %lu: Calls: %lu: Time: %.3f ms\n", __func__, found[0], nstats, (double)stat_ms);
+  writef("%s: Resolver: Found: %lu: Dirs listed: %lu: Unique names: %lu: Misses: %lu: Time: %.3f ms\n",
+    __func__, found[1], include_nlistings, include_results.size(), include_nmisses, (double)resolve_ms);
+  include_resolver_reset();
+  writef("\n");
+}
@@ -0,0 +1,400 @@
+#include "../../include/prototypes.h"
+
+#include <sys/mman.h>
+
+/* The on-disk cache of what indexing a single file produced.  There is one cache file per indexed file, named after a hash of its
+ * absolute path.  A cache file is a header, then fixed size records that refer to strings by offset, and last all the strings.
+ * So loading one is a single 'mmap()', and a walk over the records.  A entry is reused when the size and modification time of the
+ * file are unchanged, or when only the time changed but the content hash is the same.  Function defenitions and variables are only
+ * taken from the main file of a indexing, so a file parsed as the main file has a entry apart from the one it has when it is included,
+ * and the header records which one it is.  Bump 'INDEX_CACHE_VERSION' whenever the layout changes, older files are then ignored and rewritten. */
+
+#define INDEX_CACHE_MAGIC    "NXIC"
+#define INDEX_CACHE_VERSION  (2)
+
+/* A string in the string table. */
+struct IndexCacheStr {
+  Uint offset;
+  Uint len;
+};
+
+struct IndexCacheHeader {
+  char  magic[4];
+  Uint  version;
+  Llong mtime_sec;
+  Llong mtime_nsec;
+  Llong size;
+  Ulong hash;
+  IndexCacheStr path;
+  /* 'TRUE' when the file was parsed as the main file, so this has its function defenitions and variables. */
+  Uint main_file;
+  /* The number of records of each kind, in the order they are written. */
+  Uint includes;
+  Uint defines;
+  Uint enums;
+  Uint tdstructs;
+  Uint structs;
+  Uint functiondefs;
+  Uint vars;
+  Uint strings_size;
+};
+
+struct IndexCacheDefine {
+  IndexCacheStr name;
+  IndexCacheStr full_decl;
+  IndexCacheStr value;
+  IndexCacheStr file;
+  int decl_start_line;
+  int decl_end_line;
+};
+
+struct IndexCacheTdstruct {
+  IndexCacheStr name;
+  IndexCacheStr alias;
+};
+
+struct IndexCacheStruct {
+  IndexCacheStr name;
+  IndexCacheStr filename;
+  Ulong decl_st;
+  Ulong decl_end;
+};
+
+struct IndexCacheFunctiondef {
+  IndexCacheStr file;
+  IndexCacheStr name;
+  Uint decl_st;
+  Uint decl_end;
+};
+
+struct IndexCacheVar {
+  IndexCacheStr file;
+  IndexCacheStr type;
+  IndexCacheStr name;
+  IndexCacheStr value;
+  Uint decl_st;
+  Uint decl_end;
+};
+
+/* Used to build a cache file in memory, before writing it out in one go. */
+struct IndexCacheWriter {
+  string records;
+  string strings;
+
+  IndexCacheStr str(const char *data, Ulong len) {
+    IndexCacheStr ret = {(Uint)strings.size(), (Uint)len};
+    strings.append(data, len);
+    return ret;
+  }
+
+  IndexCacheStr str(const char *data) {
+    return str((data ? data : ""), (data ? strlen(data) : 0));
+  }
+
+  IndexCacheStr str(const string &data) {
+    return str(data.data(), data.size());
+  }
+
+  template <typename T>
+  void record(const T &rec) {
+    records.append((const char *)&rec, sizeof(rec));
+  }
+};
+
+/* Used to walk a mapped cache file, where every access is checked against the size of the file. */
+struct IndexCacheReader {
+  const char *data;
+  Ulong size;
+  Ulong pos;
+  const char *strings;
+  Uint strings_size;
+
+  template <typename T>
+  const T *record(void) {
+    const T *ret;
+    if ((size - pos) < sizeof(T)) {
+      return NULL;
+    }
+    ret  = (const T *)(data + pos);
+    pos += sizeof(T);
+    return ret;
+  }
+
+  bool valid(const IndexCacheStr &s) const {
+    return (s.offset <= strings_size && s.len <= (strings_size - s.offset));
+  }
+
+  char *copy(const IndexCacheStr &s) const {
+    return measured_copy((strings + s.offset), s.len);
+  }
+
+  string str(const IndexCacheStr &s) const {
+    return string((strings + s.offset), s.len);
+  }
+};
+
+/* Return`s the 64-bit fnv-1a hash of 'len' bytes at 'data', continuing from 'hash'. */
+static Ulong index_cache_fnv(const void *data, Ulong len, Ulong hash) {
+  const Uchar *byte = (const Uchar *)data;
+  for (Ulong i=0; i<len; ++i) {
+    hash ^= byte[i];
+    hash *= 0x100000001b3UL;
+  }
+  return hash;
+}
+
+/* Return`s the hash of the content of the file at 'path', or '0' when it could not be read. */
+static Ulong index_cache_hash_file(const char *path) {
+  char  buffer[65536];
+  Ulong hash = 0xcbf29ce484222325UL;
+  long  len;
+  int   fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    return 0;
+  }
+  while ((len = read(fd, buffer, sizeof(buffer))) > 0 || (len < 0 && errno == EINTR)) {
+    if (len > 0) {
+      hash = index_cache_fnv(buffer, len, hash);
+    }
+  }
+  close(fd);
+  return ((len < 0) ? 0 : hash);
+}
+
+/* Return`s the path of the cache file for the file at 'path', parsed as the main file when 'main_file' is 'TRUE'.  The caller should free the returned string. */
+static char *index_cache_path(const char *dir, const char *path, bool main_file) {
+  Ulong hash = index_cache_fnv(path, strlen(path), 0xcbf29ce484222325UL);
+  char  name[32];
+  snprintf(name, sizeof(name), (main_file ? "%016lx.main.idx" : "%016lx.idx"), hash);
+  return concatenate(dir, name);
+}
+
+/* Return`s the directory the index cache lives in, creating it when needed, or 'NULL' when there is no state directory.
+ * This uses the same state directory as the history files.  The caller should free the returned string. */
+char *index_cache_dir(void) {
+  struct stat dirinfo;
+  char *dir;
+  if (!statedir && !have_statedir()) {
+    return NULL;
+  }
+  dir = concatenate(statedir, "lsp/");
+  if (stat(dir, &dirinfo) == -1) {
+    mkdir(dir, S_IRWXU);
+  }
+  if (stat(dir, &dirinfo) == -1 || !S_ISDIR(dirinfo.st_mode)) {
+    free(dir);
+    return NULL;
+  }
+  return dir;
+}
+
+/* Load the cached index of the file at 'path', parsed as the main file when 'main_file' is 'TRUE', into 'index', and the absolute paths it includes into
+ * 'includes'.  'st' should be the current status of the file.  Return`s 'FALSE' when there is no usable cache entry, in that case 'index' and 'includes' are untouched. */
+bool index_cache_load(const char *dir, const char *path, bool main_file, const struct stat *st, Index *index, vector<string> &includes) {
+  PROFILE_FUNCTION;
+  TRACE_FUNCTION;
+  char *cache_path = index_cache_path(dir, path, main_file);
+  const IndexCacheHeader *header;
+  IndexCacheReader rd;
+  struct stat cache_st;
+  Index loaded;
+  vector<string> found;
+  bool  ret = FALSE;
+  void *map;
+  int   fd = open(cache_path, O_RDONLY);
+  free(cache_path);
+  if (fd < 0) {
+    return FALSE;
+  }
+  if (fstat(fd, &cache_st) == -1 || (Ulong)cache_st.st_size < sizeof(IndexCacheHeader)
+  || (map = mmap(NULL, cache_st.st_size, PROT_READ, MAP_PRIVATE, fd, 0)) == MAP_FAILED) {
+    close(fd);
+    return FALSE;
+  }
+  close(fd);
+  rd.data = (const char *)map;
+  rd.size = cache_st.st_size;
+  rd.pos  = 0;
+  header  = rd.record<IndexCacheHeader>();
+  /* The string table is at the very end, so it must fit after the header. */
+  if (memcmp(header->magic, INDEX_CACHE_MAGIC, 4) != 0 || header->version != INDEX_CACHE_VERSION || header->main_file != (Uint)main_file
+  || header->size != st->st_size || header->strings_size > (rd.size - sizeof(IndexCacheHeader))) {
+    munmap(map, rd.size);
+    return FALSE;
+  }
+  rd.strings      = (rd.data + (rd.size - header->strings_size));
+  rd.strings_size = header->strings_size;
+  rd.size        -= header->strings_size;
+  /* A other file with the same path hash, or a file that changed. */
+  if (!rd.valid(header->path) || rd.str(header->path) != path || ((header->mtime_sec != st->st_mtim.tv_sec
+  || header->mtime_nsec != st->st_mtim.tv_nsec) && header->hash != index_cache_hash_file(path))) {
+    munmap(map, (rd.size + rd.strings_size));
+    return FALSE;
+  }
+  for (Uint i=0; i<header->includes; ++i) {
+    const IndexCacheStr *rec = rd.record<IndexCacheStr>();
+    if (!rec || !rd.valid(*rec)) {
+      goto done;
+    }
+    found.push_back(rd.str(*rec));
+  }
+  for (Uint i=0; i<header->defines; ++i) {
+    const IndexCacheDefine *rec = rd.record<IndexCacheDefine>();
+    if (!rec || !rd.valid(rec->name) || !rd.valid(rec->full_decl) || !rd.valid(rec->value) || !rd.valid(rec->file)) {
+      goto done;
+    }
+    DefineEntry de;
+    de.name            = rd.copy(rec->name);
+    de.full_decl       = rd.str(rec->full_decl);
+    de.value           = rd.str(rec->value);
+    de.file            = rd.str(rec->file);
+    de.decl_start_line = rec->decl_start_line;
+    de.decl_end_line   = rec->decl_end_line;
+    loaded.defines[de.name] = de;
+  }
+  for (Uint i=0; i<header->enums; ++i) {
+    const IndexCacheStr *rec = rd.record<IndexCacheStr>();
+    if (!rec || !rd.valid(*rec)) {
+      goto done;
+    }
+    EnumEntry ee;
+    ee.name = rd.copy(*rec);
+    loaded.enums[ee.name] = ee;
+  }
+  for (Uint i=0; i<header->tdstructs; ++i) {
+    const IndexCacheTdstruct *rec = rd.record<IndexCacheTdstruct>();
+    if (!rec || !rd.valid(rec->name) || !rd.valid(rec->alias)) {
+      goto done;
+    }
+    TypedefStruct tds;
+    tds.name  = rd.copy(rec->name);
+    tds.alias = rd.copy(rec->alias);
+    loaded.tdstructs[tds.alias] = tds;
+  }
+  for (Uint i=0; i<header->structs; ++i) {
+    const IndexCacheStruct *rec = rd.record<IndexCacheStruct>();
+    if (!rec || !rd.valid(rec->name) || !rd.valid(rec->filename)) {
+      goto done;
+    }
+    StructEntry ste;
+    ste.name     = rd.copy(rec->name);
+    ste.filename = rd.copy(rec->filename);
+    ste.decl_st  = rec->decl_st;
+    ste.decl_end = rec->decl_end;
+    loaded.structs[ste.name] = ste;
+  }
+  for (Uint i=0; i<header->functiondefs; ++i) {
+    const IndexCacheFunctiondef *rec = rd.record<IndexCacheFunctiondef>();
+    if (!rec || !rd.valid(rec->file) || !rd.valid(rec->name)) {
+      goto done;
+    }
+    FunctionDef fd;
+    fd.file     = rd.copy(rec->file);
+    fd.name     = rd.copy(rec->name);
+    fd.decl_st  = rec->decl_st;
+    fd.decl_end = rec->decl_end;
+    loaded.functiondefs[fd.name] = fd;
+  }
+  for (Uint i=0; i<header->vars; ++i) {
+    const IndexCacheVar *rec = rd.record<IndexCacheVar>();
+    if (!rec || !rd.valid(rec->file) || !rd.valid(rec->type) || !rd.valid(rec->name) || !rd.valid(rec->value)) {
+      goto done;
+    }
+    VarDecl vd;
+    vd.file     = rd.copy(rec->file);
+    vd.type     = rd.copy(rec->type);
+    vd.name     = rd.copy(rec->name);
+    vd.value    = rd.copy(rec->value);
+    vd.decl_st  = rec->decl_st;
+    vd.decl_end = rec->decl_end;
+    loaded.vars[vd.name].push_back(vd);
+  }
+  ret = TRUE;
+  done:
+  munmap(map, (rd.size + rd.strings_size));
+  if (ret) {
+    index->merge(loaded);
+    for (auto &it : found) {
+      includes.push_back(it);
+    }
+  }
+  else {
+    loaded.delete_data();
+  }
+  return ret;
+}
+
+/* Write what indexing the file at 'path', parsed as the main file when 'main_file' is 'TRUE', produced into its cache file.  'st' should be
+ * the status of the file from before it was read, so that a change made while reading makes the entry stale right away. */
+void index_cache_store(const char *dir, const char *path, bool main_file, const struct stat *st, const Index *index, const vector<string> &includes) {
+  PROFILE_FUNCTION;
+  TRACE_FUNCTION;
+  IndexCacheHeader header;
+  IndexCacheWriter wr;
+  struct stat now;
+  char *cache_path;
+  char *tmp_path;
+  FILE *file;
+  bool  ok;
+  memcpy(header.magic, INDEX_CACHE_MAGIC, 4);
+  header.version      = INDEX_CACHE_VERSION;
+  header.mtime_sec    = st->st_mtim.tv_sec;
+  header.mtime_nsec   = st->st_mtim.tv_nsec;
+  header.size         = st->st_size;
+  header.hash         = index_cache_hash_file(path);
+  /* The file changed after it was read, so the hash is not of what was indexed. */
+  if (stat(path, &now) == -1 || now.st_size != st->st_size || now.st_mtim.tv_sec != st->st_mtim.tv_sec || now.st_mtim.tv_nsec != st->st_mtim.tv_nsec) {
+    return;
+  }
+  header.path         = wr.str(path);
+  header.main_file    = main_file;
+  header.includes     = includes.size();
+  header.defines      = index->defines.size();
+  header.enums        = index->enums.size();
+  header.tdstructs    = index->tdstructs.size();
+  header.structs      = index->structs.size();
+  header.functiondefs = index->functiondefs.size();
+  header.vars         = 0;
+  for (const auto &it : includes) {
+    wr.record(wr.str(it));
+  }
+  for (const auto &[name, de] : index->defines) {
+    wr.record(IndexCacheDefine{wr.str(de.name), wr.str(de.full_decl), wr.str(de.value), wr.str(de.file), de.decl_start_line, de.decl_end_line});
+  }
+  for (const auto &[name, ee] : index->enums) {
+    wr.record(wr.str(ee.name));
+  }
+  for (const auto &[alias, tds] : index->tdstructs) {
+    wr.record(IndexCacheTdstruct{wr.str(tds.name), wr.str(tds.alias)});
+  }
+  for (const auto &[name, ste] : index->structs) {
+    wr.record(IndexCacheStruct{wr.str(ste.name), wr.str(ste.filename), ste.decl_st, ste.decl_end});
+  }
+  for (const auto &[name, fd] : index->functiondefs) {
+    wr.record(IndexCacheFunctiondef{wr.str(fd.file), wr.str(fd.name), fd.decl_st, fd.decl_end});
+  }
+  for (const auto &[name, var_vec] : index->vars) {
+    for (const auto &vd : var_vec) {
+      wr.record(IndexCacheVar{wr.str(vd.file), wr.str(vd.type), wr.str(vd.name), wr.str(vd.value), vd.decl_st, vd.decl_end});
+      ++header.vars;
+    }
+  }
+  header.strings_size = wr.strings.size();
+  /* Write into a file of our own first, then rename it over the entry, so that a reader never sees half a file. */
+  cache_path = index_cache_path(dir, path, main_file);
+  tmp_path   = fmtstr("%s.%d.%lx", cache_path, getpid(), (Ulong)pthread_self());
+  if (!(file = fopen(tmp_path, "wb"))) {
+    free(cache_path);
+    free(tmp_path);
+    return;
+  }
+  ok  = (fwrite(&header, sizeof(header), 1, file) == 1);
+  ok &= (fwrite(wr.records.data(), 1, wr.records.size(), file) == wr.records.size());
+  ok &= (fwrite(wr.strings.data(), 1, wr.strings.size(), file) == wr.strings.size());
+  ok &= (fclose(file) == 0);
+  if (!ok || rename(tmp_path, cache_path) == -1) {
+    unlink(tmp_path);
+  }
+  free(cache_path);
+  free(tmp_path);
+}
@@ -0,0 +1,504 @@
+#include "../../include/prototypes.h"
+
+/* One indexing of a file and everything it includes, or of every file of a project.  The include graph is discovered by the tasks
+ * as they parse, every '#include' they find that was not seen before is queued here, and up to 'max_workers' tasks on the threadpool
+ * take files from the queue until it is empty.  Only 'mutex' is held while touching the queue, never while reading or parsing a file.
+ * At most 'max_pending' parsed files wait for the main thread to merge them, a task that would go over that stops, and the main
+ * thread starts a new one as it catches up.  So the memory a run holds is bounded by how far the tasks get ahead of the main thread. */
+struct IndexRun {
+  pthread_mutex_t mutex;
+  unordered_map<string, bool> seen; /* Every file queued by this run, and every file that was indexed before it started. */
+  vector<char *> queue;             /* Absolute paths waiting for a task. */
+  char *main_file;                  /* The file the run started from, function defenitions are only taken from this one.  'NULL' for a project. */
+  char *cache_dir;                  /* Where per-file results are loaded from and stored, or 'NULL' to always parse. */
+  bool  project;                    /* Function defenitions are taken from every file, and the lines of a file are dropped once parsed. */
+  char *walk;                       /* A directory the first task walks for sources to queue, before it takes any file.  'NULL' when there is none. */
+  Ulong discovered;                 /* The number of files queued so far. */
+  Ulong done;                       /* The number of files merged into the index, this is only used from the main thread. */
+  Ulong pending;                    /* The number of files parsed but not yet merged. */
+  Ulong max_pending;
+  int   workers;                    /* The number of tasks running for this run. */
+  int   max_workers;
+  int   duty;                       /* The percent of its time a task spends parsing, it sleeps for the rest. */
+  Llong start;
+  Llong last_report;
+};
+
+/* A file parsed by a task, waiting to be merged into the shared index by the main thread. */
+struct IndexJob {
+  IndexRun *run;
+  char     *path;
+  IndexFile idfile;
+  Index    *result;
+  vector<string> includes; /* The absolute path of every file this one includes, for the cache. */
+};
+
+/* The job the calling thread is parsing, when it is a indexing task. */
+static thread_local IndexJob *index_job = NULL;
+/* When not 'NULL', all parsing on the calling thread adds to this index instead of the shared one, and takes function
+ * defenitions from 'parse_main_file'.  Sub-threads set these while parsing, see 'LanguageServer::parse_into()'. */
+static thread_local Index      *parse_target    = NULL;
+static thread_local const char *parse_main_file = NULL;
+/* The number of runs that have not finished, this is only used from the main thread. */
+static int active_runs = 0;
+
+/* Return`s the current monotonic time in nano-seconds. */
+static Llong indexer_clock(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ((ts.tv_sec * 1000000000LL) + ts.tv_nsec);
+}
+
+static bool  index_run_push(IndexRun *run, const char *path, vector<string> *found);
+static void *index_run_task(void *arg);
+
+/* Start a worker for 'run', whose place in 'run->workers' the caller already took.  When the threadpool queue is full
+ * the place is given back, unless no other worker is left to empty the queue, then the calling thread does the work
+ * itself.  A worker always holds a place of its own, so that only ever happens on the main thread. */
+static void index_run_spawn(IndexRun *run) {
+  bool perform = FALSE;
+  if (submit_task(index_run_task, run, NULL, NULL)) {
+    return;
+  }
+  mutex_lock(&run->mutex);
+  if (run->workers > 1) {
+    --run->workers;
+  }
+  else {
+    perform = TRUE;
+  }
+  mutex_unlock(&run->mutex);
+  if (perform) {
+    index_run_task(run);
+  }
+}
+
+/* Parse one file on the calling thread, into a index of its own.  When the cache has a entry for the
+ * file that is still valid, that is used instead, and only the files it includes are queued. */
+static IndexJob *index_job_parse(IndexRun *run, char *path) {
+  IndexJob *job = new IndexJob();
+  Llong perf_start = nperf_now();
+  struct stat st;
+  bool has_stat = (run->cache_dir && stat(path, &st) == 0);
+  /* The same check parsing does, function defenitions and variables are only taken from the main file. */
+  bool is_main  = (run->project || strcmp(tail(path), tail(run->main_file)) == 0);
+  job->run    = run;
+  job->path   = path;
+  job->result = new Index();
+  if (has_stat && index_cache_load(run->cache_dir, path, is_main, &st, job->result, job->includes)) {
+    job->idfile.from_cache(path);
+    for (const auto &it : job->includes) {
+      index_run_push(run, it.c_str(), NULL);
+    }
+  }
+  else {
+    index_job = job;
+    job->idfile.read_file(path, TRUE);
+    LSP->parse_into(job->result, (run->project ? path : run->main_file), job->idfile.top(), path);
+    index_job = NULL;
+    if (has_stat) {
+      index_cache_store(run->cache_dir, path, is_main, &st, job->result, job->includes);
+    }
+    /* Nothing reads the lines of a file that is not open, so a project keeps only what was found in them. */
+    if (run->project) {
+      job->idfile.delete_data();
+      job->idfile.from_cache(path);
+    }
+  }
+  nperf_record(NPERF_INDEX, perf_start);
+  return job;
+}
+
+/* Runs on the main thread once every file of 'arg' has been merged, and frees the run. */
+static void on_index_run_done(void *arg) {
+  IndexRun *run = (IndexRun *)arg;
+  statusline(INFO, (run->project ? "Indexed project, %lu files in %.1f ms" : "Indexed %lu files in %.1f ms"),
+    run->done, ((double)(indexer_clock() - run->start) / 1000000.0));
+  pthread_mutex_destroy(&run->mutex);
+  free(run->main_file);
+  free(run->cache_dir);
+  free(run->walk);
+  delete run;
+  --active_runs;
+}
+
+/* Runs on the main thread for every parsed file, merging it into the shared index. */
+static void on_index_job_done(void *arg) {
+  IndexJob *job = (IndexJob *)arg;
+  IndexRun *run = job->run;
+  Index    &index = LSP->index;
+  Ulong discovered;
+  Llong now;
+  bool  spawn;
+  const auto &it = index.include.find(job->path);
+  if (it != index.include.end()) {
+    it->second.delete_data();
+  }
+  index.include[job->path] = job->idfile;
+  symbols_changed_in(*job->result);
+  index.merge(*job->result);
+  delete job->result;
+  free(job->path);
+  delete job;
+  ++run->done;
+  /* Take the place of a task that stopped because too many files were waiting here, once half of them are merged. */
+  mutex_lock(&run->mutex);
+  --run->pending;
+  discovered = run->discovered;
+  spawn      = (!run->queue.empty() && run->workers < run->max_workers && run->pending <= (run->max_pending / 2));
+  if (spawn) {
+    ++run->workers;
+  }
+  mutex_unlock(&run->mutex);
+  if (spawn) {
+    index_run_spawn(run);
+  }
+  /* Only report progress a few times a second, as a lot of small headers get merged in a single pass. */
+  if (((now = indexer_clock()) - run->last_report) >= 100000000LL) {
+    statusline(INFO, (run->project ? "Indexing project: %lu of %lu files" : "Indexing: %lu of %lu files"), run->done, discovered);
+    run->last_report = now;
+  }
+}
+
+/* The task every worker of a run performs.  It takes files from the queue until there are none left, and the last
+ * worker to find the queue empty tells the main thread that the run is done.  As files are only queued by workers of
+ * the run, or before the first one starts, no more files can show up once the last worker has stopped.  A worker also
+ * stops when 'max_pending' files wait to be merged, the queue is then not empty, so the run is not done, and as the
+ * main thread has those files left to merge, it will start a worker again. */
+static void *index_run_task(void *arg) {
+  IndexRun *run = (IndexRun *)arg;
+  char *path;
+  char *walk;
+  bool  last = FALSE;
+  Llong start;
+  vector<string> files;
+  ntrace_begin(__func__);
+  /* The place this task holds keeps the run going while it walks, even when the other tasks empty the queue. */
+  mutex_lock(&run->mutex);
+  walk      = run->walk;
+  run->walk = NULL;
+  mutex_unlock(&run->mutex);
+  if (walk) {
+    project_walk(walk, files);
+    for (const auto &it : files) {
+      index_run_push(run, it.c_str(), NULL);
+    }
+    free(walk);
+  }
+  while (1) {
+    mutex_lock(&run->mutex);
+    if (run->queue.empty()) {
+      last = !--run->workers;
+      mutex_unlock(&run->mutex);
+      break;
+    }
+    else if (run->pending >= run->max_pending) {
+      --run->workers;
+      mutex_unlock(&run->mutex);
+      break;
+    }
+    path = run->queue.back();
+    run->queue.pop_back();
+    ++run->pending;
+    mutex_unlock(&run->mutex);
+    start = indexer_clock();
+    enqueue_callback(on_index_job_done, index_job_parse(run, path));
+    /* Sleep in proportion to the time spent parsing, so the task uses at most 'duty' percent of a cpu. */
+    if (run->duty < 100) {
+      usleep(((indexer_clock() - start) * (100 - run->duty)) / (run->duty * 1000LL));
+    }
+  }
+  ntrace_end(__func__);
+  if (last) {
+    enqueue_callback(on_index_run_done, run);
+  }
+  return NULL;
+}
+
+/* Queue 'path' on 'run' unless it was seen before, and start another worker when there is room for one.  When 'found' is
+ * not 'NULL', the absolute path is added to it, even when it was seen before.  Return`s 'TRUE' when 'path' was queued. */
+static bool index_run_push(IndexRun *run, const char *path, vector<string> *found) {
+  char *absolute_path = abs_path(path);
+  bool  queued = FALSE;
+  bool  spawn  = FALSE;
+  if (!absolute_path || !file_exists(absolute_path)) {
+    free(absolute_path);
+    return FALSE;
+  }
+  if (found) {
+    found->push_back(absolute_path);
+  }
+  mutex_lock(&run->mutex);
+  if (run->seen.find(absolute_path) == run->seen.end()) {
+    run->seen[absolute_path] = TRUE;
+    run->queue.push_back(absolute_path);
+    absolute_path = NULL;
+    queued = TRUE;
+    ++run->discovered;
+    if (run->workers < run->max_workers) {
+      ++run->workers;
+      spawn = TRUE;
+    }
+  }
+  mutex_unlock(&run->mutex);
+  free(absolute_path);
+  if (spawn) {
+    index_run_spawn(run);
+  }
+  return queued;
+}
+
+/* Return`s the index that parsing on the calling thread should add to.  This is the shared index,
+ * unless the thread is parsing on behalf of a task, then it is the index that task parses into. */
+Index &LanguageServer::target(void) noexcept {
+  return (parse_target ? *parse_target : index);
+}
+
+/* Return`s the file that function defenitions are taken from, the open file, or the one given to 'parse_into()'. */
+const char *LanguageServer::main_file(void) noexcept {
+  return (parse_target ? parse_main_file : openfile->filename);
+}
+
+/* Parse the C/C++ lines from 'top', that belong to the file 'name', into 'into' instead of the shared index.
+ * Function defenitions are only taken when 'name' is 'main'.  This is what sub-threads use to parse. */
+void LanguageServer::parse_into(Index *into, const char *main, linestruct *top, const char *name) {
+  parse_target    = into;
+  parse_main_file = main;
+  parse_lines(top, name, TRUE, FALSE);
+  parse_target    = NULL;
+  parse_main_file = NULL;
+}
+
+/* Return`s 'TRUE' when 'path' needs no indexing.  On a indexing task that is when the run has seen it.  When reparsing part of a open file
+ * on a sub-thread, every include is left for the next full index anyway, so it counts as included, as the shared index must not be read there. */
+bool LanguageServer::has_been_included(const char *path) {
+  if (index_job) {
+    pthread_mutex_guard_t guard(&index_job->run->mutex);
+    return (index_job->run->seen.find(path) != index_job->run->seen.end());
+  }
+  else if (parse_target) {
+    return TRUE;
+  }
+  const auto &it = index.include.find(path);
+  if (it != index.include.end()) {
+    return true;
+  }
+  return false;
+}
+
+/* Called for every '#include' found while parsing.  On a indexing task 'path' is queued on the run, and when reparsing part of
+ * a open file it is left for the next full index.  Otherwise it is indexed right away. */
+void LanguageServer::include_file(const char *path) {
+  if (index_job) {
+    index_run_push(index_job->run, path, &index_job->includes);
+  }
+  else if (!parse_target) {
+    index_file(path);
+  }
+}
+
+/* Return`s a new run that uses at most 'max_workers' tasks, each parsing for at most 'duty' percent of the time.  Files already
+ * in the shared index are marked as seen, so the tasks never have to look at it, except for 'reparse' when that is not 'NULL'. */
+static IndexRun *index_run_create(char *main_file, char *cache_dir, int max_workers, int duty, const char *reparse) {
+  IndexRun *run = new IndexRun();
+  pthread_mutex_init(&run->mutex, NULL);
+  run->main_file   = main_file;
+  run->cache_dir   = cache_dir;
+  run->project     = FALSE;
+  run->walk        = NULL;
+  run->discovered  = 0;
+  run->done        = 0;
+  run->pending     = 0;
+  run->workers     = 0;
+  run->max_workers = ((max_workers > 0 && max_workers < MAX_THREADS) ? max_workers : MAX_THREADS);
+  run->max_pending = (run->max_workers * 8);
+  run->duty        = ((duty > 0 && duty < 100) ? duty : 100);
+  run->start       = indexer_clock();
+  run->last_report = run->start;
+  for (const auto &[filename, file] : LSP->index.include) {
+    if (!reparse || filename != reparse) {
+      run->seen[filename] = TRUE;
+    }
+  }
+  ++active_runs;
+  return run;
+}
+
+/* Index 'path' and everything it includes on the threadpool, without blocking.  Each file is parsed into a index of its own, and merged
+ * into the shared index by the main thread when it processes the callback queue.  When 'max_workers' is '0', every sub-thread may be used. */
+void LanguageServer::index_file_async(const char *path, bool reindex, int max_workers) {
+  PROFILE_FUNCTION;
+  TRACE_FUNCTION;
+  IndexRun *run;
+  char     *main_file;
+  if (!path || !(main_file = abs_path(path))) {
+    return;
+  }
+  run = index_run_create(main_file, (cache_dir ? copy_of(cache_dir) : NULL), max_workers, 100, (reindex ? main_file : NULL));
+  /* When nothing was queued, no worker will ever finish the run. */
+  if (!index_run_push(run, run->main_file, NULL)) {
+    on_index_run_done(run);
+  }
+}
+
+/* Index every file in 'paths', and everything they include, as a single run on the threadpool, without blocking.  When 'walk' is not
+ * 'NULL', every source under that directory is indexed as well, the first task of the run walks it, so the calling thread never does.
+ * Function defenitions are taken from every file, not only the open one, so the shared index covers the whole project.  The run uses
+ * at most 'cpu_share' percent of the cpus, it gets one task per whole cpu of its share, and when that is less then a whole
+ * cpu per task, the tasks sleep for the rest.  The results are cached apart from those of 'index_file_async()', as a file
+ * cached there has no function defenitions unless it was the open one. */
+void LanguageServer::index_project_async(const vector<string> &paths, int cpu_share, const char *walk) {
+  PROFILE_FUNCTION;
+  TRACE_FUNCTION;
+  IndexRun *run;
+  char     *project_cache = NULL;
+  struct stat dirinfo;
+  long  ncpus  = sysconf(_SC_NPROCESSORS_ONLN);
+  int   budget = ((ncpus > 0 ? ncpus : 1) * ((cpu_share > 0 && cpu_share < 100) ? cpu_share : 100));
+  int   workers;
+  int   spawn = 0;
+  bool  done;
+  workers = ((budget + 99) / 100);
+  if (workers > MAX_THREADS) {
+    workers = MAX_THREADS;
+  }
+  if (cache_dir) {
+    project_cache = concatenate(cache_dir, "project/");
+    if (stat(project_cache, &dirinfo) == -1) {
+      mkdir(project_cache, S_IRWXU);
+    }
+    if (stat(project_cache, &dirinfo) == -1 || !S_ISDIR(dirinfo.st_mode)) {
+      free(project_cache);
+      project_cache = NULL;
+    }
+  }
+  run = index_run_create(NULL, project_cache, workers, (budget / workers), NULL);
+  run->project = TRUE;
+  /* Set before any task can start, so whichever starts first takes it. */
+  run->walk    = (walk ? copy_of(walk) : NULL);
+  /* Hold the place of a worker while queueing, so the workers that already started cannot find the queue empty and end the run. */
+  run->workers = 1;
+  for (const auto &path : paths) {
+    index_run_push(run, path.c_str(), NULL);
+  }
+  mutex_lock(&run->mutex);
+  --run->workers;
+  /* When no task took the walk yet, it needs one of its own. */
+  while (run->workers < run->max_workers && (Ulong)run->workers < (run->queue.size() + (run->walk ? 1 : 0))) {
+    ++run->workers;
+    ++spawn;
+  }
+  done = (!run->workers && run->queue.empty() && !run->walk);
+  mutex_unlock(&run->mutex);
+  while (spawn--) {
+    index_run_spawn(run);
+  }
+  /* Files may already wait to be merged, and the run must be freed after them. */
+  if (done) {
+    enqueue_callback(on_index_run_done, run);
+  }
+}
+
+/* Return`s 'TRUE' while any run started by 'index_file_async()' has not finished. */
+bool LanguageServer::indexing(void) noexcept {
+  return active_runs;
+}
+
+/* ----------------------------- Tests ----------------------------- */
+
+#define LSP_TEST_HEADERS  (600)
+#define LSP_TEST_LINES    (120)
+
+/* `Internal`  Write a tree of headers into 'dir', where header 'i' includes headers '2i+1' and '2i+2', and every header includes the first one. */
+static bool lsp_test_write_headers(const char *dir) {
+  char  path[PATH_MAX];
+  FILE *file;
+  for (int i=0; i<LSP_TEST_HEADERS; ++i) {
+    snprintf(path, sizeof(path), "%s/header_%d.h", dir, i);
+    if (!(file = fopen(path, "w"))) {
+      return FALSE;
+    }
+    fprintf(file, "#pragma once\n\n#include \"header_0.h\"\n");
+    for (int child=((i * 2) + 1); child<=((i * 2) + 2) && child<LSP_TEST_HEADERS; ++child) {
+      fprintf(file, "#include \"header_%d.h\"\n", child);
+    }
+    for (int line=0; line<LSP_TEST_LINES; line+=4) {
+      fprintf(file, "\n/* Value %d of header %d. */\n#define HEADER_%d_VALUE_%d  (%d)\n", line, i, i, line, (i * line));
+    }
+    fclose(file);
+  }
+  snprintf(path, sizeof(path), "%s/main.c", dir);
+  if (!(file = fopen(path, "w"))) {
+    return FALSE;
+  }
+  fprintf(file, "#include \"header_0.h\"\n\nint main(void) {\n  return HEADER_0_VALUE_0;\n}\n");
+  fclose(file);
+  return TRUE;
+}
+
+/* `Internal`  Index 'main.c' in 'dir' using at most 'max_workers' tasks, pumping the callback queue the way the main loop does. */
+static void lsp_test_index(const char *name, const char *dir, int max_workers) {
+  char path[PATH_MAX];
+  Ulong files;
+  Ulong defines;
+  snprintf(path, sizeof(path), "%s/main.c", dir);
+  LSP->index.delete_data();
+  timer_action(ms,
+    LSP->index_file_async(path, FALSE, max_workers);
+    while (LSP->indexing()) {
+      prosses_callback_queue();
+      usleep(100);
+    }
+  );
+  files   = LSP->index.include.size();
+  defines = LSP->index.defines.size();
+  LSP->index.delete_data();
+  symbols_changed();
+  writef("%s: %s: Workers: %d: Files: %lu: Defines: %lu in %.5f ms\n", __func__, name, max_workers, files, defines, (double)ms);
+}
+
+/* `Internal`  Remove every file in 'dir', and then 'dir' itself. */
+static void lsp_test_remove_dir(const char *dir) {
+  char path[PATH_MAX];
+  struct dirent *entry;
+  DIR *d = opendir(dir);
+  if (d) {
+    while ((entry = readdir(d))) {
+      if (*entry->d_name != '.') {
+        snprintf(path, sizeof(path), "%s/%s", dir, entry->d_name);
+        unlink(path);
+      }
+    }
+    closedir(d);
+  }
+  rmdir(dir);
+}
+
+/* Index a generated include graph with one worker, then with all of them, and then twice
+ * more with a cache, where the first run fills the cache and the second loads from it. */
+void lsp_index_test_bench(void) {
+  char  dir[] = "/tmp/lsp_index_test_XXXXXX";
+  char  path[PATH_MAX];
+  char *was_cache_dir = LSP->cache_dir;
+  writef("\n");
+  if (!mkdtemp(dir)) {
+    writef("%s: Failed to create a directory\n\n", __func__);
+    return;
+  }
+  if (lsp_test_write_headers(dir)) {
+    LSP->cache_dir = NULL;
+    lsp_test_index("No cache", dir, 1);
+    lsp_test_index("No cache", dir, MAX_THREADS);
+    snprintf(path, sizeof(path), "%s/cache/", dir);
+    if (mkdir(path, S_IRWXU) == 0) {
+      LSP->cache_dir = path;
+      lsp_test_index("Cold cache", dir, MAX_THREADS);
+      lsp_test_index("Warm cache", dir, MAX_THREADS);
+      snprintf(path, sizeof(path), "%s/cache", dir);
+      lsp_test_remove_dir(path);
+    }
+    LSP->cache_dir = was_cache_dir;
+  }
+  lsp_test_remove_dir(dir);
+  writef("\n");
+}
@@ -1,7 +1,7 @@
 #include "../../include/prototypes.h"
 
-/* Open a file.  Return`s the fd and assigns the stream to 'f'. */
-int IndexFile::open_file(FILE **f) {
+/* Open a file.  Return`s the fd and assigns the stream to 'f'.  When 'on_thread' is 'TRUE', the signal handlers are left alone. */
+int IndexFile::open_file(FILE **f, bool on_thread) {
   int fd;
   char *full_filename = get_full_path(filename);
   struct stat fileinfo;
@@ -13,11 +13,16 @@ int IndexFile::open_file(FILE **f) {
     logI("File \"%s\" not found.", filename);
     return -1;
   }
-  block_sigwinch(TRUE);
-  install_handler_for_Ctrl_C();
-  fd = open(full_filename, O_RDONLY);
-  restore_handler_for_Ctrl_C();
-  block_sigwinch(FALSE);
+  if (on_thread) {
+    fd = open(full_filename, O_RDONLY);
+  }
+  else {
+    block_sigwinch(TRUE);
+    install_handler_for_Ctrl_C();
+    fd = open(full_filename, O_RDONLY);
+    restore_handler_for_Ctrl_C();
+    block_sigwinch(FALSE);
+  }
   if (fd == -1) {
     if (errno == EINTR || !errno) {
       logI("Interupted.");
@@ -40,7 +45,8 @@ int IndexFile::open_file(FILE **f) {
 
 #define LUMP 120
 
-void IndexFile::read_lines(FILE *f, int fd) {
+/* Read all lines from 'f'.  When 'on_thread' is 'TRUE', this does not touch the terminal or the signal mask, and cannot be interupted. */
+void IndexFile::read_lines(FILE *f, int fd, bool on_thread) {
   Ulong       bufsize   = LUMP;
   Ulong       len       = 0;
   Ulong       num_lines = 0;
@@ -50,12 +56,14 @@ void IndexFile::read_lines(FILE *f, int fd) {
   format_type format;
   filetop = make_new_node(NULL);
   filebot = filetop;
-  block_sigwinch(TRUE);
+  if (!on_thread) {
+    block_sigwinch(TRUE);
+    control_C_was_pressed = FALSE;
+  }
   flockfile(f);
-  control_C_was_pressed = FALSE;
   while ((onevalue = getc_unlocked(f)) != EOF) {
     char input = (char)onevalue;
-    if (control_C_was_pressed) {
+    if (!on_thread && control_C_was_pressed) {
       break;
     }
     if (input == '\n') {
@@ -90,8 +98,10 @@ void IndexFile::read_lines(FILE *f, int fd) {
   }
   errorcode = errno;
   funlockfile(f);
-  block_sigwinch(FALSE);
-  if (!ISSET(USING_GUI) && isendwin()) {
+  if (!on_thread) {
+    block_sigwinch(FALSE);
+  }
+  if (!on_thread && !ISSET(USING_GUI) && isendwin()) {
     if (!isatty(STDIN_FILENO)) {
       reconnect_and_store_state();
     }
@@ -101,7 +111,7 @@ void IndexFile::read_lines(FILE *f, int fd) {
   if (ferror(f) && errorcode != EINTR && errorcode) {
     logE(strerror(errorcode));
   }
-  if (control_C_was_pressed) {
+  if (!on_thread && control_C_was_pressed) {
     logI("Interupted.");
   }
   fclose(f);
@@ -163,14 +173,22 @@ void IndexFile::delete_data(void) noexcept {
   filebot = NULL;
 }
 
-void IndexFile::read_file(const char *path) {
+void IndexFile::read_file(const char *path, bool on_thread) {
   filename = copy_of(path);
   FILE *f;
-  int   fd = open_file(&f);
+  int   fd = open_file(&f, on_thread);
   if (fd < 0) {
     return;
   }
-  read_lines(f, fd);
-  close(fd);
+  /* The stream owns 'fd', and 'read_lines()' closes it.  Closing it again here could close a fd another thread just opened. */
+  read_lines(f, fd, on_thread);
+  get_last_time_changed();
+}
+
+/* Only remember 'path', for a file whose index was loaded from the cache, so its lines are never read. */
+void IndexFile::from_cache(const char *path) {
+  filename = copy_of(path);
+  filetop  = NULL;
+  filebot  = NULL;
   get_last_time_changed();
 }
@@ -75,6 +75,7 @@ void LanguageServer::fetch_compiler_defines(string compiler) {
       free(lines[i]);
     }
     free(lines);
+    symbols_changed();
   }
 }
 
@@ -93,6 +94,7 @@ LanguageServer *const &LanguageServer::instance(void) {
 
 void LanguageServer::_destroy(void) noexcept {
   LSP->index.delete_data();
+  free(LSP->cache_dir);
   delete _instance;
 }
 
@@ -156,6 +158,7 @@ auto LanguageServer::split_if_statement(const string &str) -> vector<string> {
 /* Parses a full preprossesor decl so that '\' are placed on the same line. */
 string LanguageServer::parse_full_pp_delc(linestruct *line, const char **ptr, int *end_lineno) {
   PROFILE_FUNCTION;
+  TRACE_FUNCTION;
   string      ret   = "";
   const char *start = *ptr;
   const char *end   = *ptr;
@@ -185,6 +188,7 @@ string LanguageServer::parse_full_pp_delc(linestruct *line, const char **ptr, in
 
 void LanguageServer::check(IndexFile *idfile) {
   PROFILE_FUNCTION;
+  TRACE_FUNCTION;
   linestruct * from = idfile->top() ? idfile->top() : openfile->filetop;
   FOR_EACH_LINE_NEXT(line, from) {
     Parse::comment(line);
@@ -205,16 +209,9 @@ void LanguageServer::check(IndexFile *idfile) {
   }
 }
 
-bool LanguageServer::has_been_included(const char *path) {
-  const auto &it = index.include.find(path);
-  if (it != index.include.end()) {
-    return true;
-  }
-  return false;
-}
-
 int LanguageServer::index_file(const char *path, bool reindex) {
   PROFILE_FUNCTION;
+  TRACE_FUNCTION;
   if (!path) {
     logE("Path: '%s', Is invalid.\n", path);
     return -1;
@@ -234,12 +231,21 @@ int LanguageServer::index_file(const char *path, bool reindex) {
       index.bash_data.delete_data();
     }
   }
+  Llong perf_start = nperf_now();
   IndexFile idfile;
   idfile.read_file(absolute_path);
   index.include[absolute_path] = idfile;
   free(absolute_path);
-  FOR_EACH_LINE_NEXT(line, idfile.top()) {
-    if (/* openfile->type.is_set<C_CPP>() */ openfile->is_c_file || openfile->is_cxx_file) {
+  parse_lines(idfile.top(), idfile.name(), (openfile->is_c_file || openfile->is_cxx_file), openfile->is_bash_file);
+  symbols_changed();
+  nperf_record(NPERF_INDEX, perf_start);
+  return 0;
+}
+
+/* Parse every line from 'top', that belong to the file 'name', into the index that parsing on this thread adds to, see 'target()'. */
+void LanguageServer::parse_lines(linestruct *top, const char *name, bool c_cpp, bool bash) {
+  FOR_EACH_LINE_NEXT(line, top) {
+    if (c_cpp) {
       Parse::comment(line);
       // if (line->flags.is_set<BLOCK_COMMENT_START>() || line->flags.is_set<BLOCK_COMMENT_END>()
       // || line->flags.is_set<IN_BLOCK_COMMENT>() || line->flags.is_set<PP_LINE>()) {
@@ -248,17 +254,16 @@ int LanguageServer::index_file(const char *path, bool reindex) {
       }
       // if (!(line->flags.is_set<DONT_PREPROSSES_LINE>())) {
       if (!(line->is_dont_preprocess_line)) {
-        do_preprossesor(line, idfile.name());
+        do_preprossesor(line, name);
       }
       // if (line->flags.is_set<PP_LINE>()) {
       if (line->is_pp_line) {
         continue;
       }
-      do_parse(&line, idfile.name());
+      do_parse(&line, name);
     }
-    else if (/* openfile->type.is_set<BASH>() */ openfile->is_bash_file) {
-      do_bash_parse(line, idfile.name());
+    else if (bash) {
+      do_bash_parse(line, name);
     }
   }
-  return 0;
 }
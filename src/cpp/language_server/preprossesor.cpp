@@ -165,30 +165,16 @@ void do_include(linestruct *line, const char *current_file, const char **ptr) {
     return;
   }
   if (local) {
-    LSP->index_file(path);
+    LSP->include_file(path);
     free(path);
   }
   else {
-    string check_file = string(path);
+    char *file = (*path ? include_resolve(path) : NULL);
     free(path);
-    if (check_file.empty()) {
-      return;
-    }
-    vector<string> dirs = {
-      "/usr/local/include/" + check_file,
-      "/usr/include/" + check_file,
-      "/usr/lib/clang/19/include/" + check_file,
-      "/usr/include/c++/v1/" + check_file,
-    };
-    for (const auto &it : dirs) {
-      if (LSP->has_been_included(it.c_str())) {
-        break;
-      }
-      LSP->index_file(it.c_str());
-      if (file_exists(it.c_str())) {
-        break;
-      }
+    if (file && !LSP->has_been_included(file)) {
+      LSP->include_file(file);
     }
+    free(file);
   }
 }
 
@@ -431,7 +417,7 @@ void do_define(linestruct *line, const char *current_file, const char **ptr) {
   string val = parse_full_define(line, &start, &de.decl_end_line);
   de.value   = string(val.c_str(), val.length());
   de.file    = string(current_file);
-  LSP->index.defines[de.name] = de;
+  LSP->target().defines[de.name] = de;
 }
 
 void do_ifndef(const string &define, linestruct *current_line) {
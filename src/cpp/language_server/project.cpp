@@ -0,0 +1,782 @@
+#include "../../include/prototypes.h"
+
+/* Indexing of a whole project, instead of only what the open file includes.  The files of a project are taken from its
+ * 'compile_commands.json', together with the '-I' directories the compiler is given.  Only when the 'projectwalk' option is set,
+ * a project without one is taken to be the closest directory with a '.git', and every c and c++ source under it is taken.  The
+ * indexing itself is a single run of the indexer, see 'index_project_async()'. */
+
+/* The percent of the cpus a project may use while indexing. */
+#define PROJECT_CPU_SHARE  (50)
+/* The most sources taken from a project without a 'compile_commands.json'. */
+#define PROJECT_MAX_FILES  (50000)
+
+/* A cursor into the text of a 'compile_commands.json'. */
+struct ProjectJson {
+  const char *p;
+  const char *end;
+};
+
+/* Every project root that was indexed, so a project is only indexed once. */
+static unordered_map<string, bool> project_roots;
+
+/* ----------------------------- Compilation database ----------------------------- */
+
+static void project_json_space(ProjectJson &js) {
+  while (js.p < js.end && (*js.p == ' ' || *js.p == '\t' || *js.p == '\n' || *js.p == '\r')) {
+    ++js.p;
+  }
+}
+
+/* Return`s 'TRUE' and moves past 'c' when that is the next thing at the cursor. */
+static bool project_json_take(ProjectJson &js, char c) {
+  project_json_space(js);
+  if (js.p < js.end && *js.p == c) {
+    ++js.p;
+    return TRUE;
+  }
+  return FALSE;
+}
+
+/* Read the string at the cursor into 'out'.  Return`s 'FALSE' when there is no string there, or it does not end. */
+static bool project_json_string(ProjectJson &js, string &out) {
+  Uint code;
+  project_json_space(js);
+  if (js.p >= js.end || *js.p != '"') {
+    return FALSE;
+  }
+  out.clear();
+  for (++js.p; js.p < js.end && *js.p != '"'; ++js.p) {
+    if (*js.p != '\\' || (js.p + 1) >= js.end) {
+      out += *js.p;
+      continue;
+    }
+    switch (*++js.p) {
+      case 'b': { out += '\b'; break; }
+      case 'f': { out += '\f'; break; }
+      case 'n': { out += '\n'; break; }
+      case 'r': { out += '\r'; break; }
+      case 't': { out += '\t'; break; }
+      case 'u': {
+        /* Paths are almost always ascii, so only the basic plane is decoded, into utf-8. */
+        if ((js.end - js.p) < 5 || sscanf((js.p + 1), "%4x", &code) != 1) {
+          return FALSE;
+        }
+        js.p += 4;
+        if (code < 0x80) {
+          out += (char)code;
+        }
+        else if (code < 0x800) {
+          out += (char)(0xC0 | (code >> 6));
+          out += (char)(0x80 | (code & 0x3F));
+        }
+        else {
+          out += (char)(0xE0 | (code >> 12));
+          out += (char)(0x80 | ((code >> 6) & 0x3F));
+          out += (char)(0x80 | (code & 0x3F));
+        }
+        break;
+      }
+      default: {
+        out += *js.p;
+        break;
+      }
+    }
+  }
+  if (js.p >= js.end) {
+    return FALSE;
+  }
+  ++js.p;
+  return TRUE;
+}
+
+/* Move past the value at the cursor, whatever it is.  Return`s 'FALSE' when it is malformed. */
+static bool project_json_skip(ProjectJson &js) {
+  string str;
+  char   close;
+  project_json_space(js);
+  if (js.p >= js.end) {
+    return FALSE;
+  }
+  else if (*js.p == '"') {
+    return project_json_string(js, str);
+  }
+  else if (*js.p == '[' || *js.p == '{') {
+    close = ((*js.p == '[') ? ']' : '}');
+    ++js.p;
+    if (project_json_take(js, close)) {
+      return TRUE;
+    }
+    do {
+      if (close == '}' && (!project_json_string(js, str) || !project_json_take(js, ':'))) {
+        return FALSE;
+      }
+      if (!project_json_skip(js)) {
+        return FALSE;
+      }
+    } while (project_json_take(js, ','));
+    return project_json_take(js, close);
+  }
+  /* A number, or 'true', 'false' or 'null'. */
+  while (js.p < js.end && *js.p != ',' && *js.p != ']' && *js.p != '}' && *js.p != ' ' && *js.p != '\n') {
+    ++js.p;
+  }
+  return TRUE;
+}
+
+/* Split a shell command into its arguments, the way the shell does for the quoting a compiler command uses. */
+static void project_split_command(const string &command, vector<string> &args) {
+  string arg;
+  bool   in_arg = FALSE;
+  char   quote  = '\0';
+  for (Ulong i = 0; i < command.size(); ++i) {
+    char c = command[i];
+    if (quote) {
+      if (c == quote) {
+        quote = '\0';
+      }
+      else if (c == '\\' && quote == '"' && (i + 1) < command.size()) {
+        arg += command[++i];
+      }
+      else {
+        arg += c;
+      }
+    }
+    else if (c == '\'' || c == '"') {
+      quote  = c;
+      in_arg = TRUE;
+    }
+    else if (c == '\\' && (i + 1) < command.size()) {
+      arg += command[++i];
+      in_arg = TRUE;
+    }
+    else if (c == ' ' || c == '\t' || c == '\n') {
+      if (in_arg) {
+        args.push_back(arg);
+        arg.clear();
+        in_arg = FALSE;
+      }
+    }
+    else {
+      arg += c;
+      in_arg = TRUE;
+    }
+  }
+  if (in_arg) {
+    args.push_back(arg);
+  }
+}
+
+/* Return`s the absolute form of 'path', which is relative to 'dir' unless it starts with a '/', or a empty string when it does not exist. */
+static string project_path(const string &dir, const string &path) {
+  string joined = ((path[0] == '/' || dir.empty()) ? path : (dir + "/" + path));
+  char  *absolute_path = abs_path(joined.c_str());
+  string ret;
+  if (absolute_path) {
+    ret = absolute_path;
+    free(absolute_path);
+  }
+  return ret;
+}
+
+/* Add every directory that 'args' gives to '-I', '-isystem' or '-idirafter' to 'dirs', unless it is already there. */
+static void project_add_include_dirs(const string &dir, const vector<string> &args, vector<string> &dirs) {
+  static const char *const flags[] = { "-I", "-isystem", "-idirafter" };
+  string include_dir;
+  for (Ulong i = 0; i < args.size(); ++i) {
+    include_dir.clear();
+    for (const char *flag : flags) {
+      Ulong len = strlen(flag);
+      if (args[i] == flag && (i + 1) < args.size()) {
+        include_dir = project_path(dir, args[++i]);
+        break;
+      }
+      else if (args[i].size() > len && args[i].compare(0, len, flag) == 0) {
+        include_dir = project_path(dir, args[i].substr(len));
+        break;
+      }
+    }
+    if (include_dir.empty()) {
+      continue;
+    }
+    bool known = FALSE;
+    for (const auto &it : dirs) {
+      if (it == include_dir) {
+        known = TRUE;
+        break;
+      }
+    }
+    if (!known) {
+      dirs.push_back(include_dir);
+    }
+  }
+}
+
+/* Read one entry of the compilation database at the cursor, and add its file to 'files' and its include directories to 'dirs'. */
+static bool project_json_entry(ProjectJson &js, vector<string> &files, vector<string> &dirs) {
+  string key;
+  string value;
+  string directory;
+  string file;
+  string command;
+  vector<string> args;
+  if (!project_json_take(js, '{')) {
+    return FALSE;
+  }
+  if (!project_json_take(js, '}')) {
+    do {
+      if (!project_json_string(js, key) || !project_json_take(js, ':')) {
+        return FALSE;
+      }
+      else if (key == "directory") {
+        if (!project_json_string(js, directory)) {
+          return FALSE;
+        }
+      }
+      else if (key == "file") {
+        if (!project_json_string(js, file)) {
+          return FALSE;
+        }
+      }
+      else if (key == "command") {
+        if (!project_json_string(js, command)) {
+          return FALSE;
+        }
+      }
+      else if (key == "arguments") {
+        if (!project_json_take(js, '[')) {
+          return FALSE;
+        }
+        if (!project_json_take(js, ']')) {
+          do {
+            if (!project_json_string(js, value)) {
+              return FALSE;
+            }
+            args.push_back(value);
+          } while (project_json_take(js, ','));
+          if (!project_json_take(js, ']')) {
+            return FALSE;
+          }
+        }
+      }
+      else if (!project_json_skip(js)) {
+        return FALSE;
+      }
+    } while (project_json_take(js, ','));
+    if (!project_json_take(js, '}')) {
+      return FALSE;
+    }
+  }
+  if (args.empty() && !command.empty()) {
+    project_split_command(command, args);
+  }
+  if (!file.empty() && !(file = project_path(directory, file)).empty()) {
+    files.push_back(file);
+  }
+  project_add_include_dirs(directory, args, dirs);
+  return TRUE;
+}
+
+/* Read the compilation database at 'path', adding the absolute path of every file in it to 'files', and every include
+ * directory they are compiled with to 'dirs'.  Return`s 'FALSE' when it could not be read, or is not a compilation database. */
+static bool project_read_compdb(const char *path, vector<string> &files, vector<string> &dirs) {
+  PROFILE_FUNCTION;
+  TRACE_FUNCTION;
+  FILE       *file;
+  long        len;
+  char       *data;
+  bool        ok;
+  ProjectJson js;
+  if (!(file = fopen(path, "rb"))) {
+    return FALSE;
+  }
+  if (fseek(file, 0, SEEK_END) != 0 || (len = ftell(file)) < 0 || fseek(file, 0, SEEK_SET) != 0) {
+    fclose(file);
+    return FALSE;
+  }
+  data = (char *)xmalloc(len + 1);
+  ok   = (fread(data, 1, len, file) == (Ulong)len);
+  fclose(file);
+  js.p   = data;
+  js.end = (data + len);
+  if (ok && (ok = project_json_take(js, '[')) && !project_json_take(js, ']')) {
+    do {
+      ok = project_json_entry(js, files, dirs);
+    } while (ok && project_json_take(js, ','));
+    ok = (ok && project_json_take(js, ']'));
+  }
+  free(data);
+  return ok;
+}
+
+/* ----------------------------- Directory walk ----------------------------- */
+
+/* Return`s 'TRUE' when 'name' is a c or c++ source file. */
+static bool project_is_source(const char *name) {
+  static const char *const exts[] = { ".c", ".cc", ".cpp", ".cxx", ".c++" };
+  const char *ext = strrchr(name, '.');
+  if (!ext) {
+    return FALSE;
+  }
+  for (const char *it : exts) {
+    if (strcmp(ext, it) == 0) {
+      return TRUE;
+    }
+  }
+  return FALSE;
+}
+
+/* Add every c and c++ source under 'dir' to 'files', up to 'PROJECT_MAX_FILES'.  Hidden directories are
+ * skipped, as that is where '.git' and most caches are, and a directory is listed before any below it. */
+void project_walk(const string &dir, vector<string> &files) {
+  DIR           *d;
+  struct dirent *entry;
+  vector<string> subdirs;
+  if (!(d = opendir(dir.c_str()))) {
+    return;
+  }
+  while ((entry = readdir(d)) && files.size() < PROJECT_MAX_FILES) {
+    if (*entry->d_name == '.') {
+      continue;
+    }
+    else if (entry->d_type == DT_DIR) {
+      subdirs.push_back(dir + "/" + entry->d_name);
+    }
+    else if (entry->d_type == DT_REG && project_is_source(entry->d_name)) {
+      files.push_back(dir + "/" + entry->d_name);
+    }
+  }
+  closedir(d);
+  for (const auto &it : subdirs) {
+    project_walk(it, files);
+  }
+}
+
+/* Return`s 'TRUE' when 'dir' may be walked as the root of a project.  The filesystem root and the home directory
+ * are never that, as a stray '.git' there would have us index everything below it. */
+static bool project_walkable(const string &dir) {
+  const char *home = getenv("HOME");
+  char *absolute_home;
+  bool  ret = TRUE;
+  if (dir.empty() || dir == "/") {
+    return FALSE;
+  }
+  if (home && *home && (absolute_home = abs_path(home))) {
+    ret = (dir != absolute_home);
+    free(absolute_home);
+  }
+  return ret;
+}
+
+/* Return`s the root of the project 'path' is in.  That is the closest directory above it with a 'compile_commands.json', directly or in
+ * 'build/', or else, when 'walk' is 'TRUE', the closest one with a '.git' that 'project_walkable()' allows.  The database is assigned to
+ * 'compdb', or a empty string when there is none.  Return`s a empty string when 'path' is in no project. */
+static string project_root(const char *path, string &compdb, bool walk) {
+  static const char *const compdb_names[] = { "/compile_commands.json", "/build/compile_commands.json" };
+  char  *absolute_path = abs_path(path);
+  string dir;
+  string git;
+  Ulong  slash;
+  compdb.clear();
+  if (!absolute_path) {
+    return git;
+  }
+  dir = absolute_path;
+  free(absolute_path);
+  /* At the filesystem root 'dir' is empty, so every name is still joined right. */
+  while ((slash = dir.rfind('/')) != string::npos) {
+    dir.resize(slash);
+    for (const char *name : compdb_names) {
+      if (file_exists((dir + name).c_str())) {
+        compdb = (dir + name);
+        return (dir.empty() ? string("/") : dir);
+      }
+    }
+    if (walk && git.empty() && file_exists((dir + "/.git").c_str()) && project_walkable(dir)) {
+      git = dir;
+    }
+  }
+  return git;
+}
+
+/* ----------------------------- Language server ----------------------------- */
+
+/* Index the project 'path' is in on the threadpool, the first time this is called for a file of that project.  This starts
+ * the indexing, and returns without waiting for it.  Return`s 'FALSE' when 'path' is in no project, or its project was indexed
+ * before.  A project whose database could not be read counts as not indexed, so it is tried again for the next file of it.
+ * 'path' itself is always part of the indexing, also when the compilation database does not list it. */
+bool LanguageServer::index_project(const char *path) {
+  PROFILE_FUNCTION;
+  TRACE_FUNCTION;
+  string compdb;
+  string root = project_root(path, compdb, ISSET(PROJECT_WALK));
+  vector<string> files;
+  vector<string> dirs;
+  bool walk = FALSE;
+  if (root.empty() || project_roots.find(root) != project_roots.end()) {
+    return FALSE;
+  }
+  files.push_back(path);
+  /* A database that cannot be read is only walked instead when that was asked for, as 'root' may then be far above any '.git'. */
+  if (compdb.empty() || !project_read_compdb(compdb.c_str(), files, dirs)) {
+    if (!ISSET(PROJECT_WALK) || !project_walkable(root)) {
+      statusline(AHEM, "Could not read '%s'", compdb.c_str());
+      return FALSE;
+    }
+    /* What was read before the database turned out broken is not trusted. */
+    files.resize(1);
+    dirs.clear();
+    walk = TRUE;
+  }
+  project_roots[root] = TRUE;
+  include_resolver_add_project_dirs(dirs);
+  if (walk) {
+    statusline(INFO, "Indexing project '%s'", root.c_str());
+  }
+  else {
+    statusline(INFO, "Indexing project '%s', %lu files", root.c_str(), files.size());
+  }
+  index_project_async(files, PROJECT_CPU_SHARE, (walk ? root.c_str() : NULL));
+  return TRUE;
+}
+
+/* Return`s 'TRUE' when a defenition of the 'len' bytes of 'name', as used on line 'at_line' of 'at_file', is in the shared index, and assigns
+ * the file it is in to 'file', and the line it starts on to 'line'.  A variable only counts when its scope is where the name is used, and then
+ * it shadows everything else.  After that come function defenitions, structs and last defines.  'file' points into the index, and is valid
+ * until it changes.  After 'index_project()', this covers every file of the project. */
+bool LanguageServer::find_definition(const char *name, Ulong len, const char *at_file, long at_line, const char **file, long *line) {
+  string key(name, len);
+  const auto &var = index.vars.find(key);
+  if (var != index.vars.end() && at_file) {
+    for (const auto &vd : var->second) {
+      if (at_line >= vd.decl_st && at_line <= vd.decl_end && strcmp(vd.file, at_file) == 0) {
+        *file = vd.file;
+        *line = vd.decl_st;
+        return TRUE;
+      }
+    }
+  }
+  const auto &fd = index.functiondefs.find(key);
+  if (fd != index.functiondefs.end()) {
+    *file = fd->second.file;
+    *line = fd->second.decl_st;
+    return TRUE;
+  }
+  const auto &st = index.structs.find(key);
+  if (st != index.structs.end()) {
+    *file = st->second.filename;
+    *line = st->second.decl_st;
+    return TRUE;
+  }
+  const auto &de = index.defines.find(key);
+  if (de != index.defines.end() && !de->second.file.empty()) {
+    *file = de->second.file.c_str();
+    *line = de->second.decl_start_line;
+    return TRUE;
+  }
+  return FALSE;
+}
+
+/* ----------------------------- Tests ----------------------------- */
+
+#define PROJECT_TEST_UNITS      (200)
+#define PROJECT_TEST_FUNCTIONS  (20)
+#define PROJECT_TEST_HEADERS    (40)
+
+/* `Internal`  Write a project into 'dir', with a source for every unit that includes one of the headers in 'include/', and a
+ * 'compile_commands.json' that gives that directory with '-I', half of the entries as a command and half as arguments. */
+static bool project_test_write(const char *dir) {
+  char  path[PATH_MAX];
+  FILE *file;
+  FILE *compdb;
+  snprintf(path, sizeof(path), "%s/include", dir);
+  if (mkdir(path, S_IRWXU) != 0) {
+    return FALSE;
+  }
+  snprintf(path, sizeof(path), "%s/src", dir);
+  if (mkdir(path, S_IRWXU) != 0) {
+    return FALSE;
+  }
+  for (int i=0; i<PROJECT_TEST_HEADERS; ++i) {
+    snprintf(path, sizeof(path), "%s/include/header_%d.h", dir, i);
+    if (!(file = fopen(path, "w"))) {
+      return FALSE;
+    }
+    fprintf(file, "#pragma once\n\n#define HEADER_%d_VALUE  (%d)\n\nstruct header_%d_struct {\n  int value;\n};\n", i, i, i);
+    fclose(file);
+  }
+  snprintf(path, sizeof(path), "%s/compile_commands.json", dir);
+  if (!(compdb = fopen(path, "w"))) {
+    return FALSE;
+  }
+  fprintf(compdb, "[\n");
+  for (int i=0; i<PROJECT_TEST_UNITS; ++i) {
+    snprintf(path, sizeof(path), "%s/src/tu_%d.c", dir, i);
+    if (!(file = fopen(path, "w"))) {
+      fclose(compdb);
+      return FALSE;
+    }
+    fprintf(file, "#include <header_%d.h>\n", (i % PROJECT_TEST_HEADERS));
+    for (int func=0; func<PROJECT_TEST_FUNCTIONS; ++func) {
+      fprintf(file, "\nint tu_%d_function_%d(int x) {\n  return (x + %d);\n}\n", i, func, func);
+    }
+    fclose(file);
+    if (i % 2) {
+      fprintf(compdb, "  {\"directory\": \"%s\", \"command\": \"cc -Iinclude -o src/tu_%d.o -c src/tu_%d.c\", \"file\": \"src/tu_%d.c\"}", dir, i, i, i);
+    }
+    else {
+      fprintf(compdb, "  {\"directory\": \"%s\", \"arguments\": [\"cc\", \"-I\", \"include\", \"-c\", \"src/tu_%d.c\"], \"file\": \"src/tu_%d.c\"}", dir, i, i);
+    }
+    fprintf(compdb, ((i + 1) < PROJECT_TEST_UNITS) ? ",\n" : "\n");
+  }
+  fprintf(compdb, "]\n");
+  fclose(compdb);
+  return TRUE;
+}
+
+/* `Internal`  Remove 'dir' and everything under it. */
+static void project_test_remove(const string &dir) {
+  struct dirent *entry;
+  DIR *d = opendir(dir.c_str());
+  if (d) {
+    while ((entry = readdir(d))) {
+      if (strcmp(entry->d_name, ".") != 0 && strcmp(entry->d_name, "..") != 0) {
+        if (entry->d_type == DT_DIR) {
+          project_test_remove(dir + "/" + entry->d_name);
+        }
+        else {
+          unlink((dir + "/" + entry->d_name).c_str());
+        }
+      }
+    }
+    closedir(d);
+  }
+  rmdir(dir.c_str());
+}
+
+/* `Internal`  Return`s a cursor over 'text'. */
+static ProjectJson project_test_json(const char *text) {
+  return { text, (text + strlen(text)) };
+}
+
+/* Check the parts of reading a 'compile_commands.json': the strings and values of the json, the splitting of a command the
+ * way the shell does, and the files and include directories taken from the entries. */
+void lsp_project_test(void) {
+  char dir[] = "/tmp/lsp_project_test_XXXXXX";
+  char path[PATH_MAX];
+  char text[PATH_MAX * 4];
+  string str;
+  vector<string> args;
+  vector<string> files;
+  vector<string> dirs;
+  ProjectJson js;
+  FILE *file;
+  /* Json strings, with every kind of escape, and the utf-8 of a '\u' escape. */
+  js = project_test_json(" \"a\\\\\\\"b\\n\\t\\/\\u0041\\u00e9\\u20ac\" ,");
+  ALWAYS_ASSERT(project_json_string(js, str));
+  ALWAYS_ASSERT(str == "a\\\"b\n\t/A\xC3\xA9\xE2\x82\xAC");
+  ALWAYS_ASSERT(project_json_take(js, ','));
+  js = project_test_json("\"not closed");
+  ALWAYS_ASSERT(!project_json_string(js, str));
+  js = project_test_json("\"\\u00\"");
+  ALWAYS_ASSERT(!project_json_string(js, str));
+  /* Skipping a value moves past all of it, however nested. */
+  js = project_test_json("{\"x\": [1, true, {\"y\": null}], \"z\": \"}\"} ]");
+  ALWAYS_ASSERT(project_json_skip(js));
+  ALWAYS_ASSERT(project_json_take(js, ']') && js.p == js.end);
+  js = project_test_json("[1, 2");
+  ALWAYS_ASSERT(!project_json_skip(js));
+  js = project_test_json("{\"x\" 1}");
+  ALWAYS_ASSERT(!project_json_skip(js));
+  /* Commands are split on blanks, except where quoted or escaped. */
+  project_split_command("  cc\t-DNAME=\"a b\" 'x \"y\"' a\\ b \"q\\\"x\" '' -c\nsrc/a.c ", args);
+  ALWAYS_ASSERT(args == vector<string>({ "cc", "-DNAME=a b", "x \"y\"", "a b", "q\"x", "", "-c", "src/a.c" }));
+  /* Entries give their file and include directories relative to their directory, from a command or from arguments. */
+  ALWAYS_ASSERT(mkdtemp(dir));
+  snprintf(path, sizeof(path), "%s/src", dir);
+  ALWAYS_ASSERT(mkdir(path, S_IRWXU) == 0);
+  snprintf(path, sizeof(path), "%s/compile_commands.json", dir);
+  ALWAYS_ASSERT((file = fopen(path, "w")));
+  fprintf(file,
+    "[\n"
+    "  {\"directory\": \"%s\", \"command\": \"cc -Iinclude -isystem '/usr/local/my include' -c src/a.c\", \"file\": \"src/a.c\", \"output\": \"a.o\"},\n"
+    "  {\"extra\": {\"list\": [1, 2]}, \"arguments\": [\"cc\", \"-I\", \"include\", \"-idirafter\", \"/opt/inc\", \"-c\", \"src/b.c\"], \"directory\": \"%s\", \"file\": \"src/b.c\"},\n"
+    "  {}\n"
+    "]\n", dir, dir);
+  fclose(file);
+  ALWAYS_ASSERT(project_read_compdb(path, files, dirs));
+  snprintf(text, sizeof(text), "%s/src/a.c", dir);
+  ALWAYS_ASSERT(files.size() == 2 && files[0] == text);
+  snprintf(text, sizeof(text), "%s/src/b.c", dir);
+  ALWAYS_ASSERT(files[1] == text);
+  snprintf(text, sizeof(text), "%s/include", dir);
+  ALWAYS_ASSERT(dirs == vector<string>({ text, "/usr/local/my include", "/opt/inc" }));
+  /* A database that does not end is not read. */
+  ALWAYS_ASSERT((file = fopen(path, "w")));
+  fprintf(file, "[{\"directory\": \"%s\", \"file\": \"src/a.c\"},", dir);
+  fclose(file);
+  files.clear();
+  dirs.clear();
+  ALWAYS_ASSERT(!project_read_compdb(path, files, dirs));
+  project_test_remove(dir);
+  writef("%s: Passed\n", __func__);
+}
+
+/* `Internal`  Write 'text' to the file 'name' under 'dir'.  Return`s 'FALSE' when it could not be written. */
+static bool project_test_file(const char *dir, const char *name, const char *text) {
+  char  path[PATH_MAX];
+  FILE *file;
+  snprintf(path, sizeof(path), "%s/%s", dir, name);
+  if (!(file = fopen(path, "w"))) {
+    return FALSE;
+  }
+  fputs(text, file);
+  fclose(file);
+  return TRUE;
+}
+
+/* `Internal`  Index the project 'path' is in, pumping the callback queue the way the main loop does.  Return`s what 'index_project()' did. */
+static bool project_test_index_project(const char *path) {
+  bool ret = LSP->index_project(path);
+  while (LSP->indexing()) {
+    prosses_callback_queue();
+    usleep(100);
+  }
+  return ret;
+}
+
+/* Check that a project whose 'compile_commands.json' could not be read is tried again once it can be, that with 'projectwalk' a broken
+ * database is walked instead, without anything that was read from it, and that the include directories of a project are kept when the
+ * next project is indexed. */
+void lsp_project_index_test(void) {
+  char  dir[] = "/tmp/lsp_project_test_XXXXXX";
+  char  path[PATH_MAX];
+  char  text[PATH_MAX * 2];
+  char *was_cache_dir = LSP->cache_dir;
+  bool  was_walk = ISSET(PROJECT_WALK);
+  char *found;
+  string db;
+  string git;
+  ALWAYS_ASSERT(mkdtemp(dir));
+  LSP->cache_dir = NULL;
+  UNSET(PROJECT_WALK);
+  /* The first project has a database that does not end. */
+  snprintf(path, sizeof(path), "%s/db", dir);
+  ALWAYS_ASSERT(mkdir(path, S_IRWXU) == 0);
+  db = project_path(string(), path);
+  ALWAYS_ASSERT(mkdir((db + "/include").c_str(), S_IRWXU) == 0);
+  ALWAYS_ASSERT(mkdir((db + "/src").c_str(), S_IRWXU) == 0);
+  ALWAYS_ASSERT(project_test_file(db.c_str(), "include/db_header.h", "#define DB_HEADER  (1)\n"));
+  ALWAYS_ASSERT(project_test_file(db.c_str(), "src/a.c", "int a_function(int x) {\n  return x;\n}\n"));
+  snprintf(text, sizeof(text), "[{\"directory\": \"%s\", \"command\": \"cc -Iinclude -c src/a.c\", \"file\": \"src/a.c\"}", db.c_str());
+  ALWAYS_ASSERT(project_test_file(db.c_str(), "compile_commands.json", text));
+  ALWAYS_ASSERT(!project_test_index_project((db + "/src/a.c").c_str()));
+  ALWAYS_ASSERT(project_roots.find(db) == project_roots.end());
+  /* Once it is fixed, the next file of the project indexes it, and only that once. */
+  snprintf(text, sizeof(text), "[{\"directory\": \"%s\", \"command\": \"cc -Iinclude -c src/a.c\", \"file\": \"src/a.c\"}]\n", db.c_str());
+  ALWAYS_ASSERT(project_test_file(db.c_str(), "compile_commands.json", text));
+  ALWAYS_ASSERT(project_test_index_project((db + "/src/a.c").c_str()));
+  ALWAYS_ASSERT(!project_test_index_project((db + "/src/a.c").c_str()));
+  ALWAYS_ASSERT((found = include_resolve("db_header.h")));
+  free(found);
+  /* The second project is a '.git' whose database does not end either, but lists a file and a include directory before that. */
+  snprintf(path, sizeof(path), "%s/git", dir);
+  ALWAYS_ASSERT(mkdir(path, S_IRWXU) == 0);
+  git = project_path(string(), path);
+  ALWAYS_ASSERT(mkdir((git + "/.git").c_str(), S_IRWXU) == 0);
+  ALWAYS_ASSERT(mkdir((git + "/partial").c_str(), S_IRWXU) == 0);
+  ALWAYS_ASSERT(mkdir((git + "/src").c_str(), S_IRWXU) == 0);
+  ALWAYS_ASSERT(mkdir((git + "/src/sub").c_str(), S_IRWXU) == 0);
+  ALWAYS_ASSERT(project_test_file(git.c_str(), "partial/partial_header.h", "#define PARTIAL_HEADER  (1)\n"));
+  ALWAYS_ASSERT(project_test_file(git.c_str(), "src/b.c", "int b_function(int x) {\n  return x;\n}\n"));
+  ALWAYS_ASSERT(project_test_file(git.c_str(), "src/sub/c.c", "int c_function(int x) {\n  return x;\n}\n"));
+  snprintf(text, sizeof(text), "[{\"directory\": \"%s\", \"command\": \"cc -Ipartial -c src/b.c\", \"file\": \"src/b.c\"},", git.c_str());
+  ALWAYS_ASSERT(project_test_file(git.c_str(), "compile_commands.json", text));
+  SET(PROJECT_WALK);
+  ALWAYS_ASSERT(project_test_index_project((git + "/src/b.c").c_str()));
+  /* The walk found what the database never listed, and nothing read from the database was used. */
+  ALWAYS_ASSERT(LSP->index.include.find(git + "/src/sub/c.c") != LSP->index.include.end());
+  ALWAYS_ASSERT(!(found = include_resolve("partial_header.h")));
+  /* The first project can still find its headers. */
+  ALWAYS_ASSERT((found = include_resolve("db_header.h")));
+  free(found);
+  LSP->index.delete_data();
+  symbols_changed();
+  include_resolver_set_project_dirs(vector<string>());
+  project_roots.erase(db);
+  project_roots.erase(git);
+  if (!was_walk) {
+    UNSET(PROJECT_WALK);
+  }
+  LSP->cache_dir = was_cache_dir;
+  project_test_remove(dir);
+  writef("%s: Passed\n", __func__);
+}
+
+/* `Internal`  Return`s the cpu time used by the process, in nano-seconds. */
+static Llong project_test_cpu_time(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+  return ((ts.tv_sec * 1000000000LL) + ts.tv_nsec);
+}
+
+/* `Internal`  Index 'files' with 'cpu_share', pumping the callback queue the way the main loop does.  Prints how much of a cpu was used. */
+static void project_test_index(const vector<string> &files, int cpu_share) {
+  Llong cpu = project_test_cpu_time();
+  LSP->index.delete_data();
+  symbols_changed();
+  timer_action(ms,
+    LSP->index_project_async(files, cpu_share);
+    while (LSP->indexing()) {
+      prosses_callback_queue();
+      usleep(100);
+    }
+  );
+  cpu = (project_test_cpu_time() - cpu);
+  writef("%s: Cpu share: %d%%: Files: %lu: Function defenitions: %lu: Structs: %lu in %.5f ms, using %.0f%% of a cpu\n", __func__, cpu_share,
+    LSP->index.include.size(), LSP->index.functiondefs.size(), LSP->index.structs.size(), (double)ms, ((cpu / 10000.0) / (double)ms));
+}
+
+/* Write a project with a 'compile_commands.json', read it, and index it with all of the cpus and then with half of them.  Last look
+ * up a function defenition and a struct from a header found through the '-I' of the database, the way going to a defenition does. */
+void lsp_project_test_bench(void) {
+  char  dir[] = "/tmp/lsp_project_test_XXXXXX";
+  char  path[PATH_MAX];
+  char *was_cache_dir = LSP->cache_dir;
+  const char *file;
+  long  line;
+  string root;
+  string compdb;
+  vector<string> files;
+  vector<string> dirs;
+  writef("\n");
+  if (!mkdtemp(dir)) {
+    writef("%s: Failed to create a directory\n\n", __func__);
+    return;
+  }
+  if (project_test_write(dir)) {
+    LSP->cache_dir = NULL;
+    snprintf(path, sizeof(path), "%s/src/tu_0.c", dir);
+    root = project_root(path, compdb, FALSE);
+    timer_action(read_ms,
+      project_read_compdb(compdb.c_str(), files, dirs);
+    );
+    writef("%s: Root: %s: Units: %lu: Include dirs: %lu: Read in %.5f ms\n", __func__, root.c_str(), files.size(), dirs.size(), (double)read_ms);
+    include_resolver_set_project_dirs(dirs);
+    project_test_index(files, 100);
+    project_test_index(files, 50);
+    for (const char *name : { "tu_7_function_3", "header_3_struct" }) {
+      if (LSP->find_definition(name, strlen(name), NULL, 0, &file, &line)) {
+        writef("%s: '%s': %s:%ld\n", __func__, name, file, line);
+      }
+      else {
+        writef("%s: '%s': Not found\n", __func__, name);
+      }
+    }
+    LSP->index.delete_data();
+    symbols_changed();
+    include_resolver_set_project_dirs(vector<string>());
+    LSP->cache_dir = was_cache_dir;
+  }
+  project_test_remove(dir);
+  writef("\n");
+}
@@ -0,0 +1,797 @@
+#include "../../include/prototypes.h"
+
+#include <algorithm>
+
+/* Incremental reindexing of open C/C++ files.  Every open file that gets edited is split into its top-level declarations,
+ * and every declaration remembers the entries in the shared index that parsing it produced.  Once edits settle, the file is
+ * split again and the declarations are matched to the old ones by a hash of their text.  A declaration that only moved gets its
+ * entries shifted in place, one that is gone gets its entries removed, and only new or changed ones are parsed again.  That
+ * parsing happens on the threadpool, on copies of the lines, and the results are merged by the main thread. */
+
+/* How long edits have to settle before a file is reindexed. */
+#define REINDEX_DEBOUNCE_NS  (250000000LL)
+
+enum IndexKeyKind {
+  INDEX_KEY_DEFINE,
+  INDEX_KEY_ENUM,
+  INDEX_KEY_TDSTRUCT,
+  INDEX_KEY_STRUCT,
+  INDEX_KEY_FUNCTIONDEF,
+  INDEX_KEY_VAR,
+};
+
+/* A entry in one of the maps of the shared index. */
+struct IndexKey {
+  IndexKeyKind kind;
+  string name;
+};
+
+/* One top-level declaration of a open file, and the entries in the shared index that parsing it produced. */
+struct IndexDecl {
+  Ulong hash;
+  long  start;
+  long  end;
+  vector<IndexKey> keys;
+};
+
+/* A declaration found when splitting a file.  When it has to be parsed, 'lines' is a copy of its lines. */
+struct ReindexChunk {
+  Ulong hash;
+  long  start;
+  long  end;
+  linestruct *top;
+  linestruct *lines;
+  Index      *result;
+};
+
+/* The declarations of one open file. */
+struct ReindexFile {
+  char *name = NULL;
+  vector<IndexDecl> decls; /* Sorted by line. */
+  bool  seeded = FALSE;    /* Whether the entries the file had before its first reindex were dropped, see 'reindex_drop_file()'. */
+  bool  dirty = FALSE;
+  bool  busy  = FALSE;
+  Llong last_edit = 0;
+};
+
+/* The declarations of a file that have to be parsed, this is what a task gets. */
+struct ReindexTask {
+  openfilestruct *file;
+  char *name;
+  vector<ReindexChunk> chunks;
+};
+
+/* Every open file that has been edited, this is only used from the main thread. */
+static unordered_map<openfilestruct *, ReindexFile> reindex_files;
+
+/* Return`s the current monotonic time in nano-seconds. */
+static Llong reindex_clock(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ((ts.tv_sec * 1000000000LL) + ts.tv_nsec);
+}
+
+/* Return`s 'TRUE' when 'file' is still one of the open buffers. */
+static bool reindex_file_is_open(openfilestruct *file) {
+  openfilestruct *f = openfile;
+  if (!f) {
+    return FALSE;
+  }
+  do {
+    if (f == file) {
+      return TRUE;
+    }
+    f = f->next;
+  } while (f != openfile);
+  return FALSE;
+}
+
+/* Split the lines from 'top' into top-level declarations.  A declaration ends on a line where no bracket or block comment is
+ * open, and that ends in ';' or '}', or that is a preprocessor line without a continuation.  Blank lines between declarations are
+ * skipped.  This only looks at the characters, so strings, character literals and comments are skipped for the bracket depth. */
+static void reindex_split(linestruct *top, vector<ReindexChunk> &chunks) {
+  ReindexChunk chunk;
+  const char *p;
+  int   depth      = 0;
+  bool  in_comment = FALSE;
+  bool  in_pp      = FALSE;
+  bool  blank;
+  char  last;
+  char  quote;
+  chunk.top = NULL;
+  FOR_EACH_LINE_NEXT(line, top) {
+    p     = line->data;
+    blank = TRUE;
+    last  = '\0';
+    for (; *p == ' ' || *p == '\t'; ++p);
+    if (!depth && !in_comment && *p == '#') {
+      in_pp = TRUE;
+    }
+    while (*p) {
+      if (in_comment) {
+        blank = FALSE;
+        if (*p == '*' && p[1] == '/') {
+          in_comment = FALSE;
+          ++p;
+        }
+      }
+      else if (*p == '/' && p[1] == '*') {
+        blank      = FALSE;
+        in_comment = TRUE;
+        ++p;
+      }
+      else if (*p == '/' && p[1] == '/') {
+        blank = FALSE;
+        break;
+      }
+      else if (*p == '"' || *p == '\'') {
+        quote = *p;
+        for (++p; *p && *p != quote; ++p) {
+          if (*p == '\\' && p[1]) {
+            ++p;
+          }
+        }
+        blank = FALSE;
+        last  = quote;
+        if (!*p) {
+          break;
+        }
+      }
+      else if (*p != ' ' && *p != '\t') {
+        if (*p == '{') {
+          ++depth;
+        }
+        else if (*p == '}' && depth) {
+          --depth;
+        }
+        blank = FALSE;
+        last  = *p;
+      }
+      ++p;
+    }
+    if (!chunk.top) {
+      if (blank) {
+        in_pp = FALSE;
+        continue;
+      }
+      chunk.top   = line;
+      chunk.start = line->lineno;
+      chunk.hash  = 0xcbf29ce484222325UL;
+    }
+    for (p=line->data; *p; ++p) {
+      chunk.hash = ((chunk.hash ^ (Uchar)*p) * 0x100000001b3UL);
+    }
+    chunk.hash = ((chunk.hash ^ '\n') * 0x100000001b3UL);
+    if (!depth && !in_comment && (blank || last == ';' || last == '}' || (in_pp && last != '\\'))) {
+      chunk.end    = line->lineno;
+      chunk.lines  = NULL;
+      chunk.result = NULL;
+      chunks.push_back(chunk);
+      chunk.top = NULL;
+      in_pp     = FALSE;
+    }
+  }
+  /* A declaration that runs until the end of the file. */
+  if (chunk.top) {
+    chunk.end    = chunk.top->lineno;
+    for (linestruct *line=chunk.top; line; line=line->next) {
+      chunk.end = line->lineno;
+    }
+    chunk.lines  = NULL;
+    chunk.result = NULL;
+    chunks.push_back(chunk);
+  }
+}
+
+/* Return`s a copy of 'count' lines from 'top', keeping their line numbers, so a sub-thread can parse them while the buffer is edited. */
+static linestruct *reindex_copy_lines(linestruct *top, long count) {
+  linestruct *head = NULL;
+  linestruct *tail = NULL;
+  for (linestruct *line=top; line && count--; line=line->next) {
+    tail         = make_new_node(tail);
+    tail->data   = copy_of(line->data);
+    tail->lineno = line->lineno;
+    if (!head) {
+      head = tail;
+    }
+    else {
+      tail->prev->next = tail;
+    }
+  }
+  return head;
+}
+
+/* Return`s the index of the declaration in 'decls' that 'lineno' lies within, or '-1' when there is none.  'decls' is sorted by line. */
+static long reindex_owner(const vector<IndexDecl> &decls, long lineno) {
+  long lo = 0;
+  long hi = decls.size();
+  long mid;
+  while (lo < hi) {
+    mid = ((lo + hi) / 2);
+    if (decls[mid].start <= lineno) {
+      lo = (mid + 1);
+    }
+    else {
+      hi = mid;
+    }
+  }
+  return ((lo && lineno <= decls[lo - 1].end) ? (lo - 1) : -1);
+}
+
+/* Return`s 'TRUE' when parsing 'decl' produced the entry 'name' of 'kind'. */
+static bool reindex_has_key(const IndexDecl &decl, IndexKeyKind kind, const string &name) {
+  for (const auto &key : decl.keys) {
+    if (key.kind == kind && key.name == name) {
+      return TRUE;
+    }
+  }
+  return FALSE;
+}
+
+/* Return`s the declaration in 'decls' that produced the entry 'name' of 'kind' of the file 'file', which starts at 'lineno', or '-1'. */
+static long reindex_entry_owner(const vector<IndexDecl> &decls, const char *name, const char *file, IndexKeyKind kind, const string &key, long lineno) {
+  long owner;
+  if (!file || strcmp(file, name) != 0 || (owner = reindex_owner(decls, lineno)) == -1 || !reindex_has_key(decls[owner], kind, key)) {
+    return -1;
+  }
+  return owner;
+}
+
+/* Move or remove the entries in the shared index that the old declarations 'decls' of the file 'name' produced.  When 'used[i]' is 'FALSE'
+ * the entries of declaration 'i' are removed, otherwise they are moved by 'delta[i]' lines.  Every entry is looked up by the line it had before
+ * any of them moved, so it is only ever moved once, also when a declaration moved by more then the gap to the next one. */
+static void reindex_update_entries(const char *name, const vector<IndexDecl> &decls, const vector<bool> &used, const vector<long> &delta) {
+  Index &index = LSP->index;
+  unordered_map<string, bool> done;
+  long owner;
+  for (Ulong i=0; i<decls.size(); ++i) {
+    if (used[i] && !delta[i]) {
+      continue;
+    }
+    for (const auto &key : decls[i].keys) {
+      /* These have no line, so they are only ever removed. */
+      if ((key.kind == INDEX_KEY_ENUM || key.kind == INDEX_KEY_TDSTRUCT) && used[i]) {
+        continue;
+      }
+      else if (!done.emplace((char)key.kind + key.name, TRUE).second) {
+        continue;
+      }
+      switch (key.kind) {
+        case INDEX_KEY_DEFINE: {
+          const auto &it = index.defines.find(key.name);
+          if (it == index.defines.end() || (owner = reindex_entry_owner(decls, name, it->second.file.c_str(), key.kind, key.name, it->second.decl_start_line)) == -1) {
+            break;
+          }
+          else if (used[owner]) {
+            it->second.decl_start_line += delta[owner];
+            it->second.decl_end_line   += delta[owner];
+          }
+          else {
+            free(it->second.name);
+            index.defines.erase(it);
+          }
+          break;
+        }
+        case INDEX_KEY_ENUM: {
+          const auto &it = index.enums.find(key.name);
+          if (it != index.enums.end()) {
+            free(it->second.name);
+            index.enums.erase(it);
+          }
+          break;
+        }
+        case INDEX_KEY_TDSTRUCT: {
+          const auto &it = index.tdstructs.find(key.name);
+          if (it != index.tdstructs.end()) {
+            free(it->second.name);
+            free(it->second.alias);
+            index.tdstructs.erase(it);
+          }
+          break;
+        }
+        case INDEX_KEY_STRUCT: {
+          const auto &it = index.structs.find(key.name);
+          if (it == index.structs.end() || (owner = reindex_entry_owner(decls, name, it->second.filename, key.kind, key.name, it->second.decl_st)) == -1) {
+            break;
+          }
+          else if (used[owner]) {
+            it->second.decl_st  += delta[owner];
+            it->second.decl_end += delta[owner];
+          }
+          else {
+            free(it->second.filename);
+            free(it->second.name);
+            index.structs.erase(it);
+          }
+          break;
+        }
+        case INDEX_KEY_FUNCTIONDEF: {
+          const auto &it = index.functiondefs.find(key.name);
+          if (it == index.functiondefs.end() || (owner = reindex_entry_owner(decls, name, it->second.file, key.kind, key.name, it->second.decl_st)) == -1) {
+            break;
+          }
+          else if (used[owner]) {
+            it->second.decl_st  += delta[owner];
+            it->second.decl_end += delta[owner];
+          }
+          else {
+            free(it->second.name);
+            free(it->second.file);
+            index.functiondefs.erase(it);
+          }
+          break;
+        }
+        case INDEX_KEY_VAR: {
+          const auto &it = index.vars.find(key.name);
+          if (it == index.vars.end()) {
+            break;
+          }
+          /* Compact the declarations in place, keeping the ones from other files and declarations. */
+          Ulong kept = 0;
+          for (Ulong v=0; v<it->second.size(); ++v) {
+            VarDecl &vd = it->second[v];
+            if ((owner = reindex_entry_owner(decls, name, vd.file, key.kind, key.name, vd.decl_st)) != -1) {
+              if (used[owner]) {
+                vd.decl_st  += delta[owner];
+                vd.decl_end += delta[owner];
+              }
+              else {
+                free(vd.file);
+                free(vd.type);
+                free(vd.name);
+                free(vd.value);
+                continue;
+              }
+            }
+            it->second[kept++] = vd;
+          }
+          it->second.resize(kept);
+          break;
+        }
+      }
+    }
+  }
+}
+
+/* Remove every entry of the file 'name' from the shared index.  The entries a file got when it was indexed as a whole belong to none of its
+ * declarations, so they could never be moved or removed, and parsing every declaration on the first reindex would add its variables a second
+ * time.  So they are dropped before the first reindex of a file.  Enums and typedef structs do not know their file, they get replaced by name. */
+static void reindex_drop_file(const char *name) {
+  Index &index = LSP->index;
+  for (auto it=index.defines.begin(); it!=index.defines.end();) {
+    if (it->second.file == name) {
+      symbol_changed(it->first.data(), it->first.size());
+      free(it->second.name);
+      it = index.defines.erase(it);
+    }
+    else {
+      ++it;
+    }
+  }
+  for (auto it=index.structs.begin(); it!=index.structs.end();) {
+    if (it->second.filename && strcmp(it->second.filename, name) == 0) {
+      symbol_changed(it->first.data(), it->first.size());
+      free(it->second.filename);
+      free(it->second.name);
+      it = index.structs.erase(it);
+    }
+    else {
+      ++it;
+    }
+  }
+  for (auto it=index.functiondefs.begin(); it!=index.functiondefs.end();) {
+    if (it->second.file && strcmp(it->second.file, name) == 0) {
+      symbol_changed(it->first.data(), it->first.size());
+      free(it->second.name);
+      free(it->second.file);
+      it = index.functiondefs.erase(it);
+    }
+    else {
+      ++it;
+    }
+  }
+  for (auto &[var, var_vec] : index.vars) {
+    Ulong kept = 0;
+    for (Ulong v=0; v<var_vec.size(); ++v) {
+      VarDecl &vd = var_vec[v];
+      if (vd.file && strcmp(vd.file, name) == 0) {
+        free(vd.file);
+        free(vd.type);
+        free(vd.name);
+        free(vd.value);
+        continue;
+      }
+      var_vec[kept++] = vd;
+    }
+    if (kept != var_vec.size()) {
+      symbol_changed(var.data(), var.size());
+      var_vec.resize(kept);
+    }
+  }
+}
+
+/* Return`s the keys of every entry in 'result', which is what parsing a single declaration produced. */
+static vector<IndexKey> reindex_keys_of(const Index *result) {
+  vector<IndexKey> keys;
+  for (const auto &[name, de] : result->defines) {
+    keys.push_back({INDEX_KEY_DEFINE, name});
+  }
+  for (const auto &[name, ee] : result->enums) {
+    keys.push_back({INDEX_KEY_ENUM, name});
+  }
+  for (const auto &[alias, tds] : result->tdstructs) {
+    keys.push_back({INDEX_KEY_TDSTRUCT, alias});
+  }
+  for (const auto &[name, ste] : result->structs) {
+    keys.push_back({INDEX_KEY_STRUCT, name});
+  }
+  for (const auto &[name, fd] : result->functiondefs) {
+    keys.push_back({INDEX_KEY_FUNCTIONDEF, name});
+  }
+  for (const auto &[name, var_vec] : result->vars) {
+    keys.push_back({INDEX_KEY_VAR, name});
+  }
+  return keys;
+}
+
+/* Split the lines from 'top' again, and match the declarations to the ones 'state' has by their hash.  Declarations that only moved get
+ * their entries shifted in place, ones that are gone get their entries removed from the shared index, and every new or changed one is copied
+ * into 'task'.  All matching is done before any entry is touched, so the entries are updated against the declarations as they were. */
+static void reindex_diff(ReindexFile &state, linestruct *top, ReindexTask *task) {
+  vector<ReindexChunk> chunks;
+  vector<IndexDecl> decls;
+  std::unordered_multimap<Ulong, Ulong> old_by_hash;
+  vector<bool> used(state.decls.size(), FALSE);
+  vector<long> delta(state.decls.size(), 0);
+  vector<Ulong> matched;
+  Ulong next = 0;
+  Ulong old;
+  /* Nothing is known about the declarations yet, so every one gets parsed, and what the file had before must go. */
+  if (!state.seeded) {
+    reindex_drop_file(state.name);
+    state.seeded = TRUE;
+  }
+  reindex_split(top, chunks);
+  matched.reserve(chunks.size());
+  for (auto &chunk : chunks) {
+    old = (Ulong)-1;
+    for (; next < state.decls.size() && used[next]; ++next);
+    /* Most declarations are still in the same order, so only look them up by hash once that is not the case. */
+    if (next < state.decls.size() && state.decls[next].hash == chunk.hash) {
+      old = next;
+    }
+    else {
+      if (old_by_hash.empty()) {
+        for (Ulong i=0; i<state.decls.size(); ++i) {
+          old_by_hash.emplace(state.decls[i].hash, i);
+        }
+      }
+      const auto &[first, last] = old_by_hash.equal_range(chunk.hash);
+      for (auto it=first; it!=last; ++it) {
+        if (!used[it->second]) {
+          old = it->second;
+          break;
+        }
+      }
+    }
+    if (old != (Ulong)-1) {
+      used[old]  = TRUE;
+      delta[old] = (chunk.start - state.decls[old].start);
+      matched.push_back(old);
+    }
+    else {
+      chunk.lines = reindex_copy_lines(chunk.top, (chunk.end - chunk.start + 1));
+      chunk.top   = NULL;
+      task->chunks.push_back(chunk);
+    }
+  }
+  reindex_update_entries(state.name, state.decls, used, delta);
+  /* Only the names whose entries were removed, and variables that moved, look different to the symbol table. */
+  for (Ulong i=0; i<state.decls.size(); ++i) {
+    for (const auto &key : state.decls[i].keys) {
+      if (!used[i] || (delta[i] && key.kind == INDEX_KEY_VAR)) {
+        symbol_changed(key.name.data(), key.name.size());
+      }
+    }
+  }
+  decls.reserve(matched.size());
+  for (Ulong i : matched) {
+    IndexDecl &decl = state.decls[i];
+    decl.start += delta[i];
+    decl.end   += delta[i];
+    decls.push_back(std::move(decl));
+  }
+  state.decls = std::move(decls);
+}
+
+/* The task a sub-thread performs, parsing every declaration of 'arg' into a index of its own. */
+static void *reindex_task(void *arg) {
+  ReindexTask *task = (ReindexTask *)arg;
+  ntrace_begin(__func__);
+  for (auto &chunk : task->chunks) {
+    chunk.result = new Index();
+    LSP->parse_into(chunk.result, task->name, chunk.lines, task->name);
+    free_lines(chunk.lines);
+    chunk.lines = NULL;
+  }
+  ntrace_end(__func__);
+  return task;
+}
+
+/* `Internal`  Merge what 'task' parsed into the shared index, and give 'state' the declarations. */
+static void reindex_merge(ReindexFile *state, ReindexTask *task) {
+  for (auto &chunk : task->chunks) {
+    if (state) {
+      IndexDecl decl;
+      decl.hash  = chunk.hash;
+      decl.start = chunk.start;
+      decl.end   = chunk.end;
+      decl.keys  = reindex_keys_of(chunk.result);
+      symbols_changed_in(*chunk.result);
+      LSP->index.merge(*chunk.result);
+      /* Keep the declarations sorted by line, the new ones are sorted already. */
+      auto pos = state->decls.begin();
+      for (; pos != state->decls.end() && pos->start < decl.start; ++pos);
+      state->decls.insert(pos, decl);
+    }
+    else {
+      chunk.result->delete_data();
+    }
+    delete chunk.result;
+  }
+  free(task->name);
+  delete task;
+}
+
+/* Runs on the main thread when a task is done.  When the file was closed in the meantime, the results are dropped. */
+static void on_reindex_done(void *arg) {
+  ReindexTask *task = (ReindexTask *)arg;
+  const auto &it = reindex_files.find(task->file);
+  ReindexFile *state = NULL;
+  if (it != reindex_files.end() && strcmp(it->second.name, task->name) == 0 && reindex_file_is_open(task->file)) {
+    state = &it->second;
+    state->busy = FALSE;
+  }
+  reindex_merge(state, task);
+}
+
+/* Remember that 'file' was edited, so it gets reindexed once edits settle.  This is cheap, as it is called for every edit. */
+void LanguageServer::note_edit(openfilestruct *file) {
+  if (!file->is_c_file && !file->is_cxx_file) {
+    return;
+  }
+  ReindexFile &state = reindex_files[file];
+  if (!state.name) {
+    state.name = abs_path(file->filename);
+    if (!state.name) {
+      state.name = copy_of(file->filename);
+    }
+  }
+  state.dirty     = TRUE;
+  state.last_edit = reindex_clock();
+}
+
+/* Start reindexing every edited file whose edits have settled, and that is not already being reindexed.  Called from the main loop. */
+void LanguageServer::process_edits(void) {
+  ReindexTask *task;
+  Llong now;
+  if (reindex_files.empty()) {
+    return;
+  }
+  now = reindex_clock();
+  for (auto it=reindex_files.begin(); it!=reindex_files.end();) {
+    ReindexFile &state = it->second;
+    /* The buffer was closed, so forget it.  What it added to the index stays. */
+    if (!state.busy && !reindex_file_is_open(it->first)) {
+      free(state.name);
+      it = reindex_files.erase(it);
+      continue;
+    }
+    if (state.dirty && !state.busy && (now - state.last_edit) >= REINDEX_DEBOUNCE_NS) {
+      PROFILE_FUNCTION;
+      TRACE_FUNCTION;
+      task = new ReindexTask();
+      task->file  = it->first;
+      task->name  = copy_of(state.name);
+      state.dirty = FALSE;
+      reindex_diff(state, it->first->filetop, task);
+      if (task->chunks.empty()) {
+        free(task->name);
+        delete task;
+      }
+      else {
+        state.busy = TRUE;
+        /* The entries of the changed declarations are already gone, so when the threadpool queue is full, parse them right here. */
+        if (!submit_task(reindex_task, task, NULL, on_reindex_done)) {
+          on_reindex_done(reindex_task(task));
+        }
+      }
+    }
+    ++it;
+  }
+}
+
+/* The C side only knows about edits, so this is what 'set_modified_for()' calls. */
+void lsp_note_edit(openfilestruct *const file) {
+  LSP->note_edit(file);
+}
+
+/* ----------------------------- Tests ----------------------------- */
+
+#define REINDEX_TEST_FUNCTIONS  (4000)
+
+/* `Internal`  Return`s a buffer of 'REINDEX_TEST_FUNCTIONS' small functions, each with a define and a comment above it. */
+static linestruct *reindex_test_buffer(void) {
+  char buffer[256];
+  linestruct *head = make_new_node(NULL);
+  linestruct *tail = head;
+  head->data = copy_of("#include <stdio.h>");
+  for (int i=0; i<REINDEX_TEST_FUNCTIONS; ++i) {
+    const char *lines[] = {
+      "",
+      "#define VALUE_%d  (%d)",
+      "",
+      "/* Return`s the value of function %d. */",
+      "static int function_%d(int arg) {",
+      "  int value = (arg + VALUE_%d);",
+      "  return value;",
+      "}",
+    };
+    for (const char *format : lines) {
+      snprintf(buffer, sizeof(buffer), format, i, i);
+      tail->next = make_new_node(tail);
+      tail       = tail->next;
+      tail->data = copy_of(buffer);
+    }
+  }
+  return head;
+}
+
+/* `Internal`  Return`s a buffer of the lines in 'text'. */
+static linestruct *reindex_test_lines(const char *text) {
+  linestruct *head = NULL;
+  linestruct *tail = NULL;
+  const char *end;
+  do {
+    end        = strchrnul(text, '\n');
+    tail       = make_new_node(tail);
+    tail->data = measured_copy(text, (end - text));
+    if (!head) {
+      head = tail;
+    }
+    else {
+      tail->prev->next = tail;
+    }
+    text = (end + 1);
+  } while (*end);
+  return head;
+}
+
+/* `Internal`  Diff 'head' against 'state' and merge the result, the same way a edit does, only with the parsing done in place. */
+static void reindex_test_pass(ReindexFile &state, linestruct *head) {
+  ReindexTask *task = new ReindexTask();
+  task->file = NULL;
+  task->name = copy_of(state.name);
+  reindex_diff(state, head, task);
+  reindex_merge(&state, (ReindexTask *)reindex_task(task));
+}
+
+/* `Internal`  Return`s the sorted start lines of every variable 'name' that 'file' has in the shared index. */
+static vector<long> reindex_test_var_lines(const char *name, const char *file) {
+  vector<long> lines;
+  const auto &it = LSP->index.vars.find(name);
+  if (it != LSP->index.vars.end()) {
+    for (const auto &vd : it->second) {
+      if (strcmp(vd.file, file) == 0) {
+        lines.push_back(vd.decl_st);
+      }
+    }
+  }
+  std::sort(lines.begin(), lines.end());
+  return lines;
+}
+
+/* Check that the entries of declarations that only moved end up at their new lines.  The first of three functions grows by more lines
+ * then the gap to the next one, so the old lines of the second one overlap the new lines of the first, and so on.  Every function has
+ * a parameter of the same name, which is the case where moving the declarations one at a time would move a entry twice.  Then check
+ * that the first reindex of a file that was indexed as a whole drops what a deleted function had, and adds no variable twice. */
+void lsp_reindex_test(void) {
+  ReindexFile state;
+  linestruct *head;
+  const char *before = (
+    "int first(int x) {\n  return x;\n}\n\n"
+    "int second(int x) {\n  return x;\n}\n\n"
+    "int third(int x) {\n  return x;\n}"
+  );
+  const char *after = (
+    "int first(int x) {\n  x += 1;\n  x += 1;\n  x += 1;\n  x += 1;\n  x += 1;\n  x += 1;\n  return x;\n}\n\n"
+    "int second(int x) {\n  return x;\n}\n\n"
+    "int third(int x) {\n  return x;\n}"
+  );
+  const char *deleted = (
+    "int first(int x) {\n  return x;\n}\n\n"
+    "int third(int x) {\n  return x;\n}"
+  );
+  Index initial;
+  state.name = copy_of("/tmp/reindex_test.c");
+  head = reindex_test_lines(before);
+  reindex_test_pass(state, head);
+  free_lines(head);
+  ALWAYS_ASSERT(state.decls.size() == 3);
+  ALWAYS_ASSERT(reindex_test_var_lines("x", state.name) == vector<long>({ 1, 5, 9 }));
+  head = reindex_test_lines(after);
+  reindex_test_pass(state, head);
+  free_lines(head);
+  ALWAYS_ASSERT(state.decls.size() == 3);
+  ALWAYS_ASSERT(state.decls[1].start == 11 && state.decls[1].end == 13);
+  ALWAYS_ASSERT(state.decls[2].start == 15 && state.decls[2].end == 17);
+  ALWAYS_ASSERT(LSP->index.functiondefs.find("second")->second.decl_st == 11);
+  ALWAYS_ASSERT(LSP->index.functiondefs.find("third")->second.decl_st == 15);
+  ALWAYS_ASSERT_MSG((reindex_test_var_lines("x", state.name) == vector<long>({ 1, 11, 15 })), "A moved variable was shifted more then once");
+  reindex_update_entries(state.name, state.decls, vector<bool>(state.decls.size(), FALSE), vector<long>(state.decls.size(), 0));
+  ALWAYS_ASSERT(reindex_test_var_lines("x", state.name).empty());
+  ALWAYS_ASSERT(LSP->index.functiondefs.find("second") == LSP->index.functiondefs.end());
+  free(state.name);
+  /* A file that was indexed as a whole, and whose second function was deleted before the first reindex. */
+  state = ReindexFile();
+  state.name = copy_of("/tmp/reindex_test_first.c");
+  head = reindex_test_lines(before);
+  LSP->parse_into(&initial, state.name, head, state.name);
+  LSP->index.merge(initial);
+  free_lines(head);
+  head = reindex_test_lines(deleted);
+  reindex_test_pass(state, head);
+  free_lines(head);
+  ALWAYS_ASSERT(state.decls.size() == 2);
+  ALWAYS_ASSERT_MSG((LSP->index.functiondefs.find("second") == LSP->index.functiondefs.end()), "A function deleted before the first reindex kept its entry");
+  ALWAYS_ASSERT(LSP->index.functiondefs.find("third")->second.decl_st == 5);
+  ALWAYS_ASSERT_MSG((reindex_test_var_lines("x", state.name) == vector<long>({ 1, 5 })), "The first reindex added the variables of the file again");
+  reindex_update_entries(state.name, state.decls, vector<bool>(state.decls.size(), FALSE), vector<long>(state.decls.size(), 0));
+  ALWAYS_ASSERT(reindex_test_var_lines("x", state.name).empty());
+  symbols_changed();
+  free(state.name);
+  writef("%s: Passed\n", __func__);
+}
+
+/* Measure splitting and matching a large buffer, first when nothing is known, and then after a edit to a single line, where only one
+ * declaration should be parsed again.  The parsing itself is done in place, so this measures what the main thread does on a edit. */
+void lsp_reindex_test_bench(void) {
+  ReindexFile state;
+  ReindexTask *task;
+  linestruct *head = reindex_test_buffer();
+  linestruct *line = head;
+  Ulong first_chunks;
+  Ulong edit_chunks;
+  Ulong decls;
+  state.name = copy_of("/tmp/reindex_test.c");
+  writef("\n");
+  task = new ReindexTask();
+  task->file = NULL;
+  task->name = copy_of(state.name);
+  timer_action(full_ms,
+    reindex_diff(state, head, task);
+  );
+  first_chunks = task->chunks.size();
+  reindex_merge(&state, (ReindexTask *)reindex_task(task));
+  /* Edit the body of the function in the middle of the buffer. */
+  for (long i=0; line && i<(1 + ((REINDEX_TEST_FUNCTIONS / 2) * 8) + 5); ++i, line=line->next);
+  line->data = free_and_assign(line->data, copy_of("  int value = (arg * 2);"));
+  task = new ReindexTask();
+  task->file = NULL;
+  task->name = copy_of(state.name);
+  timer_action(edit_ms,
+    reindex_diff(state, head, task);
+  );
+  edit_chunks = task->chunks.size();
+  reindex_merge(&state, (ReindexTask *)reindex_task(task));
+  decls = state.decls.size();
+  reindex_update_entries(state.name, state.decls, vector<bool>(decls, FALSE), vector<long>(decls, 0));
+  symbols_changed();
+  free(state.name);
+  free_lines(head);
+  writef(
+    "%s: Lines: %d: Declarations: %lu: Split and parse all: %lu in %.5f ms: After a edit: %lu to parse in %.5f ms\n",
+    __func__, ((REINDEX_TEST_FUNCTIONS * 8) + 1), decls, first_chunks, (double)full_ms, edit_chunks, (double)edit_ms
+  );
+  writef("\n");
+}
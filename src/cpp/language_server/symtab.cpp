@@ -0,0 +1,368 @@
+#include "../../include/prototypes.h"
+
+/* The symbol table the highlighter uses.  Every name is interned once, and gets a id, and all that is known about a name is kept
+ * in a single record indexed by that id.  So coloring a word is one probe into the interner, without building a 'std::string'.
+ * The records are built from 'test_map' and the shared index, and brought up to date on the first lookup after either of them changed,
+ * so everything that changes them has to call 'symbol_changed()' for the names it changed, or 'symbols_changed()' to have the whole table
+ * rebuilt.  All of this is only used from the main thread. */
+
+/* A slot in the interner table, 'id' is '0' when the slot is empty, so ids start at '1'. */
+struct InternSlot {
+  Uint hash;
+  Uint id;
+};
+
+/* The interner, the table is open addressing with linear probing, and its size is always a power of two. */
+static InternSlot   *intern_table = NULL;
+static Uint          intern_mask  = 0;
+static vector<char *> intern_strs  = {NULL};
+static vector<Uint>   intern_lens  = {0};
+
+/* Below these, changed names are always rebuilt one by one, and stale declarations in 'symbol_var_decls' are never worth a full rebuild. */
+#define SYMBOL_DIRTY_MIN        (256)
+#define SYMBOL_VAR_GARBAGE_MIN  (4096)
+
+/* The symbol records, indexed by interned id, and the variable declarations they refer to.  'symbols_dirty' holds the ids of the names
+ * that changed since the last lookup, and 'symbol_var_garbage' the number of declarations no record refers to anymore. */
+static vector<Symbol>    symbols;
+static vector<SymbolVar> symbol_var_decls;
+static vector<Uint>      symbols_dirty;
+static Ulong symbol_var_garbage = 0;
+static Ulong symbols_generation = 1;
+static Ulong symbols_built      = 0;
+
+/* Return`s the hash of 'len' bytes of 'str'. */
+static inline Uint intern_hash(const char *str, Ulong len) {
+  Uint hash = 0x811c9dc5U;
+  for (Ulong i=0; i<len; ++i) {
+    hash = ((hash ^ (Uchar)str[i]) * 0x01000193U);
+  }
+  return hash;
+}
+
+/* Return`s the slot of 'str', or the empty slot where it would go. */
+static inline InternSlot *intern_slot(const char *str, Ulong len, Uint hash) {
+  InternSlot *slot;
+  for (Uint i=(hash & intern_mask);; i=((i + 1) & intern_mask)) {
+    slot = &intern_table[i];
+    if (!slot->id || (slot->hash == hash && intern_lens[slot->id] == len && memcmp(intern_strs[slot->id], str, len) == 0)) {
+      return slot;
+    }
+  }
+}
+
+/* Double the size of the interner table, keeping every id. */
+static void intern_grow(void) {
+  InternSlot *old      = intern_table;
+  Uint        old_size = (intern_table ? (intern_mask + 1) : 0);
+  Uint        size     = (old_size ? (old_size * 2) : 1024);
+  intern_table = (InternSlot *)xmalloc(size * sizeof(InternSlot));
+  intern_mask  = (size - 1);
+  memset(intern_table, 0, (size * sizeof(InternSlot)));
+  for (Uint i=0; i<old_size; ++i) {
+    if (old[i].id) {
+      *intern_slot(intern_strs[old[i].id], intern_lens[old[i].id], old[i].hash) = old[i];
+    }
+  }
+  free(old);
+}
+
+/* Return`s the id of 'len' bytes of 'str', interning it when that has not been done yet.  Ids are never reused. */
+Uint intern(const char *str, Ulong len) {
+  InternSlot *slot;
+  Uint hash = intern_hash(str, len);
+  /* Keep the table at most half full. */
+  if (!intern_table || ((intern_strs.size() * 2) > intern_mask)) {
+    intern_grow();
+  }
+  slot = intern_slot(str, len, hash);
+  if (!slot->id) {
+    slot->hash = hash;
+    slot->id   = intern_strs.size();
+    intern_strs.push_back(measured_copy(str, len));
+    intern_lens.push_back(len);
+  }
+  return slot->id;
+}
+
+/* Return`s the id of 'len' bytes of 'str', or '0' when it was never interned. */
+Uint intern_find(const char *str, Ulong len) noexcept {
+  if (!intern_table) {
+    return 0;
+  }
+  return intern_slot(str, len, intern_hash(str, len))->id;
+}
+
+/* Return`s the string with 'id', or 'NULL' for a id that does not exist. */
+const char *interned(Uint id) noexcept {
+  return ((id && id < intern_strs.size()) ? intern_strs[id] : NULL);
+}
+
+/* Tell the symbol table that 'test_map' or the shared index has changed in ways too many to name, so it is rebuilt before the next lookup. */
+void symbols_changed(void) noexcept {
+  ++symbols_generation;
+}
+
+/* Tell the symbol table that what 'test_map' or the shared index know about the 'len' bytes of 'name' has changed.  Only the record
+ * of that name is built again before the next lookup, so this is what edits, and anything else that runs often, should call. */
+void symbol_changed(const char *name, Ulong len) {
+  symbols_dirty.push_back(intern(name, len));
+}
+
+/* Tell the symbol table that every name in 'index' is about to be merged into the shared index, or was just removed from it. */
+void symbols_changed_in(const Index &index) {
+  for (const auto &[name, de] : index.defines) {
+    symbol_changed(name.data(), name.size());
+  }
+  for (const auto &[name, ee] : index.enums) {
+    symbol_changed(name.data(), name.size());
+  }
+  for (const auto &[alias, tds] : index.tdstructs) {
+    symbol_changed(alias.data(), alias.size());
+  }
+  for (const auto &[name, ste] : index.structs) {
+    symbol_changed(name.data(), name.size());
+  }
+  for (const auto &[name, fd] : index.functiondefs) {
+    symbol_changed(name.data(), name.size());
+  }
+  for (const auto &[name, var_vec] : index.vars) {
+    symbol_changed(name.data(), name.size());
+  }
+}
+
+/* `Internal`  Return`s the record for 'name', interning it when needed. */
+static Symbol &symbol_for(const char *name, Ulong len) {
+  Uint id = intern(name, len);
+  if (id >= symbols.size()) {
+    symbols.resize(intern_strs.size(), Symbol());
+  }
+  return symbols[id];
+}
+
+/* `Internal`  Give 'sym' the color of a entry in 'test_map'. */
+static void symbol_set_syntax(Symbol &sym, const syntax_data_t &data) {
+  sym.kinds     |= SYMBOL_SYNTAX;
+  sym.color      = data.color;
+  sym.from_line  = data.from_line;
+  sym.to_line    = data.to_line;
+}
+
+/* `Internal`  Give 'sym' the declarations in 'var_vec'.  The file names are interned, as the index frees its own copies when a file is
+ * indexed again, and the records live until the next lookup. */
+static void symbol_set_vars(Symbol &sym, const MVector<VarDecl> &var_vec) {
+  const char *file;
+  sym.kinds |= SYMBOL_VAR;
+  sym.vars   = symbol_var_decls.size();
+  for (const auto &vd : var_vec) {
+    file = tail(vd.file);
+    symbol_var_decls.push_back({interned(intern(file, strlen(file))), vd.decl_st, vd.decl_end});
+  }
+  sym.nvars = (symbol_var_decls.size() - sym.vars);
+}
+
+/* Rebuild every record from 'test_map' and the shared index. */
+static void symbols_build(void) {
+  PROFILE_FUNCTION;
+  TRACE_FUNCTION;
+  const Index &index = LSP->index;
+  symbols.assign(symbols.size(), Symbol());
+  symbol_var_decls.clear();
+  symbol_var_garbage = 0;
+  symbols_dirty.clear();
+  for (const auto &[name, data] : test_map) {
+    symbol_set_syntax(symbol_for(name.data(), name.size()), data);
+  }
+  for (const auto &[name, var_vec] : index.vars) {
+    symbol_set_vars(symbol_for(name.data(), name.size()), var_vec);
+  }
+  for (const auto &[name, de] : index.defines) {
+    symbol_for(name.data(), name.size()).kinds |= SYMBOL_DEFINE;
+  }
+  for (const auto &[name, ee] : index.enums) {
+    symbol_for(name.data(), name.size()).kinds |= SYMBOL_ENUM;
+  }
+  for (const auto &[alias, tds] : index.tdstructs) {
+    symbol_for(alias.data(), alias.size()).kinds |= SYMBOL_TDSTRUCT;
+  }
+  for (const auto &[name, ste] : index.structs) {
+    symbol_for(name.data(), name.size()).kinds |= SYMBOL_STRUCT;
+  }
+  for (const auto &[name, fd] : index.functiondefs) {
+    symbol_for(name.data(), name.size()).kinds |= SYMBOL_FUNCTIONDEF;
+  }
+  symbols_built = symbols_generation;
+}
+
+/* `Internal`  Rebuild only the record with 'id' from 'test_map' and the shared index.  The declarations it had stay in
+ * 'symbol_var_decls' until the next full rebuild, and are counted so that happens once they make up half of it. */
+static void symbol_build(Uint id) {
+  const Index &index = LSP->index;
+  const string name(intern_strs[id], intern_lens[id]);
+  Symbol &sym = symbol_for(name.data(), name.size());
+  symbol_var_garbage += sym.nvars;
+  sym = Symbol();
+  if (auto it = test_map.find(name); it != test_map.end()) {
+    symbol_set_syntax(sym, it->second);
+  }
+  if (auto it = index.vars.find(name); it != index.vars.end()) {
+    symbol_set_vars(sym, it->second);
+  }
+  if (index.defines.find(name) != index.defines.end()) {
+    sym.kinds |= SYMBOL_DEFINE;
+  }
+  if (index.enums.find(name) != index.enums.end()) {
+    sym.kinds |= SYMBOL_ENUM;
+  }
+  if (index.tdstructs.find(name) != index.tdstructs.end()) {
+    sym.kinds |= SYMBOL_TDSTRUCT;
+  }
+  if (index.structs.find(name) != index.structs.end()) {
+    sym.kinds |= SYMBOL_STRUCT;
+  }
+  if (index.functiondefs.find(name) != index.functiondefs.end()) {
+    sym.kinds |= SYMBOL_FUNCTIONDEF;
+  }
+}
+
+/* `Internal`  Bring the records up to date before a lookup.  Only the names that changed are rebuilt, unless the whole table was changed,
+ * or so many names changed that probing each of them again costs more then walking every map once. */
+static void symbols_update(void) {
+  if (symbols_built != symbols_generation || (symbols_dirty.size() > SYMBOL_DIRTY_MIN && symbols_dirty.size() > (symbols.size() / 4))
+   || (symbol_var_garbage > SYMBOL_VAR_GARBAGE_MIN && (symbol_var_garbage * 2) > symbol_var_decls.size())) {
+    symbols_build();
+    return;
+  }
+  for (Uint id : symbols_dirty) {
+    symbol_build(id);
+  }
+  symbols_dirty.clear();
+}
+
+/* Return`s the record for 'len' bytes of 'str', or 'NULL' when the name is not known.  The record is valid until the next lookup. */
+const Symbol *symbol_lookup(const char *str, Ulong len) {
+  Uint id;
+  if (symbols_built != symbols_generation || !symbols_dirty.empty()) {
+    symbols_update();
+  }
+  id = intern_find(str, len);
+  if (!id || id >= symbols.size() || !symbols[id].kinds) {
+    return NULL;
+  }
+  return &symbols[id];
+}
+
+/* Return`s the variable declarations of 'symbol', there are 'symbol->nvars' of them. */
+const SymbolVar *symbol_vars(const Symbol *symbol) noexcept {
+  return (symbol_var_decls.data() + symbol->vars);
+}
+
+/* ----------------------------- Tests ----------------------------- */
+
+#define SYMTAB_TEST_NAMES   (20000)
+#define SYMTAB_TEST_WORDS   (200000)
+
+/* Check that changing single names only rebuilds their records, and that a record keeps the file name of a variable after the index
+ * freed its own copy, the way it does when a file is indexed again. */
+void symtab_test(void) {
+  Index &index = LSP->index;
+  const Symbol *sym;
+  Ulong built;
+  FunctionDef fd;
+  VarDecl vd;
+  index.delete_data();
+  symbols_changed();
+  ALWAYS_ASSERT(!symbol_lookup("symtab_test_function", strlen("symtab_test_function")));
+  built = symbols_built;
+  fd.file     = copy_of("/tmp/symtab_test.c");
+  fd.name     = copy_of("symtab_test_function");
+  fd.decl_st  = 1;
+  fd.decl_end = 3;
+  index.functiondefs[fd.name] = fd;
+  symbol_changed(fd.name, strlen(fd.name));
+  ALWAYS_ASSERT((sym = symbol_lookup("symtab_test_function", strlen("symtab_test_function"))) && sym->kinds == SYMBOL_FUNCTIONDEF);
+  memset(&vd, 0, sizeof(vd));
+  vd.file     = copy_of("/tmp/symtab_test.c");
+  vd.name     = copy_of("symtab_test_var");
+  vd.decl_st  = 5;
+  vd.decl_end = 9;
+  index.vars[vd.name].push_back(vd);
+  symbol_changed(vd.name, strlen(vd.name));
+  add_rm_color_map("symtab_test_word", {FG_VS_CODE_BLUE});
+  ALWAYS_ASSERT((sym = symbol_lookup("symtab_test_var", strlen("symtab_test_var"))) && sym->kinds == SYMBOL_VAR && sym->nvars == 1);
+  /* The index frees its own copy of the file name, the record must not have borrowed it. */
+  index.vars.erase(vd.name);
+  free(vd.file);
+  free(vd.name);
+  ALWAYS_ASSERT(strcmp(symbol_vars(sym)[0].file, "symtab_test.c") == 0);
+  ALWAYS_ASSERT(symbol_vars(sym)[0].decl_st == 5 && symbol_vars(sym)[0].decl_end == 9);
+  ALWAYS_ASSERT((sym = symbol_lookup("symtab_test_word", strlen("symtab_test_word"))) && sym->kinds == SYMBOL_SYNTAX && sym->color == FG_VS_CODE_BLUE);
+  /* Removing a name makes it unknown again. */
+  test_map.erase("symtab_test_word");
+  symbol_changed("symtab_test_word", strlen("symtab_test_word"));
+  symbol_changed("symtab_test_var", strlen("symtab_test_var"));
+  ALWAYS_ASSERT(!symbol_lookup("symtab_test_word", strlen("symtab_test_word")));
+  ALWAYS_ASSERT(symbol_lookup("symtab_test_function", strlen("symtab_test_function")));
+  ALWAYS_ASSERT_MSG((symbols_built == built), "Changing single names rebuilt the whole symbol table");
+  ALWAYS_ASSERT(!symbol_lookup("symtab_test_var", strlen("symtab_test_var")));
+  free(fd.file);
+  free(fd.name);
+  index.functiondefs.erase("symtab_test_function");
+  symbols_changed();
+  ALWAYS_ASSERT(!symbol_lookup("symtab_test_function", strlen("symtab_test_function")));
+  writef("%s: Passed\n", __func__);
+}
+
+/* Measure looking up words the way highlighting did before, in 'test_map' and each map of the shared index, against a single
+ * lookup in the symbol table.  Half of the words are known names and the other half are not, as is common in a line of code. */
+void symtab_test_bench(void) {
+  char buffer[64];
+  vector<char *> words;
+  Ulong hits[2] = {0, 0};
+  Index &index = LSP->index;
+  writef("\n");
+  index.delete_data();
+  for (int i=0; i<SYMTAB_TEST_NAMES; ++i) {
+    DefineEntry de;
+    FunctionDef fd;
+    snprintf(buffer, sizeof(buffer), "DEFINE_%d", i);
+    de.name = copy_of(buffer);
+    index.defines[buffer] = de;
+    snprintf(buffer, sizeof(buffer), "function_%d", i);
+    fd.name = copy_of(buffer);
+    fd.file = copy_of("test.c");
+    index.functiondefs[buffer] = fd;
+  }
+  symbols_changed();
+  for (int i=0; i<SYMTAB_TEST_WORDS; ++i) {
+    snprintf(buffer, sizeof(buffer), ((i % 2) ? "function_%d" : "word_%d"), (i % SYMTAB_TEST_NAMES));
+    words.push_back(copy_of(buffer));
+  }
+  /* Build the table first, so only lookups are measured. */
+  symbol_lookup("", 0);
+  timer_action(maps_ms,
+    for (const char *word : words) {
+      if (test_map.find(word) != test_map.end() || index.vars.find(word) != index.vars.end()
+       || index.defines.find(word) != index.defines.end() || index.enums.find(word) != index.enums.end()
+       || index.tdstructs.find(word) != index.tdstructs.end() || index.structs.find(word) != index.structs.end()
+       || index.functiondefs.find(word) != index.functiondefs.end()) {
+        ++hits[0];
+      }
+    }
+  );
+  timer_action(symtab_ms,
+    for (const char *word : words) {
+      if (symbol_lookup(word, strlen(word))) {
+        ++hits[1];
+      }
+    }
+  );
+  for (char *word : words) {
+    free(word);
+  }
+  index.delete_data();
+  symbols_changed();
+  writef("%s: Words: %d: Maps: %lu hits in %.5f ms: Symbol table: %lu hits in %.5f ms\n",
+    __func__, SYMTAB_TEST_WORDS, hits[0], (double)maps_ms, hits[1], (double)symtab_ms);
+  writef("\n");
+}
@@ -857,6 +857,9 @@ static void toggle_this(const int flag) {
   if (flag == NO_SYNTAX) {
     statusline(REMARK, "%s %s", _("Real-Time experimental syntax"), (enabled ? _("enabled") : _("disabled")));
   }
+  else if (flag == PERF_OVERLAY) {
+    statusline(REMARK, "%s %s", _("Performance overlay"), (enabled ? _("enabled") : _("disabled")));
+  }
   else {
     statusline(REMARK, "%s %s", _(epithet_of_flag(flag)), (enabled ? _("enabled") : _("disabled")));
   }
@@ -1042,7 +1045,7 @@ static int do_mouse(void) {
     else {
       go_forward_chunks(row_count, &openfile->current, &leftedge);
     }
-    openfile->current_x = actual_x(openfile->current->data, actual_last_column(leftedge, click_col));
+    openfile->current_x = line_actual_x(openfile->current, actual_last_column(leftedge, click_col));
     /* Clicking there where the cursor is toggles the mark. */
     if (!row_count && openfile->current_x == was_x) {
       do_mark();
@@ -1196,6 +1199,7 @@ static void process_a_keystroke(void) {
   functionptrtype  function;
   /* Read in a keystroke, and show the cursor while waiting. */
   input = get_kbinput(midwin, VISIBLE);
+  nperf_frame_begin();
   lastmessage = VACUUM;
   /* When the input is a window resize, do nothing. */
   if (input == KEY_WINCH) {
@@ -1382,8 +1386,15 @@ static void process_a_keystroke(void) {
   keep_mark = FALSE;
 }
 
+/* The gui loop is C, so this is what it calls every frame to merge what the threadpool finished, and start reindexing edited files. */
+void process_pending_callbacks(void) {
+  prosses_callback_queue();
+  LSP->process_edits();
+}
+
 static void tui_main_loop(void *arg) {
   prosses_callback_queue();
+  LSP->process_edits();
   confirm_margin();
   if (currmenu != MMAIN) {
     bottombars(MMAIN);
@@ -1417,8 +1428,18 @@ static void tui_main_loop(void *arg) {
   }
   errno = 0;
   focusing = TRUE;
+  /* The timings are drawn into their own window, so the update below writes only what changed in them. */
+  if (ISSET(PERF_OVERLAY)) {
+    nperf_report();
+  }
+  else {
+    nperf_report_hide();
+  }
+  /* Write only what changed in the windows this frame. */
+  nwindow_update();
   tui_curs_visible(TRUE);
   nfdwriter_flush(nfdwriter_stdout);
+  nperf_frame_end();
 }
 
 static _UNUSED void debug_key(int keycode, const Uchar *data, long len) {
@@ -1504,29 +1525,53 @@ static _UNUSED void debug_key(int keycode, const Uchar *data, long len) {
   nfdwriter_printf(nfdwriter_stdout, "\n");
 }
 
-static void tui_process_a_key_string(nevhandler *handler, const Uchar *data, long len) {
-  tui_curs_visible(FALSE);
-  shift_held = FALSE;
-  int keycode = parse_input_key(data, len, &shift_held);
-  // debug_key(keycode, data, len);
-  keybindaction action = keybind_get(keycode);
+/* Set when an input event did something, so we know to draw a new frame. */
+static bool tui_input_acted = FALSE;
+
+static void tui_process_input_event(const input_event *event, void *arg) {
+  keybindaction action;
+  linestruct *was_current;
+  Ulong was_x;
+  if (event->type == INPUT_EVENT_PASTE) {
+    paste_bulk((const char *)event->data, event->len);
+    tui_input_acted = TRUE;
+    return;
+  }
+  shift_held = event->shift;
+  action     = keybind_get(event->keycode);
   if (!action) {
-    tui_curs_visible(TRUE);
     return;
   }
-  linestruct *was_current = openfile->current;
-  Ulong       was_x       = openfile->current_x;
+  was_current = openfile->current;
+  was_x       = openfile->current_x;
   if (shift_held && !openfile->mark) {
     openfile->mark     = openfile->current;
     openfile->mark_x   = openfile->current_x;
     openfile->softmark = TRUE;
   }
-  action();
+  /* A held down key is run as many times as it repeated, but only drawn once. */
+  for (Ulong i=0; i<event->count; ++i) {
+    action();
+  }
   if (openfile->mark && openfile->softmark && !shift_held && (openfile->current != was_current || openfile->current_x != was_x || wanted_to_move(action)) && !keep_mark) {
     openfile->mark = NULL;
     refresh_needed = TRUE;
   }
   keep_mark = FALSE;
+  tui_input_acted = TRUE;
+}
+
+static void tui_process_a_key_string(nevhandler *handler, const Uchar *data, long len) {
+  nperf_frame_begin();
+  tui_curs_visible(FALSE);
+  shift_held      = FALSE;
+  tui_input_acted = FALSE;
+  input_feed(data, len, tui_process_input_event, NULL);
+  nperf_record(NPERF_INPUT, nperf_frame_started());
+  if (!tui_input_acted) {
+    tui_curs_visible(TRUE);
+    return;
+  }
   tui_main_loop(NULL);
 }
 
@@ -1541,6 +1586,8 @@ static void init_tui(void) {
   tui_clear_screen();
   tui_update_size();
   tui_set_curs_blink(FALSE);
+  /* Pastes then arrive as a single event, instead of as a lot of keys. */
+  tui_enable_bracketed_pastes();
   /* Set some key-binding actions. */
   keybind_add(TUI_KEY_UP,                0, do_up);
   keybind_add(TUI_KEY_DOWN,              0, do_down);
@@ -1577,6 +1624,8 @@ int main(int argc, char **argv) {
     NETLOGGERPTR->init(netlogger, 8080);
   }
   NETLOGGER.send_to_server("Starting NanoX.\n");
+  /* Collect frame and redraw timings when asked to dump them on exit. */
+  nperf_init();
   unix_socket_connect(UNIX_DOMAIN_SOCKET_PATH);
   unix_socket_debug("Hello unix domain socket.\n");
   atexit([] {
@@ -2179,6 +2228,7 @@ int main(int argc, char **argv) {
   /* This is the main loop of the cli-editor. */
   while (TRUE) {
     prosses_callback_queue();
+    LSP->process_edits();
     confirm_margin();
     if (on_a_vt && waiting_keycodes() == 0) {
       mute_modifiers = FALSE;
@@ -2204,8 +2254,11 @@ int main(int argc, char **argv) {
       }
     }
     else {
-      /* Update the displayed current cursor position only when there is no message and no keys are waiting in the input buffer. */
-      if (ISSET(CONSTANT_SHOW) && lastmessage == VACUUM && LINES > 1 && !ISSET(ZERO) && !waiting_keycodes()) {
+      /* Update the displayed timings or the current cursor position only when there is no message and no keys are waiting in the input buffer. */
+      if (ISSET(PERF_OVERLAY) && lastmessage == VACUUM && LINES > 1 && !ISSET(ZERO) && !waiting_keycodes()) {
+        nperf_report();
+      }
+      else if (ISSET(CONSTANT_SHOW) && lastmessage == VACUUM && LINES > 1 && !ISSET(ZERO) && !waiting_keycodes()) {
         report_cursor_position();
       }
     }
@@ -2233,8 +2286,11 @@ int main(int argc, char **argv) {
     focusing = TRUE;
     /* Forget any earlier cursor position at the prompt. */
     put_cursor_at_end_of_answer();
+    /* The screen is up to date, so the frame of the last keystroke ends here. */
+    nperf_frame_end();
     /* Read in and interpret a single keystroke. */
     process_a_keystroke();
+    nperf_record(NPERF_INPUT, nperf_frame_started());
   }
   cleanup_event_handler();
   shutdown_queue();
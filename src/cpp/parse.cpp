@@ -247,4 +247,5 @@ void parse_class_data(linestruct *from) {
     line_variable(line, class_info.variables);
   }
   test_map[class_info.name] = {FG_VS_CODE_GREEN};
+  symbol_changed(class_info.name.data(), class_info.name.size());
 }
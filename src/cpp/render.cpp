@@ -10,20 +10,24 @@ static Ulong       convert_len = 0;
 static linestruct *line        = NULL;
 static Ulong       from_col    = 0;
 
+/* The tokens of the c/c++ line being rendered, the buffer is kept between lines so tokenizing does not allocate. */
+static CTokenBuf line_tokens = {NULL, 0, 0};
+
 unordered_map<string, syntax_data_t> test_map;
 
 static void render_part(Ulong match_start, Ulong match_end, short color) {
   PROFILE_FUNCTION;
+  TRACE_FUNCTION;
   const char *thetext = NULL;
   int paintlen = 0, start_col = 0;
   if ((match_start >= till_x)) {
     return;
   }
   if (match_start > from_x) {
-    start_col = (int)(wideness(line->data, match_start) - from_col);
+    start_col = (int)(line_wideness(line, match_start) - from_col);
   }
   thetext  = (converted + actual_x(converted, start_col));
-  paintlen = (int)actual_x(thetext, (wideness(line->data, match_end) - from_col - start_col));
+  paintlen = (int)actual_x(thetext, (line_wideness(line, match_end) - from_col - start_col));
   nanox_wcoloron(midwin, color);
   nanox_mvwaddnstr(midwin, row, (margin + start_col), thetext, paintlen);
   nanox_wcoloroff(midwin, color);
@@ -49,6 +53,7 @@ static void render_part(Ulong match_start, Ulong match_end, short color) {
 /* Render the text of a given line.  Note that this function only renders the text and nothing else. */
 void render_line_text(int editrow, const char *str, linestruct *editline, Ulong from_editcol) _NOTHROW {
   PROFILE_FUNCTION;
+  TRACE_FUNCTION;
   if (margin > 0) {
     nanox_wcoloron(midwin, config->linenumber.color);
     if (ISSET(SOFTWRAP) && from_editcol) {
@@ -118,11 +123,11 @@ static void render_comment(void) {
     /* Highlight the block start if prev line is in a block comment or the start of a block comment. */
     if (line->prev && (line->prev->is_in_block_comment || line->prev->is_block_comment_start) /* line->prev && (line->prev->flags.is_set<IN_BLOCK_COMMENT>() || line->prev->flags.is_set<BLOCK_COMMENT_START>()) */) {
       if ((end - line->data) > 0 && line->data[(end - line->data) - 1] != '/') {
-        midwin_mv_add_nstr_color(row, (wideness(line->data, (start - line->data)) + margin), start, 2, ERROR_MESSAGE);
+        midwin_mv_add_nstr_color(row, (line_wideness(line, (start - line->data)) + margin), start, 2, ERROR_MESSAGE);
         /* If there is a slash comment infront the block comment. Then of cource we still color
          * the text from the slash to the block start after we error highlight the block start. */
         if (slash && (slash - line->data) < (start - line->data)) {
-          midwin_mv_add_nstr_color(row, (wideness(line->data, (slash - line->data))) + margin, slash, (start - line->data) - (slash - line->data), FG_GREEN);
+          midwin_mv_add_nstr_color(row, (line_wideness(line, (slash - line->data))) + margin, slash, (start - line->data) - (slash - line->data), FG_GREEN);
         }
         block_comment_start += (start - line->data) + 2;
       }
@@ -267,17 +272,15 @@ static void render_comment(void) {
   refresh_needed = TRUE;
 }
 
-/* Color brackets based on indent. */
+/* Color the brackets in the tokens of the current line based on indent. */
 static void render_bracket(void) {
-  const char *found = line->data;
-  do {
-    const char *const arr[] = {"{", "}", "[", "]", "(", ")"};
-    found = strstr_array(found, (const char **)arr, 6, NULL);
-    if (found) {
+  const char *found;
+  for (Ulong i=0; i<line_tokens.len; ++i) {
+    if (line_tokens.tokens[i].kind == CTOKEN_BRACKET) {
+      found = (line->data + line_tokens.tokens[i].offset);
       RENDR(R_LEN, color_bi[((*found == '{' || *found == '}') ? line_indent(line) : line_indent(line) + 1) % 3], found, 1);
-      ++found;
     }
-  } while (found && *found);
+  }
 }
 
 // void render_parents(void) {
@@ -356,6 +359,7 @@ static void rendr_define(Uint index) {
   string define_name(start, (end - start));
   if (test_map.find(define_name) == test_map.end()) {
     test_map[define_name] = {FG_VS_CODE_BLUE};
+    symbol_changed(define_name.data(), define_name.size());
   }
   vector<string> params {};
   /* Handle macro parameter list.  If there is one. */
@@ -439,6 +443,7 @@ static void rendr_define(Uint index) {
             end_lineno,
             DEFINE_PARAM_SYNTAX,
           };
+          symbol_changed(params[i].data(), params[i].size());
         }
       }
     }
@@ -816,86 +821,69 @@ static void render_control_statements(Ulong index) {
 void
 apply_syntax_to_line(const int inrow, const char *inconverted, linestruct *in_line, Ulong infrom_col) {
   PROFILE_FUNCTION;
+  TRACE_FUNCTION;
   row       = inrow;
   converted = inconverted;
   line      = in_line;
   from_col  = infrom_col;
   if (/* openfile->type.is_set<C_CPP>() */ openfile->is_c_file || openfile->is_cxx_file) {
+    /* Tokenize the line once, starting inside a block comment when the previous line ends in one. */
+    ctoken_line(&line_tokens, in_line->data, till_x, ((in_line->prev && (in_line->prev->is_in_block_comment || in_line->prev->is_block_comment_start)) ? CTOKEN_STATE_COMMENT : CTOKEN_STATE_NONE));
     render_bracket();
     render_comment();
     if (!in_line->data[0] || (block_comment_start == 0 && block_comment_end == till_x)) {
       return;
     }
-    line_word_t *head = get_line_words(in_line->data, till_x);
-    while (head) {
-      line_word_t *node = head;
-      head              = node->next;
-      if (node->start >= block_comment_start && node->end <= block_comment_end) {
-        free_node(node);
+    for (Ulong i=0; i<line_tokens.len; ++i) {
+      const CToken *tok = &line_tokens.tokens[i];
+      if (tok->kind != CTOKEN_WORD || (tok->offset >= block_comment_start && (tok->offset + tok->len) <= block_comment_end)) {
         continue;
       }
-      const auto &it = test_map.find(node->str);
-      if (it != test_map.end()) {
-        if (it->second.from_line != -1) {
-          if (in_line->lineno >= it->second.from_line && in_line->lineno <= it->second.to_line) {
-            if (in_line->lineno == it->second.to_line) {
+      /* One lookup tells us everything about the word. */
+      const char   *str = (in_line->data + tok->offset);
+      const Symbol *sym = symbol_lookup(str, tok->len);
+      if (!sym) {
+        continue;
+      }
+      const Ulong col = (line_wideness(in_line, tok->offset) + margin);
+      if (sym->kinds & SYMBOL_SYNTAX) {
+        if (sym->from_line != -1) {
+          if (in_line->lineno >= sym->from_line && in_line->lineno <= sym->to_line) {
+            if (in_line->lineno == sym->to_line) {
               const char *bracket = strchr(in_line->data, '}');
-              if (bracket && node->start > (bracket - in_line->data)) {
-                free_node(node);
+              if (bracket && tok->offset > (Ulong)(bracket - in_line->data)) {
                 continue;
               }
             }
-            midwin_mv_add_nstr_color(inrow, get_start_col(in_line, node), node->str, node->len, it->second.color);
+            midwin_mv_add_nstr_color(inrow, col, str, tok->len, sym->color);
           }
         }
         else {
-          midwin_mv_add_nstr_color(inrow, get_start_col(in_line, node), node->str, node->len, it->second.color);
-          if (it->second.color == FG_VS_CODE_BRIGHT_MAGENTA) {
-            render_control_statements(node->start);
+          midwin_mv_add_nstr_color(inrow, col, str, tok->len, sym->color);
+          if (sym->color == FG_VS_CODE_BRIGHT_MAGENTA) {
+            render_control_statements(tok->offset);
           }
         }
       }
-      const auto &is_var = LSP->index.vars.find(node->str);
-      if (is_var != LSP->index.vars.end()) {
-        for (const auto &v : is_var->second) {
-          if (strcmp(tail(v.file), tail(openfile->filename)) == 0) {
-            if (in_line->lineno >= v.decl_st && in_line->lineno <= v.decl_end) {
-              midwin_mv_add_nstr_color(inrow, get_start_col(in_line, node), node->str, node->len, FG_VS_CODE_BRIGHT_CYAN);
+      if (sym->kinds & SYMBOL_VAR) {
+        const SymbolVar *vars = symbol_vars(sym);
+        for (Uint v = 0; v < sym->nvars; ++v) {
+          if (strcmp(vars[v].file, tail(openfile->filename)) == 0) {
+            if (in_line->lineno >= vars[v].decl_st && in_line->lineno <= vars[v].decl_end) {
+              midwin_mv_add_nstr_color(inrow, col, str, tok->len, FG_VS_CODE_BRIGHT_CYAN);
             }
           }
         }
       }
-      const auto &macro = LSP->index.defines.find(node->str);
-      if (macro != LSP->index.defines.end()) {
-        midwin_mv_add_nstr_color(inrow, get_start_col(in_line, node), node->str, node->len, FG_VS_CODE_BLUE);
-        free_node(node);
-        continue;
-      }
-      const auto &is_enum = LSP->index.enums.find(node->str);
-      if (is_enum != LSP->index.enums.end()) {
-        midwin_mv_add_nstr_color(inrow, get_start_col(in_line, node), node->str, node->len, FG_VS_CODE_GREEN);
-        free_node(node);
-        continue;
-      }
-      const auto &tdsc = LSP->index.tdstructs.find(node->str);
-      if (tdsc != LSP->index.tdstructs.end()) {
-        midwin_mv_add_nstr_color(inrow, get_start_col(in_line, node), node->str, node->len, FG_VS_CODE_GREEN);
-        free_node(node);
-        continue;
+      if (sym->kinds & SYMBOL_DEFINE) {
+        midwin_mv_add_nstr_color(inrow, col, str, tok->len, FG_VS_CODE_BLUE);
       }
-      const auto &is_struct = LSP->index.structs.find(node->str);
-      if (is_struct != LSP->index.structs.end()) {
-        midwin_mv_add_nstr_color(inrow, get_start_col(in_line, node), node->str, node->len, FG_VS_CODE_GREEN);
-        free_node(node);
-        continue;
+      else if (sym->kinds & (SYMBOL_ENUM | SYMBOL_TDSTRUCT | SYMBOL_STRUCT)) {
+        midwin_mv_add_nstr_color(inrow, col, str, tok->len, FG_VS_CODE_GREEN);
       }
-      const auto &is_fd = LSP->index.functiondefs.find(node->str);
-      if (is_fd != LSP->index.functiondefs.end()) {
-        midwin_mv_add_nstr_color(inrow, get_start_col(in_line, node), node->str, node->len, FG_VS_CODE_BRIGHT_YELLOW);
-        free_node(node);
-        continue;
+      else if (sym->kinds & SYMBOL_FUNCTIONDEF) {
+        midwin_mv_add_nstr_color(inrow, col, str, tok->len, FG_VS_CODE_BRIGHT_YELLOW);
       }
-      free_node(node);
     }
     if (in_line->data[indent_char_len(in_line)] == '#') {
       render_preprossesor();
@@ -941,7 +929,7 @@ apply_syntax_to_line(const int inrow, const char *inconverted, linestruct *in_li
     const char *comment = strchr(inconverted, '#');
     if (comment) {
       if (!is_prev_char(inconverted, (comment - inconverted), '$')) {
-        render_part(actual_x(in_line->data, (comment - inconverted)), ((comment - inconverted) + (convert_len - (comment - inconverted))), FG_COMMENT_GREEN);
+        render_part(line_actual_x(in_line, (comment - inconverted)), ((comment - inconverted) + (convert_len - (comment - inconverted))), FG_COMMENT_GREEN);
       }
       else {
         comment = NULL;
@@ -985,30 +973,26 @@ apply_syntax_to_line(const int inrow, const char *inconverted, linestruct *in_li
       /* Assign head to node, and assign head to the next word. */
       line_word_t *node = head;
       head              = node->next;
-      /* Search the syntax map for the word. */
-      const auto &it = test_map.find(node->str);
-      if (it != test_map.end()) {
-        /* If found use the map element to fetch the color. */
-        mv_add_nstr_color(midwin, inrow, get_start_col(in_line, node), it->first.c_str(), it->first.length(), it->second.color);
+      /* Search the symbol table for the word. */
+      const Symbol *sym = symbol_lookup(node->str, node->len);
+      if (sym && (sym->kinds & SYMBOL_SYNTAX)) {
+        /* If found use the symbol to fetch the color. */
+        mv_add_nstr_color(midwin, inrow, get_start_col(in_line, node), node->str, node->len, sym->color);
         free_node(node);
         continue;
       }
       /* Function defenitions. */
-      const auto &func_decl = LSP->index.functiondefs.find(node->str);
-      if (func_decl != LSP->index.functiondefs.end()) {
-        const auto &[name, data] = *func_decl;
-        /* If found use the map element to fetch the color. */
-        mv_add_nstr_color(midwin, inrow, get_start_col(in_line, node), name.c_str(), name.length(), FG_VS_CODE_BRIGHT_YELLOW);
+      if (sym && (sym->kinds & SYMBOL_FUNCTIONDEF)) {
+        mv_add_nstr_color(midwin, inrow, get_start_col(in_line, node), node->str, node->len, FG_VS_CODE_BRIGHT_YELLOW);
         free_node(node);
         continue;
       }
       /* Vars. */
-      const auto &var = LSP->index.vars.find(node->str);
-      if (var != LSP->index.vars.end()) {
-        const auto &[name, vector] = *var;
-        for (const auto &v : vector) {
-          if (in_line->lineno >= v.decl_st && in_line->lineno <= v.decl_end) {
-            mv_add_nstr_color(midwin, inrow, get_start_col(in_line, node), name.c_str(), name.length(), FG_VS_CODE_BRIGHT_CYAN);
+      if (sym && (sym->kinds & SYMBOL_VAR)) {
+        const SymbolVar *vars = symbol_vars(sym);
+        for (Uint i = 0; i < sym->nvars; ++i) {
+          if (in_line->lineno >= vars[i].decl_st && in_line->lineno <= vars[i].decl_end) {
+            mv_add_nstr_color(midwin, inrow, get_start_col(in_line, node), node->str, node->len, FG_VS_CODE_BRIGHT_CYAN);
           }
         }
       }
@@ -64,13 +64,13 @@ RendrEngine *RendrEngine::instance(void) noexcept {
 
 void RendrEngine::whole_editwin(void) {
   PROFILE_FUNCTION;
+  TRACE_FUNCTION;
   int         row  = 0;
   linestruct *line = openfile->edittop;
   while (row < editwinrows && line) {
-    char *converted = display_string(line->data, 0, editwincols, true, false);
-    Ulong from_col = get_page_start(wideness(line->data, (line == openfile->current) ? openfile->current_x : 0), editwincols);
+    const char *converted = display_string_row(row, line->data, line, 0, editwincols, true, false, NULL);
+    Ulong from_col = get_page_start(line_wideness(line, (line == openfile->current) ? openfile->current_x : 0), editwincols);
     render_line_text(row, converted, line, from_col);
-    free(converted);
     line = line->next;
     ++row;
   }
@@ -213,4 +213,5 @@ void add_rm_color_map(string str, syntax_data_t data) {
     test_map.erase(str);
   }
   test_map[str] = data;
+  symbol_changed(str.data(), str.size());
 }
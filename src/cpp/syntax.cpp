@@ -465,6 +465,8 @@ void syntax_check_file(openfilestruct *file) {
         set_bash_synx(file);
       }
     }
+    /* The syntax added to 'test_map' has to be seen by the symbol table. */
+    symbols_changed();
   }
 }
 
@@ -202,6 +202,7 @@ struct main_thread_function {
 
   static void on_find_file_in_dir(void *arg) {
     PROFILE_FUNCTION;
+    TRACE_FUNCTION;
     dir_search_task_t *result = (dir_search_task_t *)arg;
     if (result->found == TRUE) {
       pause_sub_threads_guard_t pause_guard;
@@ -243,5 +244,7 @@ struct task_creator {
 
 void get_line_list_task(const char *path) {
   char *arg = copy_of(path);
-  submit_task(sub_thread_function::make_line_list_from_file, arg, NULL, main_thread_function::get_line_list);
+  if (!submit_task(sub_thread_function::make_line_list_from_file, arg, NULL, main_thread_function::get_line_list)) {
+    free(arg);
+  }
 }
@@ -98,6 +98,7 @@ static void *worker_thread(void *arg) _NOTHROW {
   setup_signal_handler_on_sub_thread(sub_thread_signal_handler);
   /* Assign 'thread_id' with the id passed via 'arg'. */
   Uchar thread_id = (Uchar)(uintptr_t)arg;
+  ntrace_thread_name("worker %u", thread_id);
   while (1) {
     lock_threadpool_mutex(TRUE);
     /* Wait for a task to become avaliable. */
@@ -177,9 +178,11 @@ void shutdown_queue(void) _NOTHROW {
   free(task_queue);
 }
 
-/* Add a task to the threadpool queue for for the subthreads to perform. */
-void submit_task(task_functionptr_t function, void *arg, void **result, callback_functionptr_t callback) _NOTHROW {
-  under_threadpool_mutex([function, arg, result, callback] {
+/* Add a task to the threadpool queue for for the subthreads to perform.  Return`s 'FALSE' when the queue
+ * is full, the task is then not performed, so the caller still owns 'arg' and has to handle that. */
+bool submit_task(task_functionptr_t function, void *arg, void **result, callback_functionptr_t callback) _NOTHROW {
+  bool submitted = FALSE;
+  under_threadpool_mutex([function, arg, result, callback, &submitted] {
     if (task_queue->count < QUEUE_SIZE) {
       task_queue->tasks[task_queue->rear].function = function;
       task_queue->tasks[task_queue->rear].arg      = arg;
@@ -189,8 +192,10 @@ void submit_task(task_functionptr_t function, void *arg, void **result, callback
       task_queue->count++;
       /* Send a signal that there is a new task. */
       pthread_cond_signal(&task_queue->cond);
+      submitted = TRUE;
     }
   });
+  return submitted;
 }
 
 /* Stop a thread by 'thread_id'.  Note that this will halt execution on that thread. */
@@ -563,7 +563,8 @@ char **retrieve_exec_output(const char *cmd, Uint *n_lines) {
     Uint len = strlen(buf);
     buf[len - 1] == '\n' ? buf[--len] = '\0' : 0;
     copy = measured_copy(buf, len);
-    (size == cap) ? ((cap *= 2), (lines = arealloc(lines, (sizeof(char *) * cap)))) : 0;
+    /* Always leave room for the terminating 'NULL'. */
+    ((size + 1) == cap) ? ((cap *= 2), (lines = arealloc(lines, (sizeof(char *) * cap)))) : 0;
     lines[size++] = copy;
   }
   pclose(prog);
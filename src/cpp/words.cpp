@@ -64,6 +64,7 @@ char *retrieve_word_from_cursor_pos(bool forward) {
 
 line_word_t *line_word_list(const char *str, Ulong slen) {
   PROFILE_FUNCTION;
+  TRACE_FUNCTION;
   line_word_t *head = NULL, *tail = NULL;
   (str[slen] == '\n') ? slen-- : 0;
   const char *start = str, *end = str;
@@ -375,6 +375,7 @@
 #define WORDCHARS        (1 << 9)
 #define GUIDESTRIPE      (1 << 10)
 #define CONF_OPT_TABSIZE (1 << 11)
+#define INCLUDEPATH      (1 << 12)
 
 /* Special keycodes for when a string bind has been partially implanted
  * or has an unpaired opening brace, or when a function in a string bind
@@ -732,7 +733,7 @@ static const Uint RECT_INDICES[6] = { 0, 1, 2, 2, 3, 0 };
 #define RECT_INDICES      RECT_INDICES
 #define RECT_INDICES_LEN  ARRAY_SIZE(RECT_INDICES)
 #define FONT_VERTBUF      "vertex:2f,tex_coord:2f,color:4f"
-#define RECT_VERTBUF      "vertex:2f,color:4f"
+#define RECT_VERTBUF      "vertex:2f,color:4f,rect:4f,radius:1f"
 
 
 /* ---------------------------------------------------------- Forward declaration's ---------------------------------------------------------- */
@@ -746,6 +747,7 @@ typedef struct augmentstruct         augmentstruct;
 typedef struct syntaxtype            syntaxtype;
 typedef struct lintstruct            lintstruct;
 typedef struct linestruct            linestruct;
+typedef struct softwrapcache         softwrapcache;
 typedef struct groupstruct           groupstruct;
 typedef struct undostruct            undostruct;
 typedef struct statusbar_undostruct  statusbar_undostruct;
@@ -771,6 +773,8 @@ typedef struct SyntaxObject     SyntaxObject;
 typedef struct SyntaxFileError  SyntaxFileError;
 /* The structure that holds the data when parsing a file. */
 typedef struct SyntaxFile       SyntaxFile;
+/* A block of memory owned by a `SyntaxArena`. */
+typedef struct SyntaxArenaBlock SyntaxArenaBlock;
 
 /* ----------------------------- gui/font.c ----------------------------- */
 
@@ -1105,6 +1109,8 @@ typedef enum {
   SUGGEST_INLINE,
   USING_GUI,
   NO_NCURSES,
+  PERF_OVERLAY,
+  PROJECT_WALK,
 # define DONTUSE                        DONTUSE
 # define CASE_SENSITIVE                 CASE_SENSITIVE
 # define CONSTANT_SHOW                  CONSTANT_SHOW
@@ -1161,6 +1167,8 @@ typedef enum {
 # define SUGGEST_INLINE                 SUGGEST_INLINE
 # define USING_GUI                      USING_GUI
 # define NO_NCURSES                     NO_NCURSES
+# define PERF_OVERLAY                   PERF_OVERLAY
+# define PROJECT_WALK                   PROJECT_WALK
 } flag_type;
 
 /* Identifiers for command line options. */
@@ -1182,7 +1190,8 @@ typedef enum {
   CLIOPT_GUI,
   CLIOPT_SAFE,
   CLIOPT_TEST,
-  CLIOPT_DEBUG_SOCKET 
+  CLIOPT_DEBUG_SOCKET,
+  CLIOPT_TRACE
 # define CLIOPT_IGNORERCFILE    CLIOPT_IGNORERCFILE
 # define CLIOPT_VERSION         CLIOPT_VERSION
 # define CLIOPT_HELP            CLIOPT_HELP
@@ -1201,6 +1210,7 @@ typedef enum {
 # define CLIOPT_SAFE            CLIOPT_SAFE
 # define CLIOPT_TEST            CLIOPT_TEST
 # define CLIOPT_DEBUG_SOCKET    CLIOPT_DEBUG_SOCKET
+# define CLIOPT_TRACE           CLIOPT_TRACE
 } cliopt_type;
 
 typedef enum {
@@ -1410,8 +1420,21 @@ struct RectVertex {
   float g;
   float b;
   float a;
+  /* The full rect this vertex is a part of, used by the rect shader to round the corners. */
+  float rx;
+  float ry;
+  float rw;
+  float rh;
+  float radius;
 };
 
+/* A single quad in the rect batch of the rect shader. */
+typedef struct {
+  Ushort layer;
+  Uint   seq;
+  RectVertex vert[4];
+} ShaderRectQuad;
+
 struct colortype {
   short id;         /* An ordinal number (if this color combo is for a multiline regex). */
   short fg;         /* This combo's foreground color. */
@@ -1488,6 +1511,8 @@ struct linestruct {
   short *multidata;
   /* Whether the user has placed an anchor at this line. */
   bool has_anchor;
+  /* The cached softwrap chunks of this line, only ever set for lines that wrap. */
+  softwrapcache *softwrap;
 
   /* TODO: Add `data_length`, `indent_length` and `alloc_length` and
    * strictly enforce these to stop dooing unessesary operations. */
@@ -1505,6 +1530,19 @@ struct linestruct {
   #define line_indent(line) wideness(line->data, indent_length(line->data))
 };
 
+/* The softwrap chunks of a line, for the content, width, tab size and wrap mode they were computed with. */
+struct softwrapcache {
+  Ulong *edges;    /* The starting column of every chunk, followed by the end column of the last chunk. */
+  Ulong  count;    /* The number of chunks. */
+  Ulong  cap;      /* The number of edges that fit in `edges`. */
+  Ulong  len;      /* The length of the line data the chunks were computed for. */
+  Ulong  hash;     /* The hash of the line data the chunks were computed for. */
+  Ulong  version;  /* The `line_data_version` at which the line data was last checked against `len` and `hash`. */
+  long   tabsize;
+  int    cols;
+  bool   at_blanks;
+};
+
 struct groupstruct {
   groupstruct *next;   /* The next group, if any. */
   long top_line;       /* First line of group. */
@@ -1661,6 +1699,21 @@ struct SyntaxFilePos {
   int column;
 };
 
+struct SyntaxArenaBlock {
+  SyntaxArenaBlock *next;
+  Ulong used;
+  Ulong cap;
+  char  data[];
+};
+
+/* Owns everything parsed from a `SyntaxFile`, allocated from blocks and freed all at once. */
+typedef struct {
+  SyntaxArenaBlock *head;  /* The block allocations are made from. */
+  SyntaxArenaBlock *tail;
+  Ulong nblocks;
+  Ulong size;              /* The number of bytes handed out. */
+} SyntaxArena;
+
 struct SyntaxFileLine {
   /* The next line in the double linked list of lines. */
   SyntaxFileLine *next;
@@ -1668,13 +1721,15 @@ struct SyntaxFileLine {
   /* The previous line in the double linked list of lines. */
   SyntaxFileLine *prev;
   
+  /* The data of this line, when the line is part of a read `SyntaxFile` this is a slice of its data, and not owned by the line. */
   char *data;
   Ulong len;
   long  lineno;
 };
 
 struct SyntaxObject {
-  char *file;
+  /* The path of the file this was parsed from, this is not a copy, it is the path of the `SyntaxFile` in the same arena. */
+  const char *file;
 
   /* Only used when there is more then one object with the same name. */
   SyntaxObject *next;
@@ -1687,13 +1742,10 @@ struct SyntaxObject {
   SyntaxObjectType type;
 
   /* The `position` in the `SyntaxFile` structure that this object is at. */
-  SyntaxFilePos *pos;
+  SyntaxFilePos pos;
 
-  /* A ptr to unique data to this type of object. */
+  /* A ptr to unique data to this type of object, allocated in the same arena as the object. */
   void *data;
-
-  /* Function ptr to be called to free the `data`, or `NULL`. */
-  FreeFuncPtr freedata;
 };
 
 struct SyntaxFileError {
@@ -1703,13 +1755,13 @@ struct SyntaxFileError {
   SyntaxFileError *prev;
 
   /* The file where this error is from. */
-  char *file;
+  const char *file;
 
   /* A string describing the error, or `NULL`. */
   char *msg;
 
   /* The position in the `SyntaxFile` where this error happened. */
-  SyntaxFilePos *pos;
+  SyntaxFilePos pos;
 };
 
 struct SyntaxFile {
@@ -1733,29 +1785,88 @@ struct SyntaxFile {
 
   /* Hash map that holds all objects parsed from the given file. */
   HashMap *objects;
+
+  /* The content of the file, when read with `syntaxfile_read()`.  Every newline is replaced by a `NULL-TERMINATOR`. */
+  char *data;
+  Ulong size;
+
+  /* When the file was read, every line in a single array, and `filetop` and `filebot` point into it. */
+  SyntaxFileLine *lines;
+  Ulong nlines;
+
+  /* Owns the path, and every object, error and piece of object data parsed from the file. */
+  SyntaxArena arena;
 };
 
+/* What parsing a set of files with `syntaxfile_parse_files()` did. */
+typedef struct {
+  int   threads;
+  Ulong files;
+  Ulong lines;
+  Ulong objects;   /* Objects per file, summed before merging. */
+  Ulong errors;
+  Ulong arena_blocks;
+  Ulong arena_bytes;
+  double parse_ms;
+  double merge_ms;
+} SyntaxParseStats;
+
 /* ----------------------------- csyntax.c ----------------------------- */
 
 typedef struct {
-  CVec *args;
-  char *expanded;  /* What this macro expands to, or in other words the value of the macro. */
+  char **args;     /* The names of the arguments, there are `nargs` of them. */
+  int    nargs;
+  int    argcap;
+  char  *expanded;  /* What this macro expands to, or in other words the value of the macro. */
   
   /* The exact row and column the expanded macro decl starts. */
-  SyntaxFilePos *expandstart;
+  SyntaxFilePos expandstart;
 
   /* The exact row and column the expanded macro decl ends. */
-  SyntaxFilePos *expandend;
+  SyntaxFilePos expandend;
 
   bool empty : 1;  /* Is set to `TRUE` if the macro does not have anything after its name. */
 } CSyntaxMacro;
 
 typedef struct {
-  SyntaxFilePos *bodystpos;
-  SyntaxFilePos *bodyendpos;
+  SyntaxFilePos bodystpos;
+  SyntaxFilePos bodyendpos;
   bool forward_decl : 1;  /* This struct is a forward declaration, and does not actuly declare anything. */
 } CSyntaxStruct;
 
+/* ----------------------------- ctoken.c ----------------------------- */
+
+/* The kind of a `CToken`. */
+typedef enum {
+  CTOKEN_WORD,          /* A identifier or keyword. */
+  CTOKEN_NUMBER,
+  CTOKEN_STRING,        /* A string literal, with its quotes. */
+  CTOKEN_CHAR,          /* A char literal, with its quotes. */
+  CTOKEN_COMMENT,       /* A line comment, or the part of a block comment that is on the line. */
+  CTOKEN_PREPROCESSOR,  /* The `#` that starts a preprocessor line, and the name of the directive. */
+  CTOKEN_BRACKET,       /* One of `(){}[]`. */
+  CTOKEN_PUNCT          /* Any other single char. */
+} CTokenKind;
+
+/* The state a line ends in, and so the state the next line starts in. */
+typedef enum {
+  CTOKEN_STATE_NONE,
+  CTOKEN_STATE_COMMENT  /* Inside a block comment. */
+} CTokenState;
+
+typedef struct {
+  Uint  offset;  /* The byte offset of the token in the line. */
+  Uint  len;
+  Uchar kind;    /* A `CTokenKind`. */
+} CToken;
+
+/* The tokens of a line.  The buffer is reused for every line, so it only allocates when a line has more tokens then any before it. */
+typedef struct {
+  CToken *tokens;
+  Ulong   len;
+  Ulong   cap;
+} CTokenBuf;
+
 /* ----------------------------- dirs.c ----------------------------- */
 
 typedef struct {
@@ -1763,18 +1874,14 @@ typedef struct {
   directory_t *dir;
 } directory_thread_data_t;
 
-/* ----------------------------- element_gridmap.c ----------------------------- */
-
-typedef struct {
-  int x;
-  int y;
-} ElementGridpos;
-
 /* ----------------------------- gui/element.c ----------------------------- */
 
 struct Element {
   Ushort layer;
 
+  /* The leaf in the element grid that holds this element, or `-1` when not in the grid. */
+  int grid_node;
+
   float x;
   float y;
   float width;
@@ -1805,7 +1912,7 @@ struct Element {
    * -100 to 100 values reprecenting 4 precentage values or any values in the range 0-255 -127-127.
    * .
    * Layout `ELEMENT_ROUNDED_RECT`:
-   *   Byte `0`: The apex fraction of the rounded corner stored as a Uchar made using a float with the value 0-1.
+   *   Byte `0`: How much the corner radius is reduced from a full half of the shortest side, stored as a Uchar made using a float with the value 0-1.
    */
   Uint xrectopts;
 
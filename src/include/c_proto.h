@@ -60,6 +60,7 @@ extern char *homedir;
 extern char *startup_problem;
 extern char *nanox_rc_path;
 extern char *backup_dir;
+extern char *include_path;
 extern char *answer;
 extern char *matchbrackets;
 extern char *punct;
@@ -151,6 +152,7 @@ extern Ulong light_from_col;
 extern Ulong light_to_col;
 extern Ulong typing_x;
 extern Ulong st_marked_x;
+extern Ulong line_data_version;
 
 extern Ulong flags[1];
 
@@ -279,9 +281,17 @@ Ulong       recode_LF_to_NUL(char *string);
 Ulong       get_page_start(Ulong column, int total_cols);
 Ulong       xplustabs_for(openfilestruct *const file);
 Ulong       xplustabs(void) _NODISCARD;
+Ulong       bytes_hash(const char *const restrict data, Ulong len) _NODISCARD _NONNULL(1);
+bool        is_long_line(const char *const restrict text) _NODISCARD _NONNULL(1);
 Ulong       wideness(const char *text, Ulong maxlen) _NODISCARD _NONNULL(1);
 Ulong       actual_x(const char *text, Ulong column) _NODISCARD _NONNULL(1);
 Ulong       breadth(const char *text) __THROW _NODISCARD _NONNULL(1);
+Ulong       line_wideness(const linestruct *const line, Ulong maxlen) _NODISCARD _NONNULL(1);
+Ulong       line_actual_x(const linestruct *const line, Ulong column) _NODISCARD _NONNULL(1);
+Ulong       line_breadth(const linestruct *const line) _NODISCARD _NONNULL(1);
+void        long_line_forget(const linestruct *const line) _NONNULL(1);
+void        long_line_test(void);
+void        long_line_test_bench(void);
 /* ----------------------------- Number of characters in ----------------------------- */
 Ulong number_of_characters_in(const linestruct *const begin, const linestruct *const end) _NODISCARD _NONNULL(1, 2);
 /* ----------------------------- Magicline ----------------------------- */
@@ -324,11 +334,17 @@ const char *strstrwrapper(const char *const haystack, const char *const needle,
 /* ----------------------------------------------- syntax/synx.c ----------------------------------------------- */
 
 
+/* ------------ SyntaxArena ------------ */
+
+void  syntaxarena_init(SyntaxArena *const arena) __THROW _NONNULL(1);
+void  syntaxarena_free(SyntaxArena *const arena) __THROW _NONNULL(1);
+void *syntaxarena_alloc(SyntaxArena *const arena, Ulong size) __THROW _NODISCARD _RETURNS_NONNULL _NONNULL(1);
+char *syntaxarena_copy(SyntaxArena *const arena, const char *const __restrict string, Ulong len) __THROW _NODISCARD _RETURNS_NONNULL _NONNULL(1, 2);
+void  syntaxarena_take(SyntaxArena *const dst, SyntaxArena *const src) __THROW _NONNULL(1, 2);
+
 /* ------------ SyntaxFilePos ------------ */
 
-SyntaxFilePos *syntaxfilepos_create(int row, int column) __THROW _NODISCARD _RETURNS_NONNULL;
-void           syntaxfilepos_free(SyntaxFilePos *const pos) __THROW _NONNULL(1);
-void           syntaxfilepos_set(SyntaxFilePos *const pos, int row, int column) __THROW _NONNULL(1);
+void syntaxfilepos_set(SyntaxFilePos *const pos, int row, int column) __THROW _NONNULL(1);
 
 /* ------------ SyntaxFileLine ------------ */
 
@@ -340,22 +356,18 @@ void            syntaxfileline_from_str(const char *const __restrict string, Syn
 
 /* ------------ SyntaxObject ------------ */
 
-SyntaxObject *syntaxobject_create(void);
-void          syntaxobject_free(SyntaxObject *const obj);
+SyntaxObject *syntaxobject_create(SyntaxArena *const arena);
 void          syntaxobject_unlink(SyntaxObject *const obj);
-void          syntaxobject_free_objects(void *ptr);
 void          syntaxobject_setfile(SyntaxObject *const obj, const char *const restrict file);
-void          syntaxobject_setdata(SyntaxObject *const sfobj, void *const data, FreeFuncPtr freedatafunc);
+void          syntaxobject_setdata(SyntaxObject *const sfobj, void *const data);
 void          syntaxobject_setpos(SyntaxObject *const obj, int row, int column);
 void          syntaxobject_setcolor(SyntaxObject *const obj, SyntaxColor color);
 void          syntaxobject_settype(SyntaxObject *const obj, SyntaxObjectType type);
 
 /* ------------ SyntaxFile ------------ */
 
-SyntaxFileError *syntaxfileerror_create(SyntaxFileError *const prev) __THROW;
-void             syntaxfileerror_free(SyntaxFileError *const err) __THROW _NONNULL(1);
+SyntaxFileError *syntaxfileerror_create(SyntaxArena *const arena, SyntaxFileError *const prev) __THROW;
 void             syntaxfileerror_unlink(SyntaxFileError *const err);
-void             syntaxfileerror_free_errors(SyntaxFileError *head);
 
 /* ------------ SyntaxFile ------------ */
 
@@ -365,9 +377,15 @@ void        syntaxfile_read(SyntaxFile *const sf, const char *const __restrict p
 void        syntaxfile_adderror(SyntaxFile *const sf, int row, int column, const char *const __restrict msg);
 void        syntaxfile_addobject(SyntaxFile *const sf, const char *const __restrict key, SyntaxObject *const value);
 
+/* ------------ SyntaxParse ------------ */
+
+void syntaxfile_parse_files(char *const *const paths, Ulong npaths, int nthreads, HashMap *const objects, SyntaxArena *const arena, SyntaxFileError **const errors, SyntaxParseStats *const stats);
+void syntaxfile_print_stats(const char *const __restrict name, const SyntaxParseStats *const stats);
+
 /* ------------ Tests ------------ */
 
-void syntaxfile_test_read(void);
+char **syntaxfile_test_paths(const char *const __restrict path, Ulong *const npaths);
+void   syntaxfile_test_read(void);
 
 
 /* ----------------------------------------------- fd.c ----------------------------------------------- */
@@ -590,14 +608,24 @@ Menu *suggestmenu(void);
 
 /* ----------------- CSyntaxMacro ----------------- */
 
-CSyntaxMacro *csyntaxmacro_create(void);
-void          csyntaxmacro_free(void *ptr);
+CSyntaxMacro *csyntaxmacro_create(SyntaxArena *const arena);
+void          csyntaxmacro_addarg(SyntaxArena *const arena, CSyntaxMacro *const macro, const char *const restrict arg, Ulong len);
 
 /* ----------------------------- Main parsing function ----------------------------- */
 
 void syntaxfile_parse_csyntax(SyntaxFile *const sf);
 
 
+/* ----------------------------------------------- syntax/ctoken.c ----------------------------------------------- */
+
+
+void        ctokenbuf_init(CTokenBuf *const buf) __THROW _NONNULL(1);
+void        ctokenbuf_free(CTokenBuf *const buf) __THROW _NONNULL(1);
+CTokenState ctoken_line(CTokenBuf *const buf, const char *const __restrict data, Ulong len, CTokenState state) __THROW _NONNULL(1);
+void        ctoken_test(void);
+void        ctoken_test_bench(void);
+
+
 /* ----------------------------------------------- csyntax.c ----------------------------------------------- */
 
 
@@ -647,6 +675,8 @@ texture_font_t  *font_get_font(Font *const f);
 texture_atlas_t *font_get_atlas(Font *const f);
 /* ----------------------------- Font get glyph ----------------------------- */
 texture_glyph_t *font_get_glyph(Font *const f, const char *const restrict codepoint);
+/* ----------------------------- Font get glyph page ----------------------------- */
+texture_glyph_t *font_get_glyph_page(Font *const f, const char *const restrict codepoint, Uint *const outpage);
 /* ----------------------------- Font get size ----------------------------- */
 Uint font_get_size(Font *const f);
 /* ----------------------------- Font get atlas size ----------------------------- */
@@ -691,25 +721,33 @@ void font_add_glyph(Font *const f, vertex_buffer_t *const buf, const char *const
 void font_vertbuf_add_mbstr(Font *const f, vertex_buffer_t *buf, const char *string, Ulong len, const char *previous, Uint color, float *const pen_x, float *const pen_y);
 /* ----------------------------- Font upload texture atlas ----------------------------- */
 void font_upload_texture_atlas(Font *const f);
+/* ----------------------------- Font render vertbuf ----------------------------- */
+void font_render_vertbuf(Font *const f, vertex_buffer_t *const buf);
 /* ----------------------------- Font add cursor ----------------------------- */
 void font_add_cursor(Font *const f, vertex_buffer_t *const buf, long row, Uint color, float x, float rowzero_y);
+/* ----------------------------- Font test evict ----------------------------- */
+void font_test_evict(void);
 
 
 /* ---------------------------------------------------------- gui/element_grid.c ---------------------------------------------------------- */
 
 
 /* ----------------------------- Element grid create ----------------------------- */
-void element_grid_create(int cell_size);
+void element_grid_create(float margin);
 /* ----------------------------- Element grid free ----------------------------- */
 void element_grid_free(void);
 /* ----------------------------- Element grid set ----------------------------- */
 void element_grid_set(Element *const e);
 /* ----------------------------- Element grid remove ----------------------------- */
 void element_grid_remove(Element *const e);
+/* ----------------------------- Element grid update ----------------------------- */
+void element_grid_update(Element *const e);
 /* ----------------------------- Element grid get ----------------------------- */
 Element *element_grid_get(float x, float y);
 /* ----------------------------- Element grid contains ----------------------------- */
 bool element_grid_contains(float x, float y);
+/* ----------------------------- Element grid test bench ----------------------------- */
+void element_grid_test_bench(float width, float height);
 
 
 /* ---------------------------------------------------------- gui/element.c ---------------------------------------------------------- */
@@ -845,6 +883,8 @@ void menu_set_static_width(Menu *const menu, float width);
 void menu_behavior_tab_accept(Menu *const menu, bool accept_on_tab);
 /* ----------------------------- Menu behavior arrow depth navigation ----------------------------- */
 void menu_behavior_arrow_depth_navigation(Menu *const menu, bool enable_arrow_depth_navigation);
+/* ----------------------------- Menu behavior filter exclude exact ----------------------------- */
+void menu_behavior_filter_exclude_exact(Menu *const menu, bool exclude_exact);
 /* ----------------------------- Menu set lable offset ----------------------------- */
 void menu_set_lable_offset(Menu *const menu, Ushort pixels);
 /* ----------------------------- Menu owns element ----------------------------- */
@@ -867,6 +907,8 @@ int menu_len(Menu *const menu);
 int menu_qsort_cb_strlen(const void *a, const void *b);
 /* ----------------------------- Menu qsort ----------------------------- */
 void menu_qsort(Menu *const menu, CmpFuncPtr cmp_func);
+/* ----------------------------- Menu filter ----------------------------- */
+void menu_filter(Menu *const menu, const char *const restrict prefix);
 
 
 /* ---------------------------------------------------------- gui/frame.c ---------------------------------------------------------- */
@@ -884,6 +926,12 @@ void frame_set_rate(int x);
 double frame_get_time_ms(void);
 /* ----------------------------- Frame get time ns ----------------------------- */
 Llong frame_get_time_ns(void);
+/* ----------------------------- Frame get work time ms ----------------------------- */
+double frame_get_work_time_ms(void);
+/* ----------------------------- Frame count draw calls ----------------------------- */
+void frame_count_draw_calls(Ulong n);
+/* ----------------------------- Frame get draw calls ----------------------------- */
+Ulong frame_get_draw_calls(void);
 /* ----------------------------- Frame should poll ----------------------------- */
 bool frame_should_poll(void);
 /* ----------------------------- Frame set poll ----------------------------- */
@@ -1178,6 +1226,8 @@ int   get_kbinput(WINDOW *const frame, bool showcursor);
 char *get_verbatim_kbinput(WINDOW *const frame, Ulong *const count);
 int   get_mouseinput(int *const my, int *const mx, bool allow_shortcuts);
 Ulong get_softwrap_breakpoint(int cols, const char *const restrict linedata, Ulong leftedge, bool *kickoff, bool *end_of_line);
+void  softwrap_cache_free(linestruct *const line);
+Ulong softwrap_chunk_end(int cols, linestruct *const line, Ulong leftedge, bool *const end_of_line);
 Ulong get_chunk_and_edge(int cols, Ulong column, linestruct *line, Ulong *leftedge);
 Ulong extra_chunks_in(int cols, linestruct *const line);
 Ulong chunk_for(int cols, Ulong column, linestruct *const line);
@@ -1188,7 +1238,10 @@ int   go_forward_chunks_for(openfilestruct *const file, int cols, int nrows, lin
 int   go_forward_chunks(int nrows, linestruct **const line, Ulong *const leftedge);
 void  ensure_firstcolumn_is_aligned_for(openfilestruct *const file, int cols);
 void  ensure_firstcolumn_is_aligned(void);
+Ulong display_string_into(char **const buffer, Ulong *const bufsize, const char *text, const linestruct *const line, Ulong column, Ulong span, bool isdata, bool isprompt);
 char *display_string(const char *text, Ulong column, Ulong span, bool isdata, bool isprompt);
+const char *display_string_row(int row, const char *text, const linestruct *const line, Ulong column, Ulong span, bool isdata, bool isprompt, Ulong *const len);
+void  display_string_rows_free(void);
 bool  line_needs_update_for(openfilestruct *const file, int cols, Ulong old_column, Ulong new_column);
 bool  line_needs_update(Ulong old_column, Ulong new_column);
 bool  less_than_a_screenful_for(CTX_ARGS, Ulong was_lineno, Ulong was_leftedge);
@@ -1228,6 +1281,9 @@ void  statusline(message_type type, const char *const restrict format, ...) _PRI
 void  statusbar_all(const char *const restrict msg);
 void  report_cursor_position_for(openfilestruct *const file);
 void  report_cursor_position(void);
+void  softwrap_test(void);
+void  softwrap_test_bench(void);
+void  display_string_test_bench(void);
 
 /* ----------------------------- Curses ----------------------------- */
 
@@ -1486,6 +1542,7 @@ void find_and_prime_applicable_syntax_for(openfilestruct *const file);
 void find_and_prime_applicable_syntax(void);
 void precalc_multicolorinfo_for(openfilestruct *const file);
 void precalc_multicolorinfo(void);
+void precalc_multicolorinfo_range_for(openfilestruct *const file, linestruct *const top, linestruct *const bot);
 
 
 /* ---------------------------------------------------------- prompt.c ---------------------------------------------------------- */
@@ -1615,6 +1672,8 @@ void copy_text_for(CTX_ARGS);
 void copy_text(void);
 void paste_text_for(CTX_ARGS);
 void paste_text(void);
+void paste_bulk_for(CTX_ARGS, const char *const restrict data, Ulong len);
+void paste_bulk(const char *const restrict data, Ulong len);
 void zap_replace_text_for(CTX_ARGS, const char *const restrict replace_with, Ulong len);
 void zap_replace_text(const char *const restrict replace_with, Ulong len);
 void chop_previous_word_for(CTX_ARGS);
@@ -1778,6 +1837,8 @@ void shader_compile(void);
 void shader_free(void);
 /* ----------------------------- Shader rect vertex load ----------------------------- */
 void shader_rect_vertex_load(RectVertex *buf, float x, float y, float w, float h, Uint color);
+/* ----------------------------- Shader rect vertex load rounded ----------------------------- */
+void shader_rect_vertex_load_rounded(RectVertex *buf, float x, float y, float w, float h, float radius, Uint color);
 /* ----------------------------- Shader rect vertex load array ----------------------------- */
 void shader_rect_vertex_load_array(RectVertex *buf, float *const array, Uint color);
 /* ----------------------------- Shader set projection ----------------------------- */
@@ -1790,6 +1851,12 @@ int shader_get_location_font_tex(void);
 int shader_get_location_font_projection(void);
 /* ----------------------------- Shader get location rect projection ----------------------------- */
 int shader_get_location_rect_projection(void);
+/* ----------------------------- Shader rect batch push ----------------------------- */
+void shader_rect_batch_push(const RectVertex *const vert, Ushort layer);
+/* ----------------------------- Shader rect batch push vertbuf ----------------------------- */
+void shader_rect_batch_push_vertbuf(vertex_buffer_t *const buf, Ushort layer);
+/* ----------------------------- Shader rect batch flush ----------------------------- */
+void shader_rect_batch_flush(void);
 
 
 /* ----------------------------------------------------------  ---------------------------------------------------------- */
@@ -1951,6 +2018,20 @@ bool wanted_to_move(functionptrtype f);
 bool changes_something(functionptrtype f);
 void do_exit(void);
 
+void process_pending_callbacks(void);
+void lsp_note_edit(openfilestruct *const file);
+void lsp_index_test_bench(void);
+void lsp_reindex_test(void);
+void lsp_reindex_test_bench(void);
+void symtab_test(void);
+void symtab_test_bench(void);
+void include_resolver_reset(void);
+void include_resolver_test(void);
+void include_resolver_test_bench(void);
+void lsp_project_test(void);
+void lsp_project_index_test(void);
+void lsp_project_test_bench(void);
+
 
 _END_C_LINKAGE
 
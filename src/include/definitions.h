@@ -63,6 +63,8 @@
 #include <Mlib/def.h>
 
 #include "../c/event/nfdwriter.h"
+#include "../c/perf/nperf.h"
+#include "../c/perf/ntrace.h"
 #include "../c/term/terminfo.h"
 #include "../c/term/move.h"
 #include "../c/term/input.h"
@@ -81,8 +81,8 @@ typedef struct IndexFile {
   linestruct *filetop;
   linestruct *filebot;
 
-  int  open_file(FILE **f);
-  void read_lines(FILE *f, int fd);
+  int  open_file(FILE **f, bool on_thread);
+  void read_lines(FILE *f, int fd, bool on_thread);
   void get_last_time_changed(void);
 
  public:
@@ -91,7 +91,8 @@ typedef struct IndexFile {
 
   bool has_changed(void) noexcept;
   void delete_data(void) noexcept;
-  void read_file(const char *path);
+  void read_file(const char *path, bool on_thread = FALSE);
+  void from_cache(const char *path);
 
 } IndexFile;
 
@@ -172,6 +173,129 @@ typedef struct Index {
     }
     classes.resize(0);
   }
+
+  /* Move everything in 'other' into this index, an entry with the same name replaces the one here.  Note that 'other' is left empty. */
+  void merge(Index &other) noexcept {
+    /* Bash data. */
+    for (auto &e : other.bash_data.error) {
+      bash_data.error.push_back(e);
+    }
+    for (auto &[name, data] : other.bash_data.variable) {
+      const auto &it = bash_data.variable.find(name);
+      if (it != bash_data.variable.end()) {
+        free(it->second.name);
+        free(it->second.value);
+      }
+      bash_data.variable[name] = data;
+    }
+    /* Defines. */
+    for (auto &[name, de] : other.defines) {
+      const auto &it = defines.find(name);
+      if (it != defines.end()) {
+        free(it->second.name);
+      }
+      defines[name] = de;
+    }
+    /* Enums. */
+    for (auto &[name, e] : other.enums) {
+      const auto &it = enums.find(name);
+      if (it != enums.end()) {
+        free(it->second.name);
+      }
+      enums[name] = e;
+    }
+    /* Typedef structs. */
+    for (auto &[alias, tds] : other.tdstructs) {
+      const auto &it = tdstructs.find(alias);
+      if (it != tdstructs.end()) {
+        free(it->second.name);
+        free(it->second.alias);
+      }
+      tdstructs[alias] = tds;
+    }
+    /* Structs. */
+    for (auto &[name, st] : other.structs) {
+      const auto &it = structs.find(name);
+      if (it != structs.end()) {
+        free(it->second.filename);
+        free(it->second.name);
+      }
+      structs[name] = st;
+    }
+    /* Function defenitions. */
+    for (auto &[name, fd] : other.functiondefs) {
+      const auto &it = functiondefs.find(name);
+      if (it != functiondefs.end()) {
+        free(it->second.name);
+        free(it->second.file);
+      }
+      functiondefs[name] = fd;
+    }
+    /* Variabels are kept per name, so these are added to what is already here. */
+    for (auto &[name, var_vec] : other.vars) {
+      auto &to = vars[name];
+      for (auto &v : var_vec) {
+        to.push_back(v);
+      }
+    }
+    for (auto &it : other.variabels) {
+      variabels.push_back(it);
+    }
+    for (auto &it : other.classes) {
+      classes.push_back(it);
+    }
+    for (auto &it : other.rawtypedef) {
+      rawtypedef.push_back(it);
+    }
+    for (auto &it : other.rawenum) {
+      rawenum.push_back(it);
+    }
+    for (auto &it : other.rawstruct) {
+      rawstruct.push_back(it);
+    }
+    /* Everything is owned by this index now, so only forget it. */
+    other.bash_data.error.resize(0);
+    other.bash_data.variable.clear();
+    other.defines.clear();
+    other.enums.clear();
+    other.tdstructs.clear();
+    other.structs.clear();
+    other.functiondefs.clear();
+    other.vars.clear();
+    other.variabels.resize(0);
+    other.classes.resize(0);
+    other.rawtypedef.resize(0);
+    other.rawenum.resize(0);
+    other.rawstruct.resize(0);
+  }
 } Index;
 
+/* What a name is, a name can be more then one of these. */
+typedef enum {
+  SYMBOL_SYNTAX      = (1 << 0), /* In 'test_map'. */
+  SYMBOL_DEFINE      = (1 << 1),
+  SYMBOL_ENUM        = (1 << 2),
+  SYMBOL_TDSTRUCT    = (1 << 3),
+  SYMBOL_STRUCT      = (1 << 4),
+  SYMBOL_FUNCTIONDEF = (1 << 5),
+  SYMBOL_VAR         = (1 << 6),
+} SymbolKind;
+
+/* Where a variable with a given name is declared. */
+typedef struct SymbolVar {
+  const char *file; /* Only the file name, not the full path. */
+  Uint decl_st;
+  Uint decl_end;
+} SymbolVar;
+
+/* Everything the highlighter needs to know about a name, see 'symbol_lookup()'. */
+typedef struct Symbol {
+  Uint kinds;     /* 'SymbolKind' flags. */
+  int  color;     /* When 'SYMBOL_SYNTAX' is set, the color from 'test_map'. */
+  int  from_line; /* When 'SYMBOL_SYNTAX' is set, the lines the color applies to, or '-1' when it applies everywhere. */
+  int  to_line;
+  Uint vars;      /* When 'SYMBOL_VAR' is set, the first declaration in 'symbol_vars()'. */
+  Uint nvars;
+} Symbol;
+
 /* clang-format on */
@@ -31,6 +31,25 @@ inline namespace LSP_utils {
 
 /* preprossesor */
 void do_preprossesor(linestruct *, const char *);
+/* index_cache */
+char *index_cache_dir(void);
+bool  index_cache_load(const char *dir, const char *path, bool main_file, const struct stat *st, Index *index, vector<string> &includes);
+void  index_cache_store(const char *dir, const char *path, bool main_file, const struct stat *st, const Index *index, const vector<string> &includes);
+/* include_resolver */
+char *include_resolve(const char *name);
+void  include_resolver_set_project_dirs(const vector<string> &dirs);
+void  include_resolver_add_project_dirs(const vector<string> &dirs);
+/* project */
+void project_walk(const string &dir, vector<string> &files);
+/* symtab */
+Uint intern(const char *str, Ulong len);
+Uint intern_find(const char *str, Ulong len) noexcept;
+const char *interned(Uint id) noexcept;
+void symbols_changed(void) noexcept;
+void symbol_changed(const char *name, Ulong len);
+void symbols_changed_in(const Index &index);
+const Symbol *symbol_lookup(const char *str, Ulong len);
+const SymbolVar *symbol_vars(const Symbol *symbol) noexcept;
 /* data_parse */
 namespace Parse {
   inline namespace utils {
@@ -56,6 +75,7 @@ class LanguageServer {
 
  public:
   Index index;
+  char *cache_dir = NULL; /* Where per-file index results are kept between sessions, or 'NULL' when there is no cache. */
 
   static LanguageServer *const &instance(void);
 
@@ -67,6 +87,24 @@ class LanguageServer {
 
   bool has_been_included(const char *path);
   int index_file(const char *path, bool reindex = FALSE);
+  void parse_lines(linestruct *top, const char *name, bool c_cpp, bool bash);
+
+  /* indexer */
+  Index &target(void) noexcept;
+  const char *main_file(void) noexcept;
+  void parse_into(Index *into, const char *main, linestruct *top, const char *name);
+  void include_file(const char *path);
+  void index_file_async(const char *path, bool reindex = FALSE, int max_workers = 0);
+  void index_project_async(const vector<string> &paths, int cpu_share, const char *walk = NULL);
+  bool indexing(void) noexcept;
+
+  /* project */
+  bool index_project(const char *path);
+  bool find_definition(const char *name, Ulong len, const char *at_file, long at_line, const char **file, long *line);
+
+  /* reindex */
+  void note_edit(openfilestruct *file);
+  void process_edits(void);
 };
 #define LSP LanguageServer::instance()
 
@@ -665,6 +665,7 @@ bool   enter_with_bracket(void);
 void   all_brackets_pos(void);
 void   do_close_bracket(void);
 void   do_parse(void);
+void   do_goto_definition(void);
 void   do_test(void);
 void   do_test_window(void);
 int    current_line_scope_end(linestruct *line);
@@ -739,7 +740,7 @@ void  pause_all_sub_threads(bool pause) _NOTHROW;
 void  init_queue_task(void) _NOTHROW;
 int   task_queue_count(void) _NOTHROW;
 void  shutdown_queue(void) _NOTHROW;
-void  submit_task(task_functionptr_t function, void *arg, void **result, callback_functionptr_t callback) _NOTHROW;
+bool  submit_task(task_functionptr_t function, void *arg, void **result, callback_functionptr_t callback) _NOTHROW;
 void  stop_thread(Uchar thread_id) _NOTHROW;
 Uchar thread_id_from_pthread(pthread_t *thread) _NOTHROW;
 
@@ -850,23 +851,23 @@ char *fetch_bracket_body(linestruct *from, Ulong index);
   
   
   void  upload_texture_atlas(texture_atlas_t *atlas);
-  float glyph_width(const char *current, const char *prev, texture_font_t *font);
-  float string_pixel_offset(const char *string, const char *previous_char, Ulong index, texture_font_t *font);
-  float pixel_breadth(texture_font_t *font, const char *text);
-  long  index_from_mouse_x(const char *string, Uint len, texture_font_t *font, float start_x);
-  long  index_from_mouse_x(const char *string, texture_font_t *font, float start_x);
+  float glyph_width(const char *current, const char *prev, Font *const font);
+  float string_pixel_offset(const char *string, const char *previous_char, Ulong index, Font *const font);
+  float pixel_breadth(Font *const font, const char *text);
+  long  index_from_mouse_x(const char *string, Uint len, Font *const font, float start_x);
+  long  index_from_mouse_x(const char *string, Font *const font, float start_x);
   linestruct *line_from_mouse_y(texture_font_t *font, float y);
   linestruct *line_and_index_from_mousepos(texture_font_t *const font, Ulong *const index) _RETURNS_NONNULL _NONNULL(1, 2);
-  float get_line_number_pixel_offset(linestruct *line, texture_font_t *font);
-  float line_pixel_x_pos(linestruct *line, Ulong index, texture_font_t *font);
-  float cursor_pixel_x_pos(texture_font_t *font);
+  float get_line_number_pixel_offset(linestruct *line, Font *const font);
+  float line_pixel_x_pos(linestruct *line, Ulong index, Font *const font);
+  float cursor_pixel_x_pos(Font *const font);
   float line_y_pixel_offset(linestruct *line, texture_font_t *font);
   float cursor_pixel_y_pos(texture_font_t *font);
-  void  add_glyph(const char *current, const char *previous, vertex_buffer_t *buffer, texture_font_t *font, vec4 color, vec2 *pen);
-  void  vertex_buffer_add_string(vertex_buffer_t *buffer, const char *string, Ulong slen, const char *previous, texture_font_t *font, vec4 color, vec2 *pen);
+  void  add_glyph(const char *current, const char *previous, vertex_buffer_t *buffer, Font *const font, vec4 color, vec2 *pen);
+  void  vertex_buffer_add_string(vertex_buffer_t *buffer, const char *string, Ulong slen, const char *previous, Font *const font, vec4 color, vec2 *pen);
   void  vertex_buffer_add_mbstr(vertex_buffer_t *buf, const char *string, Ulong len, const char *previous, Font *const font, vec4 color, vec2 *penpos);
-  void  add_openfile_cursor(texture_font_t *font, vertex_buffer_t *buffer, vec4 color);
-  void  add_cursor(texture_font_t *font, vertex_buffer_t *buf, vec4 color, vec2 at);
+  void  add_openfile_cursor(Font *const font, vertex_buffer_t *buffer, vec4 color);
+  void  add_cursor(Font *const font, vertex_buffer_t *buf, vec4 color, vec2 at);
   // void  update_projection_uniform(Uint shader);
   // void vertex_buffer_add_element_lable(guielement *element, texture_font_t *font, vertex_buffer_t *buffer);
   // void vertex_buffer_add_element_lable_offset(guielement *element, texture_font_t *font, vertex_buffer_t *buf, vec2 offset);
@@ -1058,7 +1059,6 @@ vertex_buffer_t *make_new_font_buffer(void) _NODISCARD;
 
 float pixnbreadth_prev(const char *const restrict string, long len, const char *const restrict prev_char);
 float pixnbreadth(const char *const restrict string, long len);
-float pixbreadth(texture_font_t *const font, const char *const restrict string);
 float pixbreadth(Font *const font, const char *const restrict string);
 
 
@@ -1067,7 +1067,7 @@ float pixbreadth(Font *const font, const char *const restrict string);
 
 // linestruct *line_from_cursor_pos(guieditor *const editor) _RETURNS_NONNULL;
 linestruct *line_from_cursor_pos(Editor *const editor) _RETURNS_NONNULL;
-float *pixpositions(const char *const restrict string, float normx, Ulong *outlen, texture_font_t *const font);
+float *pixpositions(const char *const restrict string, float normx, Ulong *outlen, Font *const font);
 Ulong closest_index(float *array, Ulong len, float rawx, texture_font_t *const font);
 Ulong index_from_pix_xpos(const char *const restrict string, float rawx, float normx, texture_font_t *const font);
 